@@ -0,0 +1,245 @@
+'''
+@file: conformance.py
+@breif: Conformance and speed comparison of the Python and C++ planners
+@author: Winter
+@update: 2023.2.21
+'''
+import argparse
+import heapq
+import math
+import random
+import sys
+import time
+
+import matplotlib
+# the planners create figures, none is shown here
+matplotlib.use("Agg")
+import matplotlib.pyplot as plt
+import numpy as np
+
+from utils import Grid, Map
+from graph_search import AStar, Dijkstra, GBFS, JPS
+from sample_search import RRT, RRTConnect, RRTStar, InformedRRT
+from cpp_search import CppAStar, CppDijkstra, CppGBFS, CppJPS
+from cpp_search import CppRRT, CppRRTConnect, CppRRTStar, CppInformedRRT
+
+'''
+Graph search pairs: name, Python planner, C++ planner, whether the costs are checked,
+and whether the Python / C++ planner may cut obstacle corners diagonally.
+The Python A* and Dijkstra do not cut corners, the C++ ones only check the target cell.
+'''
+GRAPH_PAIRS = [
+    ("A*", AStar, CppAStar, True, False, True),
+    ("Dijkstra", Dijkstra, CppDijkstra, True, False, True),
+    ("JPS", JPS, CppJPS, True, True, True),
+    ("GBFS", GBFS, CppGBFS, False, False, True),
+]
+
+'''
+Sample search pairs: name, Python planner, C++ planner, keyword arguments as in main.py,
+and the reason the success rates are expected to differ, None if they must agree.
+The Python planners steer towards every sample and only check the new edge, while the C++ ones
+sample whole cells and drop samples on obstacle or boundary cells. C++ RRT, RRT-Connect and RRT*
+only count the samples that grew the tree against sample_num, C++ Informed RRT* counts every draw,
+so with the 1500 samples of main.py it grows a smaller tree and fails more often than the Python one.
+'''
+SAMPLE_PAIRS = [
+    ("RRT", RRT, CppRRT, dict(max_dist=0.5, sample_num=10000), None),
+    ("RRT-Connect", RRTConnect, CppRRTConnect, dict(max_dist=0.5, sample_num=10000), None),
+    ("RRT*", RRTStar, CppRRTStar, dict(max_dist=0.5, r=20, sample_num=10000), None),
+    ("Informed RRT*", InformedRRT, CppInformedRRT, dict(max_dist=0.5, r=12, sample_num=1500),
+     "C++ counts the samples dropped on obstacle cells"),
+]
+
+def referenceCost(env: Grid, start: tuple, goal: tuple, corner_cutting: bool) -> float:
+    '''
+    Optimal 8-connected path cost by Dijkstra, inf if the goal is unreachable.
+
+    Parameters
+    ----------
+    env: Grid
+        environment
+    start: tuple
+        start point coordinate
+    goal: tuple
+        goal point coordinate
+    corner_cutting: bool
+        whether a diagonal move may pass between two obstacles touching its corners
+
+    Return
+    ----------
+    cost: float
+        optimal path cost
+    '''
+    obstacles = env.obstacles
+    g = {start: 0.0}
+    OPEN = [(0.0, start)]
+    while OPEN:
+        cost, (x, y) = heapq.heappop(OPEN)
+        if (x, y) == goal:
+            return cost
+        if cost > g[(x, y)]:
+            continue
+        for dx in (-1, 0, 1):
+            for dy in (-1, 0, 1):
+                n = (x + dx, y + dy)
+                if (dx == 0 and dy == 0) or n in obstacles:
+                    continue
+                if dx and dy and not corner_cutting and ((x + dx, y) in obstacles or (x, y + dy) in obstacles):
+                    continue
+                n_cost = cost + math.hypot(dx, dy)
+                if n_cost < g.get(n, float("inf")):
+                    g[n] = n_cost
+                    heapq.heappush(OPEN, (n_cost, n))
+    return float("inf")
+
+def graphScenarios(num: int, density: float, seed: int) -> list:
+    '''
+    The environment of main.py and `num` random ones, every goal reachable without cutting corners.
+
+    Return
+    ----------
+    scenarios: list
+        (name, start, goal, env)
+    '''
+    scenarios = [("default", (5, 5), (45, 25), Grid(51, 31))]
+    rng = random.Random(seed)
+    while len(scenarios) < num + 1:
+        env = Grid(51, 31)
+        x, y = env.x_range, env.y_range
+        obstacles = {(i, j) for i in range(x) for j in range(y) if i in (0, x - 1) or j in (0, y - 1)}
+        obstacles |= {(i, j) for i in range(1, x - 1) for j in range(1, y - 1) if rng.random() < density}
+        start = (rng.randrange(1, 10), rng.randrange(1, y - 1))
+        goal = (rng.randrange(x - 10, x - 1), rng.randrange(1, y - 1))
+        obstacles -= {start, goal}
+        env.update(obstacles)
+        if referenceCost(env, start, goal, False) < float("inf"):
+            scenarios.append(("random-{}".format(len(scenarios)), start, goal, env))
+    return scenarios
+
+def timed(plan):
+    t = time.perf_counter()
+    result = plan()
+    return result, time.perf_counter() - t
+
+def informedPlan(planner: InformedRRT):
+    '''
+    Main loop of InformedRRT.run() without the animation.
+    '''
+    best_cost, best_path = float("inf"), None
+    for _ in range(planner.sample_num):
+        cost, path = planner.plan()
+        if path and cost < best_cost:
+            planner.c_best = best_cost = cost
+            best_path = path
+    return (best_cost, best_path) if best_path else (0, None)
+
+def compareGraph(scenarios: list, tol: float) -> int:
+    '''
+    Compare path costs of the graph search pairs against the optimal ones of their motion models.
+
+    Return
+    ----------
+    failures: int
+        number of failed checks
+    '''
+    print("graph search, {} scenarios".format(len(scenarios)))
+    print("{:<10} {:>7} {:>7} {:>11} {:>11} {:>8}".format(
+        "planner", "py ok", "C++ ok", "py ms", "C++ ms", "speedup"))
+    failures = 0
+    for name, py_planner, cpp_planner, optimal, py_cut, cpp_cut in GRAPH_PAIRS:
+        py_ok = cpp_ok = 0
+        py_time = cpp_time = 0.0
+        for s_name, start, goal, env in scenarios:
+            ((py_cost, py_path), _), t = timed(py_planner(start, goal, env).plan)
+            py_time += t
+            ((cpp_cost, cpp_path), _), t = timed(cpp_planner(start, goal, env).plan)
+            cpp_time += t
+            plt.close("all")
+
+            for who, cost, path, cut in (("py", py_cost, py_path, py_cut), ("C++", cpp_cost, cpp_path, cpp_cut)):
+                if optimal:
+                    ref = referenceCost(env, start, goal, cut)
+                    ok = bool(path) and abs(cost - ref) <= tol
+                else:
+                    ref, ok = None, bool(path)
+                if ok:
+                    py_ok, cpp_ok = (py_ok + 1, cpp_ok) if who == "py" else (py_ok, cpp_ok + 1)
+                else:
+                    failures += 1
+                    print("  {} {} on {}: cost {}, expected {}".format(name, who, s_name, cost, ref))
+        print("{:<10} {:>7} {:>7} {:>11.2f} {:>11.2f} {:>7.1f}x".format(
+            name, "{}/{}".format(py_ok, len(scenarios)), "{}/{}".format(cpp_ok, len(scenarios)),
+            py_time * 1e3, cpp_time * 1e3, py_time / max(cpp_time, 1e-9)))
+    return failures
+
+def compareSample(runs: int, seed: int, rate_tol: float) -> int:
+    '''
+    Compare success rates of the sample search pairs over `runs` seeds on the environment of main.py.
+
+    Return
+    ----------
+    failures: int
+        number of failed checks
+    '''
+    start, goal, env = (18, 8), (37, 18), Map(51, 31)
+    print("sample search, {} runs".format(runs))
+    print("{:<14} {:>7} {:>7} {:>9} {:>9} {:>11} {:>11} {:>8}".format(
+        "planner", "py ok", "C++ ok", "py cost", "C++ cost", "py ms", "C++ ms", "speedup"))
+    failures = 0
+    for name, py_planner, cpp_planner, kwargs, expected in SAMPLE_PAIRS:
+        py_costs, cpp_costs = [], []
+        py_time = cpp_time = 0.0
+        for i in range(runs):
+            np.random.seed(seed + i)
+            planner = py_planner(start, goal, env, **kwargs)
+            plan = (lambda: informedPlan(planner)) if py_planner is InformedRRT else planner.plan
+            (cost, path), t = timed(plan)
+            py_time += t
+            if path:
+                py_costs.append(cost)
+
+            planner = cpp_planner(start, goal, env, seed=seed + i, **kwargs)
+            (cost, path), t = timed(planner.plan)
+            cpp_time += t
+            if path:
+                cpp_costs.append(cost)
+            plt.close("all")
+
+        py_rate, cpp_rate = len(py_costs) / runs, len(cpp_costs) / runs
+        print("{:<14} {:>6.0%} {:>6.0%} {:>9.2f} {:>9.2f} {:>11.2f} {:>11.2f} {:>7.1f}x".format(
+            name, py_rate, cpp_rate, np.mean(py_costs) if py_costs else math.nan,
+            np.mean(cpp_costs) if cpp_costs else math.nan, py_time * 1e3, cpp_time * 1e3,
+            py_time / max(cpp_time, 1e-9)))
+        if abs(py_rate - cpp_rate) > rate_tol:
+            if expected:
+                print("  {}: success rates differ by more than {:.0%}, expected: {}".format(name, rate_tol, expected))
+            else:
+                failures += 1
+                print("  {}: success rates differ by more than {:.0%}".format(name, rate_tol))
+    return failures
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="Run the same scenarios through the Python and C++ planners, "
+                                                 "check the results agree and report the speedup.")
+    parser.add_argument("--grids", type=int, default=10, help="number of random grid scenarios")
+    parser.add_argument("--density", type=float, default=0.2, help="obstacle density of the random grids")
+    parser.add_argument("--runs", type=int, default=10, help="seeded runs of every sample planner")
+    parser.add_argument("--seed", type=int, default=0, help="seed of the scenarios and runs")
+    parser.add_argument("--tol", type=float, default=1e-6, help="path cost tolerance of the optimal planners")
+    parser.add_argument("--rate-tol", type=float, default=0.2, help="success rate tolerance of the sample planners")
+    parser.add_argument("--skip-sample", action="store_true", help="only compare the graph search planners")
+    args = parser.parse_args()
+
+    try:
+        failures = compareGraph(graphScenarios(args.grids, args.density, args.seed), args.tol)
+        if not args.skip_sample:
+            print()
+            failures += compareSample(args.runs, args.seed, args.rate_tol)
+    except ImportError as e:
+        print(e)
+        sys.exit(2)
+
+    print()
+    print("conformance: {}".format("{} failures".format(failures) if failures else "ok"))
+    sys.exit(1 if failures else 0)
@@ -0,0 +1,5 @@
+from .cpp_search import CppAStar, CppDijkstra, CppGBFS, CppJPS, CppDStar
+from .cpp_search import CppRRT, CppRRTConnect, CppRRTStar, CppInformedRRT
+
+__all__ = ["CppAStar", "CppDijkstra", "CppGBFS", "CppJPS", "CppDStar",
+           "CppRRT", "CppRRTConnect", "CppRRTStar", "CppInformedRRT"]
@@ -0,0 +1,268 @@
+'''
+@file: cpp_search.py
+@breif: C++ planner cores behind the interface of the Python planners
+@author: Winter
+@update: 2023.2.20
+'''
+import math
+import numpy as np
+import os, sys
+
+sys.path.append(os.path.abspath(os.path.join(__file__, "../../")))
+# default build directory of the module, see ros/src/planner/benchmark
+sys.path.append(os.path.abspath(os.path.join(__file__, "../../../build/benchmark")))
+
+from utils import Env, Grid, Map, Node, Planner
+
+try:
+    import _planner_cores
+except ImportError:
+    _planner_cores = None
+
+# cost of an obstacle cell, the C++ planners treat cost >= 253 * 0.5 as obstacle
+LETHAL_COST = 254
+
+def _cores():
+    if _planner_cores is None:
+        raise ImportError("_planner_cores not found, build it with\n"
+                          "  cmake -S ./ros/src/planner/benchmark -B ./build/benchmark -DBUILD_PYTHON_BINDINGS=ON\n"
+                          "  cmake --build ./build/benchmark\n"
+                          "or add its directory to PYTHONPATH")
+    return _planner_cores
+
+class CppGraphSearcher(Planner):
+    '''
+    Base class for C++ graph search planners on a Grid environment.
+    Every grid point is one costmap cell, obstacles are lethal cells.
+
+    Parameters
+    ----------
+    start: tuple
+        start point coordinate
+    goal: tuple
+        goal point coordinate
+    env: Grid
+        environment
+    '''
+    def __init__(self, start: tuple, goal: tuple, env: Grid) -> None:
+        super().__init__(start, goal, env)
+        # costmap shared with the C++ planner, indexed costs[y, x]
+        self.costs = np.zeros((env.y_range, env.x_range), dtype=np.uint8)
+        for (x, y) in env.obstacles:
+            self.costs[y, x] = LETHAL_COST
+        self.core = self.create(_cores(), env.x_range, env.y_range)
+
+    def create(self, cores, nx: int, ny: int):
+        '''
+        Interface for creating the C++ planner.
+        '''
+        raise NotImplementedError
+
+    def plan(self):
+        '''
+        C++ motion plan function.
+
+        Return
+        ----------
+        cost: float
+            path cost
+        path: list
+            planning path
+        expand: list
+            all nodes that planner has searched
+        '''
+        found, path, expand = self.core.plan(self.costs, self.start.current, self.goal.current)
+        if not found:
+            return (0, []), []
+        path = [tuple(p) for p in path.tolist()]
+        cost = sum(math.hypot(p[0] - q[0], p[1] - q[1]) for p, q in zip(path, path[1:]))
+        expand = [Node((x, y), (px, py), 0, 0) for x, y, px, py in expand.tolist()]
+        return (cost, path), expand
+
+    def run(self):
+        '''
+        Running both plannig and animation.
+        '''
+        (cost, path), expand = self.plan()
+        self.plot.animation(path, str(self), cost, expand)
+
+class CppAStar(CppGraphSearcher):
+    '''
+    C++ A* motion planning.
+
+    Examples
+    ----------
+    >>> from utils import Grid
+    >>> from cpp_search import CppAStar
+    >>> planner = CppAStar((5, 5), (45, 25), Grid(51, 31))
+    >>> planner.run()
+    '''
+    def __str__(self) -> str:
+        return "A*(C++)"
+
+    def create(self, cores, nx: int, ny: int):
+        return cores.AStar(nx, ny)
+
+class CppDijkstra(CppGraphSearcher):
+    def __str__(self) -> str:
+        return "Dijkstra(C++)"
+
+    def create(self, cores, nx: int, ny: int):
+        return cores.AStar(nx, ny, dijkstra=True)
+
+class CppGBFS(CppGraphSearcher):
+    def __str__(self) -> str:
+        return "Greedy Best First Search(C++)"
+
+    def create(self, cores, nx: int, ny: int):
+        return cores.AStar(nx, ny, gbfs=True)
+
+class CppJPS(CppGraphSearcher):
+    def __str__(self) -> str:
+        return "Jump Point Search(C++)"
+
+    def create(self, cores, nx: int, ny: int):
+        return cores.JumpPointSearch(nx, ny)
+
+class CppDStar(CppGraphSearcher):
+    '''
+    C++ D* motion planning, the first plan() searches and later ones repair the path from the start.
+    '''
+    def __str__(self) -> str:
+        return "D*(C++)"
+
+    def create(self, cores, nx: int, ny: int):
+        return cores.DStar(nx, ny)
+
+class CppSampleSearcher(Planner):
+    '''
+    Base class for C++ sample search planners on a Map environment.
+    The map is rasterized into cells of `resolution`, obstacles inflated by `delta` as the Python planners do.
+
+    Parameters
+    ----------
+    start: tuple
+        start point coordinate
+    goal: tuple
+        goal point coordinate
+    env: Map
+        environment
+    max_dist: float
+        Maximum expansion distance one step
+    sample_num: int
+        Maximum number of sample points
+    resolution: float
+        costmap cell size
+    delta: float
+        obstacle inflation
+    seed: int
+        sampling seed, None for a random one
+    '''
+    def __init__(self, start: tuple, goal: tuple, env: Map, max_dist: float, sample_num: int,
+                 resolution: float = 0.1, delta: float = 0.5, seed: int = None) -> None:
+        super().__init__(start, goal, env)
+        self.max_dist = max_dist
+        self.sample_num = sample_num
+        self.resolution = resolution
+        self.delta = delta
+        self.sample_list = []
+
+        # costmap shared with the C++ planner, indexed costs[y, x]
+        nx, ny = int(math.ceil(env.x_range / resolution)), int(math.ceil(env.y_range / resolution))
+        x, y = np.meshgrid((np.arange(nx) + 0.5) * resolution, (np.arange(ny) + 0.5) * resolution)
+        obstacle = np.zeros((ny, nx), dtype=bool)
+        for (ox, oy, r) in env.obs_circ:
+            obstacle |= np.hypot(x - ox, y - oy) <= r + delta
+        for (ox, oy, w, h) in env.obs_rect + env.boundary:
+            obstacle |= (x >= ox - delta) & (x <= ox + w + delta) & (y >= oy - delta) & (y <= oy + h + delta)
+        self.costs = np.where(obstacle, LETHAL_COST, 0).astype(np.uint8)
+
+        self.core = self.create(_cores(), nx, ny, max_dist / resolution)
+        if seed is not None:
+            self.core.setSeed(seed)
+
+    def create(self, cores, nx: int, ny: int, max_dist: float):
+        '''
+        Interface for creating the C++ planner, max_dist in cells.
+        '''
+        raise NotImplementedError
+
+    def toCell(self, point: tuple) -> tuple:
+        return (int(point[0] / self.resolution), int(point[1] / self.resolution))
+
+    def toMap(self, cell) -> tuple:
+        return ((cell[0] + 0.5) * self.resolution, (cell[1] + 0.5) * self.resolution)
+
+    def plan(self):
+        '''
+        C++ motion plan function.
+
+        Return
+        ----------
+        cost: float
+            path cost
+        path: list
+            planning path
+        '''
+        found, path, expand = self.core.plan(self.costs, self.toCell(self.start.current),
+                                             self.toCell(self.goal.current))
+        self.sample_list = [Node(self.toMap((x, y)), self.toMap((px, py)), 0, 0)
+                            for x, y, px, py in expand.tolist()]
+        if not found:
+            return 0, None
+        path = [self.toMap(p) for p in path.tolist()]
+        cost = sum(math.hypot(p[0] - q[0], p[1] - q[1]) for p, q in zip(path, path[1:]))
+        return cost, path
+
+    def run(self) -> None:
+        '''
+        Running both plannig and animation.
+        '''
+        cost, path = self.plan()
+        self.plot.animation(path, str(self), cost, self.sample_list)
+
+class CppRRT(CppSampleSearcher):
+    '''
+    C++ RRT motion planning.
+
+    Examples
+    ----------
+    >>> from utils import Map
+    >>> from cpp_search import CppRRT
+    >>> planner = CppRRT((18, 8), (37, 18), Map(51, 31), max_dist=0.5, sample_num=10000)
+    >>> planner.run()
+    '''
+    def __str__(self) -> str:
+        return "Rapidly-exploring Random Tree(RRT, C++)"
+
+    def create(self, cores, nx: int, ny: int, max_dist: float):
+        return cores.RRT(nx, ny, self.resolution, self.sample_num, max_dist)
+
+class CppRRTConnect(CppSampleSearcher):
+    def __str__(self) -> str:
+        return "RRT-Connect(C++)"
+
+    def create(self, cores, nx: int, ny: int, max_dist: float):
+        return cores.RRTConnect(nx, ny, self.resolution, self.sample_num, max_dist)
+
+class CppRRTStar(CppSampleSearcher):
+    '''
+    C++ RRT* motion planning, `r` is the optimization radius in map units.
+    '''
+    def __init__(self, start: tuple, goal: tuple, env: Map, max_dist: float, sample_num: int, r: float,
+                 **kwargs) -> None:
+        self.r = r
+        super().__init__(start, goal, env, max_dist, sample_num, **kwargs)
+
+    def __str__(self) -> str:
+        return "RRT*(C++)"
+
+    def create(self, cores, nx: int, ny: int, max_dist: float):
+        return cores.RRTStar(nx, ny, self.resolution, self.sample_num, max_dist, self.r / self.resolution)
+
+class CppInformedRRT(CppRRTStar):
+    def __str__(self) -> str:
+        return "Informed RRT*(C++)"
+
+    def create(self, cores, nx: int, ny: int, max_dist: float):
+        return cores.InformedRRT(nx, ny, self.resolution, self.sample_num, max_dist, self.r / self.resolution)
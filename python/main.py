@@ -10,6 +10,9 @@ from graph_search import DStar, LPAStar, DStarLite
 
 from sample_search import RRT, RRTConnect, RRTStar, InformedRRT
 
+# C++ planners, see ros/src/planner/benchmark for building the bindings
+from cpp_search import CppAStar, CppJPS, CppRRTStar
+
 if __name__ == '__main__':
     '''
     graph search
@@ -27,6 +30,7 @@ if __name__ == '__main__':
     # # planner = DStar(start, goal, env)
     # # planner = LPAStar(start, goal, env)
     # planner = DStarLite(start, goal, env)
+    # planner = CppAStar(start, goal, env)
 
     # # animation
     # planner.run()
@@ -46,6 +50,7 @@ if __name__ == '__main__':
     # planner = RRTConnect(start, goal, env, max_dist=0.5, sample_num=10000)
     planner = RRTStar(start, goal, env, max_dist=0.5, r=20, sample_num=10000)
     # planner = InformedRRT(start, goal, env, max_dist=0.5, r=12, sample_num=1500)
+    # planner = CppRRTStar(start, goal, env, max_dist=0.5, r=20, sample_num=10000)
 
     # animation
     planner.run()
\ No newline at end of file
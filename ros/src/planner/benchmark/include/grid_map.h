@@ -0,0 +1,100 @@
+/***********************************************************
+ *
+ * @file: grid_map.h
+ * @breif: Contains the ROS-free static costmap used by the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef GRID_MAP_H
+#define GRID_MAP_H
+
+#include <string>
+#include <vector>
+
+namespace benchmark {
+// costmap_2d cost values
+#define COST_LETHAL         254
+#define COST_INSCRIBED      253
+#define COST_FREE           0
+
+/**
+ * @brief Static costmap loaded from a map_server style YAML/PGM pair, with costmap_2d style
+ *        inflation and an exact Euclidean distance field for clearance queries
+ */
+class GridMap {
+    public:
+        GridMap();
+        ~GridMap() = default;
+
+        /**
+         * @brief  load a map_server style map
+         * @param  yaml_file    map YAML file, the image path is relative to it
+         * @param  error        error message if loading fails
+         * @return true if the map was loaded
+         */
+        bool load(const std::string& yaml_file, std::string& error);
+        /**
+         * @brief  inflate the obstacles the way costmap_2d::InflationLayer does
+         * @param  inscribed_radius     robot inscribed radius
+         * @param  inflation_radius     inflation radius
+         * @param  cost_scaling_factor  exponential decay rate of the cost
+         */
+        void inflate(double inscribed_radius, double inflation_radius, double cost_scaling_factor);
+
+        /**
+         * @brief  transform from world(x, y) to map(x, y)
+         * @return true if inside the map
+         */
+        bool worldToMap(double wx, double wy, int& mx, int& my) const;
+        /**
+         * @brief  transform from map(x, y) to world(x, y), cell center
+         */
+        void mapToWorld(int mx, int my, double& wx, double& wy) const;
+        /**
+         * @brief  whether map(x, y) is an obstacle (unknown cells and cells outside the map included)
+         */
+        bool isObstacle(int mx, int my) const;
+        /**
+         * @brief  distance to the closest obstacle cell, 0 inside obstacles and outside the map
+         * @param  wx   world x
+         * @param  wy   world y
+         * @return distance in meters
+         */
+        double distance(double wx, double wy) const;
+
+        int nx() const { return this->nx_; }
+        int ny() const { return this->ny_; }
+        double resolution() const { return this->resolution_; }
+        double originX() const { return this->origin_x_; }
+        double originY() const { return this->origin_y_; }
+        // inflated costs, row-major with y = 0 at the map origin as in costmap_2d
+        const unsigned char* costs() const { return this->costs_.data(); }
+
+    protected:
+        /**
+         * @brief  read a binary (P5) or ASCII (P2) PGM image
+         */
+        bool _loadPGM(const std::string& file, std::vector<unsigned char>& pixels, int& width, int& height,
+                      std::string& error);
+        /**
+         * @brief  exact squared Euclidean distance transform (Felzenszwalb & Huttenlocher) in cells
+         */
+        void _distanceTransform();
+
+    protected:
+        int nx_, ny_;
+        double resolution_, origin_x_, origin_y_;
+        // obstacle mask, unknown cells are obstacles
+        std::vector<unsigned char> obstacle_;
+        // distance to the closest obstacle cell in cells
+        std::vector<float> dist_;
+        std::vector<unsigned char> costs_;
+};
+}
+#endif  // GRID_MAP_H
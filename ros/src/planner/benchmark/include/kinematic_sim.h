@@ -0,0 +1,111 @@
+/***********************************************************
+ *
+ * @file: kinematic_sim.h
+ * @breif: Contains the unicycle / differential drive kinematic simulator
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef KINEMATIC_SIM_H
+#define KINEMATIC_SIM_H
+
+#include <vector>
+
+#include "grid_map.h"
+
+namespace benchmark {
+/**
+ * @brief 2D pose
+ */
+struct Pose2D {
+    double x, y, theta;
+};
+
+/**
+ * @brief Simulated robot state, velocities in robot frame
+ */
+struct RobotState {
+    double x, y, theta;
+    double v, w;
+};
+
+/**
+ * @brief Simulator parameters, defaults match turtlebot3_waffle in sim_env
+ */
+struct SimParams {
+    // control period
+    double dt = 0.1;
+    // integration sub-steps per control period
+    int sub_steps = 10;
+    // velocity and acceleration limits of the base
+    double max_v = 0.26, max_w = 1.82;
+    double acc_lim_v = 2.5, acc_lim_w = 3.2;
+    // robot footprint polygon in robot frame
+    std::vector<Pose2D> footprint = { { -0.205, -0.155, 0 }, { -0.205, 0.155, 0 }, { 0.077, 0.155, 0 }, { 0.077, -0.155, 0 } };
+};
+
+/**
+ * @brief  sample the edges of a footprint polygon
+ * @param  footprint    polygon in robot frame
+ * @param  step         maximum distance between samples
+ * @return boundary samples in robot frame, the origin for an empty footprint
+ */
+std::vector<Pose2D> footprintSamples(const std::vector<Pose2D>& footprint, double step);
+
+/**
+ * @brief Unicycle kinematic simulator with acceleration limited velocity tracking and footprint
+ *        clearance against a static GridMap
+ */
+class KinematicSim {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  map      static map
+         * @param  params   simulator parameters
+         */
+        KinematicSim(const GridMap& map, const SimParams& params = SimParams());
+        ~KinematicSim() = default;
+
+        /**
+         * @brief  reset the robot state
+         * @param  state    initial state
+         */
+        void reset(const RobotState& state);
+        /**
+         * @brief  apply a velocity command for one control period
+         * @param  v    commanded linear velocity
+         * @param  w    commanded angular velocity
+         */
+        void step(double v, double w);
+        /**
+         * @brief  current robot state
+         */
+        const RobotState& state() const { return this->state_; }
+        /**
+         * @brief  distance between the footprint and the closest obstacle
+         * @return clearance in meters, 0 when in collision
+         */
+        double clearance() const;
+        /**
+         * @brief  whether the footprint overlaps an obstacle cell
+         */
+        bool inCollision() const;
+        /**
+         * @brief  simulator parameters
+         */
+        const SimParams& params() const { return this->params_; }
+
+    protected:
+        const GridMap& map_;
+        SimParams params_;
+        RobotState state_;
+        // footprint boundary samples in robot frame
+        std::vector<Pose2D> samples_;
+};
+}
+#endif  // KINEMATIC_SIM_H
@@ -0,0 +1,129 @@
+/***********************************************************
+ *
+ * @file: local_controllers.h
+ * @breif: Contains the ROS-free local planner adapters driven by the benchmark
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef LOCAL_CONTROLLERS_H
+#define LOCAL_CONTROLLERS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "grid_map.h"
+#include "kinematic_sim.h"
+#include "mpc.h"
+#include "pid_controller.h"
+
+namespace benchmark {
+/**
+ * @brief Abstract local controller with the nav_core::BaseLocalPlanner call pattern, the robot state
+ *        and the static map replace tf, odometry and the local costmap
+ */
+class LocalController {
+    public:
+        virtual ~LocalController() = default;
+
+        /**
+         * @brief  Set the plan that the controller is following
+         * @param  plan global plan in map frame, start first
+         */
+        virtual void setPlan(const std::vector<Pose2D>& plan) = 0;
+        /**
+         * @brief  compute the velocity command
+         * @param  state    robot state
+         * @param  v        linear velocity command
+         * @param  w        angular velocity command
+         * @return true if a valid velocity command was found
+         */
+        virtual bool computeVelocityCommands(const RobotState& state, double& v, double& w) = 0;
+        /**
+         * @brief  Check if the goal pose has been achieved
+         */
+        virtual bool isGoalReached() const = 0;
+};
+
+/**
+ * @brief  create a local controller
+ * @param  name     pid, mpc or dwa
+ * @param  map      static map used as local costmap
+ * @param  sim      simulator parameters, for limits and control period
+ * @return controller, nullptr if the name is unknown
+ */
+std::unique_ptr<LocalController> createController(const std::string& name, const GridMap& map, const SimParams& sim);
+
+/**
+ * @brief PIDPlanner control law: plan walking with p_window and pid_planner::PIDController
+ */
+class PIDAdapter : public LocalController {
+    public:
+        PIDAdapter(const SimParams& sim);
+        void setPlan(const std::vector<Pose2D>& plan) override;
+        bool computeVelocityCommands(const RobotState& state, double& v, double& w) override;
+        bool isGoalReached() const override { return this->goal_reached_; }
+
+    protected:
+        pid_planner::PIDController pid_;
+        std::vector<Pose2D> plan_;
+        int plan_index_;
+        bool goal_reached_;
+        double p_window_, o_window_, p_precision_, o_precision_;
+};
+
+/**
+ * @brief MPCPlanner control law: mpc_planner::MPC on the reference built by mpc_planner::buildReference()
+ */
+class MPCAdapter : public LocalController {
+    public:
+        MPCAdapter(const GridMap& map, const SimParams& sim);
+        void setPlan(const std::vector<Pose2D>& plan) override;
+        bool computeVelocityCommands(const RobotState& state, double& v, double& w) override;
+        bool isGoalReached() const override { return this->goal_reached_; }
+
+    protected:
+        const GridMap& map_;
+        mpc_planner::MPC mpc_;
+        std::vector<mpc_planner::MPCState> plan_, local_plan_;
+        size_t closest_index_;
+        bool goal_reached_;
+        double ref_speed_, obstacle_range_, xy_goal_tolerance_, yaw_goal_tolerance_, k_rotate_;
+        std::vector<std::pair<double, int>> obs_candidates_;
+        std::vector<double> obs_x_, obs_y_;
+};
+
+/**
+ * @brief Dynamic window reference controller with the scoring terms and parameters of
+ *        sim_env/config/planner/dwa_planner_params.yaml. DWAPlanner itself depends on
+ *        base_local_planner and cannot run without ROS.
+ */
+class DWAAdapter : public LocalController {
+    public:
+        DWAAdapter(const GridMap& map, const SimParams& sim);
+        void setPlan(const std::vector<Pose2D>& plan) override;
+        bool computeVelocityCommands(const RobotState& state, double& v, double& w) override;
+        bool isGoalReached() const override { return this->goal_reached_; }
+
+    protected:
+        const GridMap& map_;
+        SimParams sim_;
+        // footprint boundary samples in robot frame
+        std::vector<Pose2D> samples_;
+        std::vector<Pose2D> plan_;
+        size_t closest_index_;
+        bool goal_reached_;
+        double min_vel_x_, max_vel_x_, max_vel_theta_, min_vel_theta_;
+        double sim_time_, sim_granularity_;
+        int vx_samples_, vth_samples_;
+        double path_distance_bias_, goal_distance_bias_, occdist_scale_, forward_point_distance_;
+        double xy_goal_tolerance_, yaw_goal_tolerance_;
+};
+}
+#endif  // LOCAL_CONTROLLERS_H
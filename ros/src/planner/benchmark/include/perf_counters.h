@@ -0,0 +1,61 @@
+/***********************************************************
+ *
+ * @file: perf_counters.h
+ * @breif: Contains the hardware performance counters of the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-19
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+
+namespace benchmark {
+/**
+ * @brief Hardware counters of the calling thread and of the threads it starts while counting, read through
+ *        Linux perf_event_open. Counters the kernel or the CPU do not provide are reported as NaN.
+ */
+class PerfCounters {
+    public:
+        enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, EVENT_NUM };
+        typedef std::array<double, EVENT_NUM> Values;
+
+        /**
+         * @brief  Constructor(no counter opened)
+         */
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        /**
+         * @brief  open the counters of the calling thread, user space only
+         * @return number of counters opened
+         */
+        int open();
+        /**
+         * @brief  reset and start counting
+         */
+        void start();
+        /**
+         * @brief  stop counting
+         * @param  values   counts since start(), scaled when the kernel multiplexed the counters
+         */
+        void stop(Values& values);
+        /**
+         * @brief  short name of an event
+         */
+        static const char* name(Event event);
+
+    private:
+        // counter file descriptors, -1 if not available
+        std::array<int, EVENT_NUM> fd_;
+};
+}
+#endif  // PERF_COUNTERS_H
@@ -0,0 +1,63 @@
+/***********************************************************
+ *
+ * @file: scenario.h
+ * @breif: Contains the deterministic start / goal scenarios shared by the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <vector>
+
+#include "a_star.h"
+#include "grid_map.h"
+#include "kinematic_sim.h"
+
+namespace benchmark {
+/**
+ * @brief Start / goal query with its A* global plan
+ */
+struct Scenario {
+    // grid coordinates
+    int start_x, start_y, goal_x, goal_y;
+    // global plan in map frame, start first
+    std::vector<Pose2D> plan;
+    double path_length;
+};
+
+/**
+ * @brief  plan with A* on the inflated map and convert the path into map frame poses
+ * @param  planner  A* planner sized for the map
+ * @param  map      inflated map
+ * @param  sx       start grid x
+ * @param  sy       start grid y
+ * @param  gx       goal grid x
+ * @param  gy       goal grid y
+ * @param  plan     plan in map frame, start first, orientation along the path
+ * @param  length   path length
+ * @return true if a path was found
+ */
+bool makePlan(a_star_planner::AStar& planner, const GridMap& map, int sx, int sy, int gx, int gy,
+              std::vector<Pose2D>& plan, double& length);
+
+/**
+ * @brief  sample scenarios from a fixed seed, so every run and every thread count sees the same queries
+ * @param  map              inflated map
+ * @param  num              number of scenarios
+ * @param  seed             random seed
+ * @param  min_dist         minimum straight line distance between start and goal
+ * @param  max_dist         maximum straight line distance between start and goal
+ * @param  min_clearance    minimum obstacle distance of start and goal
+ * @return scenarios with a valid global plan, fewer than num if the map does not allow more
+ */
+std::vector<Scenario> generateScenarios(const GridMap& map, int num, unsigned int seed, double min_dist,
+                                        double max_dist, double min_clearance);
+}
+#endif  // SCENARIO_H
@@ -0,0 +1,35 @@
+/***********************************************************
+ *
+ * @file: statistics.h
+ * @breif: Contains the summary statistics printed by the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <vector>
+
+namespace benchmark {
+/**
+ * @brief  percentile by linear interpolation between closest ranks
+ * @param  values   samples, reordered in place
+ * @param  p        percentile in [0, 100]
+ * @return percentile, NaN if there is no sample
+ */
+double percentile(std::vector<double>& values, double p);
+
+/**
+ * @brief  arithmetic mean
+ * @param  values   samples
+ * @return mean, NaN if there is no sample
+ */
+double mean(const std::vector<double>& values);
+}
+#endif  // STATISTICS_H
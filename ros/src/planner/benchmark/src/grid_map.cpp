@@ -0,0 +1,271 @@
+/***********************************************************
+ *
+ * @file: grid_map.cpp
+ * @breif: Contains the ROS-free static costmap used by the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "grid_map.h"
+
+namespace benchmark {
+GridMap::GridMap() : nx_(0), ny_(0), resolution_(0.05), origin_x_(0.0), origin_y_(0.0) {}
+
+/**
+ * @brief  load a map_server style map
+ * @param  yaml_file    map YAML file, the image path is relative to it
+ * @param  error        error message if loading fails
+ * @return true if the map was loaded
+ */
+bool GridMap::load(const std::string& yaml_file, std::string& error) {
+    std::ifstream in(yaml_file);
+    if (!in) {
+        error = "cannot open " + yaml_file;
+        return false;
+    }
+
+    // flat "key: value" subset of YAML written by map_server
+    std::string image, line;
+    int negate = 0;
+    double occupied_thresh = 0.65, free_thresh = 0.196;
+    while (std::getline(in, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos || line[0] == '#')
+            continue;
+        std::string key = line.substr(0, colon), value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+
+        if (key == "image")
+            image = value;
+        else if (key == "resolution")
+            this->resolution_ = std::stod(value);
+        else if (key == "negate")
+            negate = std::stoi(value);
+        else if (key == "occupied_thresh")
+            occupied_thresh = std::stod(value);
+        else if (key == "free_thresh")
+            free_thresh = std::stod(value);
+        else if (key == "origin") {
+            std::replace(value.begin(), value.end(), '[', ' ');
+            std::replace(value.begin(), value.end(), ']', ' ');
+            std::replace(value.begin(), value.end(), ',', ' ');
+            std::istringstream(value) >> this->origin_x_ >> this->origin_y_;
+        }
+    }
+    if (image.empty()) {
+        error = "no image in " + yaml_file;
+        return false;
+    }
+    if (image[0] != '/') {
+        size_t slash = yaml_file.find_last_of('/');
+        if (slash != std::string::npos)
+            image = yaml_file.substr(0, slash + 1) + image;
+    }
+
+    std::vector<unsigned char> pixels;
+    if (!this->_loadPGM(image, pixels, this->nx_, this->ny_, error))
+        return false;
+
+    // trinary interpretation as map_server does, the image is stored top row first
+    this->obstacle_.assign(this->nx_ * this->ny_, 0);
+    for (int y = 0; y < this->ny_; y++) {
+        for (int x = 0; x < this->nx_; x++) {
+            double p = pixels[(this->ny_ - 1 - y) * this->nx_ + x] / 255.0;
+            double occ = negate ? p : 1.0 - p;
+            // occupied and unknown cells are both untraversable for the benchmark robot
+            bool occupied = occ > occupied_thresh, free = occ < free_thresh;
+            this->obstacle_[y * this->nx_ + x] = (occupied || !free) ? 1 : 0;
+        }
+    }
+
+    this->_distanceTransform();
+    this->inflate(0.0, 0.0, 1.0);
+    return true;
+}
+
+/**
+ * @brief  inflate the obstacles the way costmap_2d::InflationLayer does
+ * @param  inscribed_radius     robot inscribed radius
+ * @param  inflation_radius     inflation radius
+ * @param  cost_scaling_factor  exponential decay rate of the cost
+ */
+void GridMap::inflate(double inscribed_radius, double inflation_radius, double cost_scaling_factor) {
+    this->costs_.assign(this->nx_ * this->ny_, COST_FREE);
+    for (int i = 0; i < this->nx_ * this->ny_; i++) {
+        double d = this->dist_[i] * this->resolution_;
+        if (this->obstacle_[i])
+            this->costs_[i] = COST_LETHAL;
+        else if (d <= inscribed_radius)
+            this->costs_[i] = COST_INSCRIBED;
+        else if (d <= inflation_radius)
+            this->costs_[i] = (unsigned char)((COST_INSCRIBED - 1) * std::exp(-cost_scaling_factor * (d - inscribed_radius)));
+    }
+}
+
+/**
+ * @brief  transform from world(x, y) to map(x, y)
+ * @return true if inside the map
+ */
+bool GridMap::worldToMap(double wx, double wy, int& mx, int& my) const {
+    mx = (int)std::floor((wx - this->origin_x_) / this->resolution_);
+    my = (int)std::floor((wy - this->origin_y_) / this->resolution_);
+    return mx >= 0 && my >= 0 && mx < this->nx_ && my < this->ny_;
+}
+
+/**
+ * @brief  transform from map(x, y) to world(x, y), cell center
+ */
+void GridMap::mapToWorld(int mx, int my, double& wx, double& wy) const {
+    wx = this->origin_x_ + (mx + 0.5) * this->resolution_;
+    wy = this->origin_y_ + (my + 0.5) * this->resolution_;
+}
+
+/**
+ * @brief  whether map(x, y) is an obstacle (unknown cells and cells outside the map included)
+ */
+bool GridMap::isObstacle(int mx, int my) const {
+    if (mx < 0 || my < 0 || mx >= this->nx_ || my >= this->ny_)
+        return true;
+    return this->obstacle_[my * this->nx_ + mx] != 0;
+}
+
+/**
+ * @brief  distance to the closest obstacle cell, 0 inside obstacles and outside the map
+ * @param  wx   world x
+ * @param  wy   world y
+ * @return distance in meters
+ */
+double GridMap::distance(double wx, double wy) const {
+    int mx, my;
+    if (!this->worldToMap(wx, wy, mx, my))
+        return 0.0;
+    return this->dist_[my * this->nx_ + mx] * this->resolution_;
+}
+
+/**
+ * @brief  read a binary (P5) or ASCII (P2) PGM image
+ */
+bool GridMap::_loadPGM(const std::string& file, std::vector<unsigned char>& pixels, int& width, int& height,
+                       std::string& error) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + file;
+        return false;
+    }
+
+    // header tokens, skipping comments
+    auto next_token = [&in]() {
+        std::string token;
+        while (in >> token) {
+            if (token[0] != '#')
+                return token;
+            std::string comment;
+            std::getline(in, comment);
+        }
+        return std::string();
+    };
+
+    std::string magic = next_token();
+    if (magic != "P5" && magic != "P2") {
+        error = file + " is not a PGM image";
+        return false;
+    }
+    width = std::stoi(next_token());
+    height = std::stoi(next_token());
+    int max_val = std::stoi(next_token());
+    if (width <= 0 || height <= 0 || max_val <= 0 || max_val > 255) {
+        error = file + " has an unsupported PGM header";
+        return false;
+    }
+
+    pixels.resize(width * height);
+    if (magic == "P5") {
+        in.get();
+        in.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+        if (in.gcount() != (std::streamsize)pixels.size()) {
+            error = file + " is truncated";
+            return false;
+        }
+    } else {
+        for (auto& p : pixels) {
+            int v;
+            if (!(in >> v)) {
+                error = file + " is truncated";
+                return false;
+            }
+            p = (unsigned char)v;
+        }
+    }
+    if (max_val != 255)
+        for (auto& p : pixels)
+            p = (unsigned char)(p * 255 / max_val);
+
+    return true;
+}
+
+/**
+ * @brief  exact squared Euclidean distance transform (Felzenszwalb & Huttenlocher) in cells
+ */
+void GridMap::_distanceTransform() {
+    const float inf = 1e20f;
+    int n = std::max(this->nx_, this->ny_);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+
+    // 1D lower envelope of parabolas
+    auto transform1d = [&](int len) {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -inf;
+        z[1] = inf;
+        for (int q = 1; q < len; q++) {
+            float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+            while (s <= z[k]) {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = inf;
+        }
+        k = 0;
+        for (int q = 0; q < len; q++) {
+            while (z[k + 1] < q)
+                k++;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    };
+
+    this->dist_.resize(this->nx_ * this->ny_);
+    for (int i = 0; i < this->nx_ * this->ny_; i++)
+        this->dist_[i] = this->obstacle_[i] ? 0.0f : inf;
+
+    for (int x = 0; x < this->nx_; x++) {
+        for (int y = 0; y < this->ny_; y++)
+            f[y] = this->dist_[y * this->nx_ + x];
+        transform1d(this->ny_);
+        for (int y = 0; y < this->ny_; y++)
+            this->dist_[y * this->nx_ + x] = d[y];
+    }
+    for (int y = 0; y < this->ny_; y++) {
+        for (int x = 0; x < this->nx_; x++)
+            f[x] = this->dist_[y * this->nx_ + x];
+        transform1d(this->nx_);
+        for (int x = 0; x < this->nx_; x++)
+            this->dist_[y * this->nx_ + x] = std::sqrt(d[x]);
+    }
+}
+}
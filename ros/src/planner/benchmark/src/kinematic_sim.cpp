@@ -0,0 +1,117 @@
+/***********************************************************
+ *
+ * @file: kinematic_sim.cpp
+ * @breif: Contains the unicycle / differential drive kinematic simulator
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "kinematic_sim.h"
+
+namespace benchmark {
+/**
+ * @brief  sample the edges of a footprint polygon
+ * @param  footprint    polygon in robot frame
+ * @param  step         maximum distance between samples
+ * @return boundary samples in robot frame, the origin for an empty footprint
+ */
+std::vector<Pose2D> footprintSamples(const std::vector<Pose2D>& footprint, double step) {
+    std::vector<Pose2D> samples;
+    for (size_t i = 0; i < footprint.size(); i++) {
+        const Pose2D& a = footprint[i];
+        const Pose2D& b = footprint[(i + 1) % footprint.size()];
+        int n = std::max(1, (int)std::ceil(std::hypot(b.x - a.x, b.y - a.y) / step));
+        for (int j = 0; j < n; j++)
+            samples.push_back({ a.x + (b.x - a.x) * j / n, a.y + (b.y - a.y) * j / n, 0.0 });
+    }
+    if (samples.empty())
+        samples.push_back({ 0.0, 0.0, 0.0 });
+    return samples;
+}
+
+/**
+ * @brief  Constructor
+ * @param  map      static map
+ * @param  params   simulator parameters
+ */
+KinematicSim::KinematicSim(const GridMap& map, const SimParams& params) : map_(map), params_(params) {
+    this->state_ = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    // sample the footprint boundary at half the map resolution
+    this->samples_ = footprintSamples(this->params_.footprint, 0.5 * this->map_.resolution());
+}
+
+/**
+ * @brief  reset the robot state
+ * @param  state    initial state
+ */
+void KinematicSim::reset(const RobotState& state) {
+    this->state_ = state;
+}
+
+/**
+ * @brief  apply a velocity command for one control period
+ * @param  v    commanded linear velocity
+ * @param  w    commanded angular velocity
+ */
+void KinematicSim::step(double v, double w) {
+    const SimParams& p = this->params_;
+    v = std::min(std::max(v, -p.max_v), p.max_v);
+    w = std::min(std::max(w, -p.max_w), p.max_w);
+
+    // the base tracks the command under acceleration limits
+    double h = p.dt / p.sub_steps;
+    for (int i = 0; i < p.sub_steps; i++) {
+        double dv = std::min(std::max(v - this->state_.v, -p.acc_lim_v * h), p.acc_lim_v * h);
+        double dw = std::min(std::max(w - this->state_.w, -p.acc_lim_w * h), p.acc_lim_w * h);
+        this->state_.v += dv;
+        this->state_.w += dw;
+
+        // exact unicycle integration for constant velocities over the sub-step
+        double theta = this->state_.theta, d_theta = this->state_.w * h;
+        if (std::fabs(this->state_.w) > 1e-9) {
+            double r = this->state_.v / this->state_.w;
+            this->state_.x += r * (std::sin(theta + d_theta) - std::sin(theta));
+            this->state_.y -= r * (std::cos(theta + d_theta) - std::cos(theta));
+        } else {
+            this->state_.x += this->state_.v * std::cos(theta) * h;
+            this->state_.y += this->state_.v * std::sin(theta) * h;
+        }
+        this->state_.theta = std::atan2(std::sin(theta + d_theta), std::cos(theta + d_theta));
+    }
+}
+
+/**
+ * @brief  distance between the footprint and the closest obstacle
+ * @return clearance in meters, 0 when in collision
+ */
+double KinematicSim::clearance() const {
+    double c = std::cos(this->state_.theta), s = std::sin(this->state_.theta);
+    double d_min = std::numeric_limits<double>::max();
+    for (const auto& p : this->samples_)
+        d_min = std::min(d_min, this->map_.distance(this->state_.x + c * p.x - s * p.y, this->state_.y + s * p.x + c * p.y));
+    return d_min;
+}
+
+/**
+ * @brief  whether the footprint overlaps an obstacle cell
+ */
+bool KinematicSim::inCollision() const {
+    double c = std::cos(this->state_.theta), s = std::sin(this->state_.theta);
+    for (const auto& p : this->samples_) {
+        int mx, my;
+        this->map_.worldToMap(this->state_.x + c * p.x - s * p.y, this->state_.y + s * p.x + c * p.y, mx, my);
+        if (this->map_.isObstacle(mx, my))
+            return true;
+    }
+    return false;
+}
+}
@@ -0,0 +1,337 @@
+/***********************************************************
+ *
+ * @file: local_controllers.cpp
+ * @breif: Contains the ROS-free local planner adapters driven by the benchmark
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "local_controllers.h"
+
+namespace benchmark {
+/**
+ * @brief  normalize angle to [-pi, pi]
+ */
+static inline double normalizeAngle(double a) {
+    return std::atan2(std::sin(a), std::cos(a));
+}
+
+/**
+ * @brief  create a local controller
+ * @param  name     pid, mpc or dwa
+ * @param  map      static map used as local costmap
+ * @param  sim      simulator parameters, for limits and control period
+ * @return controller, nullptr if the name is unknown
+ */
+std::unique_ptr<LocalController> createController(const std::string& name, const GridMap& map, const SimParams& sim) {
+    if (name == "pid")
+        return std::unique_ptr<LocalController>(new PIDAdapter(sim));
+    if (name == "mpc")
+        return std::unique_ptr<LocalController>(new MPCAdapter(map, sim));
+    if (name == "dwa")
+        return std::unique_ptr<LocalController>(new DWAAdapter(map, sim));
+    return nullptr;
+}
+
+/******************************** PID ****************************************/
+PIDAdapter::PIDAdapter(const SimParams& sim) : plan_index_(0), goal_reached_(false) {
+    // PIDPlanner::initialize()
+    this->p_window_ = 0.1;
+    this->o_window_ = 3.14;
+    this->p_precision_ = 0.5;
+    this->o_precision_ = 0.2;
+
+    pid_planner::PIDParams params;
+    params.d_t = sim.dt;
+    this->pid_.setParams(params);
+}
+
+void PIDAdapter::setPlan(const std::vector<Pose2D>& plan) {
+    this->plan_ = plan;
+    this->plan_index_ = 0;
+    this->goal_reached_ = false;
+}
+
+bool PIDAdapter::computeVelocityCommands(const RobotState& state, double& v, double& w) {
+    v = w = 0.0;
+    if (this->plan_.empty())
+        return false;
+    if (this->goal_reached_)
+        return true;
+
+    int size = (int)this->plan_.size();
+    double c = std::cos(state.theta), s = std::sin(state.theta);
+    auto to_robot = [&](const Pose2D& p, double& x, double& y) {
+        double dx = p.x - state.x, dy = p.y - state.y;
+        x = c * dx + s * dy;
+        y = -s * dx + c * dy;
+    };
+
+    // next target, same plan walking as PIDPlanner::computeVelocityCommands()
+    double t_x = 0.0, t_y = 0.0, t_th_w = 0.0;
+    while (this->plan_index_ < size) {
+        int next = std::min(size - 1, this->plan_index_ + 1);
+        const Pose2D& target = this->plan_[this->plan_index_];
+        t_th_w = std::atan2(this->plan_[next].y - target.y, this->plan_[next].x - target.x);
+        to_robot(target, t_x, t_y);
+        double t_th = normalizeAngle(t_th_w - state.theta);
+        if (std::hypot(t_x, t_y) > this->p_window_ || std::fabs(t_th) > this->o_window_)
+            break;
+        this->plan_index_++;
+    }
+    if (this->plan_index_ >= size - 1)
+        to_robot(this->plan_.back(), t_x, t_y);
+
+    double final_orientation = this->plan_.back().theta;
+    if (std::hypot(this->plan_.back().x - state.x, this->plan_.back().y - state.y) <= this->p_precision_) {
+        if (std::fabs(final_orientation - state.theta) <= this->o_precision_)
+            this->goal_reached_ = true;
+        else
+            w = this->pid_.angular(state.w, final_orientation, state.theta);
+    } else {
+        v = this->pid_.linear(std::fabs(state.v), t_x, t_y);
+        if (this->plan_index_ >= size - 5)
+            t_th_w = final_orientation;
+        w = this->pid_.angular(state.w, t_th_w, state.theta);
+    }
+    return true;
+}
+
+/******************************** MPC ****************************************/
+MPCAdapter::MPCAdapter(const GridMap& map, const SimParams& sim) : map_(map), closest_index_(0), goal_reached_(false) {
+    // MPCPlanner::initialize() defaults, see sim_env/config/planner/mpc_planner_params.yaml
+    mpc_planner::MPCParams params;
+    params.dt = sim.dt;
+    params.max_v = sim.max_v;
+    params.max_w = sim.max_w;
+    params.min_w = -sim.max_w;
+    params.acc_lim_v = sim.acc_lim_v;
+    params.acc_lim_w = sim.acc_lim_w;
+    this->mpc_.setParams(params);
+
+    this->ref_speed_ = params.max_v;
+    this->obstacle_range_ = 0.8;
+    this->xy_goal_tolerance_ = 0.1;
+    this->yaw_goal_tolerance_ = 0.17;
+    this->k_rotate_ = 2.0;
+
+    int window = 2 * (int)std::ceil(this->obstacle_range_ / map.resolution()) + 1;
+    this->obs_candidates_.reserve(window * window);
+    this->obs_x_.reserve(MPC_MAX_OBSTACLES);
+    this->obs_y_.reserve(MPC_MAX_OBSTACLES);
+}
+
+void MPCAdapter::setPlan(const std::vector<Pose2D>& plan) {
+    // same warm start policy as MPCPlanner::setPlan()
+    if (this->plan_.empty() || plan.empty() ||
+        std::hypot(plan.back().x - this->plan_.back().x, plan.back().y - this->plan_.back().y) > 1e-3) {
+        this->mpc_.reset();
+        this->goal_reached_ = false;
+    }
+
+    this->plan_.clear();
+    for (const auto& p : plan)
+        this->plan_.push_back({ p.x, p.y, p.theta });
+    this->local_plan_.reserve(this->plan_.size());
+    this->closest_index_ = 0;
+}
+
+bool MPCAdapter::computeVelocityCommands(const RobotState& state, double& v, double& w) {
+    v = w = 0.0;
+    if (this->plan_.empty())
+        return false;
+
+    mpc_planner::MPCState x0 = { state.x, state.y, state.theta };
+    const mpc_planner::MPCParams& p = this->mpc_.getParams();
+    const mpc_planner::MPCState& goal = this->plan_.back();
+
+    if (std::hypot(goal.x - x0.x, goal.y - x0.y) <= this->xy_goal_tolerance_) {
+        double e_theta = normalizeAngle(goal.theta - x0.theta);
+        if (std::fabs(e_theta) <= this->yaw_goal_tolerance_)
+            this->goal_reached_ = true;
+        else
+            w = std::min(std::max(this->k_rotate_ * e_theta, p.min_w), p.max_w);
+        return true;
+    }
+
+    // part of the plan within reach of the horizon, as MPCPlanner::_transformPlan()
+    double lookahead = 2.0 * this->ref_speed_ * p.dt * MPC_HORIZON + this->obstacle_range_, length = 0.0;
+    this->local_plan_.clear();
+    for (size_t i = this->closest_index_; i < this->plan_.size(); i++) {
+        this->local_plan_.push_back(this->plan_[i]);
+        if (i > this->closest_index_)
+            length += std::hypot(this->plan_[i].x - this->plan_[i - 1].x, this->plan_[i].y - this->plan_[i - 1].y);
+        if (length > lookahead)
+            break;
+    }
+    bool at_goal = this->closest_index_ + this->local_plan_.size() == this->plan_.size();
+
+    mpc_planner::MPC::Trajectory ref;
+    this->closest_index_ += mpc_planner::buildReference(this->local_plan_, at_goal, x0, this->ref_speed_ * p.dt, ref);
+    this->mpc_.setReference(ref);
+
+    // closest obstacle cells, as MPCPlanner::_collectObstacles()
+    int cx, cy;
+    this->map_.worldToMap(x0.x, x0.y, cx, cy);
+    int r = (int)std::ceil(this->obstacle_range_ / this->map_.resolution());
+    this->obs_candidates_.clear();
+    for (int y = std::max(0, cy - r); y <= std::min(this->map_.ny() - 1, cy + r); y++)
+        for (int x = std::max(0, cx - r); x <= std::min(this->map_.nx() - 1, cx + r); x++)
+            if (this->map_.isObstacle(x, y))
+                this->obs_candidates_.emplace_back((x - cx) * (x - cx) + (y - cy) * (y - cy), y * this->map_.nx() + x);
+    if (this->obs_candidates_.size() > MPC_MAX_OBSTACLES)
+        std::nth_element(this->obs_candidates_.begin(), this->obs_candidates_.begin() + MPC_MAX_OBSTACLES,
+                         this->obs_candidates_.end());
+    this->obs_x_.clear();
+    this->obs_y_.clear();
+    for (size_t i = 0; i < std::min(this->obs_candidates_.size(), (size_t)MPC_MAX_OBSTACLES); i++) {
+        double wx, wy;
+        int idx = this->obs_candidates_[i].second;
+        this->map_.mapToWorld(idx % this->map_.nx(), idx / this->map_.nx(), wx, wy);
+        this->obs_x_.push_back(wx);
+        this->obs_y_.push_back(wy);
+    }
+    this->mpc_.setObstacles(this->obs_x_.data(), this->obs_y_.data(), (int)this->obs_x_.size());
+
+    this->mpc_.solve(x0, state.v, state.w, v, w);
+    return true;
+}
+
+/******************************** DWA ****************************************/
+DWAAdapter::DWAAdapter(const GridMap& map, const SimParams& sim)
+    : map_(map), sim_(sim), closest_index_(0), goal_reached_(false) {
+    // sim_env/config/planner/dwa_planner_params.yaml
+    this->max_vel_x_ = 0.26;
+    this->min_vel_x_ = -0.26;
+    this->max_vel_theta_ = 1.82;
+    this->min_vel_theta_ = 0.9;
+    this->sim_time_ = 2.0;
+    this->sim_granularity_ = 0.1;
+    this->vx_samples_ = 20;
+    this->vth_samples_ = 40;
+    this->path_distance_bias_ = 32.0;
+    this->goal_distance_bias_ = 20.0;
+    this->occdist_scale_ = 0.02;
+    this->forward_point_distance_ = 0.325;
+    this->xy_goal_tolerance_ = 0.05;
+    this->yaw_goal_tolerance_ = 0.17;
+
+    // footprint padded by one cell, the rollout is checked at discrete poses only
+    std::vector<Pose2D> padded = sim.footprint;
+    for (auto& p : padded) {
+        p.x += std::copysign(map.resolution(), p.x);
+        p.y += std::copysign(map.resolution(), p.y);
+    }
+    this->samples_ = footprintSamples(padded, 0.5 * map.resolution());
+}
+
+void DWAAdapter::setPlan(const std::vector<Pose2D>& plan) {
+    this->plan_ = plan;
+    this->closest_index_ = 0;
+    this->goal_reached_ = false;
+}
+
+bool DWAAdapter::computeVelocityCommands(const RobotState& state, double& v, double& w) {
+    v = w = 0.0;
+    if (this->plan_.empty())
+        return false;
+
+    const Pose2D& goal = this->plan_.back();
+    if (std::hypot(goal.x - state.x, goal.y - state.y) <= this->xy_goal_tolerance_) {
+        // stop, then rotate in place as the latched stop-rotate controller does
+        double e_theta = normalizeAngle(goal.theta - state.theta);
+        if (std::fabs(e_theta) <= this->yaw_goal_tolerance_)
+            this->goal_reached_ = true;
+        else if (std::fabs(state.v) < 0.01) {
+            double w_cmd = std::min(std::max(e_theta / this->sim_.dt, -this->max_vel_theta_), this->max_vel_theta_);
+            w = std::copysign(std::max(std::fabs(w_cmd), this->min_vel_theta_), e_theta);
+        }
+        return true;
+    }
+
+    // local plan: the part inside the 3 m local costmap window
+    for (size_t i = this->closest_index_, end = std::min(this->plan_.size(), this->closest_index_ + 40); i < end; i++)
+        if (std::hypot(this->plan_[i].x - state.x, this->plan_[i].y - state.y) <
+            std::hypot(this->plan_[this->closest_index_].x - state.x, this->plan_[this->closest_index_].y - state.y))
+            this->closest_index_ = i;
+    size_t local_end = this->closest_index_;
+    while (local_end + 1 < this->plan_.size() &&
+           std::hypot(this->plan_[local_end + 1].x - state.x, this->plan_[local_end + 1].y - state.y) < 1.5)
+        local_end++;
+    const Pose2D& local_goal = this->plan_[local_end];
+    bool use_front = std::hypot(goal.x - state.x, goal.y - state.y) > this->forward_point_distance_;
+
+    // dynamic window
+    double v_lo = std::max(this->min_vel_x_, state.v - this->sim_.acc_lim_v * this->sim_.dt);
+    double v_hi = std::min(this->max_vel_x_, state.v + this->sim_.acc_lim_v * this->sim_.dt);
+    double w_lo = std::max(-this->max_vel_theta_, state.w - this->sim_.acc_lim_w * this->sim_.dt);
+    double w_hi = std::min(this->max_vel_theta_, state.w + this->sim_.acc_lim_w * this->sim_.dt);
+
+    int n_steps = std::max(1, (int)std::ceil(this->sim_time_ / this->sim_granularity_));
+    double best_cost = std::numeric_limits<double>::max();
+    bool found = false;
+
+    for (int i = 0; i < this->vx_samples_; i++) {
+        double vs = this->vx_samples_ > 1 ? v_lo + (v_hi - v_lo) * i / (this->vx_samples_ - 1) : v_hi;
+        for (int j = 0; j < this->vth_samples_; j++) {
+            double ws = this->vth_samples_ > 1 ? w_lo + (w_hi - w_lo) * j / (this->vth_samples_ - 1) : 0.0;
+
+            double x = state.x, y = state.y, th = state.theta, occ_cost = 0.0;
+            bool valid = true;
+            for (int k = 0; k < n_steps && valid; k++) {
+                x += vs * std::cos(th) * this->sim_granularity_;
+                y += vs * std::sin(th) * this->sim_granularity_;
+                th += ws * this->sim_granularity_;
+
+                // footprint cost as base_local_planner::CostmapModel: lethal cells invalidate the
+                // trajectory, otherwise the highest cost under the footprint boundary is scored
+                double c = std::cos(th), s = std::sin(th);
+                int mx, my;
+                for (const auto& p : this->samples_) {
+                    if (!this->map_.worldToMap(x + c * p.x - s * p.y, y + s * p.x + c * p.y, mx, my) ||
+                        this->map_.isObstacle(mx, my)) {
+                        valid = false;
+                        break;
+                    }
+                    occ_cost = std::max(occ_cost, (double)this->map_.costs()[my * this->map_.nx() + mx]);
+                }
+            }
+            if (!valid)
+                continue;
+
+            // path and goal costs of the trajectory end point, alignment and goal front costs of the point
+            // forward_point_distance ahead of it, the latter are disabled close to the goal as in DWAPlanner
+            double fx = x + this->forward_point_distance_ * std::cos(th);
+            double fy = y + this->forward_point_distance_ * std::sin(th);
+            double path_dist = std::numeric_limits<double>::max(), align_dist = path_dist;
+            for (size_t k = this->closest_index_; k <= local_end; k++) {
+                path_dist = std::min(path_dist, std::hypot(this->plan_[k].x - x, this->plan_[k].y - y));
+                align_dist = std::min(align_dist, std::hypot(this->plan_[k].x - fx, this->plan_[k].y - fy));
+            }
+            double goal_dist = std::hypot(local_goal.x - x, local_goal.y - y);
+            double cost = this->path_distance_bias_ * path_dist + this->goal_distance_bias_ * goal_dist +
+                          this->occdist_scale_ * occ_cost;
+            if (use_front)
+                cost += this->path_distance_bias_ * align_dist +
+                        this->goal_distance_bias_ * std::hypot(local_goal.x - fx, local_goal.y - fy);
+            if (cost < best_cost) {
+                best_cost = cost;
+                v = vs;
+                w = ws;
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+}
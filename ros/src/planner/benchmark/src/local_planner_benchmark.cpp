@@ -0,0 +1,225 @@
+/***********************************************************
+ *
+ * @file: local_planner_benchmark.cpp
+ * @breif: Headless closed-loop benchmark of the local planners
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "grid_map.h"
+#include "kinematic_sim.h"
+#include "local_controllers.h"
+#include "scenario.h"
+#include "statistics.h"
+
+using namespace benchmark;
+
+/**
+ * @brief Outcome of one closed-loop episode
+ */
+struct EpisodeResult {
+    enum Status { SUCCESS, COLLISION, TIMEOUT } status;
+    double time_to_goal;
+    double min_clearance;
+    double goal_error;
+    // controller wall time of every cycle in seconds
+    std::vector<double> latency;
+};
+
+/**
+ * @brief  run one episode: the controller closes the loop over the kinematic simulator
+ * @param  name     controller name
+ * @param  map      static map
+ * @param  sim_params   simulator parameters
+ * @param  sc       scenario
+ * @param  replan_frequency global replanning frequency as move_base planner_frequency, 0 to keep the first plan
+ * @return episode result
+ */
+static EpisodeResult runEpisode(const std::string& name, const GridMap& map, const SimParams& sim_params,
+                                const Scenario& sc, double replan_frequency) {
+    EpisodeResult res;
+    res.status = EpisodeResult::TIMEOUT;
+    res.time_to_goal = std::numeric_limits<double>::quiet_NaN();
+    res.min_clearance = std::numeric_limits<double>::max();
+
+    std::unique_ptr<LocalController> controller = createController(name, map, sim_params);
+    KinematicSim sim(map, sim_params);
+    sim.reset({ sc.plan.front().x, sc.plan.front().y, sc.plan.front().theta, 0.0, 0.0 });
+    controller->setPlan(sc.plan);
+
+    // A* is deterministic, so replanning from the robot cell keeps episodes repeatable
+    a_star_planner::AStar planner(map.nx(), map.ny(), map.resolution());
+    int replan_steps = 0;
+    if (replan_frequency > 0.0)
+        replan_steps = std::max(1, (int)std::lround(1.0 / (replan_frequency * sim_params.dt)));
+    std::vector<Pose2D> plan;
+    double plan_length;
+
+    double timeout = 30.0 + 2.0 * sc.path_length / sim_params.max_v;
+    int max_steps = (int)std::ceil(timeout / sim_params.dt);
+    res.latency.reserve(max_steps);
+
+    for (int step = 0; step < max_steps; step++) {
+        int mx, my;
+        if (replan_steps && step && step % replan_steps == 0 && map.worldToMap(sim.state().x, sim.state().y, mx, my) &&
+            makePlan(planner, map, mx, my, sc.goal_x, sc.goal_y, plan, plan_length)) {
+            // keep the goal pose of the scenario
+            plan.back() = sc.plan.back();
+            controller->setPlan(plan);
+        }
+
+        double v, w;
+        auto t0 = std::chrono::steady_clock::now();
+        bool valid = controller->computeVelocityCommands(sim.state(), v, w);
+        res.latency.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+
+        if (controller->isGoalReached()) {
+            res.status = EpisodeResult::SUCCESS;
+            res.time_to_goal = step * sim_params.dt;
+            break;
+        }
+        // move_base would stop the base and start recovery
+        if (!valid)
+            v = w = 0.0;
+
+        sim.step(v, w);
+        res.min_clearance = std::min(res.min_clearance, sim.clearance());
+        if (sim.inCollision()) {
+            res.status = EpisodeResult::COLLISION;
+            res.min_clearance = 0.0;
+            break;
+        }
+    }
+
+    res.goal_error = std::hypot(sim.state().x - sc.plan.back().x, sim.state().y - sc.plan.back().y);
+    return res;
+}
+
+static void printUsage(const char* prog) {
+    std::printf("Usage: %s [options]\n"
+                "  --map <yaml>           map_server map (default: sim_env warehouse)\n"
+                "  --controllers <list>   comma separated, pid,mpc,dwa (default: all)\n"
+                "  --episodes <n>         episodes per controller (default: 32)\n"
+                "  --threads <n>          worker threads (default: hardware concurrency)\n"
+                "  --replan-frequency <hz> global replanning, 0 to follow the first plan (default: 5)\n"
+                "  --seed <n>             scenario seed (default: 1)\n",
+                prog);
+}
+
+int main(int argc, char** argv) {
+    std::string map_file = BENCHMARK_MAP_FILE;
+    std::string controllers = "pid,mpc,dwa";
+    int episodes = 32;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int seed = 1;
+    double replan_frequency = 5.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--map" && has_value)
+            map_file = argv[++i];
+        else if (arg == "--controllers" && has_value)
+            controllers = argv[++i];
+        else if (arg == "--episodes" && has_value)
+            episodes = std::atoi(argv[++i]);
+        else if (arg == "--threads" && has_value)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--replan-frequency" && has_value)
+            replan_frequency = std::atof(argv[++i]);
+        else if (arg == "--seed" && has_value)
+            seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    // map and inflation as configured for turtlebot3_waffle in sim_env
+    GridMap map;
+    std::string error;
+    if (!map.load(map_file, error)) {
+        std::fprintf(stderr, "Failed to load map: %s\n", error.c_str());
+        return 1;
+    }
+    map.inflate(0.077, 1.0, 3.0);
+
+    SimParams sim_params;
+    std::vector<Scenario> scenarios = generateScenarios(map, episodes, seed, 4.0, 12.0, 0.4);
+    if (scenarios.empty()) {
+        std::fprintf(stderr, "No scenario with a valid global plan in %s\n", map_file.c_str());
+        return 1;
+    }
+    std::printf("map: %s (%dx%d, %.3f m), episodes: %zu, threads: %d, seed: %u, replan: %.1f Hz\n\n",
+                map_file.c_str(), map.nx(), map.ny(), map.resolution(), scenarios.size(), threads, seed,
+                replan_frequency);
+
+    std::printf("%-6s %7s %5s %7s | %8s %8s %8s %8s | %9s %9s | %9s %9s | %8s\n", "ctrl", "success", "coll", "timeout",
+                "lat_p50", "lat_p90", "lat_p99", "lat_max", "ttg_mean", "ttg_p90", "clr_min", "clr_mean", "goal_err");
+    std::printf("%-6s %7s %5s %7s | %8s %8s %8s %8s | %9s %9s | %9s %9s | %8s\n", "", "", "", "", "(ms)", "(ms)", "(ms)",
+                "(ms)", "(s)", "(s)", "(m)", "(m)", "(m)");
+
+    std::stringstream names(controllers);
+    std::string name;
+    int exit_code = 0;
+    while (std::getline(names, name, ',')) {
+        if (!createController(name, map, sim_params)) {
+            std::fprintf(stderr, "Unknown controller: %s\n", name.c_str());
+            exit_code = 1;
+            continue;
+        }
+
+        // episodes are independent, results are stored by index so output does not depend on scheduling
+        std::vector<EpisodeResult> results(scenarios.size());
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < std::min(threads, (int)scenarios.size()); t++) {
+            workers.emplace_back([&]() {
+                for (size_t i = next++; i < scenarios.size(); i = next++)
+                    results[i] = runEpisode(name, map, sim_params, scenarios[i], replan_frequency);
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+
+        int success = 0, collision = 0, timeout = 0;
+        std::vector<double> latency, time_to_goal, clearance, goal_error;
+        for (const auto& res : results) {
+            success += res.status == EpisodeResult::SUCCESS;
+            collision += res.status == EpisodeResult::COLLISION;
+            timeout += res.status == EpisodeResult::TIMEOUT;
+            for (double l : res.latency)
+                latency.push_back(l * 1000.0);
+            if (res.status == EpisodeResult::SUCCESS)
+                time_to_goal.push_back(res.time_to_goal);
+            clearance.push_back(res.min_clearance);
+            goal_error.push_back(res.goal_error);
+        }
+
+        std::printf("%-6s %7d %5d %7d | %8.3f %8.3f %8.3f %8.3f | %9.2f %9.2f | %9.3f %9.3f | %8.3f\n", name.c_str(),
+                    success, collision, timeout, percentile(latency, 50), percentile(latency, 90),
+                    percentile(latency, 99), percentile(latency, 100), mean(time_to_goal),
+                    percentile(time_to_goal, 90), *std::min_element(clearance.begin(), clearance.end()),
+                    mean(clearance), mean(goal_error));
+    }
+
+    return exit_code;
+}
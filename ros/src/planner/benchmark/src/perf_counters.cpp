@@ -0,0 +1,151 @@
+/***********************************************************
+ *
+ * @file: perf_counters.cpp
+ * @breif: Contains the hardware performance counters of the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-19
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perf_counters.h"
+
+namespace benchmark {
+#ifdef __linux__
+namespace {
+/**
+ * @brief  set the perf event type and config of a counter
+ */
+void eventConfig(PerfCounters::Event event, perf_event_attr& attr) {
+    auto cache = [](uint64_t id, uint64_t op, uint64_t result) { return id | (op << 8) | (result << 16); };
+    switch (event) {
+        case PerfCounters::CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfCounters::INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfCounters::L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case PerfCounters::LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfCounters::BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+    }
+}
+}
+#endif
+
+/**
+ * @brief  Constructor(no counter opened)
+ */
+PerfCounters::PerfCounters() { this->fd_.fill(-1); }
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : this->fd_)
+        if (fd >= 0)
+            ::close(fd);
+#endif
+}
+
+/**
+ * @brief  open the counters of the calling thread, user space only
+ * @return number of counters opened
+ */
+int PerfCounters::open() {
+    int opened = 0;
+#ifdef __linux__
+    for (int i = 0; i < EVENT_NUM; i++) {
+        if (this->fd_[i] >= 0) {
+            opened++;
+            continue;
+        }
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        eventConfig((Event)i, attr);
+        attr.disabled = 1;
+        // threads started while counting, e.g. the portfolio backends, are added when they exit
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        this->fd_[i] = (int)::syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        opened += this->fd_[i] >= 0;
+    }
+#endif
+    return opened;
+}
+
+/**
+ * @brief  reset and start counting
+ */
+void PerfCounters::start() {
+#ifdef __linux__
+    for (int fd : this->fd_) {
+        if (fd >= 0) {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief  stop counting
+ * @param  values   counts since start(), scaled when the kernel multiplexed the counters
+ */
+void PerfCounters::stop(Values& values) {
+    values.fill(std::numeric_limits<double>::quiet_NaN());
+#ifdef __linux__
+    for (int fd : this->fd_)
+        if (fd >= 0)
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    for (int i = 0; i < EVENT_NUM; i++) {
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (this->fd_[i] < 0 || ::read(this->fd_[i], data, sizeof(data)) != (ssize_t)sizeof(data))
+            continue;
+        if (data[2] > 0)
+            values[i] = (double)data[0] * ((double)data[1] / data[2]);
+        else if (data[1] == 0)
+            values[i] = 0.0;
+    }
+#endif
+}
+
+/**
+ * @brief  short name of an event
+ */
+const char* PerfCounters::name(Event event) {
+    static const char* names[EVENT_NUM] = { "cycles", "instructions", "L1D", "LLC", "branch", "dTLB" };
+    return event >= 0 && event < EVENT_NUM ? names[event] : "";
+}
+}
@@ -0,0 +1,283 @@
+/***********************************************************
+ *
+ * @file: plan_replay.cpp
+ * @breif: Replays a planning request log through the global planners
+ * @author: Yang Haodong
+ * @update: 2023-2-17
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "a_star.h"
+#include "compressed_path_database.h"
+#include "contraction_hierarchy.h"
+#include "jump_point_search.h"
+#include "informed_rrt.h"
+#include "perf_counters.h"
+#include "plan_log.h"
+#include "portfolio_planner.h"
+#include "quadtree_planner.h"
+#include "rrt.h"
+#include "rrt_connect.h"
+#include "rrt_star.h"
+#include "statistics.h"
+#include "subgoal_graph.h"
+
+using namespace benchmark;
+
+/**
+ * @brief Replay planner and its measurements over the log
+ */
+struct Backend {
+    std::string name;
+    // planner kept while the geometry does not change, as a workspace of the wrappers
+    std::unique_ptr<global_planner::GlobalPlanner> planner;
+    std::string geometry;
+    int found = 0, compared = 0, mismatches = 0, skipped = 0;
+    // search time of every query in seconds
+    std::vector<double> time;
+    // counter sums and expanded nodes over all queries
+    PerfCounters::Values counters{};
+    double expand_num = 0.0;
+};
+
+/**
+ * @brief  create a planner as the ROS wrappers do for a recorded request
+ * @param  name     planner name
+ * @param  request  recorded request, for the costmap geometry and the planner parameters
+ * @return planner, nullptr if the planner name is unknown
+ */
+static global_planner::GlobalPlanner* createPlanner(const std::string& name, const global_planner::PlanRequest& request) {
+    int nx = request.nx, ny = request.ny;
+    double res = request.resolution;
+    int sample_points = std::atoi(request.param("sample_points", "500").c_str());
+    double sample_max_d = std::atof(request.param("sample_max_d", "5.0").c_str());
+    double opt_r = std::atof(request.param("optimization_r", "10.0").c_str());
+    bool rsr = request.param("symmetry_reduction", "0") == "1";
+
+    global_planner::GlobalPlanner* planner = nullptr;
+    if (name == "a_star")
+        planner = new a_star_planner::AStar(nx, ny, res, false, false, rsr);
+    else if (name == "dijkstra")
+        planner = new a_star_planner::AStar(nx, ny, res, true, false, rsr);
+    else if (name == "gbfs")
+        planner = new a_star_planner::AStar(nx, ny, res, false, true, rsr);
+    else if (name == "jps")
+        planner = new jps_planner::JumpPointSearch(nx, ny, res);
+    else if (name == "subgoal_graph")
+        planner = new subgoal_planner::SubgoalGraph(nx, ny, res);
+    else if (name == "contraction_hierarchy")
+        planner = new ch_planner::ContractionHierarchy(
+            nx, ny, res, std::make_shared<ch_planner::HierarchyCache>(request.param("precompute_dir", "")));
+    else if (name == "cpd")
+        planner = new cpd_planner::CompressedPathDatabase(
+            nx, ny, res, std::make_shared<cpd_planner::DatabaseCache>(request.param("precompute_dir", "")));
+    else if (name == "quadtree")
+        planner = new quadtree_planner::QuadtreePlanner(nx, ny, res);
+    else if (name == "rrt")
+        planner = new rrt_planner::RRT(nx, ny, res, sample_points, sample_max_d);
+    else if (name == "rrt_star")
+        planner = new rrt_planner::RRTStar(nx, ny, res, sample_points, sample_max_d, opt_r);
+    else if (name == "rrt_connect")
+        planner = new rrt_planner::RRTConnect(nx, ny, res, sample_points, sample_max_d);
+    else if (name == "informed_rrt")
+        planner = new rrt_planner::InformedRRT(nx, ny, res, sample_points, sample_max_d, opt_r);
+    else if (name == "portfolio") {
+        global_planner::PortfolioPlanner* portfolio = new global_planner::PortfolioPlanner(
+            nx, ny, res, std::atof(request.param("portfolio_quality_bound", "1.5").c_str()));
+        std::stringstream backends(request.param("portfolio_backends", "a_star,gbfs,jps"));
+        std::string backend;
+        while (std::getline(backends, backend, ','))
+            if (global_planner::GlobalPlanner* p = createPlanner(backend, request))
+                portfolio->addBackend(backend, p);
+        planner = portfolio;
+    }
+    if (planner)
+        planner->setFactor(request.factor);
+    return planner;
+}
+
+static void printUsage(const char* prog) {
+    std::printf("Usage: %s <log> [options]\n"
+                "  --planner <a,b,...>    replay through these planners instead of the recorded one\n"
+                "  --repeat <n>           search every request n times, e.g. under perf (default: 1)\n"
+                "  --perf                 count cycles, instructions and cache, branch and TLB misses\n"
+                "  --verbose              print every request\n",
+                prog);
+}
+
+/**
+ * @brief  ratio of two counts, NaN if the counter is not available
+ */
+static double ratio(double count, double n) { return n > 0.0 ? count / n : std::nan(""); }
+
+int main(int argc, char** argv) {
+    std::string log_file, planner_names;
+    int repeat = 1;
+    bool perf = false, verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--planner" && has_value)
+            planner_names = argv[++i];
+        else if (arg == "--repeat" && has_value)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--perf")
+            perf = true;
+        else if (arg == "--verbose")
+            verbose = true;
+        else if (arg[0] != '-' && log_file.empty())
+            log_file = arg;
+        else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (log_file.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    global_planner::PlanLogReader reader;
+    if (!reader.open(log_file)) {
+        std::fprintf(stderr, "Failed to open planning request log %s\n", log_file.c_str());
+        return 1;
+    }
+
+    // the recorded planner is replayed under an empty name
+    std::vector<Backend> backends;
+    std::stringstream names(planner_names);
+    std::string name;
+    while (std::getline(names, name, ','))
+        if (!name.empty())
+            backends.emplace_back().name = name;
+    if (backends.empty())
+        backends.emplace_back();
+
+    PerfCounters counters;
+    if (perf) {
+        int opened = counters.open();
+        if (opened < PerfCounters::EVENT_NUM)
+            std::fprintf(stderr, "%d of %d hardware counters available, check perf_event_paranoid\n", opened,
+                         (int)PerfCounters::EVENT_NUM);
+    }
+
+    global_planner::PlanRequest request;
+    std::vector<unsigned char> costs;
+    int records = 0;
+    std::vector<double> recorded_time;
+
+    while (reader.next(request, costs)) {
+        records++;
+        recorded_time.push_back(request.plan_time);
+        for (Backend& backend : backends) {
+            std::string name = backend.name.empty() ? request.planner : backend.name;
+            std::ostringstream key;
+            key << name << " " << request.nx << " " << request.ny << " " << request.resolution << " " << request.factor;
+            if (key.str() != backend.geometry) {
+                backend.planner.reset(createPlanner(name, request));
+                backend.geometry = key.str();
+            }
+            if (!backend.planner) {
+                std::fprintf(stderr, "request %d: unknown planner %s, skipped\n", records, name.c_str());
+                backend.skipped++;
+                continue;
+            }
+
+            global_planner::GlobalPlanner* planner = backend.planner.get();
+            Node start(request.start_x, request.start_y, 0, 0, planner->grid2Index(request.start_x, request.start_y), 0);
+            Node goal(request.goal_x, request.goal_y, 0, 0, planner->grid2Index(request.goal_x, request.goal_y), 0);
+            rrt_planner::RRT* sampler = dynamic_cast<rrt_planner::RRT*>(planner);
+
+            bool path_found = false;
+            std::vector<Node> path, expand;
+            PerfCounters::Values values;
+            size_t expand_num = 0;
+            double time = 0.0;
+            for (int r = 0; r < repeat; r++) {
+                if (sampler)
+                    sampler->setSeed(request.seed);
+                expand.clear();
+                if (perf)
+                    counters.start();
+                auto t0 = std::chrono::steady_clock::now();
+                std::tie(path_found, path) = planner->plan(costs.data(), start, goal, expand);
+                time += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                if (perf) {
+                    counters.stop(values);
+                    for (int i = 0; i < PerfCounters::EVENT_NUM; i++)
+                        backend.counters[i] += values[i];
+                }
+                expand_num += expand.size();
+            }
+            backend.time.push_back(time / repeat);
+            backend.expand_num += expand_num;
+            backend.found += path_found;
+
+            // the recorded planner must give the recorded result, except the portfolio whose winner depends on timing
+            bool match = true;
+            if (name == request.planner && name != "portfolio") {
+                backend.compared++;
+                match = path_found == request.found && path.size() == request.path.size();
+                for (size_t i = 0; match && i < path.size(); i++)
+                    match = path[i].x == request.path[i].first && path[i].y == request.path[i].second;
+                backend.mismatches += !match;
+            }
+            if (verbose || !match) {
+                std::printf("request %d: %s (%d, %d) -> (%d, %d) %s, %zu nodes, %zu expanded, %.3f ms (recorded %.3f ms)",
+                            records, name.c_str(), request.start_x, request.start_y, request.goal_x, request.goal_y,
+                            path_found ? "found" : "failed", path.size(), expand.size(), 1000.0 * backend.time.back(),
+                            1000.0 * request.plan_time);
+                // counters of the last repetition
+                if (perf)
+                    std::printf(", IPC %.2f, L1D %.2f, LLC %.2f misses/expanded",
+                                ratio(values[PerfCounters::INSTRUCTIONS], values[PerfCounters::CYCLES]),
+                                ratio(values[PerfCounters::L1D_MISSES], (double)expand.size()),
+                                ratio(values[PerfCounters::LLC_MISSES], (double)expand.size()));
+                std::printf("%s\n", match ? "" : ", MISMATCH");
+            }
+        }
+    }
+
+    int mismatches = 0;
+    std::printf("requests: %d\n", records);
+    std::printf("%-12s %6s %8s %6s %8s %8s %8s %8s", "time(ms)", "found", "compared", "mism", "mean", "p50", "p90",
+                "max");
+    if (perf)
+        std::printf(" %6s %8s %8s %8s %8s %8s", "IPC", "cyc/exp", "L1D/exp", "LLC/exp", "br/exp", "dTLB/exp");
+    std::printf("\n%-12s %6s %8s %6s %8.3f %8.3f %8.3f %8.3f\n", "recorded", "", "", "",
+                1000.0 * mean(recorded_time), 1000.0 * percentile(recorded_time, 50),
+                1000.0 * percentile(recorded_time, 90), 1000.0 * percentile(recorded_time, 100));
+    for (Backend& backend : backends) {
+        mismatches += backend.mismatches;
+        std::printf("%-12s %6d %8d %6d %8.3f %8.3f %8.3f %8.3f", backend.name.empty() ? "replay" : backend.name.c_str(),
+                    backend.found, backend.compared, backend.mismatches, 1000.0 * mean(backend.time),
+                    1000.0 * percentile(backend.time, 50), 1000.0 * percentile(backend.time, 90),
+                    1000.0 * percentile(backend.time, 100));
+        if (perf) {
+            const PerfCounters::Values& c = backend.counters;
+            std::printf(" %6.2f %8.1f %8.2f %8.2f %8.2f %8.2f", ratio(c[PerfCounters::INSTRUCTIONS], c[PerfCounters::CYCLES]),
+                        ratio(c[PerfCounters::CYCLES], backend.expand_num),
+                        ratio(c[PerfCounters::L1D_MISSES], backend.expand_num),
+                        ratio(c[PerfCounters::LLC_MISSES], backend.expand_num),
+                        ratio(c[PerfCounters::BRANCH_MISSES], backend.expand_num),
+                        ratio(c[PerfCounters::DTLB_MISSES], backend.expand_num));
+        }
+        std::printf("\n");
+    }
+    return mismatches ? 2 : 0;
+}
@@ -0,0 +1,211 @@
+/***********************************************************
+ *
+ * @file: planner_bindings.cpp
+ * @breif: Contains the Python bindings of the global planner cores
+ * @author: Yang Haodong
+ * @update: 2023-2-20
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "a_star.h"
+#include "d_star.h"
+#include "delta_stepping.h"
+#include "informed_rrt.h"
+#include "jump_point_search.h"
+#include "rrt.h"
+#include "rrt_connect.h"
+#include "rrt_star.h"
+
+namespace py = pybind11;
+
+namespace {
+/**
+ * @brief Global planner exposed to Python, with the costmap geometry it was built for
+ */
+class PyPlanner {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  planner  planner, ownership is taken
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         */
+        PyPlanner(global_planner::GlobalPlanner* planner, int nx, int ny) : planner_(planner), nx_(nx), ny_(ny) {}
+
+        /**
+         * @brief  search a costmap shared with NumPy, without copying it
+         * @param  costs    uint8 costmap of shape (ny, nx), C-contiguous, indexed costs[y, x]
+         * @param  start    start cell (x, y)
+         * @param  goal     goal cell (x, y)
+         * @return (found, path as int32 (n, 2) cells from goal to start, expand as int32 (n, 4) cells and parents)
+         */
+        py::tuple plan(py::array_t<unsigned char, py::array::c_style> costs, std::pair<int, int> start,
+                       std::pair<int, int> goal) {
+            if (costs.ndim() != 2 || costs.shape(0) != this->ny_ || costs.shape(1) != this->nx_)
+                throw std::invalid_argument("costmap must have shape (ny, nx) of the planner");
+            if (!this->_inside(start.first, start.second) || !this->_inside(goal.first, goal.second))
+                throw std::out_of_range("start and goal must be inside the costmap");
+
+            global_planner::GlobalPlanner* planner = this->planner_.get();
+            // the start is its own parent
+            int start_id = planner->grid2Index(start.first, start.second);
+            Node n_start(start.first, start.second, 0, 0, start_id, start_id);
+            Node n_goal(goal.first, goal.second, 0, 0, planner->grid2Index(goal.first, goal.second), 0);
+            bool found;
+            std::vector<Node> path, expand;
+            {
+                // the array is held by the caller, the search runs without the interpreter.
+                // A planner must not be used by two Python threads at once.
+                py::gil_scoped_release release;
+                std::tie(found, path) = planner->plan(costs.data(), n_start, n_goal, expand);
+            }
+
+            py::array_t<int> path_array({ (py::ssize_t)path.size(), (py::ssize_t)2 });
+            auto p = path_array.mutable_unchecked<2>();
+            for (size_t i = 0; i < path.size(); i++) {
+                p(i, 0) = path[i].x;
+                p(i, 1) = path[i].y;
+            }
+            py::array_t<int> expand_array({ (py::ssize_t)expand.size(), (py::ssize_t)4 });
+            auto e = expand_array.mutable_unchecked<2>();
+            for (size_t i = 0; i < expand.size(); i++) {
+                // nodes without a valid parent are their own parent
+                int parent_x = expand[i].x, parent_y = expand[i].y;
+                if (expand[i].pid >= 0 && expand[i].pid < this->nx_ * this->ny_)
+                    planner->index2Grid(expand[i].pid, parent_x, parent_y);
+                e(i, 0) = expand[i].x;
+                e(i, 1) = expand[i].y;
+                e(i, 2) = parent_x;
+                e(i, 3) = parent_y;
+            }
+            return py::make_tuple(found, path_array, expand_array);
+        }
+
+        /**
+         * @brief  set or reset obstacle factor, cells of cost >= 253 * factor are obstacles
+         */
+        void setFactor(double factor) { this->planner_->setFactor(factor); }
+
+        /**
+         * @brief  seed the sampling of the RRT planners, for reproducible runs
+         */
+        void setSeed(unsigned int seed) {
+            rrt_planner::RRT* sampler = dynamic_cast<rrt_planner::RRT*>(this->planner_.get());
+            if (!sampler)
+                throw std::invalid_argument("only the sample planners can be seeded");
+            sampler->setSeed(seed);
+        }
+
+        int nx() const { return this->nx_; }
+        int ny() const { return this->ny_; }
+
+    private:
+        bool _inside(int x, int y) const { return x >= 0 && x < this->nx_ && y >= 0 && y < this->ny_; }
+
+        std::unique_ptr<global_planner::GlobalPlanner> planner_;
+        // costmap size
+        int nx_, ny_;
+};
+
+/**
+ * @brief  distances from the nearest source to every cell of a costmap shared with NumPy
+ * @param  costs    uint8 costmap of shape (ny, nx), C-contiguous, indexed costs[y, x]
+ * @param  sources  source cells (x, y)
+ * @param  factor   obstacle factor, cells of cost >= 253 * factor are obstacles
+ * @param  threads  worker threads, 0 for one per core
+ * @return float64 distances in cells of shape (ny, nx), inf for obstacles and unreachable cells
+ */
+py::array_t<double> distanceField(py::array_t<unsigned char, py::array::c_style> costs,
+                                  const std::vector<std::pair<int, int>>& sources, double factor, int threads) {
+    if (costs.ndim() != 2)
+        throw std::invalid_argument("costmap must have shape (ny, nx)");
+    int ny = (int)costs.shape(0), nx = (int)costs.shape(1);
+    std::vector<int> cells;
+    for (const auto& s : sources) {
+        if (s.first < 0 || s.first >= nx || s.second < 0 || s.second >= ny)
+            throw std::out_of_range("sources must be inside the costmap");
+        cells.push_back(s.second * nx + s.first);
+    }
+    std::vector<double> dist;
+    {
+        py::gil_scoped_release release;
+        global_planner::DeltaStepping(threads).compute(costs.data(), nx, ny, LETHAL_COST * factor, cells, dist);
+    }
+    py::array_t<double> field({ (py::ssize_t)ny, (py::ssize_t)nx });
+    std::copy(dist.begin(), dist.end(), field.mutable_data());
+    return field;
+}
+}
+
+PYBIND11_MODULE(_planner_cores, m) {
+    m.doc() = "ROS-free C++ global planner cores";
+
+    py::class_<PyPlanner>(m, "GlobalPlanner")
+        .def("plan", &PyPlanner::plan, py::arg("costs").noconvert(), py::arg("start"), py::arg("goal"),
+             "Search a uint8 costmap of shape (ny, nx) without copying it.\n"
+             "Returns (found, path, expand): path is an int32 (n, 2) array of cells from goal to start,\n"
+             "expand an int32 (n, 4) array of expanded cells and their parents.")
+        .def("setFactor", &PyPlanner::setFactor, py::arg("factor"))
+        .def("setSeed", &PyPlanner::setSeed, py::arg("seed"))
+        .def_property_readonly("nx", &PyPlanner::nx)
+        .def_property_readonly("ny", &PyPlanner::ny);
+
+    m.def("distance_field", &distanceField, py::arg("costs").noconvert(), py::arg("sources"),
+          py::arg("factor") = OBSTACLE_FACTOR, py::arg("threads") = 0,
+          "Distances in cells from the nearest source to every cell of a uint8 costmap of shape (ny, nx),\n"
+          "8-connected as the graph planners, by parallel delta-stepping. inf for unreachable cells.");
+    m.def("AStar",
+          [](int nx, int ny, double resolution, bool dijkstra, bool gbfs, bool rsr) {
+              return new PyPlanner(new a_star_planner::AStar(nx, ny, resolution, dijkstra, gbfs, rsr), nx, ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution") = 1.0, py::arg("dijkstra") = false,
+          py::arg("gbfs") = false, py::arg("rsr") = false);
+    m.def("JumpPointSearch",
+          [](int nx, int ny, double resolution) {
+              return new PyPlanner(new jps_planner::JumpPointSearch(nx, ny, resolution), nx, ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution") = 1.0);
+    // the first plan() of a DStar searches, later ones repair the previous path from the given start
+    m.def("DStar",
+          [](int nx, int ny, double resolution) {
+              return new PyPlanner(new d_star_planner::DStar(nx, ny, resolution), nx, ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution") = 1.0);
+    m.def("RRT",
+          [](int nx, int ny, double resolution, int sample_num, double max_dist) {
+              return new PyPlanner(new rrt_planner::RRT(nx, ny, resolution, sample_num, max_dist), nx, ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution"), py::arg("sample_num"), py::arg("max_dist"));
+    m.def("RRTStar",
+          [](int nx, int ny, double resolution, int sample_num, double max_dist, double r) {
+              return new PyPlanner(new rrt_planner::RRTStar(nx, ny, resolution, sample_num, max_dist, r), nx, ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution"), py::arg("sample_num"), py::arg("max_dist"),
+          py::arg("r"));
+    m.def("RRTConnect",
+          [](int nx, int ny, double resolution, int sample_num, double max_dist) {
+              return new PyPlanner(new rrt_planner::RRTConnect(nx, ny, resolution, sample_num, max_dist), nx, ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution"), py::arg("sample_num"), py::arg("max_dist"));
+    m.def("InformedRRT",
+          [](int nx, int ny, double resolution, int sample_num, double max_dist, double r) {
+              return new PyPlanner(new rrt_planner::InformedRRT(nx, ny, resolution, sample_num, max_dist, r), nx,
+                                   ny);
+          },
+          py::arg("nx"), py::arg("ny"), py::arg("resolution"), py::arg("sample_num"), py::arg("max_dist"),
+          py::arg("r"));
+}
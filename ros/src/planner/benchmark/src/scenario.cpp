@@ -0,0 +1,103 @@
+/***********************************************************
+ *
+ * @file: scenario.cpp
+ * @breif: Contains the deterministic start / goal scenarios shared by the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <cmath>
+#include <random>
+
+#include "scenario.h"
+
+namespace benchmark {
+/**
+ * @brief  plan with A* on the inflated map and convert the path into map frame poses
+ * @param  planner  A* planner sized for the map
+ * @param  map      inflated map
+ * @param  sx       start grid x
+ * @param  sy       start grid y
+ * @param  gx       goal grid x
+ * @param  gy       goal grid y
+ * @param  plan     plan in map frame, start first, orientation along the path
+ * @param  length   path length
+ * @return true if a path was found
+ */
+bool makePlan(a_star_planner::AStar& planner, const GridMap& map, int sx, int sy, int gx, int gy,
+              std::vector<Pose2D>& plan, double& length) {
+    Node start(sx, sy, 0, 0, sx + map.nx() * sy, 0);
+    Node goal(gx, gy, 0, 0, gx + map.nx() * gy, 0);
+    std::vector<Node> expand, path;
+    bool found;
+    std::tie(found, path) = planner.plan(map.costs(), start, goal, expand);
+    if (!found || path.size() < 2)
+        return false;
+
+    // the planner returns the path goal first
+    plan.clear();
+    length = 0.0;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        Pose2D p;
+        map.mapToWorld(it->x, it->y, p.x, p.y);
+        p.theta = 0.0;
+        if (!plan.empty())
+            length += std::hypot(p.x - plan.back().x, p.y - plan.back().y);
+        plan.push_back(p);
+    }
+    for (size_t i = 0; i + 1 < plan.size(); i++)
+        plan[i].theta = std::atan2(plan[i + 1].y - plan[i].y, plan[i + 1].x - plan[i].x);
+    plan.back().theta = plan[plan.size() - 2].theta;
+
+    return true;
+}
+
+/**
+ * @brief  sample scenarios from a fixed seed, so every run and every thread count sees the same queries
+ * @param  map              inflated map
+ * @param  num              number of scenarios
+ * @param  seed             random seed
+ * @param  min_dist         minimum straight line distance between start and goal
+ * @param  max_dist         maximum straight line distance between start and goal
+ * @param  min_clearance    minimum obstacle distance of start and goal
+ * @return scenarios with a valid global plan, fewer than num if the map does not allow more
+ */
+std::vector<Scenario> generateScenarios(const GridMap& map, int num, unsigned int seed, double min_dist,
+                                        double max_dist, double min_clearance) {
+    std::vector<Scenario> scenarios;
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist_x(0, map.nx() - 1), dist_y(0, map.ny() - 1);
+    a_star_planner::AStar a_star(map.nx(), map.ny(), map.resolution());
+
+    auto sample = [&](int& x, int& y) {
+        for (int i = 0; i < 10000; i++) {
+            x = dist_x(gen);
+            y = dist_y(gen);
+            double wx, wy;
+            map.mapToWorld(x, y, wx, wy);
+            if (map.distance(wx, wy) >= min_clearance)
+                return true;
+        }
+        return false;
+    };
+
+    for (int attempt = 0; attempt < 100 * num && (int)scenarios.size() < num; attempt++) {
+        Scenario sc;
+        if (!sample(sc.start_x, sc.start_y) || !sample(sc.goal_x, sc.goal_y))
+            break;
+        double d = map.resolution() * std::hypot(sc.goal_x - sc.start_x, sc.goal_y - sc.start_y);
+        if (d < min_dist || d > max_dist)
+            continue;
+        if (!makePlan(a_star, map, sc.start_x, sc.start_y, sc.goal_x, sc.goal_y, sc.plan, sc.path_length))
+            continue;
+        scenarios.push_back(sc);
+    }
+
+    return scenarios;
+}
+}
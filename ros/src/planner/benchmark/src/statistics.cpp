@@ -0,0 +1,52 @@
+/***********************************************************
+ *
+ * @file: statistics.cpp
+ * @breif: Contains the summary statistics printed by the benchmarks
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "statistics.h"
+
+namespace benchmark {
+/**
+ * @brief  percentile by linear interpolation between closest ranks
+ * @param  values   samples, reordered in place
+ * @param  p        percentile in [0, 100]
+ * @return percentile, NaN if there is no sample
+ */
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty())
+        return std::numeric_limits<double>::quiet_NaN();
+
+    double rank = std::min(std::max(p, 0.0), 100.0) / 100.0 * (values.size() - 1);
+    size_t lo = (size_t)std::floor(rank), hi = (size_t)std::ceil(rank);
+    std::nth_element(values.begin(), values.begin() + lo, values.end());
+    double v_lo = values[lo];
+    if (hi == lo)
+        return v_lo;
+    double v_hi = *std::min_element(values.begin() + lo + 1, values.end());
+    return v_lo + (v_hi - v_lo) * (rank - lo);
+}
+
+/**
+ * @brief  arithmetic mean
+ * @param  values   samples
+ * @return mean, NaN if there is no sample
+ */
+double mean(const std::vector<double>& values) {
+    if (values.empty())
+        return std::numeric_limits<double>::quiet_NaN();
+    return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+}
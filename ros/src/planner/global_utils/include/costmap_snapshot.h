@@ -0,0 +1,160 @@
+/***********************************************************
+ *
+ * @file: costmap_snapshot.h
+ * @breif: Contains the tiled copy-on-write costmap snapshots
+ * @author: Yang Haodong
+ * @update: 2023-2-13
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef COSTMAP_SNAPSHOT_H
+#define COSTMAP_SNAPSHOT_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace global_planner {
+/**
+ * @brief Immutable tile of costmap cells, shared by every snapshot it did not change in
+ */
+struct CostmapTile {
+    // unique content version, 0 is never used
+    unsigned int version;
+    // cells of the tile, row-major with the tile width
+    std::vector<unsigned char> data;
+};
+
+/**
+ * @brief Versioned read-only view of the costmap. Copying a snapshot only copies tile pointers.
+ */
+class CostmapSnapshot {
+    public:
+        /**
+         * @brief  Constructor(empty snapshot)
+         */
+        CostmapSnapshot();
+
+        /**
+         * @brief  pixel number in costmap x direction
+         */
+        int nx() const { return this->nx_; }
+        /**
+         * @brief  pixel number in costmap y direction
+         */
+        int ny() const { return this->ny_; }
+        /**
+         * @brief  snapshot version, increases whenever a tile changed
+         */
+        unsigned int version() const { return this->version_; }
+        /**
+         * @brief  whether the snapshot contains no cells
+         */
+        bool empty() const { return this->tiles_.empty(); }
+        /**
+         * @brief  cost of a cell
+         * @param  x    cell x
+         * @param  y    cell y
+         * @return cost
+         */
+        unsigned char getCost(int x, int y) const;
+        /**
+         * @brief  write the snapshot into a flat costmap buffer, tiles whose version already matches are skipped
+         * @param  costs            flat buffer of size nx * ny, resized if needed
+         * @param  tile_versions    tile versions currently held by the buffer, updated
+         * @return number of tiles copied
+         */
+        int copyTo(std::vector<unsigned char>& costs, std::vector<unsigned int>& tile_versions) const;
+        /**
+         * @brief  mark the tile of a cell as modified in a flat buffer, so the next copyTo() restores it
+         * @param  tile_versions    tile versions held by the buffer
+         * @param  x    cell x
+         * @param  y    cell y
+         */
+        void invalidate(std::vector<unsigned int>& tile_versions, int x, int y) const;
+
+    protected:
+        friend class TiledCostmap;
+
+        // pixel number in costmap x and y direction
+        int nx_, ny_;
+        // tile edge length in cells, tile number in x and y direction
+        int tile_size_, tx_, ty_;
+        // snapshot version
+        unsigned int version_;
+        // tiles, row-major
+        std::vector<std::shared_ptr<const CostmapTile>> tiles_;
+};
+
+/**
+ * @brief Tiled copy-on-write mirror of a live costmap. update() only allocates the tiles that
+ *        changed since the last call, snapshots taken before keep their old tiles.
+ */
+class TiledCostmap {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  tile_size    tile edge length in cells
+         */
+        TiledCostmap(int tile_size = 64);
+
+        /**
+         * @brief  synchronize with a costmap copy and take a snapshot
+         * @param  costs    costmap, not modified during the call
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         * @return snapshot of the costmap
+         */
+        CostmapSnapshot update(const unsigned char* costs, int nx, int ny);
+        /**
+         * @brief  synchronize with the live costmap and take a snapshot. The costmap lock is only held while
+         *         the cells are copied, the tiles are compared with the copy after it was released.
+         * @param  costs    live costmap
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         * @param  mutex    costmap lock, not held by the caller
+         * @return snapshot of the live costmap
+         */
+        template <typename Mutex>
+        CostmapSnapshot update(const unsigned char* costs, int nx, int ny, Mutex& mutex) {
+            std::vector<unsigned char> copy = this->_takeBuffer();
+            {
+                std::lock_guard<Mutex> lock(mutex);
+                copy.assign(costs, costs + (size_t)nx * ny);
+            }
+            CostmapSnapshot snapshot = this->update(copy.data(), nx, ny);
+            this->_returnBuffer(std::move(copy));
+            return snapshot;
+        }
+        /**
+         * @brief  latest snapshot, without synchronizing
+         */
+        CostmapSnapshot snapshot();
+
+    private:
+        /**
+         * @brief  spare costmap copy buffer, or an empty one
+         */
+        std::vector<unsigned char> _takeBuffer();
+        /**
+         * @brief  keep a costmap copy buffer for the next update
+         */
+        void _returnBuffer(std::vector<unsigned char>&& buffer);
+
+        // guards current_, version_ and spare_
+        std::mutex mutex_;
+        // tile edge length in cells
+        int tile_size_;
+        // last tile version handed out
+        unsigned int version_;
+        // latest snapshot
+        CostmapSnapshot current_;
+        // costmap copy buffers not in use, one per concurrent update at most
+        std::vector<std::vector<unsigned char>> spare_;
+};
+}
+#endif  // COSTMAP_SNAPSHOT_H
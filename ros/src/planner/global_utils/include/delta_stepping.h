@@ -0,0 +1,122 @@
+/***********************************************************
+ *
+ * @file: delta_stepping.h
+ * @breif: Contains the parallel delta-stepping distance field engine
+ * @author: Yang Haodong
+ * @update: 2023-2-28
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef DELTA_STEPPING_H
+#define DELTA_STEPPING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace global_planner {
+/**
+ * @brief Whole-map distance fields by parallel delta-stepping (Meyer and Sanders), 8-connected with the move
+ *        costs of the graph planners. Cells are kept in buckets of width delta by their tentative distance
+ *        and a bucket is settled in phases: all threads relax the light moves (cost <= delta) of its cells
+ *        until it stays empty, then the heavy moves of the cells it settled. Every thread holds its own
+ *        buckets, the cells of a phase are handed out in batches, and distances are lowered by atomic
+ *        compare-and-swap, so the threads only meet at the phase barriers.
+ */
+class DeltaStepping {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  threads  worker threads, 0 for one per core
+         * @param  delta    bucket width in cells, moves of cost <= delta are light
+         */
+        explicit DeltaStepping(int threads = 0, double delta = 1.0);
+
+        /**
+         * @brief  distances from the nearest source to every cell
+         * @param  costs        costmap
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  threshold    cells of cost >= threshold are obstacles
+         * @param  sources      source cell indices, obstacles are ignored
+         * @param  dist         distances in cells, infinity for obstacles and unreachable cells
+         */
+        void compute(const unsigned char* costs, int nx, int ny, double threshold, const std::vector<int>& sources,
+                     std::vector<double>& dist);
+        /**
+         * @brief  shortest path from a cell down a distance field to its nearest source
+         * @param  dist     distance field of compute()
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         * @param  cell     from cell index
+         * @param  cells    path cell indices, cell first and the source last
+         * @return false if the cell is unreachable
+         */
+        static bool descend(const std::vector<double>& dist, int nx, int ny, int cell, std::vector<int>& cells);
+        /**
+         * @brief  number of worker threads
+         */
+        int threads() const { return this->threads_; }
+
+    protected:
+        /**
+         * @brief Buckets and phase lists of a worker
+         */
+        struct Worker {
+            // cyclic buckets, bucket i at i % buckets.size()
+            std::vector<std::vector<int>> buckets;
+            // cells of the running light phase, read by all workers
+            std::vector<int> frontier;
+            // cells settled in the running bucket, for its heavy phase
+            std::vector<int> settled;
+        };
+
+        /**
+         * @brief  run a computation as one of the workers
+         * @param  w        worker index
+         */
+        void _work(int w);
+        /**
+         * @brief  lower the tentative distance of a cell, and file it in the bucket of the worker if lowered
+         */
+        void _relax(Worker& worker, int cell, double d);
+        /**
+         * @brief  wait for every worker at a phase barrier
+         */
+        void _sync();
+
+        // one computation at a time
+        std::mutex lock_;
+        // worker threads, and the workers taking part in the running computation
+        int threads_, active_;
+        double delta_;
+        // computation input
+        const unsigned char* costs_;
+        int nx_, ny_;
+        double threshold_;
+        const std::vector<int>* sources_;
+        std::vector<double>* dist_out_;
+        // tentative distances, and the phase in which a cell was last taken by a worker
+        size_t capacity_;
+        std::unique_ptr<std::atomic<double>[]> dist_;
+        std::unique_ptr<std::atomic<uint32_t>[]> claim_;
+        // distance of a cell when its light moves were last relaxed
+        std::vector<double> relaxed_;
+        std::vector<Worker> workers_;
+        // running bucket, -1 once every bucket is empty
+        long bucket_;
+        // start of each worker's frontier in the concatenated light phase cells, and the next batch
+        std::vector<size_t> offsets_;
+        std::atomic<size_t> next_;
+        // phase barrier
+        std::atomic<int> arrived_;
+        std::atomic<unsigned int> generation_;
+};
+}
+#endif  // DELTA_STEPPING_H
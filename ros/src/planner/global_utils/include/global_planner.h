@@ -15,11 +15,16 @@
 #ifndef GLOBAL_PLANNER_H
 #define GLOBAL_PLANNER_H
 
+#include <atomic>
 #include <iostream>
+#include <memory_resource>
+#include <queue>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "plan_arena.h"
 #include "utils.h"
 
 /**
@@ -36,7 +41,8 @@ class GlobalPlanner {
          * @param   resolution  costmap resolution
          */
         GlobalPlanner(int nx, int ny, double resolution) : 
-            lethal_cost_(LETHAL_COST), neutral_cost_(NEUTRAL_COST), factor_(OBSTACLE_FACTOR) {
+            lethal_cost_(LETHAL_COST), neutral_cost_(NEUTRAL_COST), factor_(OBSTACLE_FACTOR), cancel_(nullptr),
+            cleared_cell_(-1), cleared_cost_(0) {
             this->setSize(nx, ny);
             this->setResolution(resolution);
         }
@@ -86,7 +92,19 @@ class GlobalPlanner {
              * @brief  set or reset obstacle factor
              * @param factor obstacle factor
              */   
-            void setFactor(double factor);           
+            virtual void setFactor(double factor);
+            /**
+             * @brief  set a flag that makes plan() give up without a path once raised
+             * @param cancel cancel flag, nullptr to disable
+             */
+            void setCancelFlag(const std::atomic<bool>* cancel);
+            /**
+             * @brief  set the cell the caller clears in the costmaps it searches, e.g. the robot location,
+             *         so that planners precomputing the layout key it on the costmap as it was
+             * @param cell  cell index, -1 for none
+             * @param cost  cost of the cell before it was cleared
+             */
+            virtual void setClearedCell(int cell, unsigned char cost);
             /**
              * @brief  transform from grid index(i) to grid map(x, y)
              * @param x grid map x
@@ -121,6 +139,10 @@ class GlobalPlanner {
 
 
     protected:
+        // open and closed list of a search, allocated from arena_
+        typedef std::priority_queue<Node, std::pmr::vector<Node>, compare_cost> OpenList;
+        typedef std::pmr::unordered_set<Node, NodeIdAsHash, compare_coordinates> ClosedList;
+
         // lethal cost
         unsigned char lethal_cost_;
         // neutral cost
@@ -135,17 +157,40 @@ class GlobalPlanner {
         double resolution_;
         // obstacle factor
         double factor_;
+        // raised to cancel a running search
+        const std::atomic<bool>* cancel_;
+        // cell the caller cleared in the costmap and its cost before
+        int cleared_cell_;
+        unsigned char cleared_cost_;
+        // containers of the running search, reset after every search
+        PlanArena arena_;
+
+        /**
+         * @brief  whether the running search was canceled
+         */
+        bool _isCanceled() const { return this->cancel_ && this->cancel_->load(std::memory_order_relaxed); }
 
         /**
          * @brief convert closed list to path
-         * @param closed_list   closed list
+         * @param closed_list   closed list, a set of nodes found by coordinates
          * @param start         start node
          * @param goal          goal node
          * @return vector containing path nodes
          */
-        std::vector<Node> _convertClosedListToPath(
-            std::unordered_set<Node, NodeIdAsHash, compare_coordinates>& closed_list,
-            const Node& start, const Node& goal);
+        template <typename List>
+        std::vector<Node> _convertClosedListToPath(List& closed_list, const Node& start, const Node& goal) {
+            auto current = *closed_list.find(goal);
+            std::vector<Node> path;
+            while (current != start) {
+                path.push_back(current);
+                auto it = closed_list.find(Node(current.pid % this->nx_, current.pid / this->nx_, 0, 0, current.pid));
+                if (it != closed_list.end()) {
+                    current = *it;
+                } else return {};
+            }
+            path.push_back(start);
+            return path;
+        }
         // std::vector<Node> _convertClosedListToPath(std::vector<Node>& closed_list,
         //     const Node& start, const Node& goal);
     };
@@ -0,0 +1,166 @@
+/***********************************************************
+ *
+ * @file: path_monitor.h
+ * @breif: Contains the global path validity monitor
+ * @author: Yang Haodong
+ * @update: 2023-2-14
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PATH_MONITOR_H
+#define PATH_MONITOR_H
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "costmap_snapshot.h"
+#include "utils.h"
+
+namespace global_planner {
+/**
+ * @brief Keeps the last global path as the cells its segments traverse, so that a periodic replan
+ *        can be answered by checking those cells instead of searching the whole map again. Only what
+ *        happens along the path is checked, a shorter corridor opening elsewhere is picked up by the
+ *        search after max_age.
+ */
+class PathMonitor {
+    public:
+        /**
+         * @brief  search between two cells inside a window of the costmap
+         * @param  entry    start cell of the detour
+         * @param  exit     end cell of the detour
+         * @param  x0       window lower x, inclusive
+         * @param  y0       window lower y, inclusive
+         * @param  x1       window upper x, inclusive
+         * @param  y1       window upper y, inclusive
+         * @param  detour   detour in costmap cells, exit first as GlobalPlanner::plan()
+         * @return true if a detour was found
+         */
+        typedef std::function<bool(const Node& entry, const Node& exit, int x0, int y0, int x1, int y1,
+                                   std::vector<Node>& detour)> WindowSearch;
+
+        /**
+         * @brief  Constructor
+         */
+        PathMonitor();
+
+        /**
+         * @brief  Set the monitor parameters
+         * @param  obstacle_cost    cells with cost greater or equal are blocked
+         * @param  max_deviation    maximum distance in cells between the robot and the path
+         * @param  max_age          the path is searched again after this many seconds, to pick up new corridors
+         * @param  cost_ratio       the path is searched again when its remaining cost grew by this ratio
+         */
+        void setParams(double obstacle_cost, int max_deviation, double max_age, double cost_ratio);
+        /**
+         * @brief  forget the monitored path
+         */
+        void reset();
+        /**
+         * @brief  monitor a new path
+         * @param  path     path as returned by GlobalPlanner::plan(), goal first
+         * @param  snapshot costmap the path was planned on
+         * @param  stamp    planning time in seconds
+         */
+        void update(const std::vector<Node>& path, const CostmapSnapshot& snapshot, double stamp);
+        /**
+         * @brief  check the monitored path against the current costmap
+         * @param  snapshot current costmap
+         * @param  start    robot cell
+         * @param  goal     goal cell
+         * @param  stamp    current time in seconds
+         * @param  path     monitored path trimmed to the robot cell, goal first as GlobalPlanner::plan()
+         * @return true if the monitored path is still valid, false if a search is needed
+         */
+        bool check(const CostmapSnapshot& snapshot, const Node& start, const Node& goal, double stamp,
+                   std::vector<Node>& path);
+        /**
+         * @brief  repair the monitored path around its blocked stretches by searching a window around each
+         *         of them, from the last free cell before to the first free waypoint after the block
+         * @param  snapshot current costmap
+         * @param  start    robot cell
+         * @param  goal     goal cell
+         * @param  stamp    current time in seconds
+         * @param  margin   cells kept free before and after a blocked stretch, and window padding
+         * @param  search   window search
+         * @param  path     repaired path trimmed to the robot cell, goal first as GlobalPlanner::plan()
+         * @return true if the path was repaired, false if a full search is needed
+         */
+        bool repair(const CostmapSnapshot& snapshot, const Node& start, const Node& goal, double stamp, int margin,
+                    const WindowSearch& search, std::vector<Node>& path);
+
+    protected:
+        /**
+         * @brief  whether the path leads to the goal and is recent enough to be reused
+         */
+        bool _isReusable(const Node& goal, double stamp) const;
+        /**
+         * @brief  index of the path cell closest to the robot
+         * @param  start    robot cell
+         * @return cell index, -1 if the robot is farther than max_deviation from the path
+         */
+        int _closestCell(const Node& start) const;
+        /**
+         * @brief  rebuild the traversed cells and their planned cost from the path nodes
+         * @param  snapshot costmap the costs are taken from
+         */
+        void _rebuildCells(const CostmapSnapshot& snapshot);
+        /**
+         * @brief  trim the path to the robot cell
+         * @param  snapshot current costmap
+         * @param  start    robot cell
+         * @param  closest  index of the path cell closest to the robot
+         * @param  path     trimmed path, goal first
+         * @return false if the robot cannot reach the next waypoint in a straight line
+         */
+        bool _trim(const CostmapSnapshot& snapshot, const Node& start, int closest, std::vector<Node>& path) const;
+        /**
+         * @brief  append the cells of the segment from (x0, y0) to (x1, y1), excluding the first one
+         * @param  x0       segment start x
+         * @param  y0       segment start y
+         * @param  x1       segment end x
+         * @param  y1       segment end y
+         * @param  segment  index of the path node the segment ends at
+         */
+        void _traverse(int x0, int y0, int x1, int y1, int segment);
+        /**
+         * @brief  whether the segment from (x0, y0) to (x1, y1) is free in the snapshot
+         */
+        bool _isSegmentFree(const CostmapSnapshot& snapshot, int x0, int y0, int x1, int y1) const;
+
+    private:
+        /**
+         * @brief Cell traversed by the path
+         */
+        struct PathCell {
+            int x, y;
+            // index of the path node the cell leads to
+            int segment;
+            // accumulated cell cost from the path start when the path was planned
+            double cost;
+        };
+
+        // guards the monitored path
+        std::mutex mutex_;
+        // blocked cell threshold
+        double obstacle_cost_;
+        // maximum robot distance to the path in cells
+        int max_deviation_;
+        // maximum path age in seconds and remaining cost growth ratio
+        double max_age_, cost_ratio_;
+        // path nodes, start first
+        std::vector<Node> nodes_;
+        // traversed cells, start first
+        std::vector<PathCell> cells_;
+        // planning time
+        double stamp_;
+        // snapshot version the cells were last checked against
+        unsigned int checked_version_;
+};
+}
+#endif  // PATH_MONITOR_H
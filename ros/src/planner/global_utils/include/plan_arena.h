@@ -0,0 +1,89 @@
+/***********************************************************
+ *
+ * @file: plan_arena.h
+ * @breif: Contains the per-search memory arena of the planners
+ * @author: Yang Haodong
+ * @update: 2023-2-19
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PLAN_ARENA_H
+#define PLAN_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace global_planner {
+/**
+ * @brief Monotonic arena of the containers of one search. Allocation is a pointer bump into a buffer that
+ *        is kept across searches and grows to the largest search seen, so a planner in steady state does
+ *        not touch the heap while searching. Not thread-safe, every planner owns its arena.
+ */
+class PlanArena {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  size     initial buffer size in bytes
+         */
+        explicit PlanArena(size_t size = 1 << 16);
+        PlanArena(const PlanArena&) = delete;
+        PlanArena& operator=(const PlanArena&) = delete;
+
+        /**
+         * @brief  memory resource of the running search
+         */
+        std::pmr::memory_resource* resource() { return this->resource_.get(); }
+        /**
+         * @brief  release everything allocated since the last reset, the containers using it must be gone.
+         *         The buffer grows when the search did not fit.
+         */
+        void reset();
+        /**
+         * @brief  buffer size in bytes
+         */
+        size_t capacity() const { return this->size_; }
+
+        /**
+         * @brief Resets the arena at the end of a search, declared before the containers it serves
+         */
+        class Scope {
+            public:
+                explicit Scope(PlanArena& arena) : arena_(arena) {}
+                ~Scope() { this->arena_.reset(); }
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            private:
+                PlanArena& arena_;
+        };
+
+    private:
+        /**
+         * @brief Heap upstream of the buffer, counting the bytes the buffer was short of
+         */
+        class Overflow : public std::pmr::memory_resource {
+            public:
+                // bytes allocated since the last reset
+                size_t bytes = 0;
+
+            private:
+                void* do_allocate(size_t bytes, size_t alignment) override;
+                void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                    return this == &other;
+                }
+        };
+
+        // buffer size in bytes
+        size_t size_;
+        std::unique_ptr<char[]> buffer_;
+        Overflow overflow_;
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> resource_;
+};
+}
+#endif  // PLAN_ARENA_H
@@ -0,0 +1,124 @@
+/***********************************************************
+ *
+ * @file: plan_log.h
+ * @breif: Contains the planning request record and replay log
+ * @author: Yang Haodong
+ * @update: 2023-2-17
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PLAN_LOG_H
+#define PLAN_LOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.h"
+
+namespace global_planner {
+/**
+ * @brief One search of a planner backend: its exact input and the recorded result
+ */
+struct PlanRequest {
+    // backend name, e.g. a_star or rrt_star
+    std::string planner;
+    // planner parameters needed to create the backend, e.g. sample_points
+    std::vector<std::pair<std::string, std::string>> params;
+    // wall time of the request in seconds
+    double stamp = 0.0;
+    // costmap geometry
+    int nx = 0, ny = 0;
+    double resolution = 0.0;
+    // obstacle factor
+    double factor = 0.0;
+    // random seed of sampling planners
+    uint32_t seed = 0;
+    // start and goal cells
+    int start_x = 0, start_y = 0, goal_x = 0, goal_y = 0;
+    // result: whether a path was found, the path cells goal first, expanded node number and search time
+    bool found = false;
+    std::vector<std::pair<int, int>> path;
+    uint32_t expand_num = 0;
+    double plan_time = 0.0;
+
+    /**
+     * @brief  value of a parameter
+     * @param  name     parameter name
+     * @param  value    default value
+     */
+    std::string param(const std::string& name, const std::string& value = "") const;
+};
+
+/**
+ * @brief Appends planning requests to a binary log. Each costmap is stored as the run length
+ *        encoded difference to the previous one, so a log of periodic replans stays small.
+ */
+class PlanLogWriter {
+    public:
+        /**
+         * @brief  Constructor(closed log)
+         */
+        PlanLogWriter();
+
+        /**
+         * @brief  open a log for appending, a new log starts with a header
+         * @param  path     log file path
+         * @return true if the log was opened
+         */
+        bool open(const std::string& path);
+        /**
+         * @brief  whether a log is open
+         */
+        bool isOpen();
+        /**
+         * @brief  append a request, thread-safe
+         * @param  request  request and result
+         * @param  costs    costmap the backend searched, of size nx * ny
+         * @return true if the record was written
+         */
+        bool record(const PlanRequest& request, const unsigned char* costs);
+
+    private:
+        // guards the file and the previous costmap
+        std::mutex mutex_;
+        // log file
+        std::ofstream out_;
+        // costmap of the previous record, the next one is stored as a difference to it
+        std::vector<unsigned char> prev_costs_;
+};
+
+/**
+ * @brief Reads a planning request log record by record
+ */
+class PlanLogReader {
+    public:
+        /**
+         * @brief  open a log
+         * @param  path     log file path
+         * @return false if the file is missing or is not a planning request log
+         */
+        bool open(const std::string& path);
+        /**
+         * @brief  read the next record
+         * @param  request  request and recorded result
+         * @param  costs    costmap the backend searched
+         * @return false at the end of the log or at a truncated record
+         */
+        bool next(PlanRequest& request, std::vector<unsigned char>& costs);
+
+    private:
+        // log file
+        std::ifstream in_;
+        // costmap of the previous record
+        std::vector<unsigned char> prev_costs_;
+};
+}
+#endif  // PLAN_LOG_H
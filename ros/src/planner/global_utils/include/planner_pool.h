@@ -0,0 +1,113 @@
+/***********************************************************
+ *
+ * @file: planner_pool.h
+ * @breif: Contains the pool of per-call planning workspaces
+ * @author: Yang Haodong
+ * @update: 2023-2-12
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PLANNER_POOL_H
+#define PLANNER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "global_planner.h"
+
+namespace global_planner {
+/**
+ * @brief Planning workspace owned by one makePlan call at a time: a planner instance carrying the
+ *        search state (costs_, start_, goal_, sample_list_, ...) and a private costmap snapshot
+ */
+struct PlannerWorkspace {
+    // planner instance with its search state
+    std::unique_ptr<GlobalPlanner> planner;
+    // costmap snapshot the planner searches on
+    std::vector<unsigned char> costs;
+    // versions of the snapshot tiles held by costs
+    std::vector<unsigned int> tile_versions;
+};
+
+/**
+ * @brief Pool of planning workspaces, so that concurrent makePlan calls do not share search state
+ */
+class PlannerPool {
+    public:
+        typedef std::function<GlobalPlanner*()> Factory;
+
+        /**
+         * @brief Workspace borrowed from the pool, given back on destruction
+         */
+        class Handle {
+            public:
+                Handle(PlannerPool* pool, std::unique_ptr<PlannerWorkspace> ws, unsigned int generation)
+                    : pool_(pool), ws_(std::move(ws)), generation_(generation) {}
+                Handle(Handle&& other) = default;
+                Handle(const Handle&) = delete;
+                Handle& operator=(const Handle&) = delete;
+                ~Handle() {
+                    if (this->ws_)
+                        this->pool_->_release(std::move(this->ws_), this->generation_);
+                }
+                PlannerWorkspace* operator->() const { return this->ws_.get(); }
+                PlannerWorkspace& operator*() const { return *this->ws_; }
+
+            private:
+                PlannerPool* pool_;
+                std::unique_ptr<PlannerWorkspace> ws_;
+                unsigned int generation_;
+        };
+
+        /**
+         * @brief  Constructor
+         */
+        PlannerPool();
+        /**
+         * @brief  Set the planner factory and the maximum number of workspaces, dropping existing ones
+         * @param  factory  creates a planner for a new workspace
+         * @param  capacity maximum number of concurrent workspaces, 1 for planners that keep state across calls
+         */
+        void reset(Factory factory, int capacity);
+        /**
+         * @brief  Drop all workspaces, workspaces in use are discarded when given back and count against
+         *         the capacity until then
+         */
+        void clear();
+        /**
+         * @brief  Borrow a workspace, blocks while all workspaces are in use
+         * @return workspace handle
+         */
+        Handle acquire();
+
+    protected:
+        /**
+         * @brief  Give a workspace back to the pool
+         * @param  ws           workspace
+         * @param  generation   pool generation the workspace was created in
+         */
+        void _release(std::unique_ptr<PlannerWorkspace> ws, unsigned int generation);
+
+    private:
+        // pool mutex, only held to hand out and give back workspaces
+        std::mutex mutex_;
+        // signalled when a workspace is given back
+        std::condition_variable released_;
+        // planner factory
+        Factory factory_;
+        // maximum number of workspaces, and the workspaces idle or in use, discarded ones included
+        int capacity_, created_;
+        // incremented by clear() to discard workspaces in use
+        unsigned int generation_;
+        // idle workspaces
+        std::vector<std::unique_ptr<PlannerWorkspace>> idle_;
+};
+}
+#endif  // PLANNER_POOL_H
@@ -0,0 +1,141 @@
+/***********************************************************
+ *
+ * @file: portfolio_planner.h
+ * @breif: Contains the portfolio planner racing several planners
+ * @author: Yang Haodong
+ * @update: 2023-2-15
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PORTFOLIO_PLANNER_H
+#define PORTFOLIO_PLANNER_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "global_planner.h"
+
+namespace global_planner {
+/**
+ * @brief Outcome statistics of the portfolio backends, shared by all portfolio instances of a wrapper
+ */
+class PortfolioStatistics {
+    public:
+        /**
+         * @brief Outcome counters of one backend
+         */
+        struct Record {
+            // searches started
+            unsigned int runs = 0;
+            // searches whose path was returned
+            unsigned int wins = 0;
+            // searches that found no path
+            unsigned int failures = 0;
+            // searches canceled because another backend won
+            unsigned int canceled = 0;
+            // accumulated search time in seconds
+            double time = 0.0;
+        };
+
+        /**
+         * @brief  count one search of a backend
+         * @param  name     backend name
+         * @param  won      whether its path was returned
+         * @param  found    whether it found a path
+         * @param  canceled whether it was canceled before finishing
+         * @param  time     search time in seconds
+         */
+        void record(const std::string& name, bool won, bool found, bool canceled, double time);
+        /**
+         * @brief  copy of the counters of every backend
+         */
+        std::map<std::string, Record> records();
+        /**
+         * @brief  one line summary of the counters, e.g. for logging
+         */
+        std::string summary();
+
+    private:
+        // guards records_
+        std::mutex mutex_;
+        // counters per backend name
+        std::map<std::string, Record> records_;
+};
+
+/**
+ * @brief Planner running several backends concurrently on the same costmap. The first path whose length
+ *        is within a bound of the straight line distance is returned and the other searches are canceled;
+ *        when no path meets the bound, the shortest one is returned once all backends finished.
+ */
+class PortfolioPlanner : public GlobalPlanner {
+    public:
+        /**
+         * @brief  Constructor
+         * @param   nx              pixel number in costmap x direction
+         * @param   ny              pixel number in costmap y direction
+         * @param   resolution      costmap resolution
+         * @param   quality_bound   accepted path length as a multiple of the straight line distance
+         * @param   stats           outcome statistics, nullptr to disable
+         */
+        PortfolioPlanner(int nx, int ny, double resolution, double quality_bound,
+                         std::shared_ptr<PortfolioStatistics> stats = nullptr);
+
+        /**
+         * @brief  add a backend, the portfolio takes ownership of the planner
+         * @param  name     backend name used in the statistics
+         * @param  planner  backend planner of the same costmap size
+         */
+        void addBackend(const std::string& name, GlobalPlanner* planner);
+        /**
+         * @brief  set or reset obstacle factor of the portfolio and its backends
+         * @param factor obstacle factor
+         */
+        void setFactor(double factor) override;
+        /**
+         * @brief  set the cell the caller clears in the costmaps, for the portfolio and its backends
+         * @param cell  cell index, -1 for none
+         * @param cost  cost of the cell before it was cleared
+         */
+        void setClearedCell(int cell, unsigned char cost) override;
+        /**
+         * @brief Race the backends
+         * @param costs     costmap
+         * @param start     start node
+         * @param goal      goal node
+         * @param expand    containing the node been search by the returned backend
+         * @return tuple contatining a bool as to whether a path was found, and the path
+         */
+        std::tuple<bool, std::vector<Node>> plan(const unsigned char* costs, const Node& start,
+                                                 const Node& goal, std::vector<Node> &expand) override;
+
+    protected:
+        /**
+         * @brief  length of a path in cells
+         */
+        double _pathLength(const std::vector<Node>& path) const;
+
+    private:
+        /**
+         * @brief Backend planner
+         */
+        struct Backend {
+            std::string name;
+            std::unique_ptr<GlobalPlanner> planner;
+        };
+
+        // backends, raced in every plan() call
+        std::vector<Backend> backends_;
+        // accepted path length as a multiple of the straight line distance
+        double quality_bound_;
+        // outcome statistics
+        std::shared_ptr<PortfolioStatistics> stats_;
+};
+}
+#endif  // PORTFOLIO_PLANNER_H
@@ -0,0 +1,278 @@
+/***********************************************************
+ *
+ * @file: precompute_cache.h
+ * @breif: Contains the cache of layout precomputations built in the background
+ * @author: Yang Haodong
+ * @update: 2023-2-26
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PRECOMPUTE_CACHE_H
+#define PRECOMPUTE_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "precompute_store.h"
+
+namespace global_planner {
+/**
+ * @brief Precomputations of the recent costmap layouts, e.g. contraction hierarchies, shared by the planners
+ *        of all workspaces. A layout is loaded from the precomputation store or built on a background thread,
+ *        one at a time, and planners search without it until it is published. The most recently used layouts
+ *        are kept in memory and in the store, so that a restart maps them instead of building again.
+ *        T provides static load(store, key, ns) and save(store, key) const.
+ */
+template <typename T>
+class PrecomputeCache {
+    public:
+        typedef std::function<std::shared_ptr<T>(const std::vector<char>& blocked, int nx, int ny,
+                                                 const PrecomputeStore& store, uint64_t key,
+                                                 const std::atomic<bool>* cancel)> Builder;
+
+        /**
+         * @brief  Constructor
+         * @param  name         precomputation name, of the layout keys and the stored files
+         * @param  directory    precomputation store directory, empty to keep the layouts in memory only
+         * @param  capacity     layouts kept in memory and in the store, the least recently used is dropped
+         * @param  builder      builds the precomputation of a layout, nullptr once the cancel flag is raised
+         */
+        PrecomputeCache(const std::string& name, const std::string& directory, size_t capacity, Builder builder)
+            : name_(name), store_(directory), capacity_(std::max<size_t>(capacity, 1)), builder_(builder),
+              building_(false), building_key_(0), queued_(false), queued_key_(0), queued_nx_(0), queued_ny_(0),
+              stop_(false), cancel_(false) {}
+        PrecomputeCache(const PrecomputeCache&) = delete;
+        PrecomputeCache& operator=(const PrecomputeCache&) = delete;
+        /**
+         * @brief  Destructor, a running build is canceled
+         */
+        virtual ~PrecomputeCache() {
+            {
+                std::lock_guard<std::mutex> lock(this->lock_);
+                this->stop_ = true;
+            }
+            this->cancel_ = true;
+            this->wake_.notify_all();
+            if (this->thread_.joinable())
+                this->thread_.join();
+        }
+
+        /**
+         * @brief  key of a layout, which only depends on which cells are free
+         * @param  blocked  obstacle cells, of size nx * ny
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         * @return layout key
+         */
+        uint64_t key(const std::vector<char>& blocked, int nx, int ny) const {
+            return PrecomputeKey().add(this->name_).add(nx).add(ny).add(blocked.data(), blocked.size()).value();
+        }
+        /**
+         * @brief  precomputation of a layout held in memory
+         * @param  key      layout key
+         * @return precomputation, nullptr if the layout is not held
+         */
+        std::shared_ptr<const T> find(uint64_t key) {
+            std::lock_guard<std::mutex> lock(this->lock_);
+            return this->_find(key);
+        }
+        /**
+         * @brief  have the precomputation of a layout loaded or built in the background, unless it is held
+         *         or being built. A request replaces the one still waiting for the builder.
+         * @param  key      layout key
+         * @param  blocked  obstacle cells, of size nx * ny
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         */
+        void request(uint64_t key, const std::vector<char>& blocked, int nx, int ny) {
+            std::lock_guard<std::mutex> lock(this->lock_);
+            if (this->_find(key) || (this->building_ && key == this->building_key_) ||
+                (this->queued_ && key == this->queued_key_))
+                return;
+            this->queued_ = true;
+            this->queued_key_ = key;
+            this->queued_blocked_ = blocked;
+            this->queued_nx_ = nx;
+            this->queued_ny_ = ny;
+            if (!this->thread_.joinable())
+                this->thread_ = std::thread(&PrecomputeCache::_run, this);
+            this->wake_.notify_one();
+        }
+
+    private:
+        /**
+         * @brief  precomputation of a layout held in memory, moved to the front, nullptr if not held
+         */
+        std::shared_ptr<const T> _find(uint64_t key) {
+            for (auto it = this->entries_.begin(); it != this->entries_.end(); it++) {
+                if (it->first == key) {
+                    this->entries_.splice(this->entries_.begin(), this->entries_, it);
+                    return it->second;
+                }
+            }
+            return nullptr;
+        }
+        /**
+         * @brief  builder thread, loads or builds the requested layouts and publishes them
+         */
+        void _run() {
+            std::unique_lock<std::mutex> lock(this->lock_);
+            while (true) {
+                this->wake_.wait(lock, [this] { return this->stop_ || this->queued_; });
+                if (this->stop_)
+                    return;
+                uint64_t key = this->queued_key_;
+                int nx = this->queued_nx_, ny = this->queued_ny_;
+                std::vector<char> blocked;
+                blocked.swap(this->queued_blocked_);
+                this->queued_ = false;
+                this->building_ = true;
+                this->building_key_ = key;
+                lock.unlock();
+
+                std::shared_ptr<const T> data;
+                if (this->store_.enabled())
+                    data = T::load(this->store_, key, nx * ny);
+                if (!data) {
+                    std::shared_ptr<T> built = this->builder_(blocked, nx, ny, this->store_, key, &this->cancel_);
+                    // the store keeps as many layouts as the memory
+                    if (built && this->store_.enabled() && built->save(this->store_, key))
+                        this->store_.prune(this->name_, this->capacity_);
+                    data = built;
+                }
+
+                lock.lock();
+                this->building_ = false;
+                if (data) {
+                    this->entries_.emplace_front(key, data);
+                    if (this->entries_.size() > this->capacity_)
+                        this->entries_.pop_back();
+                }
+            }
+        }
+
+        std::string name_;
+        PrecomputeStore store_;
+        size_t capacity_;
+        Builder builder_;
+        // guards the entries and the requests
+        std::mutex lock_;
+        // signalled on a request and on destruction
+        std::condition_variable wake_;
+        // layout keys and their precomputations, the most recently used first
+        std::list<std::pair<uint64_t, std::shared_ptr<const T>>> entries_;
+        // layout being built
+        bool building_;
+        uint64_t building_key_;
+        // layout waiting for the builder
+        bool queued_;
+        uint64_t queued_key_;
+        std::vector<char> queued_blocked_;
+        int queued_nx_, queued_ny_;
+        bool stop_;
+        // raised on destruction to cancel a running build
+        std::atomic<bool> cancel_;
+        // builder thread, started by the first request
+        std::thread thread_;
+};
+
+/**
+ * @brief Layout of the costmaps a planner searches and the precomputation it holds. The layout of the first
+ *        costmap is requested at once, a changed layout once it stayed the same for a few searches, so that
+ *        a map that keeps changing does not keep the builder busy. Until a precomputation is published,
+ *        the planner holds the previous one, or none.
+ */
+template <typename T>
+class PrecomputeLayout {
+    public:
+        /**
+         * @brief  Constructor
+         */
+        PrecomputeLayout() : key_(0), pending_key_(0), pending_(0), requested_(false) {}
+
+        /**
+         * @brief  follow the layout of a costmap, taking its precomputation once the cache holds it
+         * @param  cache        precomputation cache
+         * @param  costs        costmap
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  threshold    cells of cost >= threshold are obstacles
+         * @param  cleared      cell the caller cleared in the costmap, -1 for none
+         * @param  cleared_cost cost of the cleared cell before, the layout is the costmap as it was
+         * @return true if the held precomputation is of the costmap layout
+         */
+        bool update(PrecomputeCache<T>& cache, const unsigned char* costs, int nx, int ny, double threshold,
+                    int cleared, unsigned char cleared_cost) {
+            this->blocked_.resize(nx * ny);
+            for (int i = 0; i < nx * ny; i++)
+                this->blocked_[i] = costs[i] >= threshold;
+            if (cleared >= 0 && cleared < nx * ny && cleared_cost >= threshold)
+                this->blocked_[cleared] = 1;
+            uint64_t key = cache.key(this->blocked_, nx, ny);
+            if (this->held_ && key == this->key_)
+                return true;
+            std::shared_ptr<const T> found = cache.find(key);
+            if (found) {
+                this->held_ = found;
+                this->key_ = key;
+                return true;
+            }
+            if (key != this->pending_key_) {
+                this->pending_key_ = key;
+                this->pending_ = 0;
+            }
+            if (this->pending_ < kRebuildAfter)
+                this->pending_++;
+            if ((!this->held_ && !this->requested_) || this->pending_ >= kRebuildAfter) {
+                cache.request(key, this->blocked_, nx, ny);
+                this->requested_ = true;
+            }
+            return false;
+        }
+        /**
+         * @brief  drop the held precomputation, the next costmap is requested at once
+         */
+        void reset() {
+            this->held_.reset();
+            this->requested_ = false;
+        }
+        /**
+         * @brief  held precomputation, of the last layout or an earlier one, nullptr if none
+         */
+        const std::shared_ptr<const T>& held() const { return this->held_; }
+        /**
+         * @brief  obstacle cells of the last costmap layout
+         */
+        const std::vector<char>& blocked() const { return this->blocked_; }
+
+    private:
+        // searches a changed layout must stay the same for before it is requested
+        static const int kRebuildAfter = 3;
+
+        std::shared_ptr<const T> held_;
+        // layout of the held precomputation
+        uint64_t key_;
+        // changed layout and the searches it stayed the same for
+        uint64_t pending_key_;
+        int pending_;
+        // whether a layout was requested since the last reset
+        bool requested_;
+        // obstacle cells of the last costmap layout
+        std::vector<char> blocked_;
+};
+}
+#endif  // PRECOMPUTE_CACHE_H
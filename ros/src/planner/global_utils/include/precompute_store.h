@@ -0,0 +1,219 @@
+/***********************************************************
+ *
+ * @file: precompute_store.h
+ * @breif: Contains the memory-mapped store of planner precomputations
+ * @author: Yang Haodong
+ * @update: 2023-2-16
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PRECOMPUTE_STORE_H
+#define PRECOMPUTE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace global_planner {
+/**
+ * @brief Stable 64 bit key of the data a precomputation depends on (costmap contents, planner parameters).
+ *        The hash does not depend on the process, so keys match across restarts.
+ */
+class PrecomputeKey {
+    public:
+        /**
+         * @brief  Constructor
+         */
+        PrecomputeKey();
+
+        /**
+         * @brief  mix raw bytes into the key
+         * @param  data     bytes
+         * @param  size     number of bytes
+         * @return this key
+         */
+        PrecomputeKey& add(const void* data, size_t size);
+        /**
+         * @brief  mix a string into the key, e.g. a planner name
+         */
+        PrecomputeKey& add(const std::string& value);
+        /**
+         * @brief  mix a parameter into the key
+         */
+        PrecomputeKey& add(int value) { return this->add(&value, sizeof(value)); }
+        PrecomputeKey& add(double value) { return this->add(&value, sizeof(value)); }
+        /**
+         * @brief  mix costmap contents and geometry into the key
+         * @param  costs        costmap
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  resolution   costmap resolution
+         * @return this key
+         */
+        PrecomputeKey& addCostmap(const unsigned char* costs, int nx, int ny, double resolution);
+        /**
+         * @brief  key value
+         */
+        uint64_t value() const { return this->hash_; }
+
+    private:
+        // FNV-1a state
+        uint64_t hash_;
+};
+
+/**
+ * @brief Collects named sections and writes them as one precomputation file
+ */
+class PrecomputeWriter {
+    public:
+        /**
+         * @brief  add a section, the data is copied
+         * @param  name     section name, at most 31 characters
+         * @param  data     section bytes
+         * @param  size     number of bytes
+         */
+        void addSection(const std::string& name, const void* data, size_t size);
+        /**
+         * @brief  add a section of trivially copyable elements
+         */
+        template <typename T>
+        void addSection(const std::string& name, const std::vector<T>& data) {
+            this->addSection(name, data.data(), data.size() * sizeof(T));
+        }
+        /**
+         * @brief  write the file, through a temporary file renamed into place so readers never see a partial file
+         * @param  path     file path
+         * @param  key      key of the data the sections were computed from
+         * @param  version  layout version of the sections, chosen by the planner
+         * @return true if the file was written
+         */
+        bool write(const std::string& path, uint64_t key, uint32_t version) const;
+
+    private:
+        // section names and bytes, in insertion order
+        std::vector<std::pair<std::string, std::vector<char>>> sections_;
+};
+
+/**
+ * @brief Read-only memory mapping of a precomputation file. Sections point into the mapping, they are
+ *        valid while the mapping is open and are never copied.
+ */
+class PrecomputeMapping {
+    public:
+        /**
+         * @brief  Constructor(closed mapping)
+         */
+        PrecomputeMapping();
+        PrecomputeMapping(PrecomputeMapping&& other);
+        PrecomputeMapping& operator=(PrecomputeMapping&& other);
+        PrecomputeMapping(const PrecomputeMapping&) = delete;
+        PrecomputeMapping& operator=(const PrecomputeMapping&) = delete;
+        ~PrecomputeMapping();
+
+        /**
+         * @brief  map a precomputation file
+         * @param  path     file path
+         * @param  key      expected key
+         * @param  version  expected section layout version
+         * @return false if the file is missing, malformed or was computed from other data
+         */
+        bool open(const std::string& path, uint64_t key, uint32_t version);
+        /**
+         * @brief  unmap the file
+         */
+        void close();
+        /**
+         * @brief  whether a file is mapped
+         */
+        bool isOpen() const { return this->data_ != nullptr; }
+        /**
+         * @brief  find a section
+         * @param  name     section name
+         * @param  data     section bytes, aligned to 64 bytes
+         * @param  size     number of bytes
+         * @return true if the section exists
+         */
+        bool section(const std::string& name, const void*& data, size_t& size) const;
+        /**
+         * @brief  find a section of trivially copyable elements
+         * @param  name     section name
+         * @param  data     first element
+         * @param  count    number of elements
+         * @return true if the section exists and holds whole elements
+         */
+        template <typename T>
+        bool section(const std::string& name, const T*& data, size_t& count) const {
+            const void* bytes;
+            size_t size;
+            if (!this->section(name, bytes, size) || size % sizeof(T))
+                return false;
+            data = static_cast<const T*>(bytes);
+            count = size / sizeof(T);
+            return true;
+        }
+
+    private:
+        // mapped file
+        const char* data_;
+        // mapped size
+        size_t size_;
+};
+
+/**
+ * @brief Directory of precomputation files named by precomputation and key, so that a restarted planner
+ *        maps the data computed for the same map and parameters instead of rebuilding it
+ */
+class PrecomputeStore {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  directory    store directory, created on the first save, empty to disable the store
+         */
+        explicit PrecomputeStore(const std::string& directory = "");
+
+        /**
+         * @brief  whether the store has a directory
+         */
+        bool enabled() const { return !this->directory_.empty(); }
+        /**
+         * @brief  file path of a precomputation
+         * @param  name     precomputation name, e.g. "jps_jump_table"
+         * @param  key      key of the data it is computed from
+         */
+        std::string path(const std::string& name, uint64_t key) const;
+        /**
+         * @brief  map a stored precomputation
+         * @param  name     precomputation name
+         * @param  key      key of the data it is computed from
+         * @param  version  section layout version
+         * @param  mapping  mapping of the file
+         * @return true if a matching file was mapped, its modification time is set to now
+         */
+        bool load(const std::string& name, uint64_t key, uint32_t version, PrecomputeMapping& mapping) const;
+        /**
+         * @brief  store a precomputation
+         * @param  name     precomputation name
+         * @param  key      key of the data it is computed from
+         * @param  version  section layout version
+         * @param  writer   sections
+         * @return true if the file was written
+         */
+        bool save(const std::string& name, uint64_t key, uint32_t version, const PrecomputeWriter& writer) const;
+        /**
+         * @brief  remove the stored precomputations of a name but the most recently saved or loaded ones
+         * @param  name     precomputation name
+         * @param  keep     number of files kept
+         */
+        void prune(const std::string& name, size_t keep) const;
+
+    private:
+        // store directory
+        std::string directory_;
+};
+}
+#endif  // PRECOMPUTE_STORE_H
@@ -0,0 +1,141 @@
+/***********************************************************
+ *
+ * @file: swamp_map.h
+ * @breif: Contains the dead-end and swamp region classification of the costmap
+ * @author: Yang Haodong
+ * @update: 2023-2-26
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef SWAMP_MAP_H
+#define SWAMP_MAP_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace global_planner {
+/**
+ * @brief Swamps of the costmap (Pochter et al.), regions that no shortest 8-connected path between two
+ *        cells outside them needs to cross, so that a search may block them unless start or goal lies inside.
+ *        The free cells are split into regions, the connected cells of a sector, and a region is a swamp
+ *        when every shortest path through it between two cells of its boundary has an equally short
+ *        bypass around it and the swamps classified before it. A dead-end is a swamp whose boundary
+ *        cells are all adjacent, a pocket behind a narrow entrance. The classification of a region is
+ *        kept until a cell it read changes.
+ */
+class SwampMap {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  sector_size  edge length in cells of the sectors the regions are split from
+         */
+        explicit SwampMap(int sector_size = 8);
+
+        /**
+         * @brief  classify a costmap and block its swamps, except those of start and goal and the swamps
+         *         classified after them next to them
+         * @param  costs        costmap, the swamp cells are set to 255 which blocks them at any threshold
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  threshold    cells of cost >= threshold are obstacles
+         * @param  start        start cell index
+         * @param  goal         goal cell index
+         * @param  cells        indices of the blocked cells
+         */
+        void prune(unsigned char* costs, int nx, int ny, double threshold, int start, int goal, std::vector<int>& cells);
+        /**
+         * @brief  classify a costmap, only the regions around the cells that changed are classified again
+         * @param  costs        costmap
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  threshold    cells of cost >= threshold are obstacles
+         * @return number of cells that changed, all cells on the first call
+         */
+        int update(const unsigned char* costs, int nx, int ny, double threshold);
+        /**
+         * @brief  whether a cell lies in a swamp
+         */
+        bool swamp(int cell) const { return this->region_[cell] >= 0 && this->regions_[this->region_[cell]].swamp; }
+        /**
+         * @brief  number of swamps, dead-ends included
+         */
+        size_t swampNum() const;
+        /**
+         * @brief  number of dead-ends
+         */
+        size_t deadEndNum() const;
+
+    protected:
+        /**
+         * @brief Connected free cells of a sector
+         */
+        struct Region {
+            std::vector<int> cells;
+            bool alive, swamp, dead_end, queued;
+            // position among the swamps, a swamp was tested around the swamps before it
+            unsigned long order;
+            // cells the classification read, inclusive
+            int x0, y0, x1, y1;
+        };
+
+        /**
+         * @brief  update() with the lock held
+         */
+        int _update(const unsigned char* costs, int nx, int ny, double threshold);
+        /**
+         * @brief  split the free cells of a sector into new regions and queue them
+         * @param  sector   sector index
+         */
+        void _split(int sector);
+        /**
+         * @brief  unclassify a swamp and the later swamps next to it, whose boundary excluded it, and queue them
+         * @param  id       region
+         */
+        void _drop(int id);
+        /**
+         * @brief  whether a region is a swamp of the costmap without the current swamps
+         * @param  id       region, its read cells are updated
+         * @return true if it is a swamp
+         */
+        bool _test(int id);
+        /**
+         * @brief  regions next to a region
+         * @param  id       region
+         * @param  ids      neighbour regions
+         */
+        void _adjacent(int id, std::vector<int>& ids) const;
+        /**
+         * @brief  queue a region for classification
+         */
+        void _queue(int id);
+
+        // guards the classification
+        std::mutex lock_;
+        int sector_size_, nx_, ny_, sx_, sy_;
+        bool built_;
+        // obstacle cells of the classified costmap
+        std::vector<char> blocked_;
+        // region by cell, -1 for obstacles
+        std::vector<int> region_;
+        // regions, the ids in free_ids_ are unused
+        std::vector<Region> regions_;
+        std::vector<int> free_ids_;
+        // regions by sector
+        std::vector<std::vector<int>> sector_regions_;
+        // regions to classify
+        std::deque<int> queue_;
+        // order of the last swamp
+        unsigned long order_;
+        // test scratch, valid where the stamps match
+        std::vector<unsigned int> member_, boundary_, visit_;
+        std::vector<int> boundary_index_;
+        std::vector<double> dist_;
+        unsigned int epoch_, search_;
+};
+}
+#endif  // SWAMP_MAP_H
@@ -0,0 +1,108 @@
+/***********************************************************
+ *
+ * @file: trace.h
+ * @breif: Contains the scoped trace points and their Chrome trace export
+ * @author: Yang Haodong
+ * @update: 2023-2-18
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * TRACE_SCOPE("name") records the time spent until the end of the enclosing scope. The name must be a
+ * string literal. Trace points are compiled only with PLANNER_TRACING (cmake -DPLANNER_TRACING=ON), and
+ * then record only while Tracer::setEnabled(true).
+ */
+#ifdef PLANNER_TRACING
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) global_planner::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) \
+    do {                  \
+    } while (0)
+#endif
+
+namespace global_planner {
+/**
+ * @brief Process-wide trace recorder. Every thread appends to its own ring buffer without locking,
+ *        the oldest events are overwritten when a buffer is full.
+ */
+class Tracer {
+    public:
+        /**
+         * @brief  start or stop recording
+         */
+        static void setEnabled(bool enabled);
+        /**
+         * @brief  whether trace points record
+         */
+        static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+        /**
+         * @brief  monotonic time in nanoseconds
+         */
+        static uint64_t now();
+        /**
+         * @brief  append a complete event to the ring buffer of the calling thread
+         * @param  name     event name, a string literal
+         * @param  begin    begin time in nanoseconds
+         * @param  end      end time in nanoseconds
+         */
+        static void record(const char* name, uint64_t begin, uint64_t end);
+        /**
+         * @brief  write the buffered events as Chrome trace JSON, readable by chrome://tracing and Perfetto
+         * @param  os   output stream
+         * @return number of events written
+         */
+        static size_t writeChromeTrace(std::ostream& os);
+        /**
+         * @brief  write the buffered events to a Chrome trace file
+         * @param  path     file path
+         * @param  events   number of events written
+         * @return true if the file was written
+         */
+        static bool writeChromeTrace(const std::string& path, size_t& events);
+        /**
+         * @brief  drop the buffered events
+         */
+        static void clear();
+
+    private:
+        // recording switch
+        static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief Records the lifetime of the scope as one trace event
+ */
+class TraceScope {
+    public:
+        explicit TraceScope(const char* name)
+            : name_(Tracer::isEnabled() ? name : nullptr), begin_(name_ ? Tracer::now() : 0) {}
+        ~TraceScope() {
+            if (this->name_)
+                Tracer::record(this->name_, this->begin_, Tracer::now());
+        }
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        // event name, nullptr when tracing was off at scope entry
+        const char* name_;
+        // scope entry time in nanoseconds
+        uint64_t begin_;
+};
+}
+#endif  // TRACE_H
@@ -15,6 +15,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <array>
 #include <limits>
 #include <queue>
 #include <unordered_set>
@@ -0,0 +1,170 @@
+/***********************************************************
+ *
+ * @file: costmap_snapshot.cpp
+ * @breif: Contains the tiled copy-on-write costmap snapshots
+ * @author: Yang Haodong
+ * @update: 2023-2-13
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cstring>
+
+#include "costmap_snapshot.h"
+#include "trace.h"
+
+namespace global_planner {
+/******************************** Snapshot ****************************************/
+/**
+ * @brief  Constructor(empty snapshot)
+ */
+CostmapSnapshot::CostmapSnapshot() : nx_(0), ny_(0), tile_size_(1), tx_(0), ty_(0), version_(0) {}
+
+/**
+ * @brief  cost of a cell
+ * @param  x    cell x
+ * @param  y    cell y
+ * @return cost
+ */
+unsigned char CostmapSnapshot::getCost(int x, int y) const {
+    const CostmapTile& tile = *this->tiles_[(y / this->tile_size_) * this->tx_ + x / this->tile_size_];
+    int w = std::min(this->tile_size_, this->nx_ - (x / this->tile_size_) * this->tile_size_);
+    return tile.data[(y % this->tile_size_) * w + x % this->tile_size_];
+}
+
+/**
+ * @brief  write the snapshot into a flat costmap buffer, tiles whose version already matches are skipped
+ * @param  costs            flat buffer of size nx * ny, resized if needed
+ * @param  tile_versions    tile versions currently held by the buffer, updated
+ * @return number of tiles copied
+ */
+int CostmapSnapshot::copyTo(std::vector<unsigned char>& costs, std::vector<unsigned int>& tile_versions) const {
+    TRACE_SCOPE("CostmapSnapshot::copyTo");
+    if (costs.size() != (size_t)this->nx_ * this->ny_ || tile_versions.size() != this->tiles_.size()) {
+        costs.assign((size_t)this->nx_ * this->ny_, 0);
+        tile_versions.assign(this->tiles_.size(), 0);
+    }
+
+    int copied = 0;
+    for (int ty = 0; ty < this->ty_; ty++) {
+        for (int tx = 0; tx < this->tx_; tx++) {
+            int t = ty * this->tx_ + tx;
+            const CostmapTile& tile = *this->tiles_[t];
+            if (tile_versions[t] == tile.version)
+                continue;
+
+            int x0 = tx * this->tile_size_, y0 = ty * this->tile_size_;
+            int w = std::min(this->tile_size_, this->nx_ - x0), h = std::min(this->tile_size_, this->ny_ - y0);
+            for (int r = 0; r < h; r++)
+                std::memcpy(&costs[(size_t)(y0 + r) * this->nx_ + x0], &tile.data[r * w], w);
+            tile_versions[t] = tile.version;
+            copied++;
+        }
+    }
+    return copied;
+}
+
+/**
+ * @brief  mark the tile of a cell as modified in a flat buffer, so the next copyTo() restores it
+ * @param  tile_versions    tile versions held by the buffer
+ * @param  x    cell x
+ * @param  y    cell y
+ */
+void CostmapSnapshot::invalidate(std::vector<unsigned int>& tile_versions, int x, int y) const {
+    if (x < 0 || y < 0 || x >= this->nx_ || y >= this->ny_)
+        return;
+    int t = (y / this->tile_size_) * this->tx_ + x / this->tile_size_;
+    if (t < (int)tile_versions.size())
+        tile_versions[t] = 0;
+}
+
+/******************************** Tiled costmap ****************************************/
+/**
+ * @brief  Constructor
+ * @param  tile_size    tile edge length in cells
+ */
+TiledCostmap::TiledCostmap(int tile_size) : tile_size_(std::max(1, tile_size)), version_(0) {}
+
+/**
+ * @brief  synchronize with a costmap copy and take a snapshot
+ * @param  costs    costmap, not modified during the call
+ * @param  nx       pixel number in costmap x direction
+ * @param  ny       pixel number in costmap y direction
+ * @return snapshot of the costmap
+ */
+CostmapSnapshot TiledCostmap::update(const unsigned char* costs, int nx, int ny) {
+    TRACE_SCOPE("TiledCostmap::update");
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    CostmapSnapshot& cur = this->current_;
+
+    // the costmap was resized, every tile is new
+    if (cur.nx_ != nx || cur.ny_ != ny) {
+        cur.nx_ = nx;
+        cur.ny_ = ny;
+        cur.tile_size_ = this->tile_size_;
+        cur.tx_ = (nx + this->tile_size_ - 1) / this->tile_size_;
+        cur.ty_ = (ny + this->tile_size_ - 1) / this->tile_size_;
+        cur.tiles_.assign(cur.tx_ * cur.ty_, nullptr);
+    }
+
+    // compare each tile with the live costmap, only changed tiles are copied
+    bool changed = false;
+    for (int ty = 0; ty < cur.ty_; ty++) {
+        for (int tx = 0; tx < cur.tx_; tx++) {
+            int x0 = tx * this->tile_size_, y0 = ty * this->tile_size_;
+            int w = std::min(this->tile_size_, nx - x0), h = std::min(this->tile_size_, ny - y0);
+            std::shared_ptr<const CostmapTile>& tile = cur.tiles_[ty * cur.tx_ + tx];
+
+            bool same = tile != nullptr;
+            for (int r = 0; r < h && same; r++)
+                same = std::memcmp(&tile->data[r * w], costs + (size_t)(y0 + r) * nx + x0, w) == 0;
+            if (same)
+                continue;
+
+            std::shared_ptr<CostmapTile> fresh = std::make_shared<CostmapTile>();
+            fresh->version = ++this->version_;
+            fresh->data.resize(w * h);
+            for (int r = 0; r < h; r++)
+                std::memcpy(&fresh->data[r * w], costs + (size_t)(y0 + r) * nx + x0, w);
+            tile = fresh;
+            changed = true;
+        }
+    }
+    if (changed)
+        cur.version_ = this->version_;
+
+    return cur;
+}
+
+/**
+ * @brief  spare costmap copy buffer, or an empty one
+ */
+std::vector<unsigned char> TiledCostmap::_takeBuffer() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->spare_.empty())
+        return {};
+    std::vector<unsigned char> buffer = std::move(this->spare_.back());
+    this->spare_.pop_back();
+    return buffer;
+}
+
+/**
+ * @brief  keep a costmap copy buffer for the next update
+ */
+void TiledCostmap::_returnBuffer(std::vector<unsigned char>&& buffer) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->spare_.push_back(std::move(buffer));
+}
+
+/**
+ * @brief  latest snapshot, without synchronizing
+ */
+CostmapSnapshot TiledCostmap::snapshot() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->current_;
+}
+}
@@ -0,0 +1,256 @@
+/***********************************************************
+ *
+ * @file: delta_stepping.cpp
+ * @breif: Contains the parallel delta-stepping distance field engine
+ * @author: Yang Haodong
+ * @update: 2023-2-28
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "delta_stepping.h"
+#include "trace.h"
+
+namespace global_planner {
+namespace {
+// moves as the planners make them, diagonals included
+const int kDx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+const int kDy[8] = { 1, 0, -1, 0, 1, -1, 1, -1 };
+const double kCost[8] = { 1, 1, 1, 1, std::sqrt(2.0), std::sqrt(2.0), std::sqrt(2.0), std::sqrt(2.0) };
+const double kInf = std::numeric_limits<double>::infinity();
+// sums of the same moves in another order may differ by rounding
+const double kTolerance = 1e-9;
+// cells a worker takes from the light phase frontier at a time
+const size_t kBatch = 64;
+// cells per worker below which more workers only add barrier waits
+const int kCellsPerWorker = 16384;
+}
+
+    /**
+     * @brief  Constructor
+     * @param  threads  worker threads, 0 for one per core
+     * @param  delta    bucket width in cells, moves of cost <= delta are light
+     */
+    DeltaStepping::DeltaStepping(int threads, double delta)
+        : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())), active_(1),
+          delta_(std::max(delta, 1e-3)), costs_(nullptr), nx_(0), ny_(0), threshold_(0), sources_(nullptr),
+          dist_out_(nullptr), capacity_(0), bucket_(-1), next_(0), arrived_(0), generation_(0) {}
+
+    /**
+     * @brief  distances from the nearest source to every cell
+     * @param  costs        costmap
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  threshold    cells of cost >= threshold are obstacles
+     * @param  sources      source cell indices, obstacles are ignored
+     * @param  dist         distances in cells, infinity for obstacles and unreachable cells
+     */
+    void DeltaStepping::compute(const unsigned char* costs, int nx, int ny, double threshold,
+                                const std::vector<int>& sources, std::vector<double>& dist) {
+        TRACE_SCOPE("DeltaStepping::compute");
+        std::lock_guard<std::mutex> guard(this->lock_);
+        size_t ns = (size_t)nx * ny;
+        this->costs_ = costs;
+        this->nx_ = nx;
+        this->ny_ = ny;
+        this->threshold_ = threshold;
+        this->sources_ = &sources;
+        this->dist_out_ = &dist;
+        dist.resize(ns);
+        if (ns > this->capacity_) {
+            this->dist_.reset(new std::atomic<double>[ns]);
+            this->claim_.reset(new std::atomic<uint32_t>[ns]);
+            this->capacity_ = ns;
+        }
+        this->relaxed_.resize(ns);
+
+        // a move reaches at most the bucket floor(max cost / delta) + 1 after the running one
+        this->active_ = (int)std::max<size_t>(1, std::min<size_t>(this->threads_, ns / kCellsPerWorker));
+        this->workers_.resize(this->active_);
+        for (Worker& worker : this->workers_)
+            worker.buckets.resize((size_t)(std::sqrt(2.0) / this->delta_) + 2);
+        this->offsets_.assign(this->active_ + 1, 0);
+        this->arrived_ = 0;
+
+        std::vector<std::thread> pool;
+        for (int w = 1; w < this->active_; w++)
+            pool.emplace_back(&DeltaStepping::_work, this, w);
+        this->_work(0);
+        for (auto& t : pool)
+            t.join();
+    }
+
+    /**
+     * @brief  shortest path from a cell down a distance field to its nearest source
+     * @param  dist     distance field of compute()
+     * @param  nx       pixel number in costmap x direction
+     * @param  ny       pixel number in costmap y direction
+     * @param  cell     from cell index
+     * @param  cells    path cell indices, cell first and the source last
+     * @return false if the cell is unreachable
+     */
+    bool DeltaStepping::descend(const std::vector<double>& dist, int nx, int ny, int cell, std::vector<int>& cells) {
+        cells.clear();
+        if (cell < 0 || cell >= nx * ny || !std::isfinite(dist[cell]))
+            return false;
+        cells.push_back(cell);
+        while (dist[cell] > 0) {
+            // the neighbour the distance of the cell was reached from
+            int x = cell % nx, y = cell / nx, next = -1;
+            double best = dist[cell] + kTolerance;
+            for (int k = 0; k < 8; k++) {
+                int mx = x + kDx[k], my = y + kDy[k];
+                if (mx < 0 || mx >= nx || my < 0 || my >= ny || dist[my * nx + mx] + kCost[k] > best)
+                    continue;
+                best = dist[my * nx + mx] + kCost[k];
+                next = my * nx + mx;
+            }
+            if (next < 0)
+                return false;
+            cells.push_back(cell = next);
+        }
+        return true;
+    }
+
+    /**
+     * @brief  run a computation as one of the workers
+     * @param  w        worker index
+     */
+    void DeltaStepping::_work(int w) {
+        Worker& me = this->workers_[w];
+        int nx = this->nx_, ny = this->ny_, threads = this->active_;
+        size_t ns = (size_t)nx * ny, buckets = me.buckets.size();
+        for (size_t i = ns * w / threads; i < ns * (w + 1) / threads; i++) {
+            this->dist_[i].store(kInf, std::memory_order_relaxed);
+            this->claim_[i].store(0, std::memory_order_relaxed);
+            this->relaxed_[i] = kInf;
+        }
+        for (std::vector<int>& bucket : me.buckets)
+            bucket.clear();
+        me.frontier.clear();
+        me.settled.clear();
+        this->_sync();
+        if (w == 0) {
+            this->bucket_ = -1;
+            for (int s : *this->sources_) {
+                if (s >= 0 && s < (int)ns && this->costs_[s] < this->threshold_) {
+                    this->_relax(me, s, 0.0);
+                    this->bucket_ = 0;
+                }
+            }
+        }
+        this->_sync();
+
+        uint32_t phase = 0;
+        while (this->bucket_ >= 0) {
+            long current = this->bucket_;
+            std::vector<int>& bucket = me.buckets[current % buckets];
+
+            // light phases, until no move refiles a cell in the running bucket
+            for (;;) {
+                me.frontier.swap(bucket);
+                this->_sync();
+                if (w == 0) {
+                    for (int t = 0; t < threads; t++)
+                        this->offsets_[t + 1] = this->offsets_[t] + this->workers_[t].frontier.size();
+                    this->next_ = 0;
+                }
+                this->_sync();
+                size_t total = this->offsets_[threads];
+                if (!total)
+                    break;
+                phase++;
+                for (size_t c = this->next_.fetch_add(kBatch); c < total; c = this->next_.fetch_add(kBatch)) {
+                    int t = 0;
+                    for (size_t i = c; i < std::min(c + kBatch, total); i++) {
+                        while (this->offsets_[t + 1] <= i)
+                            t++;
+                        int u = this->workers_[t].frontier[i - this->offsets_[t]];
+                        // a cell filed twice in the phase, lowered to an earlier bucket, or relaxed at this distance
+                        if (this->claim_[u].exchange(phase, std::memory_order_relaxed) == phase)
+                            continue;
+                        double d = this->dist_[u].load(std::memory_order_relaxed);
+                        if ((long)(d / this->delta_) != current || d >= this->relaxed_[u])
+                            continue;
+                        this->relaxed_[u] = d;
+                        me.settled.push_back(u);
+                        int x = u % nx, y = u / nx;
+                        for (int k = 0; k < 8; k++) {
+                            int mx = x + kDx[k], my = y + kDy[k];
+                            if (kCost[k] <= this->delta_ && mx >= 0 && mx < nx && my >= 0 && my < ny &&
+                                this->costs_[my * nx + mx] < this->threshold_)
+                                this->_relax(me, my * nx + mx, d + kCost[k]);
+                        }
+                    }
+                }
+                this->_sync();
+                me.frontier.clear();
+            }
+
+            // heavy phase, the moves of the settled cells into later buckets
+            phase++;
+            for (int u : me.settled) {
+                if (this->claim_[u].exchange(phase, std::memory_order_relaxed) == phase)
+                    continue;
+                double d = this->dist_[u].load(std::memory_order_relaxed);
+                int x = u % nx, y = u / nx;
+                for (int k = 0; k < 8; k++) {
+                    int mx = x + kDx[k], my = y + kDy[k];
+                    if (kCost[k] > this->delta_ && mx >= 0 && mx < nx && my >= 0 && my < ny &&
+                        this->costs_[my * nx + mx] < this->threshold_)
+                        this->_relax(me, my * nx + mx, d + kCost[k]);
+                }
+            }
+            me.settled.clear();
+            this->_sync();
+
+            // the next bucket any worker filed a cell in
+            if (w == 0) {
+                this->bucket_ = -1;
+                for (long b = current + 1; b < current + (long)buckets && this->bucket_ < 0; b++)
+                    for (int t = 0; t < threads && this->bucket_ < 0; t++)
+                        if (!this->workers_[t].buckets[b % buckets].empty())
+                            this->bucket_ = b;
+            }
+            this->_sync();
+        }
+
+        for (size_t i = ns * w / threads; i < ns * (w + 1) / threads; i++)
+            (*this->dist_out_)[i] = this->dist_[i].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief  lower the tentative distance of a cell, and file it in the bucket of the worker if lowered
+     */
+    void DeltaStepping::_relax(Worker& worker, int cell, double d) {
+        double old = this->dist_[cell].load(std::memory_order_relaxed);
+        while (d < old) {
+            if (this->dist_[cell].compare_exchange_weak(old, d, std::memory_order_relaxed)) {
+                worker.buckets[(size_t)(d / this->delta_) % worker.buckets.size()].push_back(cell);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief  wait for every worker at a phase barrier
+     */
+    void DeltaStepping::_sync() {
+        unsigned int generation = this->generation_.load(std::memory_order_acquire);
+        if (this->arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 == this->active_) {
+            this->arrived_.store(0, std::memory_order_relaxed);
+            this->generation_.fetch_add(1, std::memory_order_release);
+        } else {
+            while (this->generation_.load(std::memory_order_acquire) == generation)
+                std::this_thread::yield();
+        }
+    }
+}
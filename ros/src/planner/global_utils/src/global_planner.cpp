@@ -52,6 +52,23 @@ namespace global_planner {
     void GlobalPlanner::setFactor(double factor){
         this->factor_ = factor;
     }
+    /**
+     * @brief  set a flag that makes plan() give up without a path once raised
+     * @param cancel cancel flag, nullptr to disable
+     */
+    void GlobalPlanner::setCancelFlag(const std::atomic<bool>* cancel){
+        this->cancel_ = cancel;
+    }
+    /**
+     * @brief  set the cell the caller clears in the costmaps it searches, e.g. the robot location,
+     *         so that planners precomputing the layout key it on the costmap as it was
+     * @param cell  cell index, -1 for none
+     * @param cost  cost of the cell before it was cleared
+     */
+    void GlobalPlanner::setClearedCell(int cell, unsigned char cost){
+        this->cleared_cell_ = cell;
+        this->cleared_cost_ = cost;
+    }
     /**
      * @brief  transform between grid index(i) and grid map(x, y)
      * @param x grid map x
@@ -94,27 +111,4 @@ namespace global_planner {
         mx = this->resolution_ * (gx + 0.5);
         my = this->resolution_ * (gy + 0.5);
     }
-
-    /**
-     * @brief convert closed list to path
-     * @param closed_list   closed list
-     * @param start         start node
-     * @param goal          goal node
-     * @return vector containing path nodes
-     */
-    std::vector<Node> GlobalPlanner::_convertClosedListToPath(
-            std::unordered_set<Node, NodeIdAsHash, compare_coordinates>& closed_list,
-            const Node& start, const Node& goal) {
-        auto current = *closed_list.find(goal);
-        std::vector<Node> path;
-        while (current != start) {
-            path.push_back(current);
-            auto it = closed_list.find(Node(current.pid % this->nx_, current.pid / this->nx_, 0, 0, current.pid));
-            if (it != closed_list.end()) {
-                current = *it;
-            } else return {};
-        }
-        path.push_back(start);
-        return path;
-    }
 }
\ No newline at end of file
@@ -0,0 +1,315 @@
+/***********************************************************
+ *
+ * @file: path_monitor.cpp
+ * @breif: Contains the global path validity monitor
+ * @author: Yang Haodong
+ * @update: 2023-2-14
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "path_monitor.h"
+#include "trace.h"
+
+namespace global_planner {
+/**
+ * @brief  Constructor
+ */
+PathMonitor::PathMonitor()
+    : obstacle_cost_(LETHAL_COST * OBSTACLE_FACTOR), max_deviation_(10), max_age_(5.0), cost_ratio_(1.5),
+      stamp_(0.0), checked_version_(0) {}
+
+/**
+ * @brief  Set the monitor parameters
+ * @param  obstacle_cost    cells with cost greater or equal are blocked
+ * @param  max_deviation    maximum distance in cells between the robot and the path
+ * @param  max_age          the path is searched again after this many seconds, to pick up new corridors
+ * @param  cost_ratio       the path is searched again when its remaining cost grew by this ratio
+ */
+void PathMonitor::setParams(double obstacle_cost, int max_deviation, double max_age, double cost_ratio) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->obstacle_cost_ = obstacle_cost;
+    this->max_deviation_ = max_deviation;
+    this->max_age_ = max_age;
+    this->cost_ratio_ = cost_ratio;
+}
+
+/**
+ * @brief  forget the monitored path
+ */
+void PathMonitor::reset() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->nodes_.clear();
+    this->cells_.clear();
+}
+
+/**
+ * @brief  monitor a new path
+ * @param  path     path as returned by GlobalPlanner::plan(), goal first
+ * @param  snapshot costmap the path was planned on
+ * @param  stamp    planning time in seconds
+ */
+void PathMonitor::update(const std::vector<Node>& path, const CostmapSnapshot& snapshot, double stamp) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->nodes_.assign(path.rbegin(), path.rend());
+    this->stamp_ = stamp;
+    this->checked_version_ = snapshot.version();
+    this->_rebuildCells(snapshot);
+}
+
+/**
+ * @brief  check the monitored path against the current costmap
+ * @param  snapshot current costmap
+ * @param  start    robot cell
+ * @param  goal     goal cell
+ * @param  stamp    current time in seconds
+ * @param  path     monitored path trimmed to the robot cell, goal first as GlobalPlanner::plan()
+ * @return true if the monitored path is still valid, false if a search is needed
+ */
+bool PathMonitor::check(const CostmapSnapshot& snapshot, const Node& start, const Node& goal, double stamp,
+                        std::vector<Node>& path) {
+    TRACE_SCOPE("PathMonitor::check");
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->_isReusable(goal, stamp))
+        return false;
+    int closest = this->_closestCell(start);
+    if (closest < 0)
+        return false;
+
+    // only the remaining cells are checked, and only when a tile of the costmap changed
+    if (snapshot.version() != this->checked_version_) {
+        double cost = 0.0;
+        for (int i = closest; i < (int)this->cells_.size(); i++) {
+            unsigned char c = snapshot.getCost(this->cells_[i].x, this->cells_[i].y);
+            if (c >= this->obstacle_cost_)
+                return false;
+            cost += c;
+        }
+        double planned = this->cells_.back().cost - (closest ? this->cells_[closest - 1].cost : 0.0);
+        if (cost > this->cost_ratio_ * planned + NEUTRAL_COST)
+            return false;
+        this->checked_version_ = snapshot.version();
+    }
+
+    return this->_trim(snapshot, start, closest, path);
+}
+
+/**
+ * @brief  repair the monitored path around its blocked stretches by searching a window around each
+ *         of them, from the last free cell before to the first free waypoint after the block
+ * @param  snapshot current costmap
+ * @param  start    robot cell
+ * @param  goal     goal cell
+ * @param  stamp    current time in seconds
+ * @param  margin   cells kept free before and after a blocked stretch, and window padding
+ * @param  search   window search
+ * @param  path     repaired path trimmed to the robot cell, goal first as GlobalPlanner::plan()
+ * @return true if the path was repaired, false if a full search is needed
+ */
+bool PathMonitor::repair(const CostmapSnapshot& snapshot, const Node& start, const Node& goal, double stamp,
+                         int margin, const WindowSearch& search, std::vector<Node>& path) {
+    TRACE_SCOPE("PathMonitor::repair");
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->_isReusable(goal, stamp))
+        return false;
+    int closest = this->_closestCell(start);
+    if (closest < 0)
+        return false;
+
+    auto isBlocked = [&](int i) {
+        return snapshot.getCost(this->cells_[i].x, this->cells_[i].y) >= this->obstacle_cost_;
+    };
+
+    // a few blocked stretches are repaired one after the other, beyond that a full search is cheaper
+    bool repaired = false;
+    for (int stretch = 0; stretch < 4; stretch++) {
+        int n = (int)this->cells_.size(), blocked = closest;
+        while (blocked < n && !isBlocked(blocked))
+            blocked++;
+        if (blocked == n) {
+            this->checked_version_ = snapshot.version();
+            return repaired && this->_trim(snapshot, start, closest, path);
+        }
+
+        // last free cell before the block, none if the robot is at the block, and the end of the block:
+        // margin free cells in a row
+        if (blocked == closest)
+            return false;
+        int entry = std::max(closest, blocked - margin);
+        int i = blocked, free_run = 0;
+        for (; i < n && free_run < margin; i++)
+            free_run = isBlocked(i) ? 0 : free_run + 1;
+        if (free_run == 0)
+            return false;
+
+        // first free waypoint after the block
+        int exit_node = this->cells_[i - 1].segment;
+        while (exit_node < (int)this->nodes_.size() &&
+               snapshot.getCost(this->nodes_[exit_node].x, this->nodes_[exit_node].y) >= this->obstacle_cost_)
+            exit_node++;
+        if (exit_node == (int)this->nodes_.size())
+            return false;
+
+        // window around the cells from the entry to the exit waypoint
+        int x0 = this->cells_[entry].x, x1 = x0, y0 = this->cells_[entry].y, y1 = y0;
+        for (int j = entry; j < n && this->cells_[j].segment <= exit_node; j++) {
+            x0 = std::min(x0, this->cells_[j].x);
+            x1 = std::max(x1, this->cells_[j].x);
+            y0 = std::min(y0, this->cells_[j].y);
+            y1 = std::max(y1, this->cells_[j].y);
+        }
+        x0 = std::max(0, x0 - margin);
+        y0 = std::max(0, y0 - margin);
+        x1 = std::min(snapshot.nx() - 1, x1 + margin);
+        y1 = std::min(snapshot.ny() - 1, y1 + margin);
+
+        Node n_entry(this->cells_[entry].x, this->cells_[entry].y);
+        const Node& n_exit = this->nodes_[exit_node];
+        std::vector<Node> detour;
+        if (!search(n_entry, n_exit, x0, y0, x1, y1, detour) || detour.empty())
+            return false;
+
+        // splice: nodes before the entry cell, the detour from the entry to the exit, nodes after the exit
+        std::vector<Node> nodes(this->nodes_.begin(), this->nodes_.begin() + this->cells_[entry].segment);
+        nodes.push_back(n_entry);
+        for (auto it = detour.rbegin() + 1; it != detour.rend(); ++it)
+            nodes.push_back(*it);
+        nodes.insert(nodes.end(), this->nodes_.begin() + exit_node + 1, this->nodes_.end());
+        this->nodes_.swap(nodes);
+        this->_rebuildCells(snapshot);
+
+        closest = this->_closestCell(start);
+        if (closest < 0)
+            return false;
+        repaired = true;
+    }
+    return false;
+}
+
+/**
+ * @brief  whether the path leads to the goal and is recent enough to be reused
+ */
+bool PathMonitor::_isReusable(const Node& goal, double stamp) const {
+    if (this->cells_.empty() || this->nodes_.back().x != goal.x || this->nodes_.back().y != goal.y)
+        return false;
+    return stamp - this->stamp_ <= this->max_age_;
+}
+
+/**
+ * @brief  index of the path cell closest to the robot
+ * @param  start    robot cell
+ * @return cell index, -1 if the robot is farther than max_deviation from the path
+ */
+int PathMonitor::_closestCell(const Node& start) const {
+    int closest = -1, d_min = std::numeric_limits<int>::max();
+    for (int i = 0; i < (int)this->cells_.size(); i++) {
+        int dx = this->cells_[i].x - start.x, dy = this->cells_[i].y - start.y;
+        if (dx * dx + dy * dy < d_min) {
+            d_min = dx * dx + dy * dy;
+            closest = i;
+        }
+    }
+    return d_min > this->max_deviation_ * this->max_deviation_ ? -1 : closest;
+}
+
+/**
+ * @brief  rebuild the traversed cells and their planned cost from the path nodes
+ * @param  snapshot costmap the costs are taken from
+ */
+void PathMonitor::_rebuildCells(const CostmapSnapshot& snapshot) {
+    this->cells_.clear();
+    if (this->nodes_.empty())
+        return;
+
+    // integer line traversal of every segment, jump point paths have segments longer than one cell
+    this->cells_.push_back({ this->nodes_[0].x, this->nodes_[0].y, 0, 0.0 });
+    for (int i = 1; i < (int)this->nodes_.size(); i++)
+        this->_traverse(this->nodes_[i - 1].x, this->nodes_[i - 1].y, this->nodes_[i].x, this->nodes_[i].y, i);
+
+    double cost = 0.0;
+    for (auto& cell : this->cells_) {
+        cost += snapshot.getCost(cell.x, cell.y);
+        cell.cost = cost;
+    }
+}
+
+/**
+ * @brief  trim the path to the robot cell
+ * @param  snapshot current costmap
+ * @param  start    robot cell
+ * @param  closest  index of the path cell closest to the robot
+ * @param  path     trimmed path, goal first
+ * @return false if the robot cannot reach the next waypoint in a straight line
+ */
+bool PathMonitor::_trim(const CostmapSnapshot& snapshot, const Node& start, int closest,
+                        std::vector<Node>& path) const {
+    // robot cell, then the nodes the remaining cells lead to
+    int next = std::max(1, this->cells_[closest].segment);
+    if (next >= (int)this->nodes_.size() ||
+        !this->_isSegmentFree(snapshot, start.x, start.y, this->nodes_[next].x, this->nodes_[next].y))
+        return false;
+
+    path.clear();
+    for (int i = (int)this->nodes_.size() - 1; i >= next; i--)
+        path.push_back(this->nodes_[i]);
+    path.push_back(start);
+    return true;
+}
+
+/**
+ * @brief  append the cells of the segment from (x0, y0) to (x1, y1), excluding the first one
+ * @param  x0       segment start x
+ * @param  y0       segment start y
+ * @param  x1       segment end x
+ * @param  y1       segment end y
+ * @param  segment  index of the path node the segment ends at
+ */
+void PathMonitor::_traverse(int x0, int y0, int x1, int y1, int segment) {
+    int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (x0 != x1 || y0 != y1) {
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+        this->cells_.push_back({ x0, y0, segment, 0.0 });
+    }
+}
+
+/**
+ * @brief  whether the segment from (x0, y0) to (x1, y1) is free in the snapshot
+ */
+bool PathMonitor::_isSegmentFree(const CostmapSnapshot& snapshot, int x0, int y0, int x1, int y1) const {
+    int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (x0 != x1 || y0 != y1) {
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+        if (snapshot.getCost(x0, y0) >= this->obstacle_cost_)
+            return false;
+    }
+    return true;
+}
+}
@@ -0,0 +1,53 @@
+/***********************************************************
+ *
+ * @file: plan_arena.cpp
+ * @breif: Contains the per-search memory arena of the planners
+ * @author: Yang Haodong
+ * @update: 2023-2-19
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include "plan_arena.h"
+
+namespace global_planner {
+/**
+ * @brief  Constructor
+ * @param  size     initial buffer size in bytes
+ */
+PlanArena::PlanArena(size_t size)
+    : size_(size), buffer_(new char[size]),
+      resource_(new std::pmr::monotonic_buffer_resource(buffer_.get(), size, &overflow_)) {}
+
+/**
+ * @brief  release everything allocated since the last reset, the containers using it must be gone.
+ *         The buffer grows when the search did not fit.
+ */
+void PlanArena::reset() {
+    this->resource_->release();
+    if (this->overflow_.bytes == 0)
+        return;
+
+    // room for the whole search next time
+    size_t size = this->size_;
+    while (size < this->size_ + this->overflow_.bytes)
+        size *= 2;
+    this->overflow_.bytes = 0;
+    this->resource_.reset();
+    this->buffer_.reset(new char[size]);
+    this->size_ = size;
+    this->resource_.reset(new std::pmr::monotonic_buffer_resource(this->buffer_.get(), size, &this->overflow_));
+}
+
+void* PlanArena::Overflow::do_allocate(size_t bytes, size_t alignment) {
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void PlanArena::Overflow::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+}
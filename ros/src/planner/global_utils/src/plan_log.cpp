@@ -0,0 +1,281 @@
+/***********************************************************
+ *
+ * @file: plan_log.cpp
+ * @breif: Contains the planning request record and replay log
+ * @author: Yang Haodong
+ * @update: 2023-2-17
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <cstring>
+
+#include "plan_log.h"
+
+namespace global_planner {
+namespace {
+// log magic, followed by the records
+const char kMagic[8] = { 'G', 'P', 'L', 'O', 'G', '0', '0', '1' };
+// equal cells that end a run of changed cells
+const size_t kMinEqualRun = 4;
+
+/**
+ * @brief Appends little-endian fields to a record payload
+ */
+class Encoder {
+    public:
+        void putVarint(uint64_t v) {
+            while (v >= 0x80) {
+                this->buf.push_back((char)(v | 0x80));
+                v >>= 7;
+            }
+            this->buf.push_back((char)v);
+        }
+        template <typename T>
+        void put(const T& v) { this->buf.append(reinterpret_cast<const char*>(&v), sizeof(T)); }
+        void putString(const std::string& s) {
+            this->putVarint(s.size());
+            this->buf.append(s);
+        }
+
+        std::string buf;
+};
+
+/**
+ * @brief Reads fields from a record payload, every read fails past the end
+ */
+class Decoder {
+    public:
+        Decoder(const std::string& buf) : buf(buf), pos(0) {}
+        bool getVarint(uint64_t& v) {
+            v = 0;
+            for (int shift = 0; shift < 64 && this->pos < this->buf.size(); shift += 7) {
+                unsigned char c = this->buf[this->pos++];
+                v |= (uint64_t)(c & 0x7f) << shift;
+                if (!(c & 0x80))
+                    return true;
+            }
+            return false;
+        }
+        template <typename T>
+        bool get(T& v) {
+            if (this->buf.size() - this->pos < sizeof(T))
+                return false;
+            std::memcpy(&v, &this->buf[this->pos], sizeof(T));
+            this->pos += sizeof(T);
+            return true;
+        }
+        bool getString(std::string& s) {
+            uint64_t n;
+            if (!this->getVarint(n) || this->buf.size() - this->pos < n)
+                return false;
+            s.assign(this->buf, this->pos, n);
+            this->pos += n;
+            return true;
+        }
+
+        const std::string& buf;
+        size_t pos;
+};
+}
+
+/******************************** Request ****************************************/
+/**
+ * @brief  value of a parameter
+ * @param  name     parameter name
+ * @param  value    default value
+ */
+std::string PlanRequest::param(const std::string& name, const std::string& value) const {
+    for (const auto& p : this->params)
+        if (p.first == name)
+            return p.second;
+    return value;
+}
+
+/******************************** Writer ****************************************/
+/**
+ * @brief  Constructor(closed log)
+ */
+PlanLogWriter::PlanLogWriter() {}
+
+/**
+ * @brief  open a log for appending, a new log starts with a header
+ * @param  path     log file path
+ * @return true if the log was opened
+ */
+bool PlanLogWriter::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->out_.is_open())
+        this->out_.close();
+    this->out_.open(path, std::ios::binary | std::ios::app);
+    if (!this->out_)
+        return false;
+    if (this->out_.tellp() == 0)
+        this->out_.write(kMagic, sizeof(kMagic));
+    // records of an earlier session cannot be referenced, the first costmap is stored whole
+    this->prev_costs_.clear();
+    return this->out_.flush().good();
+}
+
+/**
+ * @brief  whether a log is open
+ */
+bool PlanLogWriter::isOpen() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->out_.is_open();
+}
+
+/**
+ * @brief  append a request, thread-safe
+ * @param  request  request and result
+ * @param  costs    costmap the backend searched, of size nx * ny
+ * @return true if the record was written
+ */
+bool PlanLogWriter::record(const PlanRequest& request, const unsigned char* costs) {
+    Encoder e;
+    e.putString(request.planner);
+    e.putVarint(request.params.size());
+    for (const auto& p : request.params) {
+        e.putString(p.first);
+        e.putString(p.second);
+    }
+    e.put(request.stamp);
+    e.put((int32_t)request.nx);
+    e.put((int32_t)request.ny);
+    e.put(request.resolution);
+    e.put(request.factor);
+    e.put(request.seed);
+    e.put((int32_t)request.start_x);
+    e.put((int32_t)request.start_y);
+    e.put((int32_t)request.goal_x);
+    e.put((int32_t)request.goal_y);
+    e.put((uint8_t)request.found);
+    e.putVarint(request.path.size());
+    for (const auto& p : request.path) {
+        e.put((int32_t)p.first);
+        e.put((int32_t)p.second);
+    }
+    e.put(request.expand_num);
+    e.put(request.plan_time);
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->out_.is_open())
+        return false;
+
+    // costmap: alternating runs of cells equal to the previous costmap and of changed cells
+    size_t n = (size_t)request.nx * request.ny;
+    bool keyframe = this->prev_costs_.size() != n;
+    if (keyframe)
+        this->prev_costs_.assign(n, 0);
+    const unsigned char* prev = this->prev_costs_.data();
+    e.put((uint8_t)keyframe);
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && costs[j] == prev[j])
+            j++;
+        e.putVarint(j - i);
+        i = j;
+        // changed run, ended by a few equal cells in a row
+        size_t equal = 0;
+        for (; j < n; j++) {
+            equal = costs[j] == prev[j] ? equal + 1 : 0;
+            if (equal == kMinEqualRun) {
+                j -= kMinEqualRun - 1;
+                break;
+            }
+        }
+        e.putVarint(j - i);
+        e.buf.append(reinterpret_cast<const char*>(costs + i), j - i);
+        i = j;
+    }
+    std::memcpy(this->prev_costs_.data(), costs, n);
+
+    uint32_t size = (uint32_t)e.buf.size();
+    this->out_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    this->out_.write(e.buf.data(), e.buf.size());
+    return this->out_.flush().good();
+}
+
+/******************************** Reader ****************************************/
+/**
+ * @brief  open a log
+ * @param  path     log file path
+ * @return false if the file is missing or is not a planning request log
+ */
+bool PlanLogReader::open(const std::string& path) {
+    this->in_.close();
+    this->in_.clear();
+    this->in_.open(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    this->prev_costs_.clear();
+    return this->in_.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+/**
+ * @brief  read the next record
+ * @param  request  request and recorded result
+ * @param  costs    costmap the backend searched
+ * @return false at the end of the log or at a truncated record
+ */
+bool PlanLogReader::next(PlanRequest& request, std::vector<unsigned char>& costs) {
+    uint32_t size;
+    if (!this->in_.read(reinterpret_cast<char*>(&size), sizeof(size)))
+        return false;
+    std::string buf(size, '\0');
+    if (!this->in_.read(&buf[0], size))
+        return false;
+
+    Decoder d(buf);
+    request = PlanRequest();
+    uint64_t num;
+    // counts are checked against the bytes left before anything is sized by them, a parameter takes two at least
+    if (!d.getString(request.planner) || !d.getVarint(num) || num > (buf.size() - d.pos) / 2)
+        return false;
+    request.params.resize(num);
+    for (auto& p : request.params)
+        if (!d.getString(p.first) || !d.getString(p.second))
+            return false;
+    int32_t nx, ny, sx, sy, gx, gy;
+    uint8_t found, keyframe;
+    if (!d.get(request.stamp) || !d.get(nx) || !d.get(ny) || !d.get(request.resolution) || !d.get(request.factor) ||
+        !d.get(request.seed) || !d.get(sx) || !d.get(sy) || !d.get(gx) || !d.get(gy) || !d.get(found) ||
+        !d.getVarint(num) || num > (buf.size() - d.pos) / 8 || nx < 0 || ny < 0)
+        return false;
+    request.nx = nx;
+    request.ny = ny;
+    request.start_x = sx;
+    request.start_y = sy;
+    request.goal_x = gx;
+    request.goal_y = gy;
+    request.found = found;
+    request.path.resize(num);
+    for (auto& p : request.path) {
+        int32_t x, y;
+        if (!d.get(x) || !d.get(y))
+            return false;
+        p = { x, y };
+    }
+    if (!d.get(request.expand_num) || !d.get(request.plan_time) || !d.get(keyframe))
+        return false;
+
+    size_t n = (size_t)nx * ny;
+    if (keyframe || this->prev_costs_.size() != n)
+        this->prev_costs_.assign(n, 0);
+    for (size_t i = 0; i < n;) {
+        uint64_t equal, changed;
+        if (!d.getVarint(equal) || equal > n - i)
+            return false;
+        i += equal;
+        if (!d.getVarint(changed) || changed > n - i || changed > buf.size() - d.pos)
+            return false;
+        std::memcpy(&this->prev_costs_[i], &buf[d.pos], changed);
+        d.pos += changed;
+        i += changed;
+    }
+    costs = this->prev_costs_;
+    return true;
+}
+}
@@ -0,0 +1,100 @@
+/***********************************************************
+ *
+ * @file: planner_pool.cpp
+ * @breif: Contains the pool of per-call planning workspaces
+ * @author: Yang Haodong
+ * @update: 2023-2-12
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+
+#include "planner_pool.h"
+#include "trace.h"
+
+namespace global_planner {
+/**
+ * @brief  Constructor
+ */
+PlannerPool::PlannerPool() : capacity_(1), created_(0), generation_(0) {}
+
+/**
+ * @brief  Set the planner factory and the maximum number of workspaces, dropping existing ones
+ * @param  factory  creates a planner for a new workspace
+ * @param  capacity maximum number of concurrent workspaces, 1 for planners that keep state across calls
+ */
+void PlannerPool::reset(Factory factory, int capacity) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->factory_ = factory;
+    this->capacity_ = std::max(1, capacity);
+    // workspaces in use still count until they are given back
+    this->created_ -= (int)this->idle_.size();
+    this->generation_++;
+    this->idle_.clear();
+    this->released_.notify_all();
+}
+
+/**
+ * @brief  Drop all workspaces, workspaces in use are discarded when given back and count against
+ *         the capacity until then
+ */
+void PlannerPool::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    // workspaces in use still count until they are given back
+    this->created_ -= (int)this->idle_.size();
+    this->generation_++;
+    this->idle_.clear();
+    this->released_.notify_all();
+}
+
+/**
+ * @brief  Borrow a workspace, blocks while all workspaces are in use
+ * @return workspace handle
+ */
+PlannerPool::Handle PlannerPool::acquire() {
+    TRACE_SCOPE("PlannerPool::acquire");
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->released_.wait(lock, [this] { return !this->idle_.empty() || this->created_ < this->capacity_; });
+
+    std::unique_ptr<PlannerWorkspace> ws;
+    if (!this->idle_.empty()) {
+        ws = std::move(this->idle_.back());
+        this->idle_.pop_back();
+    } else {
+        this->created_++;
+        Factory factory = this->factory_;
+        unsigned int generation = this->generation_;
+        // planner construction may allocate whole-map buffers, keep it out of the pool lock
+        lock.unlock();
+        try {
+            ws.reset(new PlannerWorkspace());
+            ws->planner.reset(factory());
+        } catch (...) {
+            lock.lock();
+            this->created_--;
+            this->released_.notify_one();
+            throw;
+        }
+        return Handle(this, std::move(ws), generation);
+    }
+    return Handle(this, std::move(ws), this->generation_);
+}
+
+/**
+ * @brief  Give a workspace back to the pool
+ * @param  ws           workspace
+ * @param  generation   pool generation the workspace was created in
+ */
+void PlannerPool::_release(std::unique_ptr<PlannerWorkspace> ws, unsigned int generation) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (generation == this->generation_)
+        this->idle_.push_back(std::move(ws));
+    else
+        this->created_--;
+    this->released_.notify_one();
+}
+}
@@ -0,0 +1,203 @@
+/***********************************************************
+ *
+ * @file: portfolio_planner.cpp
+ * @breif: Contains the portfolio planner racing several planners
+ * @author: Yang Haodong
+ * @update: 2023-2-15
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include "portfolio_planner.h"
+#include "trace.h"
+
+namespace global_planner {
+/******************************** Statistics ****************************************/
+/**
+ * @brief  count one search of a backend
+ * @param  name     backend name
+ * @param  won      whether its path was returned
+ * @param  found    whether it found a path
+ * @param  canceled whether it was canceled before finishing
+ * @param  time     search time in seconds
+ */
+void PortfolioStatistics::record(const std::string& name, bool won, bool found, bool canceled, double time) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    Record& r = this->records_[name];
+    r.runs++;
+    r.wins += won;
+    r.failures += !found && !canceled;
+    r.canceled += canceled;
+    r.time += time;
+}
+
+/**
+ * @brief  copy of the counters of every backend
+ */
+std::map<std::string, PortfolioStatistics::Record> PortfolioStatistics::records() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->records_;
+}
+
+/**
+ * @brief  one line summary of the counters, e.g. for logging
+ */
+std::string PortfolioStatistics::summary() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    std::ostringstream os;
+    for (const auto& it : this->records_) {
+        const Record& r = it.second;
+        os << it.first << ": " << r.wins << "/" << r.runs << " wins, " << r.failures << " failed, " << r.canceled
+           << " canceled, " << (r.runs ? 1000.0 * r.time / r.runs : 0.0) << " ms avg; ";
+    }
+    return os.str();
+}
+
+/******************************** Portfolio ****************************************/
+/**
+ * @brief  Constructor
+ * @param   nx              pixel number in costmap x direction
+ * @param   ny              pixel number in costmap y direction
+ * @param   resolution      costmap resolution
+ * @param   quality_bound   accepted path length as a multiple of the straight line distance
+ * @param   stats           outcome statistics, nullptr to disable
+ */
+PortfolioPlanner::PortfolioPlanner(int nx, int ny, double resolution, double quality_bound,
+                                   std::shared_ptr<PortfolioStatistics> stats)
+    : GlobalPlanner(nx, ny, resolution), quality_bound_(quality_bound), stats_(stats) {}
+
+/**
+ * @brief  add a backend, the portfolio takes ownership of the planner
+ * @param  name     backend name used in the statistics
+ * @param  planner  backend planner of the same costmap size
+ */
+void PortfolioPlanner::addBackend(const std::string& name, GlobalPlanner* planner) {
+    planner->setFactor(this->factor_);
+    this->backends_.push_back({ name, std::unique_ptr<GlobalPlanner>(planner) });
+}
+
+/**
+ * @brief  set or reset obstacle factor of the portfolio and its backends
+ * @param factor obstacle factor
+ */
+void PortfolioPlanner::setFactor(double factor) {
+    GlobalPlanner::setFactor(factor);
+    for (auto& backend : this->backends_)
+        backend.planner->setFactor(factor);
+}
+
+/**
+ * @brief  set the cell the caller clears in the costmaps, for the portfolio and its backends
+ * @param cell  cell index, -1 for none
+ * @param cost  cost of the cell before it was cleared
+ */
+void PortfolioPlanner::setClearedCell(int cell, unsigned char cost) {
+    GlobalPlanner::setClearedCell(cell, cost);
+    for (auto& backend : this->backends_)
+        backend.planner->setClearedCell(cell, cost);
+}
+
+/**
+ * @brief Race the backends
+ * @param costs     costmap
+ * @param start     start node
+ * @param goal      goal node
+ * @param expand    containing the node been search by the returned backend
+ * @return tuple contatining a bool as to whether a path was found, and the path
+ */
+std::tuple<bool, std::vector<Node>> PortfolioPlanner::plan(const unsigned char* costs, const Node& start,
+                                                           const Node& goal, std::vector<Node>& expand) {
+    TRACE_SCOPE("PortfolioPlanner::plan");
+    expand.clear();
+    int n = (int)this->backends_.size();
+    if (n == 0)
+        return {false, {}};
+
+    /**
+     * @brief Outcome of one backend search
+     */
+    struct Result {
+        bool found = false, canceled = false;
+        double length = std::numeric_limits<double>::max(), time = 0.0;
+        std::vector<Node> path, expand;
+    };
+    std::vector<Result> results(n);
+    std::atomic<bool> cancel(false);
+    std::mutex mutex;
+    std::condition_variable finished;
+    int done = 0, winner = -1;
+    double bound = this->quality_bound_ * std::max(1.0, std::hypot(goal.x - start.x, goal.y - start.y));
+
+    // every backend searches the same read-only costmap with its own state
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n; i++) {
+        GlobalPlanner* planner = this->backends_[i].planner.get();
+        planner->setCancelFlag(&cancel);
+        threads.emplace_back([&, i, planner]() {
+            Result& r = results[i];
+            auto t0 = std::chrono::steady_clock::now();
+            std::tie(r.found, r.path) = planner->plan(costs, start, goal, r.expand);
+            r.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            r.canceled = !r.found && cancel.load();
+            if (r.found)
+                r.length = this->_pathLength(r.path);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            done++;
+            if (r.found && winner < 0 && r.length <= bound) {
+                winner = i;
+                cancel.store(true);
+            }
+            finished.notify_one();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return winner >= 0 || done == n; });
+    }
+    cancel.store(true);
+    for (auto& t : threads)
+        t.join();
+    for (auto& backend : this->backends_)
+        backend.planner->setCancelFlag(nullptr);
+
+    // no path met the bound, take the shortest one
+    if (winner < 0) {
+        for (int i = 0; i < n; i++)
+            if (results[i].found && (winner < 0 || results[i].length < results[winner].length))
+                winner = i;
+    }
+
+    if (this->stats_) {
+        for (int i = 0; i < n; i++)
+            this->stats_->record(this->backends_[i].name, i == winner, results[i].found, results[i].canceled,
+                                 results[i].time);
+    }
+
+    if (winner < 0)
+        return {false, {}};
+    expand.swap(results[winner].expand);
+    return {true, std::move(results[winner].path)};
+}
+
+/**
+ * @brief  length of a path in cells
+ */
+double PortfolioPlanner::_pathLength(const std::vector<Node>& path) const {
+    double length = 0.0;
+    for (size_t i = 1; i < path.size(); i++)
+        length += std::hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+    return length;
+}
+}
@@ -0,0 +1,349 @@
+/***********************************************************
+ *
+ * @file: precompute_store.cpp
+ * @breif: Contains the memory-mapped store of planner precomputations
+ * @author: Yang Haodong
+ * @update: 2023-2-16
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "precompute_store.h"
+
+namespace global_planner {
+namespace {
+// file magic and container format version
+const char kMagic[8] = { 'G', 'P', 'S', 'T', 'O', 'R', 'E', '\0' };
+const uint32_t kFormat = 1;
+// section payload alignment
+const size_t kAlign = 64;
+
+/**
+ * @brief File header
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t format;
+    // section layout version chosen by the planner
+    uint32_t version;
+    uint64_t key;
+    uint64_t file_size;
+    uint32_t section_num;
+    char reserved[28];
+};
+
+/**
+ * @brief Section table entry, following the header
+ */
+struct SectionEntry {
+    char name[32];
+    // payload offset from the file start, and size in bytes
+    uint64_t offset, size;
+    char reserved[16];
+};
+
+static_assert(sizeof(FileHeader) == kAlign && sizeof(SectionEntry) == kAlign, "unexpected padding");
+
+size_t alignUp(size_t n) { return (n + kAlign - 1) / kAlign * kAlign; }
+}
+
+/******************************** Key ****************************************/
+/**
+ * @brief  Constructor
+ */
+PrecomputeKey::PrecomputeKey() : hash_(14695981039346656037ULL) {}
+
+/**
+ * @brief  mix raw bytes into the key
+ * @param  data     bytes
+ * @param  size     number of bytes
+ * @return this key
+ */
+PrecomputeKey& PrecomputeKey::add(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        this->hash_ ^= p[i];
+        this->hash_ *= 1099511628211ULL;
+    }
+    return *this;
+}
+
+/**
+ * @brief  mix a string into the key, e.g. a planner name
+ */
+PrecomputeKey& PrecomputeKey::add(const std::string& value) {
+    this->add((int)value.size());
+    return this->add(value.data(), value.size());
+}
+
+/**
+ * @brief  mix costmap contents and geometry into the key
+ * @param  costs        costmap
+ * @param  nx           pixel number in costmap x direction
+ * @param  ny           pixel number in costmap y direction
+ * @param  resolution   costmap resolution
+ * @return this key
+ */
+PrecomputeKey& PrecomputeKey::addCostmap(const unsigned char* costs, int nx, int ny, double resolution) {
+    this->add(nx).add(ny).add(resolution);
+    return this->add(costs, (size_t)nx * ny);
+}
+
+/******************************** Writer ****************************************/
+/**
+ * @brief  add a section, the data is copied
+ * @param  name     section name, at most 31 characters
+ * @param  data     section bytes
+ * @param  size     number of bytes
+ */
+void PrecomputeWriter::addSection(const std::string& name, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    this->sections_.emplace_back(name.substr(0, sizeof(SectionEntry::name) - 1), std::vector<char>(p, p + size));
+}
+
+/**
+ * @brief  write the file, through a temporary file renamed into place so readers never see a partial file
+ * @param  path     file path
+ * @param  key      key of the data the sections were computed from
+ * @param  version  layout version of the sections, chosen by the planner
+ * @return true if the file was written
+ */
+bool PrecomputeWriter::write(const std::string& path, uint64_t key, uint32_t version) const {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format = kFormat;
+    header.version = version;
+    header.key = key;
+    header.section_num = (uint32_t)this->sections_.size();
+
+    // payloads follow the section table, each aligned for direct use as typed arrays
+    std::vector<SectionEntry> table(this->sections_.size());
+    size_t offset = sizeof(FileHeader) + table.size() * sizeof(SectionEntry);
+    for (size_t i = 0; i < table.size(); i++) {
+        std::memset(&table[i], 0, sizeof(SectionEntry));
+        std::strncpy(table[i].name, this->sections_[i].first.c_str(), sizeof(table[i].name) - 1);
+        table[i].offset = offset;
+        table[i].size = this->sections_[i].second.size();
+        offset = alignUp(offset + table[i].size);
+    }
+    header.file_size = offset;
+
+    std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SectionEntry));
+        const std::vector<char> padding(kAlign, 0);
+        for (size_t i = 0; i < table.size(); i++) {
+            const std::vector<char>& bytes = this->sections_[i].second;
+            out.write(bytes.data(), bytes.size());
+            out.write(padding.data(), alignUp(bytes.size()) - bytes.size());
+        }
+        if (!out.flush()) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/******************************** Mapping ****************************************/
+/**
+ * @brief  Constructor(closed mapping)
+ */
+PrecomputeMapping::PrecomputeMapping() : data_(nullptr), size_(0) {}
+
+PrecomputeMapping::PrecomputeMapping(PrecomputeMapping&& other) : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+PrecomputeMapping& PrecomputeMapping::operator=(PrecomputeMapping&& other) {
+    if (this != &other) {
+        this->close();
+        std::swap(this->data_, other.data_);
+        std::swap(this->size_, other.size_);
+    }
+    return *this;
+}
+
+PrecomputeMapping::~PrecomputeMapping() { this->close(); }
+
+/**
+ * @brief  map a precomputation file
+ * @param  path     file path
+ * @param  key      expected key
+ * @param  version  expected section layout version
+ * @return false if the file is missing, malformed or was computed from other data
+ */
+bool PrecomputeMapping::open(const std::string& path, uint64_t key, uint32_t version) {
+    this->close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    this->data_ = static_cast<const char*>(data);
+    this->size_ = st.st_size;
+
+    // reject other formats, stale keys and truncated files
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(this->data_);
+    bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 && header->format == kFormat &&
+                 header->version == version && header->key == key && header->file_size == this->size_ &&
+                 sizeof(FileHeader) + (size_t)header->section_num * sizeof(SectionEntry) <= this->size_;
+    const SectionEntry* table = reinterpret_cast<const SectionEntry*>(this->data_ + sizeof(FileHeader));
+    for (uint32_t i = 0; valid && i < header->section_num; i++)
+        valid = table[i].offset % kAlign == 0 && table[i].offset <= this->size_ &&
+                table[i].size <= this->size_ - table[i].offset;
+    if (!valid)
+        this->close();
+    return valid;
+}
+
+/**
+ * @brief  unmap the file
+ */
+void PrecomputeMapping::close() {
+    if (this->data_)
+        ::munmap(const_cast<char*>(this->data_), this->size_);
+    this->data_ = nullptr;
+    this->size_ = 0;
+}
+
+/**
+ * @brief  find a section
+ * @param  name     section name
+ * @param  data     section bytes, aligned to 64 bytes
+ * @param  size     number of bytes
+ * @return true if the section exists
+ */
+bool PrecomputeMapping::section(const std::string& name, const void*& data, size_t& size) const {
+    if (!this->data_)
+        return false;
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(this->data_);
+    const SectionEntry* table = reinterpret_cast<const SectionEntry*>(this->data_ + sizeof(FileHeader));
+    for (uint32_t i = 0; i < header->section_num; i++) {
+        if (std::strncmp(table[i].name, name.c_str(), sizeof(table[i].name)) == 0) {
+            data = this->data_ + table[i].offset;
+            size = table[i].size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************** Store ****************************************/
+/**
+ * @brief  Constructor
+ * @param  directory    store directory, created on the first save, empty to disable the store
+ */
+PrecomputeStore::PrecomputeStore(const std::string& directory) : directory_(directory) {
+    while (this->directory_.size() > 1 && this->directory_.back() == '/')
+        this->directory_.pop_back();
+}
+
+/**
+ * @brief  file path of a precomputation
+ * @param  name     precomputation name, e.g. "jps_jump_table"
+ * @param  key      key of the data it is computed from
+ */
+std::string PrecomputeStore::path(const std::string& name, uint64_t key) const {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+    return this->directory_ + "/" + name + "_" + hex + ".bin";
+}
+
+/**
+ * @brief  map a stored precomputation
+ * @param  name     precomputation name
+ * @param  key      key of the data it is computed from
+ * @param  version  section layout version
+ * @param  mapping  mapping of the file
+ * @return true if a matching file was mapped, its modification time is set to now
+ */
+bool PrecomputeStore::load(const std::string& name, uint64_t key, uint32_t version,
+                           PrecomputeMapping& mapping) const {
+    if (!this->enabled() || !mapping.open(this->path(name, key), key, version))
+        return false;
+    // the modification time orders the files by use for prune()
+    ::utime(this->path(name, key).c_str(), nullptr);
+    return true;
+}
+
+/**
+ * @brief  store a precomputation
+ * @param  name     precomputation name
+ * @param  key      key of the data it is computed from
+ * @param  version  section layout version
+ * @param  writer   sections
+ * @return true if the file was written
+ */
+bool PrecomputeStore::save(const std::string& name, uint64_t key, uint32_t version,
+                           const PrecomputeWriter& writer) const {
+    if (!this->enabled())
+        return false;
+    // create the directory and its parents
+    for (size_t pos = this->directory_.find('/', 1); pos != std::string::npos; pos = this->directory_.find('/', pos + 1))
+        ::mkdir(this->directory_.substr(0, pos).c_str(), 0755);
+    ::mkdir(this->directory_.c_str(), 0755);
+    return writer.write(this->path(name, key), key, version);
+}
+
+/**
+ * @brief  remove the stored precomputations of a name but the most recently saved or loaded ones
+ * @param  name     precomputation name
+ * @param  keep     number of files kept
+ */
+void PrecomputeStore::prune(const std::string& name, size_t keep) const {
+    DIR* dir = this->enabled() ? ::opendir(this->directory_.c_str()) : nullptr;
+    if (!dir)
+        return;
+    // files named name_<16 hex digits>.bin, newest first
+    std::vector<std::pair<time_t, std::string>> files;
+    const std::string prefix = name + "_";
+    const size_t length = prefix.size() + 16 + 4;
+    for (struct dirent* entry = ::readdir(dir); entry; entry = ::readdir(dir)) {
+        std::string file = entry->d_name;
+        if (file.size() != length || file.compare(0, prefix.size(), prefix) || file.compare(length - 4, 4, ".bin") ||
+            file.find_first_not_of("0123456789abcdef", prefix.size()) != length - 4)
+            continue;
+        struct stat info;
+        if (::stat((this->directory_ + "/" + file).c_str(), &info) == 0)
+            files.emplace_back(info.st_mtime, file);
+    }
+    ::closedir(dir);
+    std::sort(files.begin(), files.end(), std::greater<std::pair<time_t, std::string>>());
+    for (size_t i = keep; i < files.size(); i++)
+        std::remove((this->directory_ + "/" + files[i].second).c_str());
+}
+}
@@ -0,0 +1,484 @@
+/***********************************************************
+ *
+ * @file: swamp_map.cpp
+ * @breif: Contains the dead-end and swamp region classification of the costmap
+ * @author: Yang Haodong
+ * @update: 2023-2-26
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include "swamp_map.h"
+
+namespace global_planner {
+namespace {
+// moves as the planners make them, diagonals included
+const int kDx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+const int kDy[8] = { 1, 0, -1, 0, 1, -1, 1, -1 };
+const double kCost[8] = { 1, 1, 1, 1, std::sqrt(2.0), std::sqrt(2.0), std::sqrt(2.0), std::sqrt(2.0) };
+const double kInf = std::numeric_limits<double>::max();
+// sums of the same moves in another order may differ by rounding, such bypasses are as short
+const double kTolerance = 1e-9;
+
+typedef std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>,
+                            std::greater<std::pair<double, int>>> Heap;
+}
+
+    /**
+     * @brief  Constructor
+     * @param  sector_size  edge length in cells of the sectors the regions are split from
+     */
+    SwampMap::SwampMap(int sector_size)
+        : sector_size_(std::max(sector_size, 2)), nx_(0), ny_(0), sx_(0), sy_(0), built_(false), order_(0),
+          epoch_(0), search_(0) {}
+
+    /**
+     * @brief  classify a costmap and block its swamps, except those of start and goal and the swamps
+     *         classified after them next to them
+     * @param  costs        costmap, the swamp cells are set to 255 which blocks them at any threshold
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  threshold    cells of cost >= threshold are obstacles
+     * @param  start        start cell index
+     * @param  goal         goal cell index
+     * @param  cells        indices of the blocked cells
+     */
+    void SwampMap::prune(unsigned char* costs, int nx, int ny, double threshold, int start, int goal,
+                         std::vector<int>& cells) {
+        std::lock_guard<std::mutex> guard(this->lock_);
+        this->_update(costs, nx, ny, threshold);
+        int ns = nx * ny;
+
+        // the swamps of start and goal stay open, and so do the later swamps next to an open one, whose
+        // boundary excluded it
+        std::vector<char> open(this->regions_.size(), 0);
+        std::vector<int> stack, adjacent;
+        for (int c : { start, goal }) {
+            int id = c >= 0 && c < ns ? this->region_[c] : -1;
+            if (id >= 0 && this->regions_[id].swamp && !open[id]) {
+                open[id] = 1;
+                stack.push_back(id);
+            }
+        }
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            this->_adjacent(id, adjacent);
+            for (int a : adjacent) {
+                if (!open[a] && this->regions_[a].swamp && this->regions_[a].order > this->regions_[id].order) {
+                    open[a] = 1;
+                    stack.push_back(a);
+                }
+            }
+        }
+
+        cells.clear();
+        for (int id = 0; id < (int)this->regions_.size(); id++) {
+            const Region& r = this->regions_[id];
+            if (!r.alive || !r.swamp || open[id])
+                continue;
+            for (int c : r.cells)
+                costs[c] = 255;
+            cells.insert(cells.end(), r.cells.begin(), r.cells.end());
+        }
+    }
+
+    /**
+     * @brief  classify a costmap, only the regions around the cells that changed are classified again
+     * @param  costs        costmap
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  threshold    cells of cost >= threshold are obstacles
+     * @return number of cells that changed, all cells on the first call
+     */
+    int SwampMap::update(const unsigned char* costs, int nx, int ny, double threshold) {
+        std::lock_guard<std::mutex> guard(this->lock_);
+        return this->_update(costs, nx, ny, threshold);
+    }
+
+    /**
+     * @brief  number of swamps, dead-ends included
+     */
+    size_t SwampMap::swampNum() const {
+        return std::count_if(this->regions_.begin(), this->regions_.end(),
+                             [](const Region& r) { return r.alive && r.swamp; });
+    }
+
+    /**
+     * @brief  number of dead-ends
+     */
+    size_t SwampMap::deadEndNum() const {
+        return std::count_if(this->regions_.begin(), this->regions_.end(),
+                             [](const Region& r) { return r.alive && r.swamp && r.dead_end; });
+    }
+
+    /**
+     * @brief  update() with the lock held
+     */
+    int SwampMap::_update(const unsigned char* costs, int nx, int ny, double threshold) {
+        int ns = nx * ny;
+        if (nx != this->nx_ || ny != this->ny_) {
+            this->nx_ = nx;
+            this->ny_ = ny;
+            this->sx_ = (nx + this->sector_size_ - 1) / this->sector_size_;
+            this->sy_ = (ny + this->sector_size_ - 1) / this->sector_size_;
+            this->built_ = false;
+            this->blocked_.assign(ns, 1);
+            this->region_.assign(ns, -1);
+            this->regions_.clear();
+            this->free_ids_.clear();
+            this->sector_regions_.assign(this->sx_ * this->sy_, {});
+            this->queue_.clear();
+            this->member_.assign(ns, 0);
+            this->boundary_.assign(ns, 0);
+            this->visit_.assign(ns, 0);
+            this->boundary_index_.assign(ns, 0);
+            this->dist_.assign(ns, 0);
+            this->epoch_ = this->search_ = 0;
+        }
+
+        std::vector<int> changed;
+        for (int i = 0; i < ns; i++) {
+            char blocked = costs[i] >= threshold;
+            if (blocked != this->blocked_[i]) {
+                this->blocked_[i] = blocked;
+                changed.push_back(i);
+            }
+        }
+
+        if (!this->built_) {
+            this->built_ = true;
+            for (int s = 0; s < this->sx_ * this->sy_; s++)
+                this->_split(s);
+            changed.resize(ns);
+        } else if (!changed.empty()) {
+            // cells changed inside a rectangle, by a summed area table
+            std::vector<int> sum((nx + 1) * (ny + 1), 0);
+            std::vector<char> sectors(this->sx_ * this->sy_, 0);
+            for (int c : changed) {
+                sum[(c / nx + 1) * (nx + 1) + c % nx + 1] = 1;
+                sectors[(c / nx / this->sector_size_) * this->sx_ + c % nx / this->sector_size_] = 1;
+            }
+            for (int y = 1; y <= ny; y++)
+                for (int x = 1; x <= nx; x++)
+                    sum[y * (nx + 1) + x] += sum[(y - 1) * (nx + 1) + x] + sum[y * (nx + 1) + x - 1]
+                                           - sum[(y - 1) * (nx + 1) + x - 1];
+            auto touched = [&](const Region& r) {
+                int x0 = std::max(r.x0, 0), y0 = std::max(r.y0, 0);
+                int x1 = std::min(r.x1, nx - 1) + 1, y1 = std::min(r.y1, ny - 1) + 1;
+                return sum[y1 * (nx + 1) + x1] - sum[y0 * (nx + 1) + x1] - sum[y1 * (nx + 1) + x0]
+                       + sum[y0 * (nx + 1) + x0] > 0;
+            };
+
+            // the classifications that read a changed cell
+            for (int id = 0; id < (int)this->regions_.size(); id++) {
+                if (!this->regions_[id].alive || !touched(this->regions_[id]))
+                    continue;
+                if (this->regions_[id].swamp)
+                    this->_drop(id);
+                else
+                    this->_queue(id);
+            }
+            // the regions of the changed sectors are split again
+            for (int s = 0; s < this->sx_ * this->sy_; s++) {
+                if (!sectors[s])
+                    continue;
+                for (int id : this->sector_regions_[s]) {
+                    this->_drop(id);
+                    Region& r = this->regions_[id];
+                    for (int c : r.cells)
+                        this->region_[c] = -1;
+                    r.cells.clear();
+                    r.alive = false;
+                    this->free_ids_.push_back(id);
+                }
+                this->sector_regions_[s].clear();
+                this->_split(s);
+            }
+        }
+
+        // a new swamp may turn the regions beside it into swamps, a pocket is classified from its far end
+        std::vector<int> adjacent;
+        while (!this->queue_.empty()) {
+            int id = this->queue_.front();
+            this->queue_.pop_front();
+            this->regions_[id].queued = false;
+            if (!this->regions_[id].alive || this->regions_[id].swamp || !this->_test(id))
+                continue;
+            this->regions_[id].swamp = true;
+            this->regions_[id].order = ++this->order_;
+            this->_adjacent(id, adjacent);
+            for (int a : adjacent)
+                if (!this->regions_[a].swamp)
+                    this->_queue(a);
+        }
+        return (int)changed.size();
+    }
+
+    /**
+     * @brief  split the free cells of a sector into new regions and queue them
+     * @param  sector   sector index
+     */
+    void SwampMap::_split(int sector) {
+        int x0 = sector % this->sx_ * this->sector_size_, y0 = sector / this->sx_ * this->sector_size_;
+        int x1 = std::min(x0 + this->sector_size_, this->nx_), y1 = std::min(y0 + this->sector_size_, this->ny_);
+        std::vector<int> stack;
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                int seed = y * this->nx_ + x;
+                if (this->blocked_[seed] || this->region_[seed] >= 0)
+                    continue;
+
+                int id;
+                if (this->free_ids_.empty()) {
+                    id = (int)this->regions_.size();
+                    this->regions_.emplace_back();
+                } else {
+                    id = this->free_ids_.back();
+                    this->free_ids_.pop_back();
+                }
+                Region& r = this->regions_[id];
+                r.cells.clear();
+                r.alive = true;
+                r.swamp = r.dead_end = r.queued = false;
+                r.order = 0;
+                r.x0 = r.x1 = x;
+                r.y0 = r.y1 = y;
+
+                // connected free cells of the sector
+                this->region_[seed] = id;
+                stack.push_back(seed);
+                while (!stack.empty()) {
+                    int c = stack.back();
+                    stack.pop_back();
+                    r.cells.push_back(c);
+                    int cx = c % this->nx_, cy = c / this->nx_;
+                    r.x0 = std::min(r.x0, cx), r.x1 = std::max(r.x1, cx);
+                    r.y0 = std::min(r.y0, cy), r.y1 = std::max(r.y1, cy);
+                    for (int k = 0; k < 8; k++) {
+                        int mx = cx + kDx[k], my = cy + kDy[k];
+                        if (mx < x0 || mx >= x1 || my < y0 || my >= y1)
+                            continue;
+                        int n = my * this->nx_ + mx;
+                        if (!this->blocked_[n] && this->region_[n] < 0) {
+                            this->region_[n] = id;
+                            stack.push_back(n);
+                        }
+                    }
+                }
+                this->sector_regions_[sector].push_back(id);
+                this->_queue(id);
+            }
+        }
+    }
+
+    /**
+     * @brief  unclassify a swamp and the later swamps next to it, whose boundary excluded it, and queue them
+     * @param  id       region
+     */
+    void SwampMap::_drop(int id) {
+        if (!this->regions_[id].swamp)
+            return;
+        std::vector<int> stack{ id }, adjacent;
+        this->regions_[id].swamp = false;
+        while (!stack.empty()) {
+            int d = stack.back();
+            stack.pop_back();
+            Region& r = this->regions_[d];
+            r.dead_end = false;
+            this->_queue(d);
+            this->_adjacent(d, adjacent);
+            for (int a : adjacent) {
+                Region& n = this->regions_[a];
+                if (n.swamp && n.order > r.order) {
+                    n.swamp = false;
+                    stack.push_back(a);
+                } else if (!n.swamp) {
+                    this->_queue(a);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief  whether a region is a swamp of the costmap without the current swamps
+     * @param  id       region, its read cells are updated
+     * @return true if it is a swamp
+     */
+    bool SwampMap::_test(int id) {
+        Region& r = this->regions_[id];
+        unsigned int epoch = ++this->epoch_;
+        r.x0 = this->nx_, r.y0 = this->ny_, r.x1 = -1, r.y1 = -1;
+        auto read = [&](int c) {
+            int x = c % this->nx_, y = c / this->nx_;
+            r.x0 = std::min(r.x0, x - 1), r.x1 = std::max(r.x1, x + 1);
+            r.y0 = std::min(r.y0, y - 1), r.y1 = std::max(r.y1, y + 1);
+        };
+        for (int c : r.cells) {
+            this->member_[c] = epoch;
+            read(c);
+        }
+
+        // boundary, the free cells next to the region outside it and the swamps
+        std::vector<int> boundary;
+        for (int c : r.cells) {
+            int cx = c % this->nx_, cy = c / this->nx_;
+            for (int k = 0; k < 8; k++) {
+                int mx = cx + kDx[k], my = cy + kDy[k];
+                if (mx < 0 || mx >= this->nx_ || my < 0 || my >= this->ny_)
+                    continue;
+                int n = my * this->nx_ + mx;
+                if (this->member_[n] == epoch || this->boundary_[n] == epoch || this->blocked_[n] || this->swamp(n))
+                    continue;
+                this->boundary_[n] = epoch;
+                this->boundary_index_[n] = (int)boundary.size();
+                boundary.push_back(n);
+            }
+        }
+        int m = (int)boundary.size();
+        auto adjacent = [&](int a, int b) {
+            return std::abs(a % this->nx_ - b % this->nx_) <= 1 && std::abs(a / this->nx_ - b / this->nx_) <= 1;
+        };
+
+        // a path between adjacent boundary cells can not be shorter than the move between them
+        r.dead_end = true;
+        for (int i = 0; i < m && r.dead_end; i++)
+            for (int j = i + 1; j < m && r.dead_end; j++)
+                r.dead_end = adjacent(boundary[i], boundary[j]);
+        if (r.dead_end)
+            return true;
+
+        // shortest paths between the boundary cells through the region
+        std::vector<double> through(m * m, kInf);
+        Heap heap;
+        for (int i = 0; i < m; i++) {
+            unsigned int search = ++this->search_;
+            this->visit_[boundary[i]] = search;
+            this->dist_[boundary[i]] = 0;
+            heap.emplace(0, boundary[i]);
+            while (!heap.empty()) {
+                auto [d, u] = heap.top();
+                heap.pop();
+                if (d > this->dist_[u])
+                    continue;
+                if (u != boundary[i] && this->boundary_[u] == epoch) {
+                    through[i * m + this->boundary_index_[u]] = d;
+                    continue;
+                }
+                int ux = u % this->nx_, uy = u / this->nx_;
+                for (int k = 0; k < 8; k++) {
+                    int mx = ux + kDx[k], my = uy + kDy[k];
+                    if (mx < 0 || mx >= this->nx_ || my < 0 || my >= this->ny_)
+                        continue;
+                    int n = my * this->nx_ + mx;
+                    // a path enters the region from the boundary and leaves it to the boundary
+                    if (this->member_[n] != epoch && (u == boundary[i] || this->boundary_[n] != epoch))
+                        continue;
+                    double nd = d + kCost[k];
+                    if (this->visit_[n] != search || nd < this->dist_[n]) {
+                        this->visit_[n] = search;
+                        this->dist_[n] = nd;
+                        heap.emplace(nd, n);
+                    }
+                }
+            }
+        }
+
+        // bypasses outside the region and the swamps
+        for (int i = 0; i < m; i++) {
+            int pending = 0;
+            double limit = 0;
+            for (int j = i + 1; j < m; j++) {
+                if (through[i * m + j] < kInf && !adjacent(boundary[i], boundary[j])) {
+                    pending++;
+                    limit = std::max(limit, through[i * m + j]);
+                }
+            }
+            if (!pending)
+                continue;
+
+            unsigned int search = ++this->search_;
+            this->visit_[boundary[i]] = search;
+            this->dist_[boundary[i]] = 0;
+            heap = Heap();
+            heap.emplace(0, boundary[i]);
+            while (!heap.empty() && pending) {
+                auto [d, u] = heap.top();
+                heap.pop();
+                if (d > this->dist_[u])
+                    continue;
+                if (d > limit + kTolerance)
+                    break;
+                read(u);
+                if (this->boundary_[u] == epoch && this->boundary_index_[u] > i) {
+                    double need = through[i * m + this->boundary_index_[u]];
+                    if (need < kInf && !adjacent(boundary[i], u)) {
+                        if (d > need + kTolerance)
+                            return false;
+                        pending--;
+                    }
+                }
+                int ux = u % this->nx_, uy = u / this->nx_;
+                for (int k = 0; k < 8; k++) {
+                    int mx = ux + kDx[k], my = uy + kDy[k];
+                    if (mx < 0 || mx >= this->nx_ || my < 0 || my >= this->ny_)
+                        continue;
+                    int n = my * this->nx_ + mx;
+                    if (this->blocked_[n] || this->member_[n] == epoch || this->swamp(n))
+                        continue;
+                    double nd = d + kCost[k];
+                    if (this->visit_[n] != search || nd < this->dist_[n]) {
+                        this->visit_[n] = search;
+                        this->dist_[n] = nd;
+                        heap.emplace(nd, n);
+                    }
+                }
+            }
+            if (pending)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief  regions next to a region
+     * @param  id       region
+     * @param  ids      neighbour regions
+     */
+    void SwampMap::_adjacent(int id, std::vector<int>& ids) const {
+        ids.clear();
+        for (int c : this->regions_[id].cells) {
+            int cx = c % this->nx_, cy = c / this->nx_;
+            for (int k = 0; k < 8; k++) {
+                int mx = cx + kDx[k], my = cy + kDy[k];
+                if (mx < 0 || mx >= this->nx_ || my < 0 || my >= this->ny_)
+                    continue;
+                int n = this->region_[my * this->nx_ + mx];
+                if (n >= 0 && n != id)
+                    ids.push_back(n);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+
+    /**
+     * @brief  queue a region for classification
+     */
+    void SwampMap::_queue(int id) {
+        if (this->regions_[id].queued)
+            return;
+        this->regions_[id].queued = true;
+        this->queue_.push_back(id);
+    }
+}
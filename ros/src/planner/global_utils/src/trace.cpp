@@ -0,0 +1,207 @@
+/***********************************************************
+ *
+ * @file: trace.cpp
+ * @breif: Contains the scoped trace points and their Chrome trace export
+ * @author: Yang Haodong
+ * @update: 2023-2-18
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+#include "trace.h"
+
+namespace global_planner {
+namespace {
+// events per thread, a power of two
+const uint64_t kBufferSize = 1 << 16;
+
+/**
+ * @brief Buffered event, written by the owner thread and read by the exporter while it may be overwritten
+ */
+struct TraceEvent {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> begin, end;
+};
+
+/**
+ * @brief Ring buffer of one thread, single producer
+ */
+struct ThreadBuffer {
+    explicit ThreadBuffer(uint32_t tid) : tid(tid), events(new TraceEvent[kBufferSize]), head(0), tail(0) {}
+
+    // trace thread id
+    uint32_t tid;
+    std::unique_ptr<TraceEvent[]> events;
+    // number of events ever written, and first event not dropped by clear()
+    std::atomic<uint64_t> head, tail;
+};
+
+/**
+ * @brief Buffers of all threads that recorded. The buffer of an exited thread keeps its events for export
+ *        and is handed to the next thread that starts recording, so there are only as many buffers as
+ *        threads ever recorded at the same time.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    // buffers of exited threads
+    std::vector<std::shared_ptr<ThreadBuffer>> free;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+/**
+ * @brief Buffer held by a thread, returned to the registry when the thread exits
+ */
+struct BufferLease {
+    BufferLease() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (r.free.empty()) {
+            r.buffers.push_back(std::make_shared<ThreadBuffer>((uint32_t)r.buffers.size() + 1));
+            buffer = r.buffers.back();
+        } else {
+            buffer = r.free.back();
+            r.free.pop_back();
+        }
+    }
+    ~BufferLease() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.free.push_back(buffer);
+    }
+
+    std::shared_ptr<ThreadBuffer> buffer;
+};
+
+/**
+ * @brief  ring buffer of the calling thread, taken on first use
+ */
+ThreadBuffer& localBuffer() {
+    thread_local BufferLease lease;
+    return *lease.buffer;
+}
+
+// time origin of the exported timestamps
+const std::chrono::steady_clock::time_point kOrigin = std::chrono::steady_clock::now();
+}
+
+std::atomic<bool> Tracer::enabled_(false);
+
+/**
+ * @brief  start or stop recording
+ */
+void Tracer::setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+/**
+ * @brief  monotonic time in nanoseconds
+ */
+uint64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kOrigin).count();
+}
+
+/**
+ * @brief  append a complete event to the ring buffer of the calling thread
+ * @param  name     event name, a string literal
+ * @param  begin    begin time in nanoseconds
+ * @param  end      end time in nanoseconds
+ */
+void Tracer::record(const char* name, uint64_t begin, uint64_t end) {
+    ThreadBuffer& buffer = localBuffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    TraceEvent& e = buffer.events[head & (kBufferSize - 1)];
+    // the exporter seeing the slot overwritten also sees the head of the previous event
+    std::atomic_thread_fence(std::memory_order_release);
+    e.name.store(name, std::memory_order_relaxed);
+    e.begin.store(begin, std::memory_order_relaxed);
+    e.end.store(end, std::memory_order_relaxed);
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * @brief  write the buffered events as Chrome trace JSON, readable by chrome://tracing and Perfetto
+ * @param  os   output stream
+ * @return number of events written
+ */
+size_t Tracer::writeChromeTrace(std::ostream& os) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffers = r.buffers;
+    }
+
+    int pid = ::getpid();
+    size_t count = 0;
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (const auto& buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = std::max(buffer->tail.load(std::memory_order_relaxed),
+                                  head > kBufferSize ? head - kBufferSize : 0);
+        std::vector<std::pair<const char*, std::pair<uint64_t, uint64_t>>> events;
+        for (uint64_t i = first; i < head; i++) {
+            const TraceEvent& e = buffer->events[i & (kBufferSize - 1)];
+            events.push_back({ e.name.load(std::memory_order_relaxed),
+                               { e.begin.load(std::memory_order_relaxed), e.end.load(std::memory_order_relaxed) } });
+        }
+        // events the owner thread overwrote while they were copied are dropped
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t overwritten = buffer->head.load(std::memory_order_acquire);
+        size_t skip = overwritten + 1 > first + kBufferSize ? overwritten + 1 - first - kBufferSize : 0;
+
+        for (size_t i = skip; i < events.size(); i++) {
+            os << (count++ ? "," : "") << "\n{\"name\":\"";
+            for (const char* c = events[i].first; *c; c++) {
+                if (*c == '"' || *c == '\\')
+                    os << '\\';
+                os << *c;
+            }
+            const auto& t = events[i].second;
+            os << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"ts\":" << t.first / 1000.0
+               << ",\"dur\":" << (t.second - t.first) / 1000.0 << "}";
+        }
+    }
+    os << "\n]}\n";
+    return count;
+}
+
+/**
+ * @brief  write the buffered events to a Chrome trace file
+ * @param  path     file path
+ * @param  events   number of events written
+ * @return true if the file was written
+ */
+bool Tracer::writeChromeTrace(const std::string& path, size_t& events) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out.precision(15);
+    events = Tracer::writeChromeTrace(out);
+    return out.flush().good();
+}
+
+/**
+ * @brief  drop the buffered events
+ */
+void Tracer::clear() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& buffer : r.buffers)
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+}
@@ -14,9 +14,11 @@
 #ifndef A_STAR_H
 #define A_STAR_H
 
+#include <memory>
 #include <queue>
 
 #include "global_planner.h"
+#include "rectangle_decomposition.h"
 #include "utils.h"
 
 namespace a_star_planner{
@@ -32,8 +34,9 @@ class AStar : public global_planner::GlobalPlanner {
          * @param   resolution  costmap resolution
          * @param   dijkstra    using diksktra implementation
          * @param   gbfs        using gbfs implementation
+         * @param   rsr         using rectangular symmetry reduction, skipping the interiors of empty rectangles
          */
-        AStar(int nx, int ny, double resolution, bool dijkstra=false, bool gbfs=false);
+        AStar(int nx, int ny, double resolution, bool dijkstra=false, bool gbfs=false, bool rsr=false);
 
         /**
          * @brief A* implementation
@@ -48,10 +51,19 @@ class AStar : public global_planner::GlobalPlanner {
     
 
     private:
+        /**
+         * @brief  insert the cells a macro edge crosses into a path, diagonal moves first
+         * @param  path     path with macro edges
+         * @return path of adjacent cells
+         */
+        std::vector<Node> _unfoldMacroEdges(const std::vector<Node>& path);
+
         // using diksktra
         bool is_dijkstra_;
         // using greedy best first search(GBFS)
         bool is_gbfs_;
+        // empty rectangles of rectangular symmetry reduction, nullptr if not used
+        std::unique_ptr<RectangleDecomposition> rectangles_;
 };
 }
 #endif
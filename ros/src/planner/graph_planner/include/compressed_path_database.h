@@ -0,0 +1,194 @@
+/***********************************************************
+ *
+ * @file: compressed_path_database.h
+ * @breif: Contains the compressed path database planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-24
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef COMPRESSED_PATH_DATABASE_H
+#define COMPRESSED_PATH_DATABASE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "a_star.h"
+#include "global_planner.h"
+#include "precompute_cache.h"
+#include "precompute_store.h"
+#include "utils.h"
+
+namespace cpd_planner {
+/**
+ * @brief First moves of the optimal paths between all pairs of free cells, 8-connected as A* searches them.
+ *        Targets are ordered depth-first so that nearby cells share first moves, and the moves of every
+ *        source are run-length compressed over that order, a run taking any move optimal for all its targets.
+ *        Immutable once built, shared by the planners of a layout.
+ */
+class Database {
+    public:
+        Database(const Database&) = delete;
+        Database& operator=(const Database&) = delete;
+
+        /**
+         * @brief  compute the first moves from every free cell, the sources of a row in parallel
+         * @param  blocked  obstacle cells, of size nx * ny
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         * @param  threads  worker threads, 0 for one per core
+         * @param  store    the finished rows are checkpointed to the store and a build resumes from them
+         * @param  key      key of the layout
+         * @param  cancel   flag that makes the build give up once raised, the checkpoint is kept
+         * @return database, nullptr if the build was canceled
+         */
+        static std::shared_ptr<Database> build(const std::vector<char>& blocked, int nx, int ny, int threads,
+                                               const global_planner::PrecomputeStore& store, uint64_t key,
+                                               const std::atomic<bool>* cancel = nullptr);
+        /**
+         * @brief  map a stored database
+         * @param  store    precomputation store
+         * @param  key      key of the layout
+         * @param  ns       total pixel number the database must have
+         * @return database, nullptr if none is stored
+         */
+        static std::shared_ptr<Database> load(const global_planner::PrecomputeStore& store, uint64_t key, int ns);
+        /**
+         * @brief  store the database
+         * @param  store    precomputation store
+         * @param  key      key of the layout
+         * @return true if it was written
+         */
+        bool save(const global_planner::PrecomputeStore& store, uint64_t key) const;
+
+        /**
+         * @brief  first move of an optimal path
+         * @param  source   source cell index
+         * @param  target   target cell index
+         * @return index into getMotion(), -1 if either cell is an obstacle or the target is unreachable
+         */
+        int firstMove(int source, int target) const;
+        /**
+         * @brief  whether a cell is free in the layout
+         */
+        bool free(int cell) const { return this->order_[cell] >= 0; }
+        /**
+         * @brief  number of free cells
+         */
+        int nodeNum() const { return this->node_num_; }
+        /**
+         * @brief  number of runs over all sources
+         */
+        size_t runNum() const { return this->offset_[this->node_num_]; }
+
+    private:
+        Database() = default;
+
+        // number of free cells
+        int node_num_ = 0;
+        // target order by cell, -1 for obstacles
+        const int* order_ = nullptr;
+        // CSR offsets by target order of the source and the runs, each the first target order << 4 | move
+        const uint32_t* offset_ = nullptr;
+        const uint32_t* run_ = nullptr;
+        // contents of a built database
+        std::vector<int> orders_;
+        std::vector<uint32_t> offsets_, runs_;
+        // mapping of a stored database
+        global_planner::PrecomputeMapping mapping_;
+        // total pixel number
+        int ns_ = 0;
+};
+
+/**
+ * @brief Databases of the recent layouts, built in the background once for all planners of a layout and
+ *        kept in the precomputation store so that a restart maps them instead of building again
+ */
+class DatabaseCache : public global_planner::PrecomputeCache<Database> {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  directory    precomputation store directory, empty to keep the database in memory only
+         * @param  threads      build threads, 0 for one per core
+         * @param  capacity     layouts kept in memory and in the store, the least recently used is dropped
+         */
+        explicit DatabaseCache(const std::string& directory = "", int threads = 0, size_t capacity = 4);
+};
+
+/**
+ * @brief Class for objects that plan by first move lookups in a compressed path database of a layout.
+ *        The database of a layout is built in the background and the path is searched by A* until it is
+ *        published. Around the cells blocked or freed since the layout the path is searched by A*, from
+ *        where the lookups enter such a dirty region to where they leave it, and a changed layout that
+ *        stays the same for a few searches is built again. A start or goal outside the layout is searched
+ *        by A* alone.
+ */
+class CompressedPathDatabase : public global_planner::GlobalPlanner {
+    public:
+        /**
+         * @brief  Constructor
+         * @param   nx          pixel number in costmap x direction
+         * @param   ny          pixel number in costmap y direction
+         * @param   resolution  costmap resolution
+         * @param   cache       database cache shared with other planners, nullptr for a private one
+         */
+        CompressedPathDatabase(int nx, int ny, double resolution, std::shared_ptr<DatabaseCache> cache = nullptr);
+        /**
+         * @brief Compressed path database implementation
+         * @param costs     costmap
+         * @param start     start node
+         * @param goal      goal node
+         * @param expand    containing the node been search during the process
+         * @return tuple contatining a bool as to whether a path was found, and the path
+         */
+        std::tuple<bool, std::vector<Node>> plan(const unsigned char* costs, const Node& start,
+                                                 const Node& goal, std::vector<Node> &expand);
+        /**
+         * @brief  set or reset obstacle factor, the database is taken again by the next search
+         * @param factor obstacle factor
+         */
+        void setFactor(double factor) override;
+
+    protected:
+        /**
+         * @brief  take the latest database published for the costmap layouts
+         * @param  costs    costmap
+         * @return true if the database is of the costmap layout
+         */
+        bool _take(const unsigned char* costs);
+        /**
+         * @brief  mark the cells blocked or freed since the layout, and their neighbours
+         * @param  costs    costmap
+         * @return true if any cell is dirty
+         */
+        bool _markDirty(const unsigned char* costs);
+        /**
+         * @brief  A* between two cells, appended without the first one
+         * @param  costs    costmap
+         * @param  from     from cell index
+         * @param  to       to cell index
+         * @param  cells    path cells
+         * @param  expand   the nodes A* expanded are appended
+         * @return false if A* found no path
+         */
+        bool _detour(const unsigned char* costs, int from, int to, std::vector<int>& cells, std::vector<Node>& expand);
+
+        std::shared_ptr<DatabaseCache> cache_;
+        // layout of the costmaps and its database
+        global_planner::PrecomputeLayout<Database> layout_;
+        // database the search follows, of the costmap layout or an earlier one
+        std::shared_ptr<const Database> database_;
+        // cells that differ from the layout, dilated by one cell
+        std::vector<char> dirty_;
+        // searches the dirty regions and what the database can not answer
+        a_star_planner::AStar fallback_;
+};
+}
+#endif  // COMPRESSED_PATH_DATABASE_H
@@ -0,0 +1,213 @@
+/***********************************************************
+ *
+ * @file: contraction_hierarchy.h
+ * @breif: Contains the contraction hierarchy planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-23
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "a_star.h"
+#include "global_planner.h"
+#include "precompute_cache.h"
+#include "precompute_store.h"
+#include "utils.h"
+
+namespace ch_planner {
+/**
+ * @brief Contraction hierarchy of the free cells of a costmap, 8-connected as A* searches them.
+ *        Nodes are numbered in contraction order, every node keeps the edges to the nodes contracted after
+ *        it, shortcuts remember the node they skip. Immutable once built, shared by the planners of a layout.
+ */
+class Hierarchy {
+    public:
+        /**
+         * @brief Upward edge, mid is the skipped node of a shortcut and -1 for a move between two cells
+         */
+        struct Edge {
+            int to;
+            int mid;
+            double weight;
+        };
+
+        Hierarchy(const Hierarchy&) = delete;
+        Hierarchy& operator=(const Hierarchy&) = delete;
+
+        /**
+         * @brief  contract the free cells of a costmap
+         * @param  blocked  obstacle cells, of size nx * ny
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         * @param  threads  worker threads, 0 for one per core
+         * @param  cancel   flag that makes the build give up once raised, nullptr to disable
+         * @return hierarchy, nullptr if the build was canceled
+         */
+        static std::shared_ptr<Hierarchy> build(const std::vector<char>& blocked, int nx, int ny, int threads,
+                                                const std::atomic<bool>* cancel = nullptr);
+        /**
+         * @brief  map a stored hierarchy
+         * @param  store    precomputation store
+         * @param  key      key of the layout
+         * @param  ns       total pixel number the hierarchy must have
+         * @return hierarchy, nullptr if none is stored
+         */
+        static std::shared_ptr<Hierarchy> load(const global_planner::PrecomputeStore& store, uint64_t key, int ns);
+        /**
+         * @brief  store the hierarchy
+         * @param  store    precomputation store
+         * @param  key      key of the layout
+         * @return true if it was written
+         */
+        bool save(const global_planner::PrecomputeStore& store, uint64_t key) const;
+
+        /**
+         * @brief  node of a cell, -1 for obstacles
+         */
+        int node(int cell) const { return this->node_[cell]; }
+        /**
+         * @brief  cell of a node
+         */
+        int cell(int node) const { return this->cell_[node]; }
+        /**
+         * @brief  number of nodes
+         */
+        int nodeNum() const { return this->node_num_; }
+        /**
+         * @brief  number of upward edges, shortcuts included
+         */
+        int edgeNum() const { return this->offset_[this->node_num_]; }
+        /**
+         * @brief  upward edges of a node
+         */
+        const Edge* begin(int node) const { return this->edge_ + this->offset_[node]; }
+        const Edge* end(int node) const { return this->edge_ + this->offset_[node + 1]; }
+
+    private:
+        Hierarchy() = default;
+
+        // number of nodes
+        int node_num_ = 0;
+        // node by cell, cell by node, CSR offsets and upward edges, in the vectors or the mapping
+        const int* node_ = nullptr;
+        const int* cell_ = nullptr;
+        const int* offset_ = nullptr;
+        const Edge* edge_ = nullptr;
+        // contents of a built hierarchy
+        std::vector<int> nodes_, cells_, offsets_;
+        std::vector<Edge> edges_;
+        // mapping of a stored hierarchy
+        global_planner::PrecomputeMapping mapping_;
+        // total pixel number
+        int ns_ = 0;
+};
+
+/**
+ * @brief Hierarchies of the recent layouts, contracted in the background once for all planners of a layout
+ *        and kept in the precomputation store so that a restart maps them instead of contracting again
+ */
+class HierarchyCache : public global_planner::PrecomputeCache<Hierarchy> {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  directory    precomputation store directory, empty to keep the hierarchy in memory only
+         * @param  threads      contraction threads, 0 for one per core
+         * @param  capacity     layouts kept in memory and in the store, the least recently used is dropped
+         */
+        explicit HierarchyCache(const std::string& directory = "", int threads = 0, size_t capacity = 4);
+};
+
+/**
+ * @brief Class for objects that plan on a contraction hierarchy of a fixed layout. A query is a bidirectional
+ *        upward search, shortcuts are unpacked into cells only when a path is requested.
+ *        The hierarchy of a layout is contracted in the background, and the search is left to A* until it
+ *        is published and while the costmap layout differs from it, where its paths are no longer shortest.
+ */
+class ContractionHierarchy : public global_planner::GlobalPlanner {
+    public:
+        /**
+         * @brief  Constructor
+         * @param   nx          pixel number in costmap x direction
+         * @param   ny          pixel number in costmap y direction
+         * @param   resolution  costmap resolution
+         * @param   cache       hierarchy cache shared with other planners, nullptr for a private one
+         */
+        ContractionHierarchy(int nx, int ny, double resolution, std::shared_ptr<HierarchyCache> cache = nullptr);
+        /**
+         * @brief Contraction hierarchy search implementation
+         * @param costs     costmap
+         * @param start     start node
+         * @param goal      goal node
+         * @param expand    containing the node been search during the process
+         * @return tuple contatining a bool as to whether a path was found, and the path
+         */
+        std::tuple<bool, std::vector<Node>> plan(const unsigned char* costs, const Node& start,
+                                                 const Node& goal, std::vector<Node> &expand);
+        /**
+         * @brief  shortest path cost, without unpacking the path
+         * @param  costs    costmap, the hierarchy is taken as by plan() and A* searches what it can not answer
+         * @param  start    start node
+         * @param  goal     goal node
+         * @param  cost     path cost in cells
+         * @return true if the goal is reachable
+         */
+        bool distance(const unsigned char* costs, const Node& start, const Node& goal, double& cost);
+        /**
+         * @brief  set or reset obstacle factor, the hierarchy is taken again by the next search
+         * @param factor obstacle factor
+         */
+        void setFactor(double factor) override;
+
+    protected:
+        /**
+         * @brief  take the hierarchy of the costmap layout once it is published, and size the search state to it
+         * @param  costs    costmap
+         * @return true if the hierarchy is of the costmap layout
+         */
+        bool _take(const unsigned char* costs);
+        /**
+         * @brief  bidirectional upward search
+         * @param  s        start node
+         * @param  t        goal node
+         * @param  cost     path cost
+         * @param  meet     highest node of the path
+         * @param  expand   settled nodes are appended if not nullptr
+         * @return true if a path was found
+         */
+        bool _query(int s, int t, double& cost, int& meet, std::vector<Node>* expand);
+        /**
+         * @brief  append the cells of an edge, without its first node
+         * @param  a        first node
+         * @param  b        last node
+         * @param  mid      node skipped by the edge, -1 for a move between two cells
+         * @param  cells    path cells
+         */
+        void _unpack(int a, int b, int mid, std::vector<int>& cells) const;
+
+        std::shared_ptr<HierarchyCache> cache_;
+        // layout of the costmaps and its hierarchy
+        global_planner::PrecomputeLayout<Hierarchy> layout_;
+        // hierarchy the search state is sized to
+        std::shared_ptr<const Hierarchy> hierarchy_;
+        // searches what the hierarchy can not answer
+        a_star_planner::AStar fallback_;
+        // forward and backward search state, valid where stamp equals the query count
+        std::vector<double> dist_[2];
+        std::vector<int> parent_[2], parent_mid_[2];
+        std::vector<uint32_t> stamp_[2];
+        uint32_t query_;
+};
+}
+#endif  // CONTRACTION_HIERARCHY_H
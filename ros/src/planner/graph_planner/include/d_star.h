@@ -5,9 +5,6 @@
 #include <map>
 #include <algorithm>
 
-#include <ros/ros.h>
-#include <nav_msgs/OccupancyGrid.h>
-
 #include "global_planner.h"
 
 #define inf 1 << 20
@@ -51,7 +48,7 @@ namespace d_star_planner
 
         bool isCollision(DNodePtr n1, DNodePtr n2);
 
-        void getNeighbours(DNodePtr nodePtr, std::vector<DNodePtr> &neighbours);
+        void getNeighbours(DNodePtr nodePtr, std::pmr::vector<DNodePtr> &neighbours);
 
         double cost(DNodePtr n1, DNodePtr n2);
 
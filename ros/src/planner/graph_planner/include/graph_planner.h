@@ -14,13 +14,30 @@
 #ifndef GRAPH_PLANNER_H
 #define GRAPH_PLANNER_H
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <nav_core/base_global_planner.h>
+#include <nav_msgs/OccupancyGrid.h>
 #include <nav_msgs/Path.h>
 #include <nav_msgs/GetPlan.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/Point.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <std_srvs/Trigger.h>
 
+#include "compressed_path_database.h"
+#include "contraction_hierarchy.h"
+#include "costmap_snapshot.h"
 #include "global_planner.h"
+#include "path_monitor.h"
+#include "plan_log.h"
+#include "planner_pool.h"
+#include "poi_library.h"
+#include "portfolio_planner.h"
+#include "swamp_map.h"
+#include "trace.h"
 
 namespace graph_planner {
 class GraphPlanner : public nav_core::BaseGlobalPlanner {
@@ -79,6 +96,23 @@ class GraphPlanner : public nav_core::BaseGlobalPlanner {
          * @param  resp response from server
          */
         bool makePlanService(nav_msgs::GetPlan::Request& req, nav_msgs::GetPlan::Response& resp);
+        /**
+         * @brief  dump the trace events recorded since the last dump as Chrome trace JSON
+         * @param  req  request from client
+         * @param  resp response from server, with the trace file in the message
+         */
+        bool dumpTraceService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& resp);
+        /**
+         * @brief  path between the points of interest nearest to start and goal, from the path library
+         * @param  req  request from client
+         * @param  resp response from server, empty plan if either end is not at a point of interest
+         */
+        bool poiPathService(nav_msgs::GetPlan::Request& req, nav_msgs::GetPlan::Response& resp);
+        /**
+         * @brief  hand a costmap snapshot to the path library update thread, unless an update is still running
+         * @param  event    timer event
+         */
+        void poiUpdateCallback(const ros::TimerEvent& event);
         /**
          * @brief  local costmap callback function
          * @param  costmap local costmap data
@@ -95,12 +129,28 @@ class GraphPlanner : public nav_core::BaseGlobalPlanner {
         ros::Publisher plan_pub_;
         // initialization flag
         bool initialized_;
-        // global graph planner
-        global_planner::GlobalPlanner* g_planner_;
+        // workspaces of the global graph planner, one per concurrent makePlan call
+        global_planner::PlannerPool planner_pool_;
+        // copy-on-write mirror of the costmap, workspaces refresh only the tiles that changed
+        global_planner::TiledCostmap costmap_tiles_;
+        // last path of move_base, answers its periodic replans while nothing along it changed
+        global_planner::PathMonitor path_monitor_;
+        // log of the searches, for offline replay
+        global_planner::PlanLogWriter plan_log_;
         // nodes explorer publisher
         ros::Publisher expand_pub_;
         // planning service
         ros::ServiceServer make_plan_srv_;
+        // trace dump service
+        ros::ServiceServer dump_trace_srv_;
+        // points of interest path service
+        ros::ServiceServer poi_path_srv_;
+        // points of interest cost matrix publisher
+        ros::Publisher poi_costs_pub_;
+        // points of interest library update timer
+        ros::Timer poi_timer_;
+        // trace dump file
+        std::string trace_file_;
         // planner name
         std::string planner_name_;
         // local costmap subscriber
@@ -109,8 +159,6 @@ class GraphPlanner : public nav_core::BaseGlobalPlanner {
         // nav_msgs::OccupancyGrid* p_local_costmap_;
 
     private:
-        // thread mutex
-        boost::mutex mutex_;
         // offset of transform from world(x,y) to grid map(x,y)
         double convert_offset_;
         // tolerance
@@ -121,9 +169,122 @@ class GraphPlanner : public nav_core::BaseGlobalPlanner {
         double factor_;
         // whether publish expand map or not
         bool is_expand_;
+        // maximum number of concurrent makePlan calls
+        int max_concurrent_plans_;
+        // whether reuse the last path while it stays valid
+        bool is_monitor_;
+        // whether repair a blocked path in a window around the block before searching the whole map
+        bool is_repair_;
+        // free cells kept around a blocked stretch, and window padding
+        int repair_margin_;
+        // planners raced by the portfolio planner
+        std::vector<std::string> portfolio_backends_;
+        // path length accepted from the first portfolio backend, as a multiple of the straight line distance
+        double portfolio_bound_;
+        // sample number, maximum edge length in cells and rewiring radius of the sampling portfolio backends
+        int sample_points_;
+        double sample_max_d_, opt_r_;
+        // win statistics of the portfolio backends
+        std::shared_ptr<global_planner::PortfolioStatistics> portfolio_stats_;
+        // whether A*, dijkstra and gbfs skip the interiors of empty rectangles
+        bool symmetry_reduction_;
+        // dead-ends and swamps blocked for A*, dijkstra, gbfs and jps, nullptr if not pruned
+        std::shared_ptr<global_planner::SwampMap> swamp_map_;
+        // precomputation store directory, empty to keep precomputations in memory only
+        std::string precompute_dir_;
+        // contraction hierarchy shared by the planners of all workspaces
+        std::shared_ptr<ch_planner::HierarchyCache> hierarchy_cache_;
+        // compressed path database shared by the planners of all workspaces
+        std::shared_ptr<cpd_planner::DatabaseCache> database_cache_;
+        // world positions of the points of interest, in the order of the cost matrix
+        std::vector<geometry_msgs::Point> poi_points_;
+        // paths between all pairs of points of interest, nullptr without points of interest
+        std::unique_ptr<poi_planner::PathLibrary> poi_library_;
+        // cells of the points of interest the path library holds
+        std::vector<Node> poi_cells_;
+        // costmap copy the path library is updated from, and the snapshot tile versions it holds
+        std::vector<unsigned char> poi_costs_;
+        std::vector<unsigned int> poi_tile_versions_;
+        // path library update thread, so that neither the timer nor the services wait for an update
+        std::thread poi_thread_;
+        std::mutex poi_lock_;
+        std::condition_variable poi_wake_;
+        // snapshot and point of interest cells handed to the update thread
+        global_planner::CostmapSnapshot poi_snapshot_;
+        std::vector<Node> poi_next_cells_;
+        // points of interest off the costmap at the last update, warned about once they leave it
+        std::vector<bool> poi_off_map_;
+        // whether an update is handed over or running, and whether the thread should exit
+        bool poi_busy_, poi_stop_;
 
 
     protected:
+        /**
+         * @brief  plan a path given start and goal in world map
+         * @param  start        start in world map
+         * @param  goal         goal in world map
+         * @param  tolerance    error tolerance
+         * @param  plan         plan
+         * @param  monitored    whether the path is the monitored one of move_base, service queries for other
+         *                      starts and goals neither reuse nor replace it
+         * @return true if find a path successfully else false
+         */
+        bool _makePlan(const geometry_msgs::PoseStamped& start, const geometry_msgs::PoseStamped& goal, double tolerance,
+                       std::vector<geometry_msgs::PoseStamped>& plan, bool monitored);
+        /**
+         * @brief  create a planner instance for a new workspace
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  resolution   costmap resolution
+         * @return planner, NULL if the planner name is unknown
+         */
+        global_planner::GlobalPlanner* _createPlanner(int nx, int ny, double resolution);
+        /**
+         * @brief  create a single graph planner
+         * @param  name         planner name
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  resolution   costmap resolution
+         * @return planner, NULL if the planner name is unknown
+         */
+        global_planner::GlobalPlanner* _createBackend(const std::string& name, int nx, int ny, double resolution);
+        /**
+         * @brief  append a search to the request log
+         * @param  costs        costmap the planner searched
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  start        start node
+         * @param  goal         goal node
+         * @param  path_found   whether a path was found
+         * @param  path         path, goal first
+         * @param  expand_num   number of expanded nodes
+         * @param  plan_time    search time in seconds
+         */
+        void _recordRequest(const unsigned char* costs, int nx, int ny, const Node& start, const Node& goal,
+                            bool path_found, const std::vector<Node>& path, size_t expand_num, double plan_time);
+        /**
+         * @brief  reset the workspace pool to the current costmap size
+         */
+        void _resetPlannerPool();
+        /**
+         * @brief  path library update thread, brings the library up to date with each snapshot handed to it
+         *         and publishes the cost matrix
+         */
+        void _poiUpdateLoop();
+        /**
+         * @brief  search between two cells inside a window of the costmap snapshot by A*
+         * @param  snapshot costmap snapshot
+         * @param  entry    start cell of the detour
+         * @param  exit     end cell of the detour
+         * @param  x0       window lower x, inclusive
+         * @param  y0       window lower y, inclusive
+         * @param  x1       window upper x, inclusive
+         * @param  y1       window upper y, inclusive
+         * @param  detour   detour in costmap cells, exit first
+         * @return true if a detour was found
+         */
+        bool _searchWindow(const global_planner::CostmapSnapshot& snapshot, const Node& entry, const Node& exit,
+                           int x0, int y0, int x1, int y1, std::vector<Node>& detour);
         /**
          * @brief  Inflate the boundary of costmap into obstacles to prevent cross planning
          * @param  costarr  costmap pointer
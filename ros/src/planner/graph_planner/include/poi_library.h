@@ -0,0 +1,160 @@
+/***********************************************************
+ *
+ * @file: poi_library.h
+ * @breif: Contains the all-pairs path library between points of interest
+ * @author: Yang Haodong
+ * @update: 2023-2-28
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef POI_LIBRARY_H
+#define POI_LIBRARY_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "delta_stepping.h"
+#include "utils.h"
+
+namespace poi_planner {
+/**
+ * @brief Shortest paths between all pairs of points of interest, 8-connected with the move costs of the
+ *        graph planners. The paths of a source are found by one Dijkstra search, the sources in parallel,
+ *        or by a parallel distance field when fewer sources than threads are searched, and each path is
+ *        kept as runs of equal moves. An update searches again only the pairs whose path
+ *        crosses a cell blocked since, and the pairs a freed cell could shorten, where the octile distance
+ *        through the freed cells undercuts the path. Queries read the library of the last finished update,
+ *        which is swapped in atomically, so they are never held up by a running update.
+ */
+class PathLibrary {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  threads  search threads, 0 for one per core
+         */
+        explicit PathLibrary(int threads = 0);
+
+        /**
+         * @brief  set the points of interest, all pairs are searched by the next update
+         * @param  pois     cells of the points of interest, of id -1 for points off the costmap
+         */
+        void setPois(const std::vector<Node>& pois);
+        /**
+         * @brief  search the pairs the costmap changes since the last update may have changed
+         * @param  costs        costmap
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  threshold    cells of cost >= threshold are obstacles
+         * @return number of pairs searched
+         */
+        int update(const unsigned char* costs, int nx, int ny, double threshold);
+        /**
+         * @brief  number of points of interest
+         */
+        int size() const;
+        /**
+         * @brief  path cost between two points of interest in cells
+         * @return cost, -1 if unreachable or either point is off the costmap
+         */
+        double cost(int from, int to) const;
+        /**
+         * @brief  row-major matrix of the path costs in cells, -1 for unreachable pairs and the rows and columns
+         *         of the points off the costmap
+         */
+        std::vector<double> matrix() const;
+        /**
+         * @brief  path between two points of interest
+         * @param  from     start point of interest
+         * @param  to       goal point of interest
+         * @param  path     path cells, goal first as GlobalPlanner::plan()
+         * @return false if unreachable
+         */
+        bool path(int from, int to, std::vector<Node>& path) const;
+        /**
+         * @brief  bytes of the stored paths
+         */
+        size_t bytes() const;
+
+    protected:
+        /**
+         * @brief Path from the lower to the higher point of interest
+         */
+        struct Route {
+            // cost in cells, -1 if unreachable
+            double cost = -1;
+            // runs of equal moves, the move index << 5 | the repeats - 1
+            std::vector<uint8_t> runs;
+            // bounding box of the path cells
+            int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+        };
+
+        /**
+         * @brief  search the dirty pairs of a source
+         * @param  source   point of interest
+         * @param  targets  points of interest above source to find
+         * @param  worker   worker index of the search state
+         */
+        void _search(int source, const std::vector<int>& targets, int worker);
+        /**
+         * @brief  search the dirty pairs of a source by a whole-map distance field, all threads at once
+         * @param  source   point of interest
+         * @param  targets  points of interest above source to find
+         */
+        void _searchField(int source, const std::vector<int>& targets);
+        /**
+         * @brief  store a path as runs of moves
+         * @param  route    route of the pair, its cost set
+         * @param  from     lower point of interest
+         * @param  moves    move indices from the lower point of interest
+         */
+        void _encode(Route& route, const Node& from, const std::vector<int>& moves) const;
+        /**
+         * @brief  route of a pair, from the lower point of interest
+         */
+        Route& _route(int a, int b) { return this->routes_[a * this->pois_.size() + b]; }
+
+        /**
+         * @brief Points of interest and routes of a finished update, immutable once published
+         */
+        struct Table {
+            std::vector<Node> pois;
+            std::vector<Route> routes;
+            int nx = 0;
+            /**
+             * @brief  route of a pair, from the lower point of interest
+             */
+            const Route& route(int a, int b) const { return this->routes[a * this->pois.size() + b]; }
+        };
+
+        // serializes updates
+        std::mutex lock_;
+        // library of the last finished update, nullptr before the first, read and swapped atomically
+        std::shared_ptr<const Table> table_;
+        int threads_, nx_, ny_;
+        // whether every pair must be searched
+        bool reset_;
+        std::vector<Node> pois_;
+        // routes of the pairs a < b at a * size + b
+        std::vector<Route> routes_;
+        // obstacle cells of the last update
+        std::vector<char> blocked_;
+        // search state by worker
+        struct Search {
+            std::vector<double> dist;
+            std::vector<int8_t> move;
+            std::vector<unsigned int> visit;
+            unsigned int stamp = 0;
+        };
+        std::vector<Search> search_;
+        // whole-map distance fields, for updates with fewer sources than threads
+        global_planner::DeltaStepping field_;
+        std::vector<double> dist_;
+};
+}
+#endif  // POI_LIBRARY_H
@@ -0,0 +1,149 @@
+/***********************************************************
+ *
+ * @file: quadtree_planner.h
+ * @breif: Contains the quadtree free space decomposition planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-27
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef QUADTREE_PLANNER_H
+#define QUADTREE_PLANNER_H
+
+#include <vector>
+
+#include "global_planner.h"
+#include "utils.h"
+
+namespace quadtree_planner {
+/**
+ * @brief Adaptive quadtree over the costmap whose leaves are uniformly free or occupied squares, cells
+ *        outside the costmap counting as occupied. It is kept by splitting the leaves a costmap change
+ *        made mixed and merging the siblings it made uniform, so that its size follows the obstacle
+ *        boundaries rather than the area. Free leaves link to the free leaves they touch, edges and corners.
+ */
+class Quadtree {
+    public:
+        /**
+         * @brief Square of the tree
+         */
+        struct Quad {
+            // lower corner and edge length in cells
+            int x, y, size;
+            // first of the four children, -1 for leaves
+            int child;
+            // leaves: free or occupied
+            bool free;
+            // neighbour links of a free leaf, valid if linked
+            bool linked;
+            std::vector<int> links;
+        };
+
+        /**
+         * @brief  Constructor
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         */
+        Quadtree(int nx, int ny);
+
+        /**
+         * @brief  split and merge the leaves where the costmap changed
+         * @param  costs        costmap
+         * @param  threshold    cells of cost >= threshold are occupied
+         * @return number of leaves split, merged or changed
+         */
+        int update(const unsigned char* costs, double threshold);
+        /**
+         * @brief  leaf containing a cell
+         */
+        int leaf(int x, int y) const;
+        /**
+         * @brief  free leaves touching a free leaf
+         */
+        const std::vector<int>& links(int q);
+        /**
+         * @brief  square of the tree
+         */
+        const Quad& get(int q) const { return this->quads_[q]; }
+        /**
+         * @brief  number of squares, for sizing search state
+         */
+        size_t size() const { return this->quads_.size(); }
+        /**
+         * @brief  number of leaves
+         */
+        size_t leafNum() const;
+
+    private:
+        /**
+         * @brief  bring a subtree up to date with the costmap
+         * @param  q        square
+         * @param  changed  squares that were split, merged or changed, appended
+         */
+        void _update(int q, std::vector<int>& changed);
+        /**
+         * @brief  whether a square is uniform
+         * @param  x, y, size   square
+         * @param  free         whether the uniform square is free
+         * @return true if all cells are free or all occupied
+         */
+        bool _uniform(int x, int y, int size, bool& free) const;
+        /**
+         * @brief  leaves intersecting a rectangle, inclusive
+         */
+        void _collect(int q, int x0, int y0, int x1, int y1, std::vector<int>& leaves) const;
+
+        int nx_, ny_;
+        // costmap and threshold of the running update
+        const unsigned char* costs_;
+        double threshold_;
+        // squares, the root first. Children are allocated four at a time, the blocks in free_blocks_ are unused
+        std::vector<Quad> quads_;
+        std::vector<int> free_blocks_;
+};
+
+/**
+ * @brief Class for objects that plan by A* over the free leaves of a quadtree, from the leaf center to the
+ *        leaf center through the cells where they touch, and smooth the path by line of sight checks
+ */
+class QuadtreePlanner : public global_planner::GlobalPlanner {
+    public:
+        /**
+         * @brief  Constructor
+         * @param   nx          pixel number in costmap x direction
+         * @param   ny          pixel number in costmap y direction
+         * @param   resolution  costmap resolution
+         */
+        QuadtreePlanner(int nx, int ny, double resolution);
+        /**
+         * @brief Quadtree planner implementation
+         * @param costs     costmap
+         * @param start     start node
+         * @param goal      goal node
+         * @param expand    containing the node been search during the process
+         * @return tuple contatining a bool as to whether a path was found, and the path
+         */
+        std::tuple<bool, std::vector<Node>> plan(const unsigned char* costs, const Node& start,
+                                                 const Node& goal, std::vector<Node> &expand);
+
+    protected:
+        /**
+         * @brief  whether every cell of the line between two cells is free
+         */
+        bool _lineOfSight(const unsigned char* costs, const Node& a, const Node& b) const;
+        /**
+         * @brief  cells of the line between two cells, 8-connected, without the first one
+         * @param  a        from cell
+         * @param  b        to cell
+         * @param  cells    line cells, appended
+         */
+        void _line(const Node& a, const Node& b, std::vector<Node>& cells) const;
+
+        Quadtree tree_;
+};
+}
+#endif  // QUADTREE_PLANNER_H
@@ -0,0 +1,107 @@
+/***********************************************************
+ *
+ * @file: rectangle_decomposition.h
+ * @breif: Contains the empty rectangle decomposition of rectangular symmetry reduction
+ * @author: Yang Haodong
+ * @update: 2023-2-25
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef RECTANGLE_DECOMPOSITION_H
+#define RECTANGLE_DECOMPOSITION_H
+
+#include <utility>
+#include <vector>
+
+namespace a_star_planner {
+/**
+ * @brief Decomposition of the free cells into empty rectangles for rectangular symmetry reduction
+ *        (Harabor & Botea). Inside a rectangle all octile paths between two perimeter cells are
+ *        symmetric, so a search skips the interior of a rectangle with at least one interior cell and
+ *        crosses it by macro edges from every perimeter cell to the opposite side and diagonally to the
+ *        adjacent sides. A start inside a rectangle is connected to its whole perimeter, and so is a goal.
+ *        The decomposition is updated incrementally from the cells that change.
+ */
+class RectangleDecomposition {
+    public:
+        /**
+         * @brief Rectangle of cells [x0, x1] x [y0, y1]
+         */
+        struct Rect {
+            int x0, y0, x1, y1;
+        };
+
+        /**
+         * @brief  Constructor
+         * @param  nx       pixel number in costmap x direction
+         * @param  ny       pixel number in costmap y direction
+         */
+        RectangleDecomposition(int nx, int ny);
+
+        /**
+         * @brief  decompose a costmap, or redecompose the rectangles around the cells that changed
+         * @param  costs        costmap
+         * @param  threshold    cells of cost >= threshold are obstacles
+         * @return number of cells that changed, all cells on the first call
+         */
+        int update(const unsigned char* costs, double threshold);
+        /**
+         * @brief  rectangle of a cell, -1 for obstacles
+         */
+        int rect(int cell) const { return this->rect_id_[cell]; }
+        /**
+         * @brief  whether the interior of a rectangle is skipped
+         */
+        bool pruned(int id) const {
+            const Rect& r = this->rects_[id];
+            return r.x1 - r.x0 >= 2 && r.y1 - r.y0 >= 2;
+        }
+        /**
+         * @brief  whether a cell is inside its rectangle, off the perimeter
+         */
+        bool interior(int cell) const;
+        /**
+         * @brief  macro edges of a perimeter cell across its rectangle, or of an interior cell to the perimeter
+         * @param  cell     cell index of a pruned rectangle
+         * @param  edges    target cell index and octile length, appended
+         */
+        void macroEdges(int cell, std::vector<std::pair<int, double>>& edges) const;
+        /**
+         * @brief  octile length of the straight line path between two cells
+         */
+        double distance(int a, int b) const;
+        /**
+         * @brief  number of rectangles
+         */
+        size_t size() const { return this->rects_.size() - this->free_ids_.size(); }
+
+    private:
+        /**
+         * @brief  cover the uncovered free cells among some cells with maximal rectangles, row-major
+         * @param  cells    cell indices
+         */
+        void _cover(std::vector<int>& cells);
+        /**
+         * @brief  remove a rectangle and append its cells
+         * @param  id       rectangle
+         * @param  cells    uncovered cell indices
+         */
+        void _remove(int id, std::vector<int>& cells);
+
+        int nx_, ny_;
+        // whether the costmap was decomposed
+        bool built_;
+        // obstacle cells of the decomposed costmap
+        std::vector<char> blocked_;
+        // rectangle by cell, -1 for obstacles
+        std::vector<int> rect_id_;
+        // rectangles, the ids in free_ids_ are unused
+        std::vector<Rect> rects_;
+        std::vector<int> free_ids_;
+};
+}
+#endif  // RECTANGLE_DECOMPOSITION_H
@@ -0,0 +1,154 @@
+/***********************************************************
+ *
+ * @file: subgoal_graph.h
+ * @breif: Contains the simple subgoal graph planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-22
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef SUBGOAL_GRAPH_H
+#define SUBGOAL_GRAPH_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "global_planner.h"
+#include "utils.h"
+
+namespace subgoal_planner {
+/**
+ * @brief Class for objects that plan on a simple subgoal graph (Uras & Koenig). Subgoals are the free cells
+ *        at the convex corners of obstacles, connected when one is directly h-reachable from the other, i.e.
+ *        reachable along an octile path free of obstacles and other subgoals. A query connects start and goal
+ *        to the graph, searches the few subgoals and refines the result into a grid path.
+ *        The graph is built from the first costmap and rebuilt incrementally around the cells that change.
+ *        Diagonal moves must not cut obstacle corners, so paths can be longer than those of A*.
+ */
+class SubgoalGraph : public global_planner::GlobalPlanner {
+    public:
+        /**
+         * @brief  Constructor
+         * @param   nx          pixel number in costmap x direction
+         * @param   ny          pixel number in costmap y direction
+         * @param   resolution  costmap resolution
+         */
+        SubgoalGraph(int nx, int ny, double resolution);
+        /**
+         * @brief Subgoal graph search implementation
+         * @param costs     costmap
+         * @param start     start node
+         * @param goal      goal node
+         * @param expand    containing the subgoals been search during the process
+         * @return tuple contatining a bool as to whether a path was found, and the path
+         */
+        std::tuple<bool, std::vector<Node>> plan(const unsigned char* costs, const Node& start,
+                                                 const Node& goal, std::vector<Node> &expand);
+        /**
+         * @brief  set or reset obstacle factor, the graph is rebuilt by the next search
+         * @param factor obstacle factor
+         */
+        void setFactor(double factor) override;
+        /**
+         * @brief  number of subgoals
+         */
+        size_t subgoalNum() const { return this->subgoals_.size(); }
+        /**
+         * @brief  number of undirected edges
+         */
+        size_t edgeNum() const { return this->edges_.size() / 2; }
+
+    protected:
+        /**
+         * @brief Directly h-reachable subgoals of a subgoal, and the box of cells their search read
+         */
+        struct Sweep {
+            std::vector<int> reach;
+            int x0, y0, x1, y1;
+        };
+
+        /**
+         * @brief  build the graph from a costmap, or rebuild the subgoals the changed cells affect
+         * @param  costs    costmap
+         */
+        void _update(const unsigned char* costs);
+        /**
+         * @brief  recompute the cardinal clearances of a row (east, west) or a column (north, south)
+         * @param  dir      cardinal direction
+         * @param  line     row y or column x
+         */
+        void _computeClearance(int dir, int line);
+        /**
+         * @brief  pack the sweeps into the CSR adjacency
+         */
+        void _buildCSR();
+        /**
+         * @brief  find the directly h-reachable subgoals of a cell
+         * @param  x        cell x
+         * @param  y        cell y
+         * @param  target   cell index treated as a subgoal, -1 for none
+         * @param  sweep    reachable cells and the box of the cells read
+         */
+        void _sweep(int x, int y, int target, Sweep& sweep) const;
+        /**
+         * @brief  number of moves from a cell in a direction until a subgoal or before an obstacle
+         * @param  x        cell x
+         * @param  y        cell y
+         * @param  dir      direction, cardinal 0-3, diagonal 4-7
+         * @param  target   cell index treated as a subgoal, -1 for none
+         * @param  sweep    the box of the cells read is extended
+         * @return number of moves
+         */
+        int _clearance(int x, int y, int dir, int target, Sweep& sweep) const;
+        /**
+         * @brief  append the octile path from a to b, diagonal moves first, without a
+         * @param  a        from cell index
+         * @param  b        to cell index
+         * @param  cells    path cells
+         * @return false if the path is blocked
+         */
+        bool _walk(int a, int b, std::vector<int>& cells) const;
+        /**
+         * @brief  whether a cell is a subgoal of the current costmap
+         */
+        bool _isSubgoal(int x, int y) const;
+        /**
+         * @brief  whether a cell is inside the costmap and free
+         */
+        bool _free(int x, int y) const {
+            return x >= 0 && x < this->nx_ && y >= 0 && y < this->ny_ && !this->blocked_[y * this->nx_ + x];
+        }
+        /**
+         * @brief  whether a move from a cell is valid, diagonal moves must not cut obstacle corners
+         */
+        bool _canMove(int x, int y, int dir) const;
+        /**
+         * @brief  octile distance between two cells
+         */
+        double _octile(int a, int b) const;
+
+        // whether a graph was built
+        bool built_;
+        // costmap the graph was built from
+        std::vector<unsigned char> costs_;
+        // obstacle cells
+        std::vector<char> blocked_;
+        // subgoal cells
+        std::vector<char> is_subgoal_;
+        // moves to the next subgoal or obstacle in the cardinal directions
+        std::vector<int> clearance_[4];
+        // directly h-reachable subgoals, by subgoal cell
+        std::unordered_map<int, Sweep> sweeps_;
+        // subgoal cells by vertex and vertex by cell, -1 if not a subgoal
+        std::vector<int> subgoals_, vertex_;
+        // CSR adjacency, the edges of vertex i are edges_[offsets_[i]] ... edges_[offsets_[i + 1] - 1]
+        std::vector<int> offsets_, edges_;
+        // octile length of the edges
+        std::vector<float> weights_;
+};
+}
+#endif  // SUBGOAL_GRAPH_H
@@ -11,12 +11,14 @@
  * --------------------------------------------------------
  *
  **********************************************************/
+#include <algorithm>
 #include <cmath>
 #include <queue>
 #include <unordered_set>
 #include <vector>
 
 #include "a_star.h"
+#include "trace.h"
 
 namespace a_star_planner{
   /**
@@ -24,8 +26,11 @@ namespace a_star_planner{
    * @param   nx          pixel number in costmap x direction
    * @param   ny          pixel number in costmap y direction
    * @param   resolution  costmap resolution
+   * @param   dijkstra    using diksktra implementation
+   * @param   gbfs        using gbfs implementation
+   * @param   rsr         using rectangular symmetry reduction, skipping the interiors of empty rectangles
    */
-  AStar::AStar(int nx, int ny, double resolution, bool dijkstra, bool gbfs) : 
+  AStar::AStar(int nx, int ny, double resolution, bool dijkstra, bool gbfs, bool rsr) : 
       GlobalPlanner(nx, ny, resolution) {
     // can not using both dijkstra and GBFS at the same time
     if(!(dijkstra && gbfs)) {
@@ -35,6 +40,8 @@ namespace a_star_planner{
       this->is_dijkstra_ = false;
       this->is_gbfs_ = false;   
     }
+    if (rsr)
+      this->rectangles_ = std::make_unique<RectangleDecomposition>(nx, ny);
   };
   /**
    * @brief A* implementation
@@ -47,12 +54,16 @@ namespace a_star_planner{
    */
   std::tuple<bool, std::vector<Node>> AStar::plan(const unsigned char* costs, const Node& start,
                                                   const Node& goal, std::vector<Node> &expand) {
+    TRACE_SCOPE("AStar::plan");
+    // search containers live in the arena until the end of the search
+    global_planner::PlanArena::Scope arena(this->arena_);
+
     // open list
-    std::priority_queue<Node, std::vector<Node>, compare_cost> open_list;
+    OpenList open_list(compare_cost(), std::pmr::vector<Node>(this->arena_.resource()));
     open_list.push(start);
 
     // closed list
-    std::unordered_set<Node, NodeIdAsHash, compare_coordinates> closed_list;
+    ClosedList closed_list(0, NodeIdAsHash(), compare_coordinates(), this->arena_.resource());
 
     // expand list
     expand.clear();
@@ -61,8 +72,22 @@ namespace a_star_planner{
     // get all possible motions
     const std::vector<Node> motion = getMotion();
 
+    // rectangular symmetry reduction: a goal inside a rectangle is reached from its perimeter
+    const RectangleDecomposition* rects = this->rectangles_.get();
+    int goal_id = this->grid2Index(goal.x, goal.y), goal_rect = -1;
+    if (rects) {
+      this->rectangles_->update(costs, this->lethal_cost_ * this->factor_);
+      if (goal_id >= 0 && goal_id < this->ns_ && rects->interior(goal_id))
+        goal_rect = rects->rect(goal_id);
+    }
+    auto reduced = [&](int id) {
+      return rects->rect(id) >= 0 && rects->pruned(rects->rect(id));
+    };
+    std::pmr::vector<Node> successors(this->arena_.resource());
+    std::vector<std::pair<int, double>> macro_edges;
+
     // main loop
-    while (!open_list.empty()) {
+    while (!open_list.empty() && !this->_isCanceled()) {
       // pop current node from open list
       Node current = open_list.top();
       open_list.pop();
@@ -75,12 +100,39 @@ namespace a_star_planner{
       // goal found
       if (current==goal) {
         closed_list.insert(current);
+        if (rects)
+          return {true, this->_unfoldMacroEdges(this->_convertClosedListToPath(closed_list, start, goal))};
         return {true, this->_convertClosedListToPath(closed_list, start, goal)};
       }
 
+      // neighbors of current node, with rectangular symmetry reduction the perimeter of an empty
+      // rectangle leads across it by macro edges instead of through its interior
+      successors.clear();
+      if (!rects) {
+        for (const auto& m : motion)
+          successors.push_back(current + m);
+      } else {
+        for (const auto& m : motion) {
+          Node next = current + m;
+          if (next.x < 0 || next.x >= this->nx_ || next.y < 0 || next.y >= this->ny_)
+            continue;
+          int id = this->grid2Index(next.x, next.y);
+          if (!reduced(id) || !rects->interior(id))
+            successors.push_back(next);
+        }
+        if (current.id >= 0 && current.id < this->ns_ && reduced(current.id)) {
+          macro_edges.clear();
+          rects->macroEdges(current.id, macro_edges);
+          if (rects->rect(current.id) == goal_rect)
+            macro_edges.emplace_back(goal_id, rects->distance(current.id, goal_id));
+          for (const auto& e : macro_edges)
+            successors.emplace_back(e.first % this->nx_, e.first / this->nx_, current.cost + e.second);
+        }
+      }
+
       // explore neighbor of current node
-      for (const auto& m : motion) {
-        Node new_point = current + m;
+      for (const auto& next : successors) {
+        Node new_point = next;
 
         // current node do not exist in closed list
         if (closed_list.find(new_point) != closed_list.end())
@@ -117,4 +169,32 @@ namespace a_star_planner{
     }
     return {false, {}};
   }
+
+  /**
+   * @brief  insert the cells a macro edge crosses into a path, diagonal moves first
+   * @param  path     path with macro edges
+   * @return path of adjacent cells
+   */
+  std::vector<Node> AStar::_unfoldMacroEdges(const std::vector<Node>& path) {
+    std::vector<Node> cells;
+    for (size_t i = 0; i < path.size(); i++) {
+      cells.push_back(path[i]);
+      if (i + 1 == path.size())
+        break;
+      // walk back from the later node, which the path lists first
+      Node cur = path[i];
+      const Node& prev = path[i + 1];
+      while (std::max(std::abs(prev.x - cur.x), std::abs(prev.y - cur.y)) > 1) {
+        int dx = (prev.x > cur.x) - (prev.x < cur.x), dy = (prev.y > cur.y) - (prev.y < cur.y);
+        cur.cost -= dx && dy ? std::sqrt(2) : 1;
+        cur.x += dx;
+        cur.y += dy;
+        cur.id = this->grid2Index(cur.x, cur.y);
+        cur.pid = prev.id;
+        cells.back().pid = cur.id;
+        cells.push_back(cur);
+      }
+    }
+    return cells;
+  }
 }
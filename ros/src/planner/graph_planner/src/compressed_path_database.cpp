@@ -0,0 +1,488 @@
+/***********************************************************
+ *
+ * @file: compressed_path_database.cpp
+ * @breif: Contains the compressed path database planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-24
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#include "compressed_path_database.h"
+#include "trace.h"
+
+namespace cpd_planner {
+namespace {
+// layout version of the stored database and of its checkpoint
+const uint32_t kVersion = 1;
+const char* const kName = "compressed_path_database";
+const char* const kCheckpoint = "compressed_path_database_checkpoint";
+// rows computed between two checkpoints
+const int kCheckpointRows = 16;
+// move of the runs whose targets are unreachable
+const int kNoMove = 8;
+const double kInf = std::numeric_limits<double>::max();
+// sums of the same moves in another order may differ by rounding, such paths are as short
+const double kTolerance = 1e-9;
+
+/**
+ * @brief  run fn(i, worker) for every i in [0, n) on the worker threads
+ */
+void parallelFor(int n, int threads, const std::function<void(int, int)>& fn) {
+    std::atomic<int> next(0);
+    auto work = [&](int worker) {
+        for (int i = next++; i < n; i = next++)
+            fn(i, worker);
+    };
+    std::vector<std::thread> pool;
+    for (int w = 1; w < threads; w++)
+        pool.emplace_back(work, w);
+    work(0);
+    for (auto& t : pool)
+        t.join();
+}
+
+/**
+ * @brief Runs of the sources of one row, in row-major order
+ */
+struct Row {
+    std::vector<uint32_t> count;
+    std::vector<uint32_t> runs;
+};
+
+/**
+ * @brief Dijkstra state of a worker
+ */
+struct Search {
+    std::vector<double> dist;
+    // optimal first moves, bit kNoMove for unreachable targets
+    std::vector<uint16_t> moves;
+    std::vector<std::pair<double, int>> heap;
+};
+}
+
+    /**
+     * @brief  compute the first moves from every free cell, the sources of a row in parallel
+     * @param  blocked  obstacle cells, of size nx * ny
+     * @param  nx       pixel number in costmap x direction
+     * @param  ny       pixel number in costmap y direction
+     * @param  threads  worker threads, 0 for one per core
+     * @param  store    the finished rows are checkpointed to the store and a build resumes from them
+     * @param  key      key of the layout
+     * @param  cancel   flag that makes the build give up once raised, the checkpoint is kept
+     * @return database, nullptr if the build was canceled
+     */
+    std::shared_ptr<Database> Database::build(const std::vector<char>& blocked, int nx, int ny, int threads,
+                                              const global_planner::PrecomputeStore& store, uint64_t key,
+                                              const std::atomic<bool>* cancel) {
+        TRACE_SCOPE("Database::build");
+        if (threads <= 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        int ns = nx * ny;
+        const std::vector<Node> motion = getMotion();
+        auto neighbour = [&](int cell, int k) {
+            int x = cell % nx + motion[k].x, y = cell / nx + motion[k].y;
+            return x >= 0 && x < nx && y >= 0 && y < ny && !blocked[y * nx + x] ? y * nx + x : -1;
+        };
+
+        // depth-first order of the targets, neighbouring cells tend to share their first moves
+        std::shared_ptr<Database> database(new Database());
+        database->orders_.assign(ns, -1);
+        std::vector<int> cells, stack;
+        for (int root = 0; root < ns; root++) {
+            if (blocked[root] || database->orders_[root] >= 0)
+                continue;
+            stack.push_back(root);
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                if (database->orders_[u] >= 0)
+                    continue;
+                database->orders_[u] = (int)cells.size();
+                cells.push_back(u);
+                for (int k = (int)motion.size() - 1; k >= 0; k--) {
+                    int v = neighbour(u, k);
+                    if (v >= 0 && database->orders_[v] < 0)
+                        stack.push_back(v);
+                }
+            }
+        }
+        int n = (int)cells.size();
+        const std::vector<int>& order = database->orders_;
+
+        // resume from the rows of an interrupted build
+        std::vector<Row> rows(ny);
+        int done = 0;
+        global_planner::PrecomputeMapping checkpoint;
+        const uint32_t *progress = nullptr, *count = nullptr, *runs = nullptr;
+        size_t progress_num = 0, count_num = 0, run_num = 0;
+        if (store.enabled() && store.load(kCheckpoint, key, kVersion, checkpoint) &&
+            checkpoint.section("progress", progress, progress_num) && progress_num == 1 &&
+            checkpoint.section("count", count, count_num) && checkpoint.section("run", runs, run_num)) {
+            // every source of the finished rows, or the checkpoint is of another build
+            bool valid = progress[0] <= (uint32_t)ny;
+            size_t c = 0, r = 0;
+            for (int y = 0; valid && y < (int)progress[0]; y++)
+                for (int x = 0; valid && x < nx; x++) {
+                    if (blocked[y * nx + x])
+                        continue;
+                    valid = c < count_num && r + count[c] <= run_num;
+                    if (valid) {
+                        rows[y].count.push_back(count[c]);
+                        rows[y].runs.insert(rows[y].runs.end(), runs + r, runs + r + count[c]);
+                        r += count[c++];
+                    }
+                }
+            if (valid && c == count_num && r == run_num)
+                done = (int)progress[0];
+            else
+                rows.assign(ny, Row());
+        }
+        checkpoint.close();
+
+        std::vector<Search> search(threads);
+        for (Search& s : search) {
+            s.dist.assign(n, kInf);
+            s.moves.assign(n, 0);
+        }
+        auto canceled = [&]() { return cancel && cancel->load(std::memory_order_relaxed); };
+        auto compute = [&](int y, int worker) {
+            Search& s = search[worker];
+            for (int x = 0; x < nx; x++) {
+                int source = y * nx + x;
+                if (blocked[source] || canceled())
+                    continue;
+
+                // optimal first moves towards every target, unions over the shortest paths
+                std::fill(s.dist.begin(), s.dist.end(), kInf);
+                std::fill(s.moves.begin(), s.moves.end(), 1 << kNoMove);
+                s.dist[order[source]] = 0.0;
+                s.moves[order[source]] = (1 << (kNoMove + 1)) - 1;
+                s.heap.push_back({ 0.0, source });
+                while (!s.heap.empty()) {
+                    std::pop_heap(s.heap.begin(), s.heap.end(), std::greater<std::pair<double, int>>());
+                    std::pair<double, int> item = s.heap.back();
+                    s.heap.pop_back();
+                    int u = order[item.second];
+                    if (item.first > s.dist[u])
+                        continue;
+                    for (int k = 0; k < (int)motion.size(); k++) {
+                        int cell = neighbour(item.second, k);
+                        if (cell < 0)
+                            continue;
+                        int v = order[cell];
+                        double g = item.first + motion[k].cost;
+                        uint16_t moves = item.second == source ? 1 << k : s.moves[u];
+                        if (g < s.dist[v] - kTolerance) {
+                            s.dist[v] = g;
+                            s.moves[v] = moves;
+                            s.heap.push_back({ g, cell });
+                            std::push_heap(s.heap.begin(), s.heap.end(), std::greater<std::pair<double, int>>());
+                        }
+                        else if (g <= s.dist[v] + kTolerance)
+                            s.moves[v] |= moves;
+                    }
+                }
+
+                // a run lasts while some move is optimal for all its targets
+                uint32_t start = 0, before = (uint32_t)rows[y].runs.size();
+                uint16_t common = s.moves[0];
+                for (int t = 1; t <= n; t++) {
+                    if (t < n && (common & s.moves[t])) {
+                        common &= s.moves[t];
+                        continue;
+                    }
+                    int move = 0;
+                    while (!(common & (1 << move)))
+                        move++;
+                    rows[y].runs.push_back(start << 4 | move);
+                    if (t < n) {
+                        start = t;
+                        common = s.moves[t];
+                    }
+                }
+                rows[y].count.push_back((uint32_t)rows[y].runs.size() - before);
+            }
+        };
+
+        for (int y = done; y < ny; y += kCheckpointRows) {
+            int last = std::min(ny, y + kCheckpointRows);
+            parallelFor(last - y, threads, [&](int i, int worker) { compute(y + i, worker); });
+            // the rows of a canceled chunk are incomplete, a later build resumes from the last checkpoint
+            if (canceled())
+                return nullptr;
+            if (!store.enabled() || last == ny)
+                continue;
+            std::vector<uint32_t> counts, all_runs;
+            for (int r = 0; r < last; r++) {
+                counts.insert(counts.end(), rows[r].count.begin(), rows[r].count.end());
+                all_runs.insert(all_runs.end(), rows[r].runs.begin(), rows[r].runs.end());
+            }
+            global_planner::PrecomputeWriter writer;
+            writer.addSection("progress", std::vector<uint32_t>{ (uint32_t)last });
+            writer.addSection("count", counts);
+            writer.addSection("run", all_runs);
+            store.save(kCheckpoint, key, kVersion, writer);
+        }
+
+        // sources by target order
+        std::vector<uint32_t> first(ns, 0), length(ns, 0);
+        for (int y = 0; y < ny; y++) {
+            uint32_t r = 0;
+            size_t c = 0;
+            for (int x = 0; x < nx; x++)
+                if (!blocked[y * nx + x]) {
+                    first[y * nx + x] = r;
+                    length[y * nx + x] = rows[y].count[c];
+                    r += rows[y].count[c++];
+                }
+        }
+        database->ns_ = ns;
+        database->node_num_ = n;
+        database->offsets_.assign(n + 1, 0);
+        for (int s = 0; s < n; s++) {
+            const uint32_t* begin = rows[cells[s] / nx].runs.data() + first[cells[s]];
+            database->runs_.insert(database->runs_.end(), begin, begin + length[cells[s]]);
+            database->offsets_[s + 1] = (uint32_t)database->runs_.size();
+        }
+        database->order_ = database->orders_.data();
+        database->offset_ = database->offsets_.data();
+        database->run_ = database->runs_.data();
+        return database;
+    }
+
+    /**
+     * @brief  map a stored database
+     * @param  store    precomputation store
+     * @param  key      key of the layout
+     * @param  ns       total pixel number the database must have
+     * @return database, nullptr if none is stored
+     */
+    std::shared_ptr<Database> Database::load(const global_planner::PrecomputeStore& store, uint64_t key, int ns) {
+        std::shared_ptr<Database> database(new Database());
+        if (!store.load(kName, key, kVersion, database->mapping_))
+            return nullptr;
+        size_t order_num, offset_num, run_num;
+        const global_planner::PrecomputeMapping& mapping = database->mapping_;
+        if (!mapping.section("order", database->order_, order_num) ||
+            !mapping.section("offset", database->offset_, offset_num) ||
+            !mapping.section("run", database->run_, run_num) || order_num != (size_t)ns || offset_num == 0 ||
+            database->offset_[offset_num - 1] != run_num)
+            return nullptr;
+        database->ns_ = ns;
+        database->node_num_ = (int)offset_num - 1;
+        return database;
+    }
+
+    /**
+     * @brief  store the database
+     * @param  store    precomputation store
+     * @param  key      key of the layout
+     * @return true if it was written
+     */
+    bool Database::save(const global_planner::PrecomputeStore& store, uint64_t key) const {
+        global_planner::PrecomputeWriter writer;
+        writer.addSection("order", this->order_, this->ns_ * sizeof(int));
+        writer.addSection("offset", this->offset_, (this->node_num_ + 1) * sizeof(uint32_t));
+        writer.addSection("run", this->run_, this->runNum() * sizeof(uint32_t));
+        if (!store.save(kName, key, kVersion, writer))
+            return false;
+        std::remove(store.path(kCheckpoint, key).c_str());
+        return true;
+    }
+
+    /**
+     * @brief  first move of an optimal path
+     * @param  source   source cell index
+     * @param  target   target cell index
+     * @return index into getMotion(), -1 if either cell is an obstacle or the target is unreachable
+     */
+    int Database::firstMove(int source, int target) const {
+        int s = this->order_[source], t = this->order_[target];
+        if (s < 0 || t < 0)
+            return -1;
+        // last run starting at or before the target, the first run starts at 0
+        const uint32_t* run = std::upper_bound(this->run_ + this->offset_[s], this->run_ + this->offset_[s + 1],
+                                               (uint32_t)t << 4 | 0xF) - 1;
+        int move = *run & 0xF;
+        return move == kNoMove ? -1 : move;
+    }
+
+    /**
+     * @brief  Constructor
+     * @param  directory    precomputation store directory, empty to keep the database in memory only
+     * @param  threads      build threads, 0 for one per core
+     * @param  capacity     layouts kept in memory and in the store, the least recently used is dropped
+     */
+    DatabaseCache::DatabaseCache(const std::string& directory, int threads, size_t capacity)
+        : PrecomputeCache<Database>(kName, directory, capacity,
+              [threads, capacity](const std::vector<char>& blocked, int nx, int ny,
+                                  const global_planner::PrecomputeStore& store, uint64_t key,
+                                  const std::atomic<bool>* cancel) {
+                  // checkpoints of builds that never finished count against the store too
+                  store.prune(kCheckpoint, capacity);
+                  return Database::build(blocked, nx, ny, threads, store, key, cancel);
+              }) {}
+
+    /**
+     * @brief  Constructor
+     * @param   nx          pixel number in costmap x direction
+     * @param   ny          pixel number in costmap y direction
+     * @param   resolution  costmap resolution
+     * @param   cache       database cache shared with other planners, nullptr for a private one
+     */
+    CompressedPathDatabase::CompressedPathDatabase(int nx, int ny, double resolution,
+                                                   std::shared_ptr<DatabaseCache> cache)
+        : GlobalPlanner(nx, ny, resolution), cache_(cache ? cache : std::make_shared<DatabaseCache>()),
+          dirty_(this->ns_, 0), fallback_(nx, ny, resolution) {}
+
+    /**
+     * @brief Compressed path database implementation
+     * @param costs     costmap
+     * @param start     start node
+     * @param goal      goal node
+     * @param expand    containing the node been search during the process
+     * @return tuple contatining a bool as to whether a path was found, and the path
+     */
+    std::tuple<bool, std::vector<Node>> CompressedPathDatabase::plan(const unsigned char* costs, const Node& start,
+                                                                     const Node& goal, std::vector<Node> &expand) {
+        TRACE_SCOPE("CompressedPathDatabase::plan");
+        expand.clear();
+        expand.push_back(start);
+        bool exact = this->_take(costs);
+        int s = this->grid2Index(start.x, start.y), t = this->grid2Index(goal.x, goal.y);
+
+        if (this->database_ && this->database_->free(s) && this->database_->free(t)) {
+            const Database& database = *this->database_;
+            bool dirty = !exact && this->_markDirty(costs);
+            const std::vector<Node> motion = getMotion();
+            auto next = [&](int cell, int move) {
+                return this->grid2Index(cell % this->nx_ + motion[move].x, cell / this->nx_ + motion[move].y);
+            };
+
+            // follow the first moves, A* from where they enter a dirty region to where they leave it
+            std::vector<int> cells{ s };
+            bool found = true;
+            for (int c = s; c != t && found;) {
+                if (this->_isCanceled())
+                    return {false, {}};
+                int move = database.firstMove(c, t);
+                found = move >= 0;
+                if (!found)
+                    break;
+                int n = next(c, move);
+                if (!dirty || !this->dirty_[n]) {
+                    cells.push_back(n);
+                    expand.push_back(Node(n % this->nx_, n / this->nx_, 0, 0, n, c));
+                    c = n;
+                    continue;
+                }
+                int e = n;
+                while (found && e != t && this->dirty_[e]) {
+                    move = database.firstMove(e, t);
+                    found = move >= 0;
+                    e = found ? next(e, move) : e;
+                }
+                found = found && this->_detour(costs, c, e, cells, expand);
+                c = e;
+            }
+
+            if (found) {
+                std::vector<Node> path;
+                double g = 0.0;
+                for (size_t i = 0; i < cells.size(); i++) {
+                    int x = cells[i] % this->nx_, y = cells[i] / this->nx_;
+                    if (i)
+                        g += std::hypot(x - cells[i - 1] % this->nx_, y - cells[i - 1] / this->nx_);
+                    path.push_back(Node(x, y, g, 0, cells[i], cells[i ? i - 1 : 0]));
+                }
+                std::reverse(path.begin(), path.end());
+                return {true, path};
+            }
+            // no path in the layout is final unless cells changed since it was taken
+            if (!dirty)
+                return {false, {}};
+        }
+        this->fallback_.setCancelFlag(this->cancel_);
+        return this->fallback_.plan(costs, start, goal, expand);
+    }
+
+    /**
+     * @brief  set or reset obstacle factor, the database is taken again by the next search
+     * @param factor obstacle factor
+     */
+    void CompressedPathDatabase::setFactor(double factor) {
+        GlobalPlanner::setFactor(factor);
+        this->fallback_.setFactor(factor);
+        this->layout_.reset();
+        this->database_.reset();
+    }
+
+    /**
+     * @brief  take the latest database published for the costmap layouts
+     * @param  costs    costmap
+     * @return true if the database is of the costmap layout
+     */
+    bool CompressedPathDatabase::_take(const unsigned char* costs) {
+        bool exact = this->layout_.update(*this->cache_, costs, this->nx_, this->ny_,
+                                          this->lethal_cost_ * this->factor_, this->cleared_cell_, this->cleared_cost_);
+        this->database_ = this->layout_.held();
+        return exact;
+    }
+
+    /**
+     * @brief  mark the cells blocked or freed since the layout, and their neighbours
+     * @param  costs    costmap
+     * @return true if any cell is dirty
+     */
+    bool CompressedPathDatabase::_markDirty(const unsigned char* costs) {
+        bool dirty = false;
+        std::fill(this->dirty_.begin(), this->dirty_.end(), 0);
+        for (int i = 0; i < this->ns_; i++) {
+            if ((costs[i] < this->lethal_cost_ * this->factor_) == this->database_->free(i))
+                continue;
+            dirty = true;
+            int x = i % this->nx_, y = i / this->nx_;
+            for (int dy = std::max(0, y - 1); dy <= std::min(this->ny_ - 1, y + 1); dy++)
+                for (int dx = std::max(0, x - 1); dx <= std::min(this->nx_ - 1, x + 1); dx++)
+                    this->dirty_[dy * this->nx_ + dx] = 1;
+        }
+        return dirty;
+    }
+
+    /**
+     * @brief  A* between two cells, appended without the first one
+     * @param  costs    costmap
+     * @param  from     from cell index
+     * @param  to       to cell index
+     * @param  cells    path cells
+     * @param  expand   the nodes A* expanded are appended
+     * @return false if A* found no path
+     */
+    bool CompressedPathDatabase::_detour(const unsigned char* costs, int from, int to, std::vector<int>& cells,
+                                         std::vector<Node>& expand) {
+        std::vector<Node> detour_expand;
+        Node a(from % this->nx_, from / this->nx_, 0, 0, from, from), b(to % this->nx_, to / this->nx_, 0, 0, to, 0);
+        this->fallback_.setCancelFlag(this->cancel_);
+        auto result = this->fallback_.plan(costs, a, b, detour_expand);
+        expand.insert(expand.end(), detour_expand.begin(), detour_expand.end());
+        const std::vector<Node>& path = std::get<1>(result);
+        if (!std::get<0>(result) || path.empty())
+            return false;
+        // goal first
+        for (auto it = path.rbegin() + 1; it != path.rend(); it++)
+            cells.push_back(this->grid2Index(it->x, it->y));
+        return true;
+    }
+}
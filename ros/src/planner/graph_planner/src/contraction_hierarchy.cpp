@@ -0,0 +1,615 @@
+/***********************************************************
+ *
+ * @file: contraction_hierarchy.cpp
+ * @breif: Contains the contraction hierarchy planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-23
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <thread>
+
+#include "contraction_hierarchy.h"
+#include "trace.h"
+
+namespace ch_planner {
+namespace {
+// layout version of the stored hierarchy
+const uint32_t kVersion = 1;
+// nodes a witness search settles before it gives up and the shortcut is kept
+const int kWitnessSettled = 500;
+// the same for the priority, which only estimates the shortcuts
+const int kEstimateSettled = 5;
+const double kInf = std::numeric_limits<double>::max();
+// sums of the same moves in another order may differ by rounding, such witnesses are as short
+const double kTolerance = 1e-9;
+
+/**
+ * @brief Edge of the graph being contracted
+ */
+struct Arc {
+    int to;
+    int mid;
+    double weight;
+};
+
+/**
+ * @brief Shortcut found by a contraction
+ */
+struct Shortcut {
+    int from;
+    Arc arc;
+};
+
+/**
+ * @brief  run fn(i, worker) for every i in [0, n) on the worker threads
+ */
+void parallelFor(int n, int threads, const std::function<void(int, int)>& fn) {
+    std::atomic<int> next(0);
+    auto work = [&](int worker) {
+        for (int i = next.fetch_add(64); i < n; i = next.fetch_add(64))
+            for (int j = i; j < std::min(n, i + 64); j++)
+                fn(j, worker);
+    };
+    std::vector<std::thread> pool;
+    for (int w = 1; w < threads; w++)
+        pool.emplace_back(work, w);
+    work(0);
+    for (auto& t : pool)
+        t.join();
+}
+
+/**
+ * @brief Node contraction of an undirected graph. Every round contracts, in parallel, the nodes whose priority
+ *        is lower than that of all their neighbours.
+ */
+class Contractor {
+    public:
+        Contractor(std::vector<std::vector<Arc>>& adj, int threads)
+            : adj_(adj), n_((int)adj.size()), threads_(threads), contracted_(n_, 0), priority_(n_, 0),
+              deleted_(n_, 0), level_(n_, 0), witness_(threads) {
+            for (Witness& w : this->witness_) {
+                w.dist.assign(this->n_, kInf);
+                w.need.assign(this->n_, -1.0);
+            }
+        }
+
+        /**
+         * @brief  contract all nodes
+         * @param  order    nodes in contraction order
+         * @param  up       edges of every node to the nodes contracted after it
+         * @param  cancel   flag checked between the rounds, nullptr to disable
+         * @return false if canceled
+         */
+        bool run(std::vector<int>& order, std::vector<std::vector<Arc>>& up, const std::atomic<bool>* cancel) {
+            std::vector<int> remaining(this->n_);
+            std::iota(remaining.begin(), remaining.end(), 0);
+            parallelFor(this->n_, this->threads_, [&](int v, int worker) { this->_updatePriority(v, worker); });
+
+            order.clear();
+            up.assign(this->n_, {});
+            std::vector<char> affected(this->n_, 0);
+            while (!remaining.empty()) {
+                if (cancel && cancel->load(std::memory_order_relaxed))
+                    return false;
+                // independent set of local minima, the global minimum is always one
+                std::vector<char> pick(remaining.size(), 0);
+                parallelFor((int)remaining.size(), this->threads_, [&](int i, int) {
+                    int v = remaining[i];
+                    pick[i] = 1;
+                    for (const Arc& a : this->adj_[v])
+                        if (!this->contracted_[a.to] && this->_before(a.to, v)) {
+                            pick[i] = 0;
+                            break;
+                        }
+                });
+                std::vector<int> selected;
+                for (size_t i = 0; i < remaining.size(); i++)
+                    if (pick[i])
+                        selected.push_back(remaining[i]);
+
+                // witnesses must not pass nodes contracted in the same round
+                for (int v : selected)
+                    this->contracted_[v] = 1;
+                std::vector<std::vector<Shortcut>> shortcuts(selected.size());
+                parallelFor((int)selected.size(), this->threads_, [&](int i, int worker) {
+                    this->_shortcuts(selected[i], kWitnessSettled, this->witness_[worker], shortcuts[i]);
+                });
+
+                std::vector<int> neighbours;
+                for (int v : selected) {
+                    order.push_back(v);
+                    for (const Arc& a : this->adj_[v]) {
+                        if (this->contracted_[a.to])
+                            continue;
+                        up[v].push_back(a);
+                        this->deleted_[a.to]++;
+                        this->level_[a.to] = std::max(this->level_[a.to], this->level_[v] + 1);
+                        if (!affected[a.to]) {
+                            affected[a.to] = 1;
+                            neighbours.push_back(a.to);
+                        }
+                    }
+                }
+                for (const auto& list : shortcuts)
+                    for (const Shortcut& s : list) {
+                        this->_addArc(s.from, s.arc.to, s.arc.mid, s.arc.weight);
+                        this->_addArc(s.arc.to, s.from, s.arc.mid, s.arc.weight);
+                    }
+
+                // drop the contracted nodes from the neighbours, then their priorities change
+                parallelFor((int)neighbours.size(), this->threads_, [&](int i, int) {
+                    std::vector<Arc>& arcs = this->adj_[neighbours[i]];
+                    arcs.erase(std::remove_if(arcs.begin(), arcs.end(),
+                                              [&](const Arc& a) { return this->contracted_[a.to]; }), arcs.end());
+                });
+                parallelFor((int)neighbours.size(), this->threads_, [&](int i, int worker) {
+                    this->_updatePriority(neighbours[i], worker);
+                });
+                for (int u : neighbours)
+                    affected[u] = 0;
+                remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                               [&](int v) { return this->contracted_[v]; }), remaining.end());
+            }
+            return true;
+        }
+
+    private:
+        typedef std::pair<double, int> Item;
+
+        /**
+         * @brief Witness search state of a worker
+         */
+        struct Witness {
+            std::vector<double> dist;
+            // witness length a neighbour needs, -1 for other nodes
+            std::vector<double> need;
+            std::vector<int> touched;
+            std::vector<Item> heap;
+        };
+
+        /**
+         * @brief  whether u is contracted before v
+         */
+        bool _before(int u, int v) const {
+            return this->priority_[u] < this->priority_[v] || (this->priority_[u] == this->priority_[v] && u < v);
+        }
+
+        /**
+         * @brief  priority of a node: edge difference, contracted neighbours and depth
+         */
+        void _updatePriority(int v, int worker) {
+            std::vector<Shortcut> shortcuts;
+            this->_shortcuts(v, kEstimateSettled, this->witness_[worker], shortcuts);
+            int degree = 0;
+            for (const Arc& a : this->adj_[v])
+                degree += !this->contracted_[a.to];
+            this->priority_[v] = 2 * ((int)shortcuts.size() - degree) + this->deleted_[v] + this->level_[v];
+        }
+
+        /**
+         * @brief  shortcuts needed to contract v, between neighbours without a shorter witness path
+         */
+        void _shortcuts(int v, int max_settled, Witness& w, std::vector<Shortcut>& shortcuts) const {
+            std::vector<Arc> arcs;
+            for (const Arc& a : this->adj_[v])
+                if (!this->contracted_[a.to])
+                    arcs.push_back(a);
+
+            std::vector<Item>& heap = w.heap;
+            for (size_t i = 0; i + 1 < arcs.size(); i++) {
+                // the search ends once every later neighbour has a witness
+                double limit = 0.0;
+                int pending = 0;
+                for (size_t j = i + 1; j < arcs.size(); j++) {
+                    w.need[arcs[j].to] = arcs[i].weight + arcs[j].weight + kTolerance;
+                    limit = std::max(limit, w.need[arcs[j].to]);
+                    pending++;
+                }
+
+                // shortest paths from the neighbour around v, bounded
+                int source = arcs[i].to, settled = 0;
+                w.dist[source] = 0.0;
+                w.touched.push_back(source);
+                heap.push_back({ 0.0, source });
+                while (!heap.empty() && pending > 0 && settled < max_settled) {
+                    std::pop_heap(heap.begin(), heap.end(), std::greater<Item>());
+                    Item item = heap.back();
+                    heap.pop_back();
+                    if (item.first > limit)
+                        break;
+                    if (item.first > w.dist[item.second])
+                        continue;
+                    settled++;
+                    for (const Arc& a : this->adj_[item.second]) {
+                        double g = item.first + a.weight;
+                        if (a.to == v || this->contracted_[a.to] || g >= w.dist[a.to])
+                            continue;
+                        if (w.dist[a.to] == kInf)
+                            w.touched.push_back(a.to);
+                        if (g <= w.need[a.to] && w.dist[a.to] > w.need[a.to])
+                            pending--;
+                        w.dist[a.to] = g;
+                        heap.push_back({ g, a.to });
+                        std::push_heap(heap.begin(), heap.end(), std::greater<Item>());
+                    }
+                }
+                heap.clear();
+
+                for (size_t j = i + 1; j < arcs.size(); j++) {
+                    if (w.dist[arcs[j].to] > w.need[arcs[j].to])
+                        shortcuts.push_back(Shortcut{ source, Arc{ arcs[j].to, v, arcs[i].weight + arcs[j].weight } });
+                    w.need[arcs[j].to] = -1.0;
+                }
+                for (int u : w.touched)
+                    w.dist[u] = kInf;
+                w.touched.clear();
+            }
+        }
+
+        /**
+         * @brief  add an arc, or shorten the existing one
+         */
+        void _addArc(int from, int to, int mid, double weight) {
+            for (Arc& a : this->adj_[from])
+                if (a.to == to) {
+                    if (weight < a.weight)
+                        a = Arc{ to, mid, weight };
+                    return;
+                }
+            this->adj_[from].push_back(Arc{ to, mid, weight });
+        }
+
+        std::vector<std::vector<Arc>>& adj_;
+        int n_, threads_;
+        std::vector<char> contracted_;
+        std::vector<int> priority_, deleted_, level_;
+        std::vector<Witness> witness_;
+};
+}
+
+    /**
+     * @brief  contract the free cells of a costmap
+     * @param  blocked  obstacle cells, of size nx * ny
+     * @param  nx       pixel number in costmap x direction
+     * @param  ny       pixel number in costmap y direction
+     * @param  threads  worker threads, 0 for one per core
+     * @param  cancel   flag that makes the build give up once raised, nullptr to disable
+     * @return hierarchy, nullptr if the build was canceled
+     */
+    std::shared_ptr<Hierarchy> Hierarchy::build(const std::vector<char>& blocked, int nx, int ny, int threads,
+                                                const std::atomic<bool>* cancel) {
+        TRACE_SCOPE("Hierarchy::build");
+        if (threads <= 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        int ns = nx * ny;
+
+        // free cells, moves between them as A* makes them
+        std::vector<int> free_cells, free_node(ns, -1);
+        for (int i = 0; i < ns; i++)
+            if (!blocked[i]) {
+                free_node[i] = (int)free_cells.size();
+                free_cells.push_back(i);
+            }
+        int n = (int)free_cells.size();
+        std::vector<std::vector<Arc>> adj(n);
+        for (int v = 0; v < n; v++) {
+            int x = free_cells[v] % nx, y = free_cells[v] / nx;
+            for (const Node& m : getMotion()) {
+                int mx = x + m.x, my = y + m.y;
+                if (mx >= 0 && mx < nx && my >= 0 && my < ny && free_node[my * nx + mx] >= 0)
+                    adj[v].push_back(Arc{ free_node[my * nx + mx], -1, m.cost });
+            }
+        }
+
+        std::vector<int> order;
+        std::vector<std::vector<Arc>> up;
+        if (!Contractor(adj, threads).run(order, up, cancel))
+            return nullptr;
+
+        // number the nodes in contraction order
+        std::vector<int> rank(n);
+        for (int r = 0; r < n; r++)
+            rank[order[r]] = r;
+        std::shared_ptr<Hierarchy> hierarchy(new Hierarchy());
+        hierarchy->ns_ = ns;
+        hierarchy->node_num_ = n;
+        hierarchy->nodes_.assign(ns, -1);
+        hierarchy->cells_.resize(n);
+        hierarchy->offsets_.assign(n + 1, 0);
+        for (int r = 0; r < n; r++) {
+            int v = order[r];
+            hierarchy->cells_[r] = free_cells[v];
+            hierarchy->nodes_[free_cells[v]] = r;
+            for (const Arc& a : up[v])
+                hierarchy->edges_.push_back(Edge{ rank[a.to], a.mid < 0 ? -1 : rank[a.mid], a.weight });
+            hierarchy->offsets_[r + 1] = (int)hierarchy->edges_.size();
+        }
+        hierarchy->node_ = hierarchy->nodes_.data();
+        hierarchy->cell_ = hierarchy->cells_.data();
+        hierarchy->offset_ = hierarchy->offsets_.data();
+        hierarchy->edge_ = hierarchy->edges_.data();
+        return hierarchy;
+    }
+
+    /**
+     * @brief  map a stored hierarchy
+     * @param  store    precomputation store
+     * @param  key      key of the layout
+     * @param  ns       total pixel number the hierarchy must have
+     * @return hierarchy, nullptr if none is stored
+     */
+    std::shared_ptr<Hierarchy> Hierarchy::load(const global_planner::PrecomputeStore& store, uint64_t key, int ns) {
+        std::shared_ptr<Hierarchy> hierarchy(new Hierarchy());
+        if (!store.load("contraction_hierarchy", key, kVersion, hierarchy->mapping_))
+            return nullptr;
+        size_t node_num, cell_num, offset_num, edge_num;
+        const global_planner::PrecomputeMapping& mapping = hierarchy->mapping_;
+        if (!mapping.section("node", hierarchy->node_, node_num) || !mapping.section("cell", hierarchy->cell_, cell_num) ||
+            !mapping.section("offset", hierarchy->offset_, offset_num) ||
+            !mapping.section("edge", hierarchy->edge_, edge_num) || node_num != (size_t)ns ||
+            offset_num != cell_num + 1 || (size_t)hierarchy->offset_[cell_num] != edge_num)
+            return nullptr;
+        hierarchy->ns_ = ns;
+        hierarchy->node_num_ = (int)cell_num;
+        return hierarchy;
+    }
+
+    /**
+     * @brief  store the hierarchy
+     * @param  store    precomputation store
+     * @param  key      key of the layout
+     * @return true if it was written
+     */
+    bool Hierarchy::save(const global_planner::PrecomputeStore& store, uint64_t key) const {
+        global_planner::PrecomputeWriter writer;
+        writer.addSection("node", this->node_, this->ns_ * sizeof(int));
+        writer.addSection("cell", this->cell_, this->node_num_ * sizeof(int));
+        writer.addSection("offset", this->offset_, (this->node_num_ + 1) * sizeof(int));
+        writer.addSection("edge", this->edge_, this->edgeNum() * sizeof(Edge));
+        return store.save("contraction_hierarchy", key, kVersion, writer);
+    }
+
+    /**
+     * @brief  Constructor
+     * @param  directory    precomputation store directory, empty to keep the hierarchy in memory only
+     * @param  threads      contraction threads, 0 for one per core
+     * @param  capacity     layouts kept in memory and in the store, the least recently used is dropped
+     */
+    HierarchyCache::HierarchyCache(const std::string& directory, int threads, size_t capacity)
+        : PrecomputeCache<Hierarchy>("contraction_hierarchy", directory, capacity,
+              [threads](const std::vector<char>& blocked, int nx, int ny, const global_planner::PrecomputeStore&,
+                        uint64_t, const std::atomic<bool>* cancel) {
+                  return Hierarchy::build(blocked, nx, ny, threads, cancel);
+              }) {}
+
+    /**
+     * @brief  Constructor
+     * @param   nx          pixel number in costmap x direction
+     * @param   ny          pixel number in costmap y direction
+     * @param   resolution  costmap resolution
+     * @param   cache       hierarchy cache shared with other planners, nullptr for a private one
+     */
+    ContractionHierarchy::ContractionHierarchy(int nx, int ny, double resolution, std::shared_ptr<HierarchyCache> cache)
+        : GlobalPlanner(nx, ny, resolution), cache_(cache ? cache : std::make_shared<HierarchyCache>()),
+          fallback_(nx, ny, resolution), query_(0) {}
+
+    /**
+     * @brief Contraction hierarchy search implementation
+     * @param costs     costmap
+     * @param start     start node
+     * @param goal      goal node
+     * @param expand    containing the node been search during the process
+     * @return tuple contatining a bool as to whether a path was found, and the path
+     */
+    std::tuple<bool, std::vector<Node>> ContractionHierarchy::plan(const unsigned char* costs, const Node& start,
+                                                                   const Node& goal, std::vector<Node> &expand) {
+        TRACE_SCOPE("ContractionHierarchy::plan");
+        double cost;
+        int meet;
+        expand.clear();
+        expand.push_back(start);
+        // the paths are shortest in the layout of the hierarchy only, where the start cleared by the caller
+        // may be an obstacle
+        int s = -1, t = -1;
+        if (this->_take(costs)) {
+            s = this->hierarchy_->node(this->grid2Index(start.x, start.y));
+            t = this->hierarchy_->node(this->grid2Index(goal.x, goal.y));
+        }
+        if (s >= 0 && t >= 0) {
+            const Hierarchy& h = *this->hierarchy_;
+            if (!this->_query(s, t, cost, meet, &expand))
+                return {false, {}};
+
+            // up from the start, then down to the goal
+            std::vector<int> chain, cells{ h.cell(s) };
+            for (int v = meet; v != s; v = this->parent_[0][v])
+                chain.push_back(v);
+            for (int i = (int)chain.size() - 1, a = s; i >= 0; a = chain[i--])
+                this->_unpack(a, chain[i], this->parent_mid_[0][chain[i]], cells);
+            for (int v = meet; v != t; v = this->parent_[1][v])
+                this->_unpack(v, this->parent_[1][v], this->parent_mid_[1][v], cells);
+
+            std::vector<Node> path;
+            double g = 0.0;
+            for (size_t i = 0; i < cells.size(); i++) {
+                int x = cells[i] % this->nx_, y = cells[i] / this->nx_;
+                if (i)
+                    g += std::hypot(x - cells[i - 1] % this->nx_, y - cells[i - 1] / this->nx_);
+                path.push_back(Node(x, y, g, 0, cells[i], cells[i ? i - 1 : 0]));
+            }
+            std::reverse(path.begin(), path.end());
+            return {true, path};
+        }
+        this->fallback_.setCancelFlag(this->cancel_);
+        return this->fallback_.plan(costs, start, goal, expand);
+    }
+
+    /**
+     * @brief  shortest path cost, without unpacking the path
+     * @param  costs    costmap, the hierarchy is taken as by plan() and A* searches what it can not answer
+     * @param  start    start node
+     * @param  goal     goal node
+     * @param  cost     path cost in cells
+     * @return true if the goal is reachable
+     */
+    bool ContractionHierarchy::distance(const unsigned char* costs, const Node& start, const Node& goal, double& cost) {
+        if (this->_take(costs)) {
+            int s = this->hierarchy_->node(this->grid2Index(start.x, start.y));
+            int t = this->hierarchy_->node(this->grid2Index(goal.x, goal.y));
+            int meet;
+            if (s >= 0 && t >= 0)
+                return this->_query(s, t, cost, meet, nullptr);
+        }
+        std::vector<Node> expand;
+        this->fallback_.setCancelFlag(this->cancel_);
+        auto result = this->fallback_.plan(costs, start, goal, expand);
+        if (!std::get<0>(result))
+            return false;
+        const std::vector<Node>& path = std::get<1>(result);
+        cost = 0.0;
+        for (size_t i = 1; i < path.size(); i++)
+            cost += std::hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+        return true;
+    }
+
+    /**
+     * @brief  set or reset obstacle factor, the hierarchy is taken again by the next search
+     * @param factor obstacle factor
+     */
+    void ContractionHierarchy::setFactor(double factor) {
+        GlobalPlanner::setFactor(factor);
+        this->fallback_.setFactor(factor);
+        this->layout_.reset();
+    }
+
+    /**
+     * @brief  take the hierarchy of the costmap layout once it is published, and size the search state to it
+     * @param  costs    costmap
+     * @return true if the hierarchy is of the costmap layout
+     */
+    bool ContractionHierarchy::_take(const unsigned char* costs) {
+        if (!this->layout_.update(*this->cache_, costs, this->nx_, this->ny_, this->lethal_cost_ * this->factor_,
+                                  this->cleared_cell_, this->cleared_cost_))
+            return false;
+        if (this->hierarchy_ == this->layout_.held())
+            return true;
+        this->hierarchy_ = this->layout_.held();
+        int n = this->hierarchy_->nodeNum();
+        for (int d = 0; d < 2; d++) {
+            this->dist_[d].assign(n, 0.0);
+            this->parent_[d].assign(n, -1);
+            this->parent_mid_[d].assign(n, -1);
+            this->stamp_[d].assign(n, 0);
+        }
+        this->query_ = 0;
+        return true;
+    }
+
+    /**
+     * @brief  bidirectional upward search
+     * @param  s        start node
+     * @param  t        goal node
+     * @param  cost     path cost
+     * @param  meet     highest node of the path
+     * @param  expand   settled nodes are appended if not nullptr
+     * @return true if a path was found
+     */
+    bool ContractionHierarchy::_query(int s, int t, double& cost, int& meet, std::vector<Node>* expand) {
+        const Hierarchy& h = *this->hierarchy_;
+        if (++this->query_ == 0) {
+            // stamps wrapped around
+            for (int d = 0; d < 2; d++)
+                std::fill(this->stamp_[d].begin(), this->stamp_[d].end(), 0);
+            this->query_ = 1;
+        }
+
+        global_planner::PlanArena::Scope arena(this->arena_);
+        typedef std::pair<double, int> Item;
+        typedef std::priority_queue<Item, std::pmr::vector<Item>, std::greater<Item>> Queue;
+        Queue queue[2] = { Queue(std::greater<Item>(), std::pmr::vector<Item>(this->arena_.resource())),
+                           Queue(std::greater<Item>(), std::pmr::vector<Item>(this->arena_.resource())) };
+        int source[2] = { s, t };
+        for (int d = 0; d < 2; d++) {
+            this->dist_[d][source[d]] = 0.0;
+            this->parent_[d][source[d]] = -1;
+            this->stamp_[d][source[d]] = this->query_;
+            queue[d].push({ 0.0, source[d] });
+        }
+
+        double best = kInf;
+        meet = -1;
+        while (!queue[0].empty() || !queue[1].empty()) {
+            // the direction with the lower key, both are done once their keys reach the best path
+            int d = queue[1].empty() || (!queue[0].empty() && queue[0].top().first <= queue[1].top().first) ? 0 : 1;
+            Item item = queue[d].top();
+            if (item.first >= best || this->_isCanceled())
+                break;
+            queue[d].pop();
+            int u = item.second;
+            if (item.first > this->dist_[d][u])
+                continue;
+            if (expand) {
+                int c = h.cell(u);
+                expand->push_back(Node(c % this->nx_, c / this->nx_, item.first, 0, c, c));
+            }
+            if (this->stamp_[1 - d][u] == this->query_ && item.first + this->dist_[1 - d][u] < best) {
+                best = item.first + this->dist_[1 - d][u];
+                meet = u;
+            }
+            // stall on demand, no shortest path continues from a node that a higher node reaches shorter
+            bool stalled = false;
+            for (const Hierarchy::Edge* e = h.begin(u); e != h.end(u) && !stalled; e++)
+                stalled = this->stamp_[d][e->to] == this->query_ && this->dist_[d][e->to] + e->weight < item.first;
+            if (stalled)
+                continue;
+            for (const Hierarchy::Edge* e = h.begin(u); e != h.end(u); e++) {
+                double g = item.first + e->weight;
+                if (this->stamp_[d][e->to] == this->query_ && g >= this->dist_[d][e->to])
+                    continue;
+                this->stamp_[d][e->to] = this->query_;
+                this->dist_[d][e->to] = g;
+                this->parent_[d][e->to] = u;
+                this->parent_mid_[d][e->to] = e->mid;
+                queue[d].push({ g, e->to });
+            }
+        }
+        cost = best;
+        return meet >= 0 && !this->_isCanceled();
+    }
+
+    /**
+     * @brief  append the cells of an edge, without its first node
+     * @param  a        first node
+     * @param  b        last node
+     * @param  mid      node skipped by the edge, -1 for a move between two cells
+     * @param  cells    path cells
+     */
+    void ContractionHierarchy::_unpack(int a, int b, int mid, std::vector<int>& cells) const {
+        if (mid < 0) {
+            cells.push_back(this->hierarchy_->cell(b));
+            return;
+        }
+        // both halves are upward edges of the skipped node
+        int mid_a = -1, mid_b = -1;
+        for (const Hierarchy::Edge* e = this->hierarchy_->begin(mid); e != this->hierarchy_->end(mid); e++) {
+            if (e->to == a)
+                mid_a = e->mid;
+            else if (e->to == b)
+                mid_b = e->mid;
+        }
+        this->_unpack(a, mid, mid_a, cells);
+        this->_unpack(mid, b, mid_b, cells);
+    }
+}
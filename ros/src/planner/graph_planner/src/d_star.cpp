@@ -1,4 +1,8 @@
+#include <cmath>
+#include <cstring>
+
 #include "d_star.h"
+#include "trace.h"
 
 namespace d_star_planner
 {
@@ -62,7 +66,7 @@ namespace d_star_planner
                this->global_costmap[n2_id] > this->lethal_cost_ * this->factor_;
     }
 
-    void DStar::getNeighbours(DNodePtr nodePtr, std::vector<DNodePtr> &neighbours)
+    void DStar::getNeighbours(DNodePtr nodePtr, std::pmr::vector<DNodePtr> &neighbours)
     {
         int x = nodePtr->x, y = nodePtr->y;
         for (int i = -1; i <= 1; i++)
@@ -101,7 +105,11 @@ namespace d_star_planner
         this->open_list.erase(this->open_list.begin());
         x->tag = CLOSED;
 
-        std::vector<DNodePtr> neigbours;
+        // at most 8 neighbours, kept on the stack: the open list and nodes outlive a search, only these are per call
+        alignas(DNodePtr) unsigned char buffer[8 * sizeof(DNodePtr)];
+        std::pmr::monotonic_buffer_resource stack(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        std::pmr::vector<DNodePtr> neigbours(&stack);
+        neigbours.reserve(8);
         this->getNeighbours(x, neigbours);
 
         if (k_old < x->cost)
@@ -248,6 +256,7 @@ namespace d_star_planner
 
     std::tuple<bool, std::vector<Node>> DStar::plan(const unsigned char *costs, const Node &start, const Node &goal, std::vector<Node> &expand)
     {
+        TRACE_SCOPE("DStar::plan");
         // update costmap
         memcpy(this->global_costmap, costs, this->ns_);
 
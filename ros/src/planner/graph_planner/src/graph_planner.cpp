@@ -11,12 +11,24 @@
  * --------------------------------------------------------
  *
  **********************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <tuple>
+
 #include <pluginlib/class_list_macros.h>
 
 #include "graph_planner.h"
 #include "a_star.h"
 #include "jump_point_search.h"
 #include "d_star.h"
+#include "quadtree_planner.h"
+#include "subgoal_graph.h"
+#include "rrt.h"
+#include "rrt_star.h"
+#include "rrt_connect.h"
+#include "informed_rrt.h"
 
 PLUGINLIB_EXPORT_CLASS(graph_planner::GraphPlanner, nav_core::BaseGlobalPlanner)
 
@@ -25,7 +37,7 @@ namespace graph_planner {
      * @brief  Constructor(default)
      */
     GraphPlanner::GraphPlanner() :
-            costmap_(NULL), initialized_(false), g_planner_(NULL){ }
+            costmap_(NULL), initialized_(false), poi_busy_(false), poi_stop_(false){ }
     /**
      * @brief  Constructor
      * @param  name     planner name
@@ -42,10 +54,15 @@ namespace graph_planner {
      * @details default
      */
     GraphPlanner::~GraphPlanner() {
-        if (g_planner_)
-        {
-            delete g_planner_;
-            g_planner_ = NULL;
+        // workspaces are released by the pool, a running path library update is finished first
+        if (this->poi_thread_.joinable()) {
+            this->poi_timer_.stop();
+            {
+                std::lock_guard<std::mutex> guard(this->poi_lock_);
+                this->poi_stop_ = true;
+            }
+            this->poi_wake_.notify_one();
+            this->poi_thread_.join();
         }
     }
 
@@ -72,10 +89,6 @@ namespace graph_planner {
             this->costmap_ = costmap;
             // costmap frame ID
             this->frame_id_ = frame_id;
-            // costmap size
-            unsigned int nx = costmap->getSizeInCellsX(), ny = costmap->getSizeInCellsY();
-            // costmap resolution
-            double resolution = costmap->getResolution();
 
             /*======================= static parameters loading ==========================*/
             // offset of transform from world(x,y) to grid map(x,y)
@@ -88,23 +101,87 @@ namespace graph_planner {
             private_nh.param("obstacle_factor", this->factor_, 0.5);
             // whether publish expand zone or not
             private_nh.param("expand_zone", this->is_expand_, false);
+            // move_base planning and the make_plan service may plan at the same time
+            private_nh.param("max_concurrent_plans", this->max_concurrent_plans_, 2);
+            // path monitor, the last path is kept until it is blocked, left, too expensive or too old
+            double monitor_max_deviation, monitor_max_age, monitor_cost_ratio;
+            private_nh.param("monitor_path", this->is_monitor_, true);
+            private_nh.param("monitor_max_deviation", monitor_max_deviation, 0.5);
+            private_nh.param("monitor_max_age", monitor_max_age, 5.0);
+            private_nh.param("monitor_cost_ratio", monitor_cost_ratio, 1.5);
+            // a blocked path is first repaired in a window around the block
+            double repair_margin;
+            private_nh.param("repair_path", this->is_repair_, true);
+            private_nh.param("repair_margin", repair_margin, 1.0);
+            this->repair_margin_ = std::max(1, (int)std::ceil(repair_margin / costmap->getResolution()));
+            this->path_monitor_.setParams(LETHAL_COST * this->factor_,
+                                          (int)std::ceil(monitor_max_deviation / costmap->getResolution()),
+                                          monitor_max_age, monitor_cost_ratio);
 
+            // trace points (built with PLANNER_TRACING), dumped by the dump_trace service
+            bool tracing;
+            private_nh.param("tracing", tracing, false);
+            private_nh.param("trace_file", this->trace_file_, (std::string)"/tmp/planner_trace.json");
+            global_planner::Tracer::setEnabled(tracing);
             // planner name
             private_nh.param("planner_name", this->planner_name_, (std::string)"a_star");
-            if (this->planner_name_ == "a_star")
-                this->g_planner_ = new a_star_planner::AStar(nx, ny, resolution);
-            else if (this->planner_name_ == "dijkstra")
-                this->g_planner_ = new a_star_planner::AStar(nx, ny, resolution, true);
-            else if (this->planner_name_ == "gbfs")
-                this->g_planner_ = new a_star_planner::AStar(nx, ny, resolution, false, true); 
-            else if (this->planner_name_ == "jps")
-                this->g_planner_ = new jps_planner::JumpPointSearch(nx, ny, resolution);
-            else if (this->planner_name_ == "d_star")
-            {
-                // this->p_local_costmap_ = new nav_msgs::OccupancyGrid();
-                this->g_planner_ = new d_star_planner::DStar(nx, ny, resolution); // (, this->p_local_costmap_)
-                // this->local_costmap_sub_ = private_nh.subscribe("/move_base/local_costmap/costmap", 1, &GraphPlanner::localCostmapCallback, this);
+            // portfolio planner, races the backends and returns the first path within the bound
+            private_nh.param("portfolio_backends", this->portfolio_backends_,
+                             std::vector<std::string>{ "a_star", "gbfs", "jps" });
+            private_nh.param("portfolio_quality_bound", this->portfolio_bound_, 1.5);
+            // sampling backends of the portfolio, as the sample planner reads them
+            private_nh.param("sample_points", this->sample_points_, 500);
+            private_nh.param("sample_max_d", this->sample_max_d_, 5.0);
+            private_nh.param("optimization_r", this->opt_r_, 10.0);
+            if (this->planner_name_ == "portfolio")
+                this->portfolio_stats_ = std::make_shared<global_planner::PortfolioStatistics>();
+            // rectangular symmetry reduction of A*, dijkstra and gbfs, skipping the interiors of empty rectangles
+            private_nh.param("symmetry_reduction", this->symmetry_reduction_, false);
+            // dead-end and swamp pruning, the regions no shortest path needs are blocked unless start or goal is inside
+            bool swamp_pruning;
+            int swamp_sector;
+            private_nh.param("swamp_pruning", swamp_pruning, false);
+            private_nh.param("swamp_sector", swamp_sector, 8);
+            if (swamp_pruning && (this->planner_name_ == "a_star" || this->planner_name_ == "dijkstra" ||
+                                  this->planner_name_ == "gbfs" || this->planner_name_ == "jps"))
+                this->swamp_map_ = std::make_shared<global_planner::SwampMap>(swamp_sector);
+            // contraction hierarchy and compressed path database, kept in the precomputation store so that
+            // a restart maps them, empty to disable
+            private_nh.param("precompute_dir", this->precompute_dir_, (std::string)"");
+            int ch_threads, cpd_threads;
+            private_nh.param("ch_threads", ch_threads, 0);
+            private_nh.param("cpd_threads", cpd_threads, 0);
+            this->hierarchy_cache_ = std::make_shared<ch_planner::HierarchyCache>(this->precompute_dir_, ch_threads);
+            this->database_cache_ = std::make_shared<cpd_planner::DatabaseCache>(this->precompute_dir_, cpd_threads);
+            // points of interest, the path library between all pairs is updated periodically for the fleet scheduler
+            XmlRpc::XmlRpcValue pois;
+            double poi_update_period;
+            int poi_threads;
+            private_nh.param("poi_update_period", poi_update_period, 2.0);
+            private_nh.param("poi_threads", poi_threads, 0);
+            if (private_nh.getParam("pois", pois) && pois.getType() == XmlRpc::XmlRpcValue::TypeArray) {
+                for (int i = 0; i < pois.size(); i++) {
+                    XmlRpc::XmlRpcValue& poi = pois[i];
+                    if (poi.getType() != XmlRpc::XmlRpcValue::TypeStruct || !poi.hasMember("x") || !poi.hasMember("y")) {
+                        ROS_WARN("Point of interest %d has no x or y, skipped", i);
+                        continue;
+                    }
+                    geometry_msgs::Point p;
+                    p.x = poi["x"].getType() == XmlRpc::XmlRpcValue::TypeInt ? (int)poi["x"] : (double)poi["x"];
+                    p.y = poi["y"].getType() == XmlRpc::XmlRpcValue::TypeInt ? (int)poi["y"] : (double)poi["y"];
+                    this->poi_points_.push_back(p);
+                }
             }
+            if (!this->poi_points_.empty() && poi_update_period > 0)
+                this->poi_library_ = std::make_unique<poi_planner::PathLibrary>(poi_threads);
+            // append every search to a log that plan_replay feeds through the planners offline, empty to disable
+            std::string record_log;
+            private_nh.param("record_log", record_log, (std::string)"");
+            if (!record_log.empty() && !this->plan_log_.open(record_log))
+                ROS_WARN("Failed to open the planning request log %s", record_log.c_str());
+            // this->p_local_costmap_ = new nav_msgs::OccupancyGrid();
+            // this->local_costmap_sub_ = private_nh.subscribe("/move_base/local_costmap/costmap", 1, &GraphPlanner::localCostmapCallback, this);
+            this->_resetPlannerPool();
 
             ROS_INFO("Using global graph planner: %s", this->planner_name_.c_str());
 
@@ -115,6 +192,16 @@ namespace graph_planner {
             this->expand_pub_ = private_nh.advertise<nav_msgs::OccupancyGrid>("expand", 1);
             // register planning service
             this->make_plan_srv_ = private_nh.advertiseService("make_plan", &GraphPlanner::makePlanService, this);
+            // register trace dump service
+            this->dump_trace_srv_ = private_nh.advertiseService("dump_trace", &GraphPlanner::dumpTraceService, this);
+            // register points of interest cost matrix publisher, path service and update timer
+            if (this->poi_library_) {
+                this->poi_thread_ = std::thread(&GraphPlanner::_poiUpdateLoop, this);
+                this->poi_costs_pub_ = private_nh.advertise<std_msgs::Float64MultiArray>("poi_costs", 1, true);
+                this->poi_path_srv_ = private_nh.advertiseService("poi_path", &GraphPlanner::poiPathService, this);
+                this->poi_timer_ = private_nh.createTimer(ros::Duration(poi_update_period),
+                                                          &GraphPlanner::poiUpdateCallback, this);
+            }
 
             // set initialization flag
             this->initialized_ = true;
@@ -135,12 +222,25 @@ namespace graph_planner {
     }
     bool GraphPlanner::makePlan(const geometry_msgs::PoseStamped& start, const geometry_msgs::PoseStamped& goal, double tolerance,
                 std::vector<geometry_msgs::PoseStamped>& plan) {
-                    // start thread mutex
-        boost::mutex::scoped_lock lock(this->mutex_);
+        return this->_makePlan(start, goal, tolerance, plan, true);
+    }
+    /**
+     * @brief  plan a path given start and goal in world map
+     * @param  start        start in world map
+     * @param  goal         goal in world map
+     * @param  tolerance    error tolerance
+     * @param  plan         plan
+     * @param  monitored    whether the path is the monitored one of move_base, service queries for other
+     *                      starts and goals neither reuse nor replace it
+     * @return true if find a path successfully else false
+     */
+    bool GraphPlanner::_makePlan(const geometry_msgs::PoseStamped& start, const geometry_msgs::PoseStamped& goal,
+                                 double tolerance, std::vector<geometry_msgs::PoseStamped>& plan, bool monitored) {
         if (!this->initialized_) {
             ROS_ERROR("This planner has not been initialized yet, but it is being used, please call initialize() before use");
             return false;
         }
+        TRACE_SCOPE("GraphPlanner::makePlan");
         // clear existing plan
         plan.clear();
         // get costmap size
@@ -170,23 +270,81 @@ namespace graph_planner {
             ROS_WARN_THROTTLE(1.0, "The goal sent to the global planner is off the global costmap. Planning will always fail to this goal.");
             return false;
         }
+        // borrow a workspace, the search state is private to this call
+        global_planner::PlannerPool::Handle ws = this->planner_pool_.acquire();
+        if (!ws->planner) {
+            ROS_ERROR("Unknown global graph planner: %s", this->planner_name_.c_str());
+            return false;
+        }
+
         // tranform from costmap to grid map
         int g_start_x, g_start_y, g_goal_x, g_goal_y;
-        this->g_planner_->map2Grid(m_start_x, m_start_y, g_start_x, g_start_y);
-        this->g_planner_->map2Grid(m_goal_x, m_goal_y, g_goal_x, g_goal_y);
-        Node n_start(g_start_x, g_start_y, 0, 0, this->g_planner_->grid2Index(g_start_x, g_start_y), 0);
-        Node n_goal(g_goal_x, g_goal_y, 0, 0, this->g_planner_->grid2Index(g_goal_x, g_goal_y), 0);
-        
-        // clear the cost of robot location
-        this->costmap_->setCost(g_start_x, g_start_y, costmap_2d::FREE_SPACE);
-
-        // outline the map
-        if(this->is_outline_)
-            this->_outlineMap(this->costmap_->getCharMap(), nx, ny);
-
-        // calculate path
-        std::vector<Node> expand;
-        const auto [path_found, path] = this->g_planner_->plan(this->costmap_->getCharMap(), n_start, n_goal, expand);
+        ws->planner->map2Grid(m_start_x, m_start_y, g_start_x, g_start_y);
+        ws->planner->map2Grid(m_goal_x, m_goal_y, g_goal_x, g_goal_y);
+        Node n_start(g_start_x, g_start_y, 0, 0, ws->planner->grid2Index(g_start_x, g_start_y), 0);
+        Node n_goal(g_goal_x, g_goal_y, 0, 0, ws->planner->grid2Index(g_goal_x, g_goal_y), 0);
+
+        // snapshot the costmap, the only shared state. Its lock is held only for a flat copy, only tiles
+        // changed since the last snapshot are copied, and the search below runs while costmap updates continue.
+        global_planner::CostmapSnapshot snapshot;
+        {
+            TRACE_SCOPE("GraphPlanner::snapshot");
+            snapshot = this->costmap_tiles_.update(this->costmap_->getCharMap(), nx, ny,
+                                                   *(this->costmap_->getMutex()));
+        }
+
+        std::vector<Node> expand, path;
+        bool path_found = false;
+        double stamp = ros::Time::now().toSec();
+        // reuse the last path, trimmed to the robot, while the cells along it stay free
+        if (monitored && this->is_monitor_ && this->path_monitor_.check(snapshot, n_start, n_goal, stamp, path)) {
+            path_found = true;
+            ROS_DEBUG("Global path is still valid, search skipped");
+        } else if (monitored && this->is_monitor_ && this->is_repair_ &&
+                   this->path_monitor_.repair(snapshot, n_start, n_goal, stamp, this->repair_margin_,
+                       [&](const Node& entry, const Node& exit, int x0, int y0, int x1, int y1, std::vector<Node>& detour) {
+                           return this->_searchWindow(snapshot, entry, exit, x0, y0, x1, y1, detour);
+                       }, path)) {
+            path_found = true;
+            ROS_DEBUG("Global path repaired around the blocked stretch");
+        } else {
+            snapshot.copyTo(ws->costs, ws->tile_versions);
+
+            // clear the cost of robot location, in the workspace copy only
+            int start_cell = ws->planner->grid2Index(g_start_x, g_start_y);
+            ws->planner->setClearedCell(start_cell, ws->costs[start_cell]);
+            ws->costs[start_cell] = costmap_2d::FREE_SPACE;
+            snapshot.invalidate(ws->tile_versions, g_start_x, g_start_y);
+
+            // outline the map
+            if(this->is_outline_)
+                this->_outlineMap(ws->costs.data(), nx, ny);
+
+            // block the dead-ends and swamps, their tiles are restored by the next copy
+            if (this->swamp_map_) {
+                TRACE_SCOPE("GraphPlanner::pruneSwamps");
+                std::vector<int> swamp_cells;
+                this->swamp_map_->prune(ws->costs.data(), nx, ny, LETHAL_COST * this->factor_, n_start.id, n_goal.id,
+                                        swamp_cells);
+                for (int c : swamp_cells)
+                    snapshot.invalidate(ws->tile_versions, c % nx, c / nx);
+            }
+
+            // calculate path
+            auto t0 = std::chrono::steady_clock::now();
+            std::tie(path_found, path) = ws->planner->plan(ws->costs.data(), n_start, n_goal, expand);
+            if (this->plan_log_.isOpen())
+                this->_recordRequest(ws->costs.data(), nx, ny, n_start, n_goal, path_found, path, expand.size(),
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+            if (this->portfolio_stats_)
+                ROS_DEBUG_THROTTLE(10.0, "Portfolio statistics: %s", this->portfolio_stats_->summary().c_str());
+            if (monitored && this->is_monitor_) {
+                if (path_found)
+                    this->path_monitor_.update(path, snapshot, stamp);
+                else
+                    this->path_monitor_.reset();
+            }
+        }
 
         if (path_found) {
             if (this->_getPlanFromPath(path, plan)) {
@@ -210,6 +368,7 @@ namespace graph_planner {
      * @param  path planning path
      */
     void GraphPlanner::publishPlan(const std::vector<geometry_msgs::PoseStamped>& plan) {
+        TRACE_SCOPE("GraphPlanner::publishPlan");
         if (!this->initialized_) {
             ROS_ERROR("This planner has not been initialized yet, but it is being used, please call initialize() before use");
             return;
@@ -223,26 +382,158 @@ namespace graph_planner {
         // publish plan to rviz
         this->plan_pub_.publish(gui_plan);
     }
+    /**
+     * @brief  dump the trace events recorded since the last dump as Chrome trace JSON
+     * @param  req  request from client
+     * @param  resp response from server, with the trace file in the message
+     */
+    bool GraphPlanner::dumpTraceService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& resp) {
+        size_t events = 0;
+        resp.success = global_planner::Tracer::writeChromeTrace(this->trace_file_, events);
+        if (resp.success) {
+            global_planner::Tracer::clear();
+            resp.message = std::to_string(events) + " trace events written to " + this->trace_file_;
+        } else
+            resp.message = "Failed to write " + this->trace_file_;
+        return true;
+    }
     /**
      * @brief  regeister planning service
      * @param  req  request from client
      * @param  resp response from server
      */
     bool GraphPlanner::makePlanService(nav_msgs::GetPlan::Request& req, nav_msgs::GetPlan::Response& resp) {
+        // D* keeps its search state across calls, a service request starts from scratch
         if (this->planner_name_ == "d_star")
-        {
-            delete this->g_planner_;
-            // costmap size
-            unsigned int nx = this->costmap_->getSizeInCellsX(), ny = this->costmap_->getSizeInCellsY();
-            // costmap resolution
-            double resolution = this->costmap_->getResolution();
-            this->g_planner_ = new d_star_planner::DStar(nx, ny, resolution);  // (, this->p_local_costmap_)
-        }
-        makePlan(req.start, req.goal, resp.plan.poses);
+            this->planner_pool_.clear();
+        this->_makePlan(req.start, req.goal, this->tolerance_, resp.plan.poses, false);
         resp.plan.header.stamp = ros::Time::now();
         resp.plan.header.frame_id = this->frame_id_;
         return true;
     }
+    /**
+     * @brief  path between the points of interest nearest to start and goal, from the path library
+     * @param  req  request from client
+     * @param  resp response from server, empty plan if either end is not at a point of interest
+     */
+    bool GraphPlanner::poiPathService(nav_msgs::GetPlan::Request& req, nav_msgs::GetPlan::Response& resp) {
+        resp.plan.header.stamp = ros::Time::now();
+        resp.plan.header.frame_id = this->frame_id_;
+        if (!this->poi_library_)
+            return true;
+        // the nearest point of interest within the tolerance, at least a cell
+        double tolerance = std::max((double)req.tolerance, this->costmap_->getResolution());
+        auto nearest = [&](const geometry_msgs::PoseStamped& pose) {
+            int index = -1;
+            double best = tolerance;
+            for (size_t i = 0; i < this->poi_points_.size(); i++) {
+                double d = std::hypot(this->poi_points_[i].x - pose.pose.position.x,
+                                      this->poi_points_[i].y - pose.pose.position.y);
+                if (d <= best) {
+                    best = d;
+                    index = (int)i;
+                }
+            }
+            return index;
+        };
+        int from = nearest(req.start), to = nearest(req.goal);
+        std::vector<Node> path;
+        if (from < 0 || to < 0)
+            ROS_WARN("No point of interest within %.2f m of the requested start or goal", tolerance);
+        else if (this->poi_library_->size() && this->poi_library_->path(from, to, path))
+            this->_getPlanFromPath(path, resp.plan.poses);
+        return true;
+    }
+    /**
+     * @brief  hand a costmap snapshot to the path library update thread, unless an update is still running
+     * @param  event    timer event
+     */
+    void GraphPlanner::poiUpdateCallback(const ros::TimerEvent& event) {
+        {
+            std::lock_guard<std::mutex> guard(this->poi_lock_);
+            if (this->poi_busy_)
+                return;
+        }
+        int nx = this->costmap_->getSizeInCellsX(), ny = this->costmap_->getSizeInCellsY();
+        global_planner::CostmapSnapshot snapshot =
+            this->costmap_tiles_.update(this->costmap_->getCharMap(), nx, ny, *(this->costmap_->getMutex()));
+
+        // cells of the points of interest, which move with the costmap origin, points off the costmap are skipped
+        std::vector<Node> cells;
+        this->poi_off_map_.resize(this->poi_points_.size(), false);
+        for (size_t i = 0; i < this->poi_points_.size(); i++) {
+            const geometry_msgs::Point& p = this->poi_points_[i];
+            double mx, my;
+            bool off_map = !this->_worldToMap(p.x, p.y, mx, my);
+            if (off_map && !this->poi_off_map_[i])
+                ROS_WARN("Point of interest %zu at (%.2f, %.2f) is off the global costmap, its paths are skipped", i,
+                         p.x, p.y);
+            this->poi_off_map_[i] = off_map;
+            if (off_map)
+                cells.emplace_back(-1, -1, 0, 0, -1, 0);
+            else
+                cells.emplace_back((int)mx, (int)my, 0, 0, (int)my * nx + (int)mx, 0);
+        }
+        {
+            std::lock_guard<std::mutex> guard(this->poi_lock_);
+            this->poi_snapshot_ = std::move(snapshot);
+            this->poi_next_cells_ = std::move(cells);
+            this->poi_busy_ = true;
+        }
+        this->poi_wake_.notify_one();
+    }
+    /**
+     * @brief  path library update thread, brings the library up to date with each snapshot handed to it
+     *         and publishes the cost matrix
+     */
+    void GraphPlanner::_poiUpdateLoop() {
+        for (;;) {
+            global_planner::CostmapSnapshot snapshot;
+            std::vector<Node> cells;
+            {
+                std::unique_lock<std::mutex> guard(this->poi_lock_);
+                this->poi_wake_.wait(guard, [this] { return this->poi_stop_ || this->poi_busy_; });
+                if (this->poi_stop_)
+                    return;
+                snapshot = std::move(this->poi_snapshot_);
+                cells = std::move(this->poi_next_cells_);
+            }
+
+            TRACE_SCOPE("GraphPlanner::poiUpdate");
+            int nx = snapshot.nx(), ny = snapshot.ny();
+            snapshot.copyTo(this->poi_costs_, this->poi_tile_versions_);
+            if (this->is_outline_)
+                this->_outlineMap(this->poi_costs_.data(), nx, ny);
+            if (cells != this->poi_cells_) {
+                this->poi_cells_ = cells;
+                this->poi_library_->setPois(cells);
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            int searched = this->poi_library_->update(this->poi_costs_.data(), nx, ny, LETHAL_COST * this->factor_);
+            ROS_DEBUG("Path library: %d pairs searched in %.3f s, %zu bytes", searched,
+                      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count(),
+                      this->poi_library_->bytes());
+
+            // costs in meters, -1 for unreachable pairs and points off the costmap
+            int n = (int)this->poi_cells_.size();
+            std_msgs::Float64MultiArray msg;
+            msg.layout.dim.resize(2);
+            msg.layout.dim[0].label = "from";
+            msg.layout.dim[0].size = n;
+            msg.layout.dim[0].stride = n * n;
+            msg.layout.dim[1].label = "to";
+            msg.layout.dim[1].size = n;
+            msg.layout.dim[1].stride = n;
+            msg.data = this->poi_library_->matrix();
+            for (double& c : msg.data)
+                if (c > 0)
+                    c *= this->costmap_->getResolution();
+            this->poi_costs_pub_.publish(msg);
+
+            std::lock_guard<std::mutex> guard(this->poi_lock_);
+            this->poi_busy_ = false;
+        }
+    }
     /**
      * @brief  local costmap callback function
      * @param  costmap local costmap data
@@ -253,6 +544,170 @@ namespace graph_planner {
     // }
 
 
+    /**
+     * @brief  create a planner instance for a new workspace
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  resolution   costmap resolution
+     * @return planner, NULL if the planner name is unknown
+     */
+    global_planner::GlobalPlanner* GraphPlanner::_createPlanner(int nx, int ny, double resolution) {
+        global_planner::GlobalPlanner* planner = NULL;
+        if (this->planner_name_ == "portfolio") {
+            global_planner::PortfolioPlanner* portfolio = new global_planner::PortfolioPlanner(
+                nx, ny, resolution, this->portfolio_bound_, this->portfolio_stats_);
+            for (const std::string& name : this->portfolio_backends_) {
+                // D* keeps its search across calls and cannot be canceled halfway
+                global_planner::GlobalPlanner* backend = name == "d_star" ? NULL : this->_createBackend(name, nx, ny, resolution);
+                if (backend)
+                    portfolio->addBackend(name, backend);
+                else
+                    ROS_WARN("Global planner %s can not be used in the portfolio, skipped", name.c_str());
+            }
+            planner = portfolio;
+        }
+        else
+            planner = this->_createBackend(this->planner_name_, nx, ny, resolution);
+        // same obstacle threshold as the path monitor
+        if (planner)
+            planner->setFactor(this->factor_);
+        return planner;
+    }
+    /**
+     * @brief  create a single graph planner
+     * @param  name         planner name
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  resolution   costmap resolution
+     * @return planner, NULL if the planner name is unknown
+     */
+    global_planner::GlobalPlanner* GraphPlanner::_createBackend(const std::string& name, int nx, int ny, double resolution) {
+        if (name == "a_star")
+            return new a_star_planner::AStar(nx, ny, resolution, false, false, this->symmetry_reduction_);
+        else if (name == "dijkstra")
+            return new a_star_planner::AStar(nx, ny, resolution, true, false, this->symmetry_reduction_);
+        else if (name == "gbfs")
+            return new a_star_planner::AStar(nx, ny, resolution, false, true, this->symmetry_reduction_);
+        else if (name == "jps")
+            return new jps_planner::JumpPointSearch(nx, ny, resolution);
+        else if (name == "d_star")
+            return new d_star_planner::DStar(nx, ny, resolution);  // (, this->p_local_costmap_)
+        else if (name == "subgoal_graph")
+            return new subgoal_planner::SubgoalGraph(nx, ny, resolution);
+        else if (name == "contraction_hierarchy")
+            return new ch_planner::ContractionHierarchy(nx, ny, resolution, this->hierarchy_cache_);
+        else if (name == "cpd")
+            return new cpd_planner::CompressedPathDatabase(nx, ny, resolution, this->database_cache_);
+        else if (name == "quadtree")
+            return new quadtree_planner::QuadtreePlanner(nx, ny, resolution);
+        else if (name == "rrt")
+            return new rrt_planner::RRT(nx, ny, resolution, this->sample_points_, this->sample_max_d_);
+        else if (name == "rrt_star")
+            return new rrt_planner::RRTStar(nx, ny, resolution, this->sample_points_, this->sample_max_d_, this->opt_r_);
+        else if (name == "rrt_connect")
+            return new rrt_planner::RRTConnect(nx, ny, resolution, this->sample_points_, this->sample_max_d_);
+        else if (name == "informed_rrt")
+            return new rrt_planner::InformedRRT(nx, ny, resolution, this->sample_points_, this->sample_max_d_, this->opt_r_);
+        return NULL;
+    }
+    /**
+     * @brief  append a search to the request log
+     * @param  costs        costmap the planner searched
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  start        start node
+     * @param  goal         goal node
+     * @param  path_found   whether a path was found
+     * @param  path         path, goal first
+     * @param  expand_num   number of expanded nodes
+     * @param  plan_time    search time in seconds
+     */
+    void GraphPlanner::_recordRequest(const unsigned char* costs, int nx, int ny, const Node& start, const Node& goal, bool path_found,
+                                      const std::vector<Node>& path, size_t expand_num, double plan_time) {
+        global_planner::PlanRequest request;
+        request.planner = this->planner_name_;
+        if (this->planner_name_ == "portfolio") {
+            std::string backends;
+            for (const std::string& name : this->portfolio_backends_)
+                backends += (backends.empty() ? "" : ",") + name;
+            request.params.emplace_back("portfolio_backends", backends);
+            request.params.emplace_back("portfolio_quality_bound", std::to_string(this->portfolio_bound_));
+            request.params.emplace_back("sample_points", std::to_string(this->sample_points_));
+            request.params.emplace_back("sample_max_d", std::to_string(this->sample_max_d_));
+            request.params.emplace_back("optimization_r", std::to_string(this->opt_r_));
+        }
+        if (this->symmetry_reduction_)
+            request.params.emplace_back("symmetry_reduction", "1");
+        if (this->swamp_map_)
+            request.params.emplace_back("swamp_pruning", "1");
+        if (!this->precompute_dir_.empty())
+            request.params.emplace_back("precompute_dir", this->precompute_dir_);
+        request.stamp = ros::Time::now().toSec();
+        request.nx = nx;
+        request.ny = ny;
+        request.resolution = this->costmap_->getResolution();
+        request.factor = this->factor_;
+        request.start_x = start.x;
+        request.start_y = start.y;
+        request.goal_x = goal.x;
+        request.goal_y = goal.y;
+        request.found = path_found;
+        for (const Node& node : path)
+            request.path.emplace_back(node.x, node.y);
+        request.expand_num = expand_num;
+        request.plan_time = plan_time;
+        this->plan_log_.record(request, costs);
+    }
+    /**
+     * @brief  reset the workspace pool to the current costmap size
+     */
+    void GraphPlanner::_resetPlannerPool() {
+        int nx = this->costmap_->getSizeInCellsX(), ny = this->costmap_->getSizeInCellsY();
+        double resolution = this->costmap_->getResolution();
+        // D* repairs its previous search, so calls on it stay serialized
+        int capacity = this->planner_name_ == "d_star" ? 1 : this->max_concurrent_plans_;
+        this->planner_pool_.reset([this, nx, ny, resolution]() { return this->_createPlanner(nx, ny, resolution); },
+                                  capacity);
+    }
+    /**
+     * @brief  search between two cells inside a window of the costmap snapshot
+     * @param  snapshot costmap snapshot
+     * @param  entry    start cell of the detour
+     * @param  exit     end cell of the detour
+     * @param  x0       window lower x, inclusive
+     * @param  y0       window lower y, inclusive
+     * @param  x1       window upper x, inclusive
+     * @param  y1       window upper y, inclusive
+     * @param  detour   detour in costmap cells, exit first
+     * @return true if a detour was found
+     */
+    bool GraphPlanner::_searchWindow(const global_planner::CostmapSnapshot& snapshot, const Node& entry, const Node& exit,
+                                     int x0, int y0, int x1, int y1, std::vector<Node>& detour) {
+        int w = x1 - x0 + 1, h = y1 - y0 + 1;
+        // plain A*, the precomputing backends would build and cache a hierarchy or database of the window
+        std::unique_ptr<global_planner::GlobalPlanner> planner(
+            new a_star_planner::AStar(w, h, this->costmap_->getResolution()));
+        planner->setFactor(this->factor_);
+
+        // the window border is an obstacle, the backends index cells linearly and would wrap around rows
+        std::vector<unsigned char> costs(w * h);
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                costs[x + w * y] = snapshot.getCost(x0 + x, y0 + y);
+        this->_outlineMap(costs.data(), w, h);
+
+        Node n_entry(entry.x - x0, entry.y - y0, 0, 0, planner->grid2Index(entry.x - x0, entry.y - y0), 0);
+        Node n_exit(exit.x - x0, exit.y - y0, 0, 0, planner->grid2Index(exit.x - x0, exit.y - y0), 0);
+        costs[n_entry.id] = costmap_2d::FREE_SPACE;
+        costs[n_exit.id] = costmap_2d::FREE_SPACE;
+
+        std::vector<Node> expand;
+        const auto [found, path] = planner->plan(costs.data(), n_entry, n_exit, expand);
+        detour.clear();
+        for (const auto& node : path)
+            detour.emplace_back(node.x + x0, node.y + y0, node.cost, node.h_cost);
+        return found;
+    }
     /**
      * @brief  Inflate the boundary of costmap into obstacles to prevent cross planning
      * @param  costarr  costmap pointer
@@ -274,6 +729,7 @@ namespace graph_planner {
      * @param  expand  set of expand nodes
      */
     void GraphPlanner::_publishExpand(std::vector<Node> &expand){
+        TRACE_SCOPE("GraphPlanner::publishExpand");
         ROS_DEBUG("Expand Zone Size:%ld", expand.size());
         // 获得代价地图尺寸与分辨率
         int nx = this->costmap_->getSizeInCellsX(), ny = this->costmap_->getSizeInCellsY();
@@ -333,6 +789,7 @@ namespace graph_planner {
      * @return bool true if successful else false
      */
     bool GraphPlanner::_getPlanFromPath(std::vector<Node> path, std::vector<geometry_msgs::PoseStamped>& plan) {
+        TRACE_SCOPE("GraphPlanner::getPlanFromPath");
         if (!this->initialized_) {
             ROS_ERROR("This planner has not been initialized yet, but it is being used, please call initialize() before use");
             return false;
@@ -11,7 +11,10 @@
  * --------------------------------------------------------
  *
  **********************************************************/
+#include <cmath>
+
 #include "jump_point_search.h"
+#include "trace.h"
 
 namespace jps_planner {
     /**
@@ -32,16 +35,20 @@ namespace jps_planner {
      */
     std::tuple<bool, std::vector<Node>> JumpPointSearch::plan(const unsigned char* costs, const Node& start,
                                                 const Node& goal, std::vector<Node> &expand) {
+        TRACE_SCOPE("JumpPointSearch::plan");
         // copy
         this->costs_ = costs;
         this->start_ = start, this->goal_ = goal;
 
+        // search containers live in the arena until the end of the search
+        global_planner::PlanArena::Scope arena(this->arena_);
+
         // open list
-        std::priority_queue<Node, std::vector<Node>, compare_cost> open_list;
+        OpenList open_list(compare_cost(), std::pmr::vector<Node>(this->arena_.resource()));
         open_list.push(start);
 
         // closed list
-        std::unordered_set<Node, NodeIdAsHash, compare_coordinates> closed_list;
+        ClosedList closed_list(0, NodeIdAsHash(), compare_coordinates(), this->arena_.resource());
 
         // expand list
         expand.clear();
@@ -50,8 +57,12 @@ namespace jps_planner {
         // get all possible motions
         std::vector<Node> motions = getMotion();
 
+        // jump points of the current node, reused by every expansion
+        std::pmr::vector<Node> jp_list(this->arena_.resource());
+        jp_list.reserve(motions.size());
+
         // main loop
-        while (!open_list.empty()) {
+        while (!open_list.empty() && !this->_isCanceled()) {
             // pop current node from open list
             Node current = open_list.top();
             open_list.pop();
@@ -67,7 +78,7 @@ namespace jps_planner {
             }
 
             // explore neighbor of current node
-            std::vector<Node> jp_list;
+            jp_list.clear();
             for (const auto& motion : motions) {
                 Node jp = this->jump(current, motion);
 
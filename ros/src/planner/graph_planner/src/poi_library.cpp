@@ -0,0 +1,419 @@
+/***********************************************************
+ *
+ * @file: poi_library.cpp
+ * @breif: Contains the all-pairs path library between points of interest
+ * @author: Yang Haodong
+ * @update: 2023-2-28
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <thread>
+
+#include "poi_library.h"
+#include "trace.h"
+
+namespace poi_planner {
+namespace {
+// moves in the order of getMotion()
+const int kDx[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+const int kDy[8] = { 1, 0, -1, 0, 1, -1, 1, -1 };
+const double kCost[8] = { 1, 1, 1, 1, std::sqrt(2.0), std::sqrt(2.0), std::sqrt(2.0), std::sqrt(2.0) };
+// edge length in cells of the tiles the changed cells are grouped in
+const int kTile = 16;
+// sums of the same moves in another order may differ by rounding, such paths are as short
+const double kTolerance = 1e-9;
+
+/**
+ * @brief  octile distance of a cell to a rectangle, inclusive
+ */
+double octile(int x, int y, int x0, int y0, int x1, int y1) {
+    int dx = std::max({ x0 - x, x - x1, 0 }), dy = std::max({ y0 - y, y - y1, 0 });
+    return std::max(dx, dy) - std::min(dx, dy) + std::sqrt(2.0) * std::min(dx, dy);
+}
+
+/**
+ * @brief  run fn(i, worker) for every i in [0, n) on the worker threads
+ */
+void parallelFor(int n, int threads, const std::function<void(int, int)>& fn) {
+    std::atomic<int> next(0);
+    auto work = [&](int worker) {
+        for (int i = next++; i < n; i = next++)
+            fn(i, worker);
+    };
+    std::vector<std::thread> pool;
+    for (int w = 1; w < std::min(threads, n); w++)
+        pool.emplace_back(work, w);
+    work(0);
+    for (auto& t : pool)
+        t.join();
+}
+}
+
+    /**
+     * @brief  Constructor
+     * @param  threads  search threads, 0 for one per core
+     */
+    PathLibrary::PathLibrary(int threads)
+        : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())), nx_(0), ny_(0),
+          reset_(true), search_(this->threads_), field_(this->threads_) {}
+
+    /**
+     * @brief  set the points of interest, all pairs are searched by the next update
+     * @param  pois     cells of the points of interest, of id -1 for points off the costmap
+     */
+    void PathLibrary::setPois(const std::vector<Node>& pois) {
+        std::lock_guard<std::mutex> guard(this->lock_);
+        this->pois_ = pois;
+        this->routes_.assign(pois.size() * pois.size(), Route());
+        this->reset_ = true;
+    }
+
+    /**
+     * @brief  search the pairs the costmap changes since the last update may have changed
+     * @param  costs        costmap
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  threshold    cells of cost >= threshold are obstacles
+     * @return number of pairs searched
+     */
+    int PathLibrary::update(const unsigned char* costs, int nx, int ny, double threshold) {
+        TRACE_SCOPE("PathLibrary::update");
+        std::lock_guard<std::mutex> guard(this->lock_);
+        int ns = nx * ny, n = (int)this->pois_.size();
+        if (nx != this->nx_ || ny != this->ny_) {
+            this->nx_ = nx;
+            this->ny_ = ny;
+            this->blocked_.assign(ns, 1);
+            for (Search& s : this->search_) {
+                s.dist.assign(ns, 0);
+                s.move.assign(ns, -1);
+                s.visit.assign(ns, 0);
+                s.stamp = 0;
+            }
+            this->reset_ = true;
+        }
+
+        // tiles holding cells blocked or freed since, and the bounding boxes of the freed cells
+        int tx = (nx + kTile - 1) / kTile, ty = (ny + kTile - 1) / kTile;
+        std::vector<int> blocked_sum((tx + 1) * (ty + 1), 0);
+        std::vector<int> freed(tx * ty, 0), box(4 * tx * ty);
+        bool any_freed = false;
+        for (int i = 0; i < ns; i++) {
+            char blocked = costs[i] >= threshold;
+            if (blocked == this->blocked_[i])
+                continue;
+            this->blocked_[i] = blocked;
+            int x = i % nx, y = i / nx, t = (y / kTile) * tx + x / kTile;
+            if (blocked) {
+                blocked_sum[(y / kTile + 1) * (tx + 1) + x / kTile + 1] = 1;
+                continue;
+            }
+            any_freed = true;
+            if (!freed[t]++) {
+                box[4 * t] = box[4 * t + 2] = x;
+                box[4 * t + 1] = box[4 * t + 3] = y;
+            }
+            box[4 * t] = std::min(box[4 * t], x), box[4 * t + 2] = std::max(box[4 * t + 2], x);
+            box[4 * t + 1] = std::min(box[4 * t + 1], y), box[4 * t + 3] = std::max(box[4 * t + 3], y);
+        }
+        for (int y = 1; y <= ty; y++)
+            for (int x = 1; x <= tx; x++)
+                blocked_sum[y * (tx + 1) + x] += blocked_sum[(y - 1) * (tx + 1) + x] + blocked_sum[y * (tx + 1) + x - 1]
+                                                 - blocked_sum[(y - 1) * (tx + 1) + x - 1];
+        std::vector<int> freed_tiles;
+        for (int t = 0; t < tx * ty; t++)
+            if (freed[t])
+                freed_tiles.push_back(t);
+
+        // dirty pairs by their lower point of interest
+        std::vector<std::vector<int>> targets(n);
+        int dirty = 0;
+        for (int a = 0; a < n; a++) {
+            for (int b = a + 1; b < n; b++) {
+                // points off the costmap reach nothing
+                if (this->pois_[a].id < 0 || this->pois_[b].id < 0)
+                    continue;
+                const Route& r = this->_route(a, b);
+                bool search = this->reset_;
+                if (!search && r.cost < 0) {
+                    search = any_freed;
+                } else if (!search) {
+                    // a blocked cell on the path
+                    int x0 = r.x0 / kTile, y0 = r.y0 / kTile, x1 = r.x1 / kTile + 1, y1 = r.y1 / kTile + 1;
+                    if (blocked_sum[y1 * (tx + 1) + x1] - blocked_sum[y0 * (tx + 1) + x1] -
+                        blocked_sum[y1 * (tx + 1) + x0] + blocked_sum[y0 * (tx + 1) + x0] > 0) {
+                        int x = this->pois_[a].x, y = this->pois_[a].y;
+                        search = this->blocked_[y * nx + x];
+                        for (size_t i = 0; i < r.runs.size() && !search; i++) {
+                            for (int k = 0; k <= (r.runs[i] & 31) && !search; k++) {
+                                x += kDx[r.runs[i] >> 5], y += kDy[r.runs[i] >> 5];
+                                search = this->blocked_[y * nx + x];
+                            }
+                        }
+                    }
+                    // a freed cell the path could be shortened through
+                    const Node& pa = this->pois_[a];
+                    const Node& pb = this->pois_[b];
+                    for (size_t i = 0; i < freed_tiles.size() && !search; i++) {
+                        const int* f = &box[4 * freed_tiles[i]];
+                        search = octile(pa.x, pa.y, f[0], f[1], f[2], f[3]) + octile(pb.x, pb.y, f[0], f[1], f[2], f[3])
+                                 < r.cost - kTolerance;
+                    }
+                }
+                if (search) {
+                    targets[a].push_back(b);
+                    dirty++;
+                }
+            }
+        }
+        this->reset_ = false;
+
+        std::vector<int> sources;
+        for (int a = 0; a < n; a++)
+            if (!targets[a].empty())
+                sources.push_back(a);
+        if ((int)sources.size() < this->threads_) {
+            for (int a : sources)
+                this->_searchField(a, targets[a]);
+        } else
+            parallelFor((int)sources.size(), this->threads_,
+                        [&](int i, int worker) { this->_search(sources[i], targets[sources[i]], worker); });
+
+        // publish the finished library
+        std::shared_ptr<Table> table = std::make_shared<Table>();
+        table->pois = this->pois_;
+        table->routes = this->routes_;
+        table->nx = nx;
+        std::atomic_store(&this->table_, std::shared_ptr<const Table>(std::move(table)));
+        return dirty;
+    }
+
+    /**
+     * @brief  number of points of interest
+     */
+    int PathLibrary::size() const {
+        std::shared_ptr<const Table> table = std::atomic_load(&this->table_);
+        return table ? (int)table->pois.size() : 0;
+    }
+
+    /**
+     * @brief  path cost between two points of interest in cells
+     * @return cost, -1 if unreachable
+     */
+    double PathLibrary::cost(int from, int to) const {
+        std::shared_ptr<const Table> table = std::atomic_load(&this->table_);
+        if (!table || table->pois[from].id < 0 || table->pois[to].id < 0)
+            return -1;
+        if (from == to)
+            return 0;
+        return table->route(std::min(from, to), std::max(from, to)).cost;
+    }
+
+    /**
+     * @brief  row-major matrix of the path costs in cells, -1 for unreachable pairs
+     */
+    std::vector<double> PathLibrary::matrix() const {
+        std::shared_ptr<const Table> table = std::atomic_load(&this->table_);
+        int n = table ? (int)table->pois.size() : 0;
+        std::vector<double> costs(n * n, 0);
+        for (int a = 0; a < n; a++) {
+            if (table->pois[a].id < 0)
+                costs[a * n + a] = -1;
+            for (int b = a + 1; b < n; b++)
+                costs[a * n + b] = costs[b * n + a] = table->route(a, b).cost;
+        }
+        return costs;
+    }
+
+    /**
+     * @brief  path between two points of interest
+     * @param  from     start point of interest
+     * @param  to       goal point of interest
+     * @param  path     path cells, goal first as GlobalPlanner::plan()
+     * @return false if unreachable
+     */
+    bool PathLibrary::path(int from, int to, std::vector<Node>& path) const {
+        path.clear();
+        std::shared_ptr<const Table> table = std::atomic_load(&this->table_);
+        int a = std::min(from, to), b = std::max(from, to);
+        if (!table || a < 0 || b >= (int)table->pois.size() || table->pois[a].id < 0 || table->pois[b].id < 0 ||
+            (a != b && table->route(a, b).cost < 0))
+            return false;
+
+        // cells from the lower point of interest
+        std::vector<Node> cells{ table->pois[a] };
+        if (a != b) {
+            for (uint8_t run : table->route(a, b).runs) {
+                for (int k = 0; k <= (run & 31); k++) {
+                    const Node& c = cells.back();
+                    cells.emplace_back(c.x + kDx[run >> 5], c.y + kDy[run >> 5]);
+                }
+            }
+        }
+        if (from > to)
+            std::reverse(cells.begin(), cells.end());
+        for (size_t i = 0; i < cells.size(); i++) {
+            Node& c = cells[i];
+            c.id = c.y * table->nx + c.x;
+            c.pid = i ? cells[i - 1].id : c.id;
+            c.cost = i ? cells[i - 1].cost + std::hypot(c.x - cells[i - 1].x, c.y - cells[i - 1].y) : 0;
+        }
+        path.assign(cells.rbegin(), cells.rend());
+        return true;
+    }
+
+    /**
+     * @brief  bytes of the stored paths
+     */
+    size_t PathLibrary::bytes() const {
+        std::shared_ptr<const Table> table = std::atomic_load(&this->table_);
+        if (!table)
+            return 0;
+        size_t bytes = table->routes.size() * sizeof(Route);
+        for (const Route& r : table->routes)
+            bytes += r.runs.capacity();
+        return bytes;
+    }
+
+    /**
+     * @brief  search the dirty pairs of a source
+     * @param  source   point of interest
+     * @param  targets  points of interest above source to find
+     * @param  worker   worker index of the search state
+     */
+    void PathLibrary::_search(int source, const std::vector<int>& targets, int worker) {
+        Search& s = this->search_[worker];
+        unsigned int stamp = ++s.stamp;
+        if (!stamp) {
+            std::fill(s.visit.begin(), s.visit.end(), 0);
+            stamp = s.stamp = 1;
+        }
+        for (int b : targets)
+            this->_route(source, b) = Route();
+        const Node& p = this->pois_[source];
+        int start = p.y * this->nx_ + p.x;
+        if (this->blocked_[start])
+            return;
+
+        // targets still to settle, by cell
+        std::vector<int> cells;
+        for (int b : targets)
+            if (!this->blocked_[this->pois_[b].y * this->nx_ + this->pois_[b].x])
+                cells.push_back(this->pois_[b].y * this->nx_ + this->pois_[b].x);
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        size_t pending = cells.size();
+
+        std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>,
+                            std::greater<std::pair<double, int>>> heap;
+        s.visit[start] = stamp;
+        s.dist[start] = 0;
+        s.move[start] = -1;
+        heap.emplace(0, start);
+        while (!heap.empty() && pending) {
+            auto [d, u] = heap.top();
+            heap.pop();
+            if (d > s.dist[u])
+                continue;
+            if (std::binary_search(cells.begin(), cells.end(), u))
+                pending--;
+            int ux = u % this->nx_, uy = u / this->nx_;
+            for (int k = 0; k < 8; k++) {
+                int mx = ux + kDx[k], my = uy + kDy[k];
+                if (mx < 0 || mx >= this->nx_ || my < 0 || my >= this->ny_)
+                    continue;
+                int v = my * this->nx_ + mx;
+                double nd = d + kCost[k];
+                if (this->blocked_[v] || (s.visit[v] == stamp && nd >= s.dist[v]))
+                    continue;
+                s.visit[v] = stamp;
+                s.dist[v] = nd;
+                s.move[v] = (int8_t)k;
+                heap.emplace(nd, v);
+            }
+        }
+
+        // paths of the settled targets, as runs of moves from the source
+        std::vector<int> moves;
+        for (int b : targets) {
+            const Node& t = this->pois_[b];
+            int c = t.y * this->nx_ + t.x;
+            if (this->blocked_[c] || s.visit[c] != stamp)
+                continue;
+            Route& r = this->_route(source, b);
+            r.cost = s.dist[c];
+            moves.clear();
+            for (int k = s.move[c]; c != start; k = s.move[c]) {
+                moves.push_back(k);
+                c -= kDy[k] * this->nx_ + kDx[k];
+            }
+            std::reverse(moves.begin(), moves.end());
+            this->_encode(r, p, moves);
+        }
+    }
+
+    /**
+     * @brief  search the dirty pairs of a source by a whole-map distance field, all threads at once
+     * @param  source   point of interest
+     * @param  targets  points of interest above source to find
+     */
+    void PathLibrary::_searchField(int source, const std::vector<int>& targets) {
+        for (int b : targets)
+            this->_route(source, b) = Route();
+        const Node& p = this->pois_[source];
+        this->field_.compute(reinterpret_cast<const unsigned char*>(this->blocked_.data()), this->nx_, this->ny_, 1,
+                             { p.y * this->nx_ + p.x }, this->dist_);
+
+        // paths down the field from the targets, as moves from the source
+        std::vector<int> cells, moves;
+        for (int b : targets) {
+            const Node& t = this->pois_[b];
+            int c = t.y * this->nx_ + t.x;
+            if (!global_planner::DeltaStepping::descend(this->dist_, this->nx_, this->ny_, c, cells))
+                continue;
+            moves.clear();
+            for (size_t i = cells.size() - 1; i > 0; i--) {
+                int dx = cells[i - 1] % this->nx_ - cells[i] % this->nx_;
+                int dy = cells[i - 1] / this->nx_ - cells[i] / this->nx_, k = 0;
+                while (kDx[k] != dx || kDy[k] != dy)
+                    k++;
+                moves.push_back(k);
+            }
+            Route& r = this->_route(source, b);
+            r.cost = this->dist_[c];
+            this->_encode(r, p, moves);
+        }
+    }
+
+    /**
+     * @brief  store a path as runs of moves
+     * @param  route    route of the pair, its cost set
+     * @param  from     lower point of interest
+     * @param  moves    move indices from the lower point of interest
+     */
+    void PathLibrary::_encode(Route& route, const Node& from, const std::vector<int>& moves) const {
+        int x = route.x0 = route.x1 = from.x, y = route.y0 = route.y1 = from.y;
+        route.runs.clear();
+        for (int k : moves) {
+            x += kDx[k], y += kDy[k];
+            route.x0 = std::min(route.x0, x), route.x1 = std::max(route.x1, x);
+            route.y0 = std::min(route.y0, y), route.y1 = std::max(route.y1, y);
+            if (!route.runs.empty() && (route.runs.back() >> 5) == k && (route.runs.back() & 31) < 31)
+                route.runs.back()++;
+            else
+                route.runs.push_back((uint8_t)(k << 5));
+        }
+        route.runs.shrink_to_fit();
+    }
+}
@@ -0,0 +1,370 @@
+/***********************************************************
+ *
+ * @file: quadtree_planner.cpp
+ * @breif: Contains the quadtree free space decomposition planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-27
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "quadtree_planner.h"
+#include "trace.h"
+
+namespace quadtree_planner {
+    /**
+     * @brief  Constructor
+     * @param  nx       pixel number in costmap x direction
+     * @param  ny       pixel number in costmap y direction
+     */
+    Quadtree::Quadtree(int nx, int ny) : nx_(nx), ny_(ny), costs_(nullptr), threshold_(0) {
+        int size = 1;
+        while (size < nx || size < ny)
+            size *= 2;
+        // an occupied root, split by the first update
+        this->quads_.push_back(Quad{ 0, 0, size, -1, false, false, {} });
+    }
+
+    /**
+     * @brief  split and merge the leaves where the costmap changed
+     * @param  costs        costmap
+     * @param  threshold    cells of cost >= threshold are occupied
+     * @return number of leaves split, merged or changed
+     */
+    int Quadtree::update(const unsigned char* costs, double threshold) {
+        this->costs_ = costs;
+        this->threshold_ = threshold;
+        std::vector<int> changed, leaves;
+        this->_update(0, changed);
+
+        // the links of the leaves around a change are found again
+        for (int q : changed) {
+            const Quad& c = this->quads_[q];
+            leaves.clear();
+            this->_collect(0, c.x - 1, c.y - 1, c.x + c.size, c.y + c.size, leaves);
+            for (int l : leaves)
+                this->quads_[l].linked = false;
+        }
+        this->costs_ = nullptr;
+        return (int)changed.size();
+    }
+
+    /**
+     * @brief  leaf containing a cell
+     */
+    int Quadtree::leaf(int x, int y) const {
+        int q = 0;
+        while (this->quads_[q].child >= 0) {
+            const Quad& n = this->quads_[q];
+            int half = n.size / 2;
+            q = n.child + (x >= n.x + half) + 2 * (y >= n.y + half);
+        }
+        return q;
+    }
+
+    /**
+     * @brief  free leaves touching a free leaf
+     */
+    const std::vector<int>& Quadtree::links(int q) {
+        if (!this->quads_[q].linked) {
+            std::vector<int> leaves;
+            const Quad& n = this->quads_[q];
+            this->_collect(0, n.x - 1, n.y - 1, n.x + n.size, n.y + n.size, leaves);
+            Quad& m = this->quads_[q];
+            m.links.clear();
+            for (int l : leaves)
+                if (l != q && this->quads_[l].free)
+                    m.links.push_back(l);
+            m.linked = true;
+        }
+        return this->quads_[q].links;
+    }
+
+    /**
+     * @brief  number of leaves
+     */
+    size_t Quadtree::leafNum() const {
+        size_t num = 0;
+        std::vector<int> stack{ 0 };
+        while (!stack.empty()) {
+            int q = stack.back();
+            stack.pop_back();
+            if (this->quads_[q].child < 0)
+                num++;
+            else
+                for (int k = 0; k < 4; k++)
+                    stack.push_back(this->quads_[q].child + k);
+        }
+        return num;
+    }
+
+    /**
+     * @brief  bring a subtree up to date with the costmap
+     * @param  q        square
+     * @param  changed  squares that were split, merged or changed, appended
+     */
+    void Quadtree::_update(int q, std::vector<int>& changed) {
+        if (this->quads_[q].child < 0) {
+            const Quad n = this->quads_[q];
+            bool free;
+            if (this->_uniform(n.x, n.y, n.size, free)) {
+                if (free != n.free) {
+                    this->quads_[q].free = free;
+                    changed.push_back(q);
+                }
+                return;
+            }
+
+            // split a mixed leaf
+            int child;
+            if (this->free_blocks_.empty()) {
+                child = (int)this->quads_.size();
+                this->quads_.resize(child + 4);
+            } else {
+                child = this->free_blocks_.back();
+                this->free_blocks_.pop_back();
+            }
+            int half = n.size / 2;
+            for (int k = 0; k < 4; k++)
+                this->quads_[child + k] = Quad{ n.x + (k & 1) * half, n.y + (k >> 1) * half, half, -1, false, false, {} };
+            this->quads_[q].child = child;
+            this->quads_[q].linked = false;
+            this->quads_[q].links.clear();
+            changed.push_back(q);
+            for (int k = 0; k < 4; k++)
+                this->_update(child + k, changed);
+            return;
+        }
+
+        int child = this->quads_[q].child;
+        for (int k = 0; k < 4; k++)
+            this->_update(child + k, changed);
+
+        // merge uniform siblings
+        for (int k = 0; k < 4; k++)
+            if (this->quads_[child + k].child >= 0 || this->quads_[child + k].free != this->quads_[child].free)
+                return;
+        Quad& n = this->quads_[q];
+        n.free = this->quads_[child].free;
+        n.child = -1;
+        n.linked = false;
+        for (int k = 0; k < 4; k++)
+            this->quads_[child + k].links.clear();
+        this->free_blocks_.push_back(child);
+        changed.push_back(q);
+    }
+
+    /**
+     * @brief  whether a square is uniform
+     * @param  x, y, size   square
+     * @param  free         whether the uniform square is free
+     * @return true if all cells are free or all occupied
+     */
+    bool Quadtree::_uniform(int x, int y, int size, bool& free) const {
+        if (x >= this->nx_ || y >= this->ny_) {
+            free = false;
+            return true;
+        }
+        int x1 = std::min(x + size, this->nx_), y1 = std::min(y + size, this->ny_);
+        free = this->costs_[y * this->nx_ + x] < this->threshold_;
+        // the cells outside the costmap are occupied
+        if (free && (x1 < x + size || y1 < y + size))
+            return false;
+        for (int cy = y; cy < y1; cy++) {
+            const unsigned char* row = this->costs_ + cy * this->nx_;
+            for (int cx = x; cx < x1; cx++)
+                if ((row[cx] < this->threshold_) != free)
+                    return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief  leaves intersecting a rectangle, inclusive
+     */
+    void Quadtree::_collect(int q, int x0, int y0, int x1, int y1, std::vector<int>& leaves) const {
+        const Quad& n = this->quads_[q];
+        if (n.x > x1 || n.y > y1 || n.x + n.size <= x0 || n.y + n.size <= y0)
+            return;
+        if (n.child < 0) {
+            leaves.push_back(q);
+            return;
+        }
+        for (int k = 0; k < 4; k++)
+            this->_collect(n.child + k, x0, y0, x1, y1, leaves);
+    }
+
+    /**
+     * @brief  Constructor
+     * @param   nx          pixel number in costmap x direction
+     * @param   ny          pixel number in costmap y direction
+     * @param   resolution  costmap resolution
+     */
+    QuadtreePlanner::QuadtreePlanner(int nx, int ny, double resolution)
+        : GlobalPlanner(nx, ny, resolution), tree_(nx, ny) {}
+
+    /**
+     * @brief Quadtree planner implementation
+     * @param costs     costmap
+     * @param start     start node
+     * @param goal      goal node
+     * @param expand    containing the node been search during the process
+     * @return tuple contatining a bool as to whether a path was found, and the path
+     */
+    std::tuple<bool, std::vector<Node>> QuadtreePlanner::plan(const unsigned char* costs, const Node& start,
+                                                              const Node& goal, std::vector<Node> &expand) {
+        TRACE_SCOPE("QuadtreePlanner::plan");
+        expand.clear();
+        double threshold = this->lethal_cost_ * this->factor_;
+        {
+            TRACE_SCOPE("QuadtreePlanner::update");
+            this->tree_.update(costs, threshold);
+        }
+        auto inside = [&](const Node& n) {
+            return n.x >= 0 && n.x < this->nx_ && n.y >= 0 && n.y < this->ny_ &&
+                   costs[this->grid2Index(n.x, n.y)] < threshold;
+        };
+        if (!inside(start) || !inside(goal))
+            return { false, {} };
+
+        // search containers live in the arena until the end of the search
+        global_planner::PlanArena::Scope arena(this->arena_);
+        const double inf = std::numeric_limits<double>::max();
+        int from = this->tree_.leaf(start.x, start.y), to = this->tree_.leaf(goal.x, goal.y);
+        // a leaf is entered at its center, the leaves of start and goal at those cells
+        auto center = [&](int q, double& x, double& y) {
+            const Quadtree::Quad& n = this->tree_.get(q);
+            const Node& end = q == from ? start : goal;
+            if (q == from || q == to) {
+                x = end.x, y = end.y;
+            } else {
+                x = n.x + (n.size - 1) / 2.0, y = n.y + (n.size - 1) / 2.0;
+            }
+        };
+
+        // A* over the free leaves
+        std::pmr::vector<double> g(this->tree_.size(), inf, this->arena_.resource());
+        std::pmr::vector<int> parent(this->tree_.size(), -1, this->arena_.resource());
+        std::pmr::vector<char> closed(this->tree_.size(), 0, this->arena_.resource());
+        std::priority_queue<std::pair<double, int>, std::pmr::vector<std::pair<double, int>>,
+                            std::greater<std::pair<double, int>>>
+            open_list(std::greater<std::pair<double, int>>(),
+                      std::pmr::vector<std::pair<double, int>>(this->arena_.resource()));
+        g[from] = 0;
+        open_list.emplace(std::hypot(goal.x - start.x, goal.y - start.y), from);
+        while (!open_list.empty() && !this->_isCanceled()) {
+            int q = open_list.top().second;
+            open_list.pop();
+            if (closed[q])
+                continue;
+            closed[q] = 1;
+            // a leaf is expanded as its representative cell, with the cell of its parent leaf as parent
+            double qx, qy, px, py;
+            center(q, qx, qy);
+            center(parent[q] < 0 ? q : parent[q], px, py);
+            expand.emplace_back((int)qx, (int)qy, g[q], 0, this->grid2Index((int)qx, (int)qy),
+                                this->grid2Index((int)px, (int)py));
+            if (q == to)
+                break;
+            for (int l : this->tree_.links(q)) {
+                if (closed[l])
+                    continue;
+                double lx, ly;
+                center(l, lx, ly);
+                double cost = g[q] + std::hypot(lx - qx, ly - qy);
+                if (cost < g[l]) {
+                    g[l] = cost;
+                    parent[l] = q;
+                    open_list.emplace(cost + std::hypot(goal.x - lx, goal.y - ly), l);
+                }
+            }
+        }
+        if (!closed[to])
+            return { false, {} };
+
+        // waypoints from start to goal, a leaf is left from its cell nearest to the next one
+        std::vector<int> leaves;
+        for (int q = to; q >= 0; q = parent[q])
+            leaves.push_back(q);
+        std::reverse(leaves.begin(), leaves.end());
+        std::vector<Node> waypoints{ start };
+        for (size_t i = 0; i + 1 < leaves.size(); i++) {
+            const Quadtree::Quad& a = this->tree_.get(leaves[i]);
+            const Quadtree::Quad& b = this->tree_.get(leaves[i + 1]);
+            double bx, by;
+            center(leaves[i + 1], bx, by);
+            Node exit(std::clamp((int)std::lround(bx), a.x, a.x + a.size - 1),
+                      std::clamp((int)std::lround(by), a.y, a.y + a.size - 1));
+            Node entry(std::clamp(exit.x, b.x, b.x + b.size - 1), std::clamp(exit.y, b.y, b.y + b.size - 1));
+            waypoints.push_back(exit);
+            waypoints.push_back(entry);
+        }
+        waypoints.push_back(goal);
+
+        // a waypoint is skipped while the next one is in line of sight
+        std::vector<Node> cells{ start };
+        for (size_t anchor = 0; anchor + 1 < waypoints.size();) {
+            size_t next = anchor + 1;
+            while (next + 1 < waypoints.size() && this->_lineOfSight(costs, waypoints[anchor], waypoints[next + 1]))
+                next++;
+            this->_line(waypoints[anchor], waypoints[next], cells);
+            anchor = next;
+        }
+
+        // goal first, as the other planners
+        std::vector<Node> path;
+        for (size_t i = 0; i < cells.size(); i++) {
+            Node& c = cells[i];
+            c.id = this->grid2Index(c.x, c.y);
+            c.pid = i ? cells[i - 1].id : c.id;
+            c.cost = i ? cells[i - 1].cost + std::hypot(c.x - cells[i - 1].x, c.y - cells[i - 1].y) : 0;
+        }
+        path.assign(cells.rbegin(), cells.rend());
+        return { true, path };
+    }
+
+    /**
+     * @brief  whether every cell of the line between two cells is free
+     */
+    bool QuadtreePlanner::_lineOfSight(const unsigned char* costs, const Node& a, const Node& b) const {
+        std::vector<Node> cells;
+        this->_line(a, b, cells);
+        for (const Node& c : cells)
+            if (costs[c.y * this->nx_ + c.x] >= this->lethal_cost_ * this->factor_)
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief  cells of the line between two cells, 8-connected, without the first one
+     * @param  a        from cell
+     * @param  b        to cell
+     * @param  cells    line cells, appended
+     */
+    void QuadtreePlanner::_line(const Node& a, const Node& b, std::vector<Node>& cells) const {
+        int dx = std::abs(b.x - a.x), dy = std::abs(b.y - a.y);
+        int sx = a.x < b.x ? 1 : -1, sy = a.y < b.y ? 1 : -1;
+        int err = dx - dy, x = a.x, y = a.y;
+        while (x != b.x || y != b.y) {
+            int e2 = 2 * err;
+            if (e2 > -dy) {
+                err -= dy;
+                x += sx;
+            }
+            if (e2 < dx) {
+                err += dx;
+                y += sy;
+            }
+            cells.emplace_back(x, y);
+        }
+    }
+}
@@ -0,0 +1,208 @@
+/***********************************************************
+ *
+ * @file: rectangle_decomposition.cpp
+ * @breif: Contains the empty rectangle decomposition of rectangular symmetry reduction
+ * @author: Yang Haodong
+ * @update: 2023-2-25
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "rectangle_decomposition.h"
+
+namespace a_star_planner {
+    /**
+     * @brief  Constructor
+     * @param  nx       pixel number in costmap x direction
+     * @param  ny       pixel number in costmap y direction
+     */
+    RectangleDecomposition::RectangleDecomposition(int nx, int ny)
+        : nx_(nx), ny_(ny), built_(false), blocked_(nx * ny, 1), rect_id_(nx * ny, -1) {}
+
+    /**
+     * @brief  decompose a costmap, or redecompose the rectangles around the cells that changed
+     * @param  costs        costmap
+     * @param  threshold    cells of cost >= threshold are obstacles
+     * @return number of cells that changed, all cells on the first call
+     */
+    int RectangleDecomposition::update(const unsigned char* costs, double threshold) {
+        int ns = this->nx_ * this->ny_;
+        std::vector<int> cells;
+        if (!this->built_) {
+            this->built_ = true;
+            for (int i = 0; i < ns; i++)
+                this->blocked_[i] = costs[i] >= threshold;
+            cells.resize(ns);
+            for (int i = 0; i < ns; i++)
+                cells[i] = i;
+            this->_cover(cells);
+            return ns;
+        }
+
+        // a blocked cell splits its rectangle, a freed cell may join its neighbours
+        int changed = 0;
+        for (int i = 0; i < ns; i++) {
+            char blocked = costs[i] >= threshold;
+            if (blocked == this->blocked_[i])
+                continue;
+            changed++;
+            this->blocked_[i] = blocked;
+            if (blocked) {
+                if (this->rect_id_[i] >= 0)
+                    this->_remove(this->rect_id_[i], cells);
+                continue;
+            }
+            cells.push_back(i);
+            int x = i % this->nx_, y = i / this->nx_;
+            const int dx[4] = { 1, -1, 0, 0 }, dy[4] = { 0, 0, 1, -1 };
+            for (int k = 0; k < 4; k++) {
+                int mx = x + dx[k], my = y + dy[k];
+                if (mx >= 0 && mx < this->nx_ && my >= 0 && my < this->ny_ && this->rect_id_[my * this->nx_ + mx] >= 0)
+                    this->_remove(this->rect_id_[my * this->nx_ + mx], cells);
+            }
+        }
+        if (changed) {
+            std::sort(cells.begin(), cells.end());
+            cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+            this->_cover(cells);
+        }
+        return changed;
+    }
+
+    /**
+     * @brief  whether a cell is inside its rectangle, off the perimeter
+     */
+    bool RectangleDecomposition::interior(int cell) const {
+        if (this->rect_id_[cell] < 0)
+            return false;
+        const Rect& r = this->rects_[this->rect_id_[cell]];
+        int x = cell % this->nx_, y = cell / this->nx_;
+        return x > r.x0 && x < r.x1 && y > r.y0 && y < r.y1;
+    }
+
+    /**
+     * @brief  octile length of the straight line path between two cells
+     */
+    double RectangleDecomposition::distance(int a, int b) const {
+        int dx = std::abs(a % this->nx_ - b % this->nx_), dy = std::abs(a / this->nx_ - b / this->nx_);
+        return std::max(dx, dy) - std::min(dx, dy) + std::sqrt(2.0) * std::min(dx, dy);
+    }
+
+    /**
+     * @brief  macro edges of a perimeter cell across its rectangle, or of an interior cell to the perimeter
+     * @param  cell     cell index of a pruned rectangle
+     * @param  edges    target cell index and octile length, appended
+     */
+    void RectangleDecomposition::macroEdges(int cell, std::vector<std::pair<int, double>>& edges) const {
+        const Rect& r = this->rects_[this->rect_id_[cell]];
+        int x = cell % this->nx_, y = cell / this->nx_;
+        if (this->interior(cell)) {
+            for (int px = r.x0; px <= r.x1; px++)
+                for (int py : { r.y0, r.y1 })
+                    edges.emplace_back(py * this->nx_ + px, this->distance(cell, py * this->nx_ + px));
+            for (int py = r.y0 + 1; py < r.y1; py++)
+                for (int px : { r.x0, r.x1 })
+                    edges.emplace_back(py * this->nx_ + px, this->distance(cell, py * this->nx_ + px));
+            return;
+        }
+        // sides as the inward normal (nx, ny), the distance across and the range along the side
+        struct Side {
+            bool on;
+            int nx, ny, across, lo, hi, along;
+        };
+        const Side sides[4] = {
+            { x == r.x0, 1, 0, r.x1 - r.x0, r.y0, r.y1, y },
+            { x == r.x1, -1, 0, r.x1 - r.x0, r.y0, r.y1, y },
+            { y == r.y0, 0, 1, r.y1 - r.y0, r.x0, r.x1, x },
+            { y == r.y1, 0, -1, r.y1 - r.y0, r.x0, r.x1, x },
+        };
+        for (const Side& s : sides) {
+            if (!s.on)
+                continue;
+            int ox = x + s.nx * s.across, oy = y + s.ny * s.across;
+            // the opposite side within one diagonal move per row crossed
+            for (int a = std::max(s.lo, s.along - s.across); a <= std::min(s.hi, s.along + s.across); a++) {
+                int d = std::abs(a - s.along);
+                int tx = s.nx ? ox : a, ty = s.nx ? a : oy;
+                edges.emplace_back(ty * this->nx_ + tx, s.across - d + std::sqrt(2.0) * d);
+            }
+            // diagonals ending on an adjacent side
+            for (int t : { -1, 1 }) {
+                int k = t > 0 ? s.hi - s.along : s.along - s.lo;
+                if (k <= 0 || k >= s.across)
+                    continue;
+                int tx = x + s.nx * k + (s.nx ? 0 : t * k), ty = y + s.ny * k + (s.nx ? t * k : 0);
+                edges.emplace_back(ty * this->nx_ + tx, std::sqrt(2.0) * k);
+            }
+        }
+    }
+
+    /**
+     * @brief  cover the uncovered free cells among some cells with maximal rectangles, row-major
+     * @param  cells    cell indices
+     */
+    void RectangleDecomposition::_cover(std::vector<int>& cells) {
+        auto open = [&](int x, int y) {
+            int i = y * this->nx_ + x;
+            return !this->blocked_[i] && this->rect_id_[i] < 0;
+        };
+        for (int cell : cells) {
+            int x0 = cell % this->nx_, y0 = cell / this->nx_;
+            if (!open(x0, y0))
+                continue;
+
+            // grow as a square while possible, then along the side that still grows
+            int x1 = x0, y1 = y0;
+            bool grow_x = true, grow_y = true;
+            while (grow_x || grow_y) {
+                if (grow_x) {
+                    grow_x = x1 + 1 < this->nx_;
+                    for (int y = y0; y <= y1 && grow_x; y++)
+                        grow_x = open(x1 + 1, y);
+                    x1 += grow_x;
+                }
+                if (grow_y) {
+                    grow_y = y1 + 1 < this->ny_;
+                    for (int x = x0; x <= x1 && grow_y; x++)
+                        grow_y = open(x, y1 + 1);
+                    y1 += grow_y;
+                }
+            }
+
+            int id;
+            if (this->free_ids_.empty()) {
+                id = (int)this->rects_.size();
+                this->rects_.push_back(Rect{ x0, y0, x1, y1 });
+            }
+            else {
+                id = this->free_ids_.back();
+                this->free_ids_.pop_back();
+                this->rects_[id] = Rect{ x0, y0, x1, y1 };
+            }
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                    this->rect_id_[y * this->nx_ + x] = id;
+        }
+    }
+
+    /**
+     * @brief  remove a rectangle and append its cells
+     * @param  id       rectangle
+     * @param  cells    uncovered cell indices
+     */
+    void RectangleDecomposition::_remove(int id, std::vector<int>& cells) {
+        const Rect r = this->rects_[id];
+        for (int y = r.y0; y <= r.y1; y++)
+            for (int x = r.x0; x <= r.x1; x++) {
+                this->rect_id_[y * this->nx_ + x] = -1;
+                cells.push_back(y * this->nx_ + x);
+            }
+        this->free_ids_.push_back(id);
+    }
+}
@@ -0,0 +1,478 @@
+/***********************************************************
+ *
+ * @file: subgoal_graph.cpp
+ * @breif: Contains the simple subgoal graph planner class
+ * @author: Yang Haodong
+ * @update: 2023-2-22
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "subgoal_graph.h"
+#include "trace.h"
+
+namespace subgoal_planner {
+namespace {
+// moves, cardinal east, north, west, south then diagonal north-east, north-west, south-west, south-east
+const int kDx[8] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+const int kDy[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+
+/**
+ * @brief  index of the move (dx, dy), each in -1, 0, 1
+ */
+int direction(int dx, int dy) {
+    for (int d = 0; d < 8; d++)
+        if (kDx[d] == dx && kDy[d] == dy)
+            return d;
+    return -1;
+}
+
+int sign(int v) { return (v > 0) - (v < 0); }
+}
+
+    /**
+     * @brief  Constructor
+     * @param   nx          pixel number in costmap x direction
+     * @param   ny          pixel number in costmap y direction
+     * @param   resolution  costmap resolution
+     */
+    SubgoalGraph::SubgoalGraph(int nx, int ny, double resolution) : GlobalPlanner(nx, ny, resolution), built_(false) {}
+
+    /**
+     * @brief Subgoal graph search implementation
+     * @param costs     costmap
+     * @param start     start node
+     * @param goal      goal node
+     * @param expand    containing the subgoals been search during the process
+     * @return tuple contatining a bool as to whether a path was found, and the path
+     */
+    std::tuple<bool, std::vector<Node>> SubgoalGraph::plan(const unsigned char* costs, const Node& start,
+                                                           const Node& goal, std::vector<Node> &expand) {
+        TRACE_SCOPE("SubgoalGraph::plan");
+        this->_update(costs);
+
+        expand.clear();
+        expand.push_back(start);
+        int s = this->grid2Index(start.x, start.y), g = this->grid2Index(goal.x, goal.y);
+        if (!this->_free(start.x, start.y) || !this->_free(goal.x, goal.y))
+            return {false, {}};
+        if (s == g)
+            return {true, {start}};
+
+        // subgoal route from start to goal
+        std::vector<int> route;
+        Sweep from_start, to_goal;
+        this->_sweep(start.x, start.y, g, from_start);
+        if (std::find(from_start.reach.begin(), from_start.reach.end(), g) != from_start.reach.end())
+            route = { s, g };
+        else {
+            this->_sweep(goal.x, goal.y, s, to_goal);
+            if (std::find(to_goal.reach.begin(), to_goal.reach.end(), s) != to_goal.reach.end())
+                route = { s, g };
+        }
+
+        if (route.empty()) {
+            // search containers live in the arena until the end of the search
+            global_planner::PlanArena::Scope arena(this->arena_);
+            std::pmr::memory_resource* resource = this->arena_.resource();
+
+            // subgoal vertices, then start and goal
+            int m = (int)this->subgoals_.size(), v_start = m, v_goal = m + 1;
+            auto cell = [&](int v) { return v == v_start ? s : v == v_goal ? g : this->subgoals_[v]; };
+            std::pmr::vector<double> g_cost(m + 2, std::numeric_limits<double>::max(), resource);
+            std::pmr::vector<int> parent(m + 2, -1, resource);
+            std::pmr::vector<char> closed(m + 2, 0, resource);
+            // edges from the subgoals directly h-reachable from the goal
+            std::pmr::vector<double> goal_edge(m, -1.0, resource);
+            for (int t : to_goal.reach)
+                goal_edge[this->vertex_[t]] = this->_octile(t, g);
+
+            OpenList open_list(compare_cost(), std::pmr::vector<Node>(this->arena_.resource()));
+            g_cost[v_start] = 0.0;
+            open_list.push(Node(start.x, start.y, 0.0, this->_octile(s, g), v_start, -1));
+
+            bool found = false;
+            while (!open_list.empty() && !this->_isCanceled()) {
+                Node current = open_list.top();
+                open_list.pop();
+                int u = current.id;
+                if (closed[u])
+                    continue;
+                closed[u] = 1;
+
+                // goal found
+                if (u == v_goal) {
+                    found = true;
+                    break;
+                }
+                if (u != v_start)
+                    expand.push_back(Node(current.x, current.y, current.cost, current.h_cost, cell(u), cell(parent[u])));
+
+                auto relax = [&](int v, double w) {
+                    if (closed[v] || g_cost[u] + w >= g_cost[v])
+                        return;
+                    g_cost[v] = g_cost[u] + w;
+                    parent[v] = u;
+                    int c = cell(v);
+                    open_list.push(Node(c % this->nx_, c / this->nx_, g_cost[v], this->_octile(c, g), v, u));
+                };
+                if (u == v_start) {
+                    for (int t : from_start.reach)
+                        relax(this->vertex_[t], this->_octile(s, t));
+                } else {
+                    for (int e = this->offsets_[u]; e < this->offsets_[u + 1]; e++)
+                        relax(this->edges_[e], this->weights_[e]);
+                    if (goal_edge[u] >= 0.0)
+                        relax(v_goal, goal_edge[u]);
+                }
+            }
+            if (!found)
+                return {false, {}};
+            for (int v = v_goal; v != -1; v = parent[v])
+                route.push_back(cell(v));
+            std::reverse(route.begin(), route.end());
+        }
+
+        // refine the route into cells, every leg is an octile path from one of its ends
+        std::vector<int> cells{ s };
+        for (size_t i = 0; i + 1 < route.size(); i++) {
+            size_t size = cells.size();
+            if (this->_walk(route[i], route[i + 1], cells))
+                continue;
+            cells.resize(size);
+            std::vector<int> back;
+            if (!this->_walk(route[i + 1], route[i], back))
+                return {false, {}};
+            cells.insert(cells.end(), back.rbegin() + 1, back.rend());
+            cells.push_back(route[i + 1]);
+        }
+
+        std::vector<Node> path;
+        double cost = 0.0;
+        for (size_t i = 0; i < cells.size(); i++) {
+            if (i)
+                cost += this->_octile(cells[i - 1], cells[i]);
+            path.push_back(Node(cells[i] % this->nx_, cells[i] / this->nx_, cost, 0, cells[i], cells[i ? i - 1 : 0]));
+        }
+        std::reverse(path.begin(), path.end());
+        return {true, path};
+    }
+
+    /**
+     * @brief  set or reset obstacle factor, the graph is rebuilt by the next search
+     * @param factor obstacle factor
+     */
+    void SubgoalGraph::setFactor(double factor) {
+        GlobalPlanner::setFactor(factor);
+        this->built_ = false;
+    }
+
+    /**
+     * @brief  build the graph from a costmap, or rebuild the subgoals the changed cells affect
+     * @param  costs    costmap
+     */
+    void SubgoalGraph::_update(const unsigned char* costs) {
+        if (this->built_ && std::memcmp(costs, this->costs_.data(), this->ns_) == 0)
+            return;
+        TRACE_SCOPE("SubgoalGraph::update");
+        double threshold = this->lethal_cost_ * this->factor_;
+
+        if (!this->built_) {
+            this->costs_.assign(costs, costs + this->ns_);
+            this->blocked_.resize(this->ns_);
+            for (int i = 0; i < this->ns_; i++)
+                this->blocked_[i] = costs[i] >= threshold;
+            this->is_subgoal_.resize(this->ns_);
+            for (int y = 0; y < this->ny_; y++)
+                for (int x = 0; x < this->nx_; x++)
+                    this->is_subgoal_[y * this->nx_ + x] = this->_isSubgoal(x, y);
+            for (int d = 0; d < 4; d++) {
+                this->clearance_[d].resize(this->ns_);
+                for (int line = 0; line < (kDx[d] ? this->ny_ : this->nx_); line++)
+                    this->_computeClearance(d, line);
+            }
+            this->sweeps_.clear();
+            for (int i = 0; i < this->ns_; i++)
+                if (this->is_subgoal_[i])
+                    this->_sweep(i % this->nx_, i / this->nx_, -1, this->sweeps_[i]);
+            this->subgoals_.clear();
+            this->vertex_.assign(this->ns_, -1);
+            this->_buildCSR();
+            this->built_ = true;
+            return;
+        }
+
+        // cells that became free or blocked, and the cells around them whose subgoal status they decide
+        std::vector<char> dirty(this->ns_, 0), rows(this->ny_, 0), cols(this->nx_, 0);
+        std::vector<int> changed;
+        for (int i = 0; i < this->ns_; i++) {
+            if (costs[i] == this->costs_[i])
+                continue;
+            this->costs_[i] = costs[i];
+            char blocked = costs[i] >= threshold;
+            if (blocked != this->blocked_[i]) {
+                this->blocked_[i] = blocked;
+                changed.push_back(i);
+            }
+        }
+        if (changed.empty())
+            return;
+
+        for (int i : changed) {
+            int cx = i % this->nx_, cy = i / this->nx_;
+            for (int y = std::max(0, cy - 1); y <= std::min(this->ny_ - 1, cy + 1); y++)
+                for (int x = std::max(0, cx - 1); x <= std::min(this->nx_ - 1, cx + 1); x++) {
+                    int j = y * this->nx_ + x;
+                    dirty[j] = rows[y] = cols[x] = 1;
+                    char is_subgoal = this->_isSubgoal(x, y);
+                    if (is_subgoal == this->is_subgoal_[j])
+                        continue;
+                    this->is_subgoal_[j] = is_subgoal;
+                    // a new subgoal is swept below, its own cell is dirty
+                    if (is_subgoal)
+                        this->sweeps_[j] = Sweep{ {}, x, y, x, y };
+                    else
+                        this->sweeps_.erase(j);
+                }
+        }
+        for (int y = 0; y < this->ny_; y++)
+            if (rows[y]) {
+                this->_computeClearance(0, y);
+                this->_computeClearance(2, y);
+            }
+        for (int x = 0; x < this->nx_; x++)
+            if (cols[x]) {
+                this->_computeClearance(1, x);
+                this->_computeClearance(3, x);
+            }
+
+        // a sweep only changes if a cell it read changed, so only sweeps whose box holds a dirty cell are redone
+        int w = this->nx_ + 1;
+        std::vector<int> sum(w * (this->ny_ + 1), 0);
+        for (int y = 0; y < this->ny_; y++)
+            for (int x = 0; x < this->nx_; x++)
+                sum[(y + 1) * w + x + 1] = dirty[y * this->nx_ + x] + sum[y * w + x + 1] + sum[(y + 1) * w + x]
+                                           - sum[y * w + x];
+        for (auto& kv : this->sweeps_) {
+            Sweep& sweep = kv.second;
+            if (sum[(sweep.y1 + 1) * w + sweep.x1 + 1] - sum[sweep.y0 * w + sweep.x1 + 1]
+                - sum[(sweep.y1 + 1) * w + sweep.x0] + sum[sweep.y0 * w + sweep.x0] > 0)
+                this->_sweep(kv.first % this->nx_, kv.first / this->nx_, -1, sweep);
+        }
+        this->_buildCSR();
+    }
+
+    /**
+     * @brief  recompute the cardinal clearances of a row (east, west) or a column (north, south)
+     * @param  dir      cardinal direction
+     * @param  line     row y or column x
+     */
+    void SubgoalGraph::_computeClearance(int dir, int line) {
+        int len = kDx[dir] ? this->nx_ : this->ny_;
+        std::vector<int>& clearance = this->clearance_[dir];
+        // the next cell in the direction first
+        for (int k = len - 1; k >= 0; k--) {
+            int pos = kDx[dir] + kDy[dir] > 0 ? k : len - 1 - k;
+            int x = kDx[dir] ? pos : line, y = kDx[dir] ? line : pos;
+            int nx = x + kDx[dir], ny = y + kDy[dir];
+            int next = ny * this->nx_ + nx;
+            if (!this->_free(nx, ny))
+                clearance[y * this->nx_ + x] = 0;
+            else if (this->is_subgoal_[next])
+                clearance[y * this->nx_ + x] = 1;
+            else
+                clearance[y * this->nx_ + x] = 1 + clearance[next];
+        }
+    }
+
+    /**
+     * @brief  pack the sweeps into the CSR adjacency
+     */
+    void SubgoalGraph::_buildCSR() {
+        // vertices in cell order
+        for (int c : this->subgoals_)
+            this->vertex_[c] = -1;
+        this->subgoals_.clear();
+        for (const auto& kv : this->sweeps_)
+            this->subgoals_.push_back(kv.first);
+        std::sort(this->subgoals_.begin(), this->subgoals_.end());
+        for (size_t i = 0; i < this->subgoals_.size(); i++)
+            this->vertex_[this->subgoals_[i]] = (int)i;
+
+        // undirected edges, found from either end
+        std::vector<std::pair<int, int>> arcs;
+        for (const auto& kv : this->sweeps_)
+            for (int t : kv.second.reach) {
+                arcs.emplace_back(this->vertex_[kv.first], this->vertex_[t]);
+                arcs.emplace_back(this->vertex_[t], this->vertex_[kv.first]);
+            }
+        std::sort(arcs.begin(), arcs.end());
+        arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+
+        this->offsets_.assign(this->subgoals_.size() + 1, 0);
+        this->edges_.resize(arcs.size());
+        this->weights_.resize(arcs.size());
+        for (size_t e = 0; e < arcs.size(); e++) {
+            this->offsets_[arcs[e].first + 1]++;
+            this->edges_[e] = arcs[e].second;
+            this->weights_[e] = (float)this->_octile(this->subgoals_[arcs[e].first], this->subgoals_[arcs[e].second]);
+        }
+        for (size_t i = 0; i < this->subgoals_.size(); i++)
+            this->offsets_[i + 1] += this->offsets_[i];
+    }
+
+    /**
+     * @brief  find the directly h-reachable subgoals of a cell
+     * @param  x        cell x
+     * @param  y        cell y
+     * @param  target   cell index treated as a subgoal, -1 for none
+     * @param  sweep    reachable cells and the box of the cells read
+     */
+    void SubgoalGraph::_sweep(int x, int y, int target, Sweep& sweep) const {
+        sweep.reach.clear();
+        sweep.x0 = sweep.x1 = x;
+        sweep.y0 = sweep.y1 = y;
+        auto stop = [&](int cx, int cy) {
+            int i = cy * this->nx_ + cx;
+            return this->is_subgoal_[i] || i == target;
+        };
+
+        // subgoals straight ahead
+        int moves[8], limit[4];
+        for (int d = 0; d < 8; d++) {
+            moves[d] = this->_clearance(x, y, d, target, sweep);
+            bool hit = moves[d] > 0 && stop(x + moves[d] * kDx[d], y + moves[d] * kDy[d]);
+            if (hit)
+                sweep.reach.push_back((y + moves[d] * kDy[d]) * this->nx_ + x + moves[d] * kDx[d]);
+            if (d < 4)
+                limit[d] = hit ? moves[d] - 1 : moves[d];
+        }
+
+        // subgoals reached by diagonal then cardinal moves, every quadrant swept along its diagonal
+        for (int d = 4; d < 8; d++) {
+            int card[2] = { kDx[d] > 0 ? 0 : 2, kDy[d] > 0 ? 1 : 3 };
+            int max[2] = { limit[card[0]], limit[card[1]] };
+            int diag = moves[d];
+            if (diag > 0 && stop(x + diag * kDx[d], y + diag * kDy[d]))
+                diag--;
+            int cx = x, cy = y;
+            for (int i = 1; i <= diag; i++) {
+                cx += kDx[d];
+                cy += kDy[d];
+                for (int j = 0; j < 2; j++) {
+                    int c = card[j];
+                    int k = this->_clearance(cx, cy, c, target, sweep);
+                    if (k > 0 && k <= max[j] && stop(cx + k * kDx[c], cy + k * kDy[c])) {
+                        sweep.reach.push_back((cy + k * kDy[c]) * this->nx_ + cx + k * kDx[c]);
+                        k--;
+                    }
+                    max[j] = std::min(max[j], k);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief  number of moves from a cell in a direction until a subgoal or before an obstacle
+     * @param  x        cell x
+     * @param  y        cell y
+     * @param  dir      direction, cardinal 0-3, diagonal 4-7
+     * @param  target   cell index treated as a subgoal, -1 for none
+     * @param  sweep    the box of the cells read is extended
+     * @return number of moves
+     */
+    int SubgoalGraph::_clearance(int x, int y, int dir, int target, Sweep& sweep) const {
+        int k = 0;
+        if (dir < 4) {
+            k = this->clearance_[dir][y * this->nx_ + x];
+            // the target on the ray stops it like a subgoal
+            if (target >= 0) {
+                int tx = target % this->nx_, ty = target / this->nx_;
+                int t = kDx[dir] ? (tx - x) * kDx[dir] : (ty - y) * kDy[dir];
+                if ((kDx[dir] ? ty == y : tx == x) && t > 0 && t < k)
+                    k = t;
+            }
+        } else {
+            int cx = x, cy = y;
+            while (this->_canMove(cx, cy, dir)) {
+                cx += kDx[dir];
+                cy += kDy[dir];
+                k++;
+                int i = cy * this->nx_ + cx;
+                if (this->is_subgoal_[i] || i == target)
+                    break;
+            }
+        }
+        // the clearance depends on the cells up to one move past it
+        int ex = std::max(0, std::min(this->nx_ - 1, x + (k + 1) * kDx[dir]));
+        int ey = std::max(0, std::min(this->ny_ - 1, y + (k + 1) * kDy[dir]));
+        sweep.x0 = std::min(sweep.x0, ex);
+        sweep.x1 = std::max(sweep.x1, ex);
+        sweep.y0 = std::min(sweep.y0, ey);
+        sweep.y1 = std::max(sweep.y1, ey);
+        return k;
+    }
+
+    /**
+     * @brief  append the octile path from a to b, diagonal moves first, without a
+     * @param  a        from cell index
+     * @param  b        to cell index
+     * @param  cells    path cells
+     * @return false if the path is blocked
+     */
+    bool SubgoalGraph::_walk(int a, int b, std::vector<int>& cells) const {
+        int x = a % this->nx_, y = a / this->nx_, bx = b % this->nx_, by = b / this->nx_;
+        int dx = bx - x, dy = by - y;
+        int diag = std::min(std::abs(dx), std::abs(dy));
+        int d = direction(sign(dx), sign(dy)), c = direction(std::abs(dx) > diag ? sign(dx) : 0,
+                                                             std::abs(dy) > diag ? sign(dy) : 0);
+        for (int i = 0; i < std::max(std::abs(dx), std::abs(dy)); i++) {
+            int m = i < diag ? d : c;
+            if (!this->_canMove(x, y, m))
+                return false;
+            x += kDx[m];
+            y += kDy[m];
+            cells.push_back(y * this->nx_ + x);
+        }
+        return true;
+    }
+
+    /**
+     * @brief  whether a cell is a subgoal of the current costmap
+     */
+    bool SubgoalGraph::_isSubgoal(int x, int y) const {
+        if (!this->_free(x, y))
+            return false;
+        // a corner of an obstacle that a path turns around
+        for (int d = 4; d < 8; d++)
+            if (!this->_free(x + kDx[d], y + kDy[d]) && this->_free(x + kDx[d], y) && this->_free(x, y + kDy[d]))
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief  whether a move from a cell is valid, diagonal moves must not cut obstacle corners
+     */
+    bool SubgoalGraph::_canMove(int x, int y, int dir) const {
+        int tx = x + kDx[dir], ty = y + kDy[dir];
+        if (!this->_free(tx, ty))
+            return false;
+        return dir < 4 || (this->_free(tx, y) && this->_free(x, ty));
+    }
+
+    /**
+     * @brief  octile distance between two cells
+     */
+    double SubgoalGraph::_octile(int a, int b) const {
+        int dx = std::abs(a % this->nx_ - b % this->nx_), dy = std::abs(a / this->nx_ - b / this->nx_);
+        return std::max(dx, dy) + (std::sqrt(2.0) - 1.0) * std::min(dx, dy);
+    }
+}
@@ -54,6 +54,7 @@
 #include <base_local_planner/latched_stop_rotate_controller.h>
 
 #include <base_local_planner/odometry_helper_ros.h>
+#include <odom_cache.h>
 
 #include <dwa_planner/dwa.h>
 
@@ -153,6 +154,7 @@ namespace dwa_planner {
 
 
       base_local_planner::OdometryHelperRos odom_helper_;
+      local_planner::OdomCache odom_cache_; ///< @brief Lock-free odometry snapshot read every control cycle
       std::string odom_topic_;
   };
 };
@@ -35,6 +35,7 @@
 * Author: Eitan Marder-Eppstein
 *********************************************************************/
 #include <dwa_planner/dwa.h>
+#include "trace.h"
 #include <base_local_planner/goal_functions.h>
 #include <cmath>
 
@@ -240,6 +241,7 @@ namespace dwa_planner {
       const geometry_msgs::PoseStamped& global_pose,
       const std::vector<geometry_msgs::PoseStamped>& new_plan,
       const std::vector<geometry_msgs::Point>& footprint_spec) {
+    TRACE_SCOPE("DWA::updatePlanAndLocalCosts");
     global_plan_.resize(new_plan.size());
     for (unsigned int i = 0; i < new_plan.size(); ++i) {
       global_plan_[i] = new_plan[i];
@@ -294,6 +296,7 @@ namespace dwa_planner {
       const geometry_msgs::PoseStamped& global_pose,
       const geometry_msgs::PoseStamped& global_vel,
       geometry_msgs::PoseStamped& drive_velocities) {
+    TRACE_SCOPE("DWA::findBestPath");
 
     //make sure that our configuration doesn't change mid-run
     boost::mutex::scoped_lock l(configuration_mutex_);
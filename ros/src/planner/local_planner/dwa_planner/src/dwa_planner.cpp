@@ -36,6 +36,7 @@
 *********************************************************************/
 
 #include <dwa_planner/dwa_planner.h>
+#include "trace.h"
 #include <Eigen/Core>
 #include <cmath>
 
@@ -90,7 +91,7 @@ namespace dwa_planner {
   }
 
   DWAPlanner::DWAPlanner() : initialized_(false),
-      odom_helper_("odom"), setup_(false) {
+      odom_helper_("odom"), odom_cache_("odom"), setup_(false) {
 
   }
 
@@ -118,6 +119,7 @@ namespace dwa_planner {
       if( private_nh.getParam( "odom_topic", odom_topic_ ))
       {
         odom_helper_.setOdomTopic( odom_topic_ );
+        odom_cache_.setOdomTopic( odom_topic_ );
       }
       
       initialized_ = true;
@@ -187,7 +189,7 @@ namespace dwa_planner {
     }
 
     geometry_msgs::PoseStamped robot_vel;
-    odom_helper_.getRobotVel(robot_vel);
+    odom_cache_.getRobotVel(robot_vel);
 
     /* For timing uncomment
     struct timeval start, end;
@@ -256,6 +258,7 @@ namespace dwa_planner {
 
 
   bool DWAPlanner::computeVelocityCommands(geometry_msgs::Twist& cmd_vel) {
+    TRACE_SCOPE("DWAPlanner::computeVelocityCommands");
     // dispatches to either dwa sampling control or stop and rotate control, depending on whether we have been close enough to goal
     if ( ! costmap_ros_->getRobotPose(current_pose_)) {
       ROS_ERROR("Could not get robot pose");
@@ -0,0 +1,106 @@
+/***********************************************************
+ *
+ * @file: odom_cache.h
+ * @breif: Contains the lock-free latest-value odometry cache
+ * @author: Yang Haodong
+ * @update: 2023-2-6
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef ODOM_CACHE_H
+#define ODOM_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <string>
+
+#include <ros/ros.h>
+#include <nav_msgs/Odometry.h>
+#include <geometry_msgs/PoseStamped.h>
+
+namespace local_planner {
+/**
+ * @brief Robot state extracted from the latest odometry message
+ * @param x     robot x in odometry frame
+ * @param y     robot y in odometry frame
+ * @param theta robot yaw in odometry frame
+ * @param vx    linear velocity x in robot frame
+ * @param vy    linear velocity y in robot frame
+ * @param wz    angular velocity in robot frame
+ * @param stamp message stamp
+ */
+struct OdomState {
+    double x, y, theta;
+    double vx, vy, wz;
+    ros::Time stamp;
+};
+
+/**
+ * @brief Latest-value odometry cache. The subscriber callback is the single writer and
+ *        publishes every message through a sequence lock, so controllers read a consistent
+ *        snapshot without taking a mutex or copying a full nav_msgs::Odometry.
+ */
+class OdomCache {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  topic    odometry topic, nothing is subscribed if empty
+         */
+        OdomCache(const std::string& topic = "");
+        ~OdomCache() = default;
+
+        /**
+         * @brief  (re)subscribe to a odometry topic
+         * @param  topic    odometry topic
+         */
+        void setOdomTopic(const std::string& topic);
+        /**
+         * @brief  read the latest odometry snapshot, never blocks the writer
+         * @param  state    latest robot state
+         * @return true if at least one odometry message has been received
+         */
+        bool getState(OdomState& state) const;
+        /**
+         * @brief  age of the latest odometry message
+         * @return seconds between now and the message stamp, infinity if no message received
+         */
+        double getAge() const;
+        /**
+         * @brief  robot velocity encoded as OdometryHelperRos::getRobotVel() does,
+         *         i.e. (vx, vy) as position and wz as yaw in robot frame
+         * @param  robot_vel    robot velocity
+         */
+        void getRobotVel(geometry_msgs::PoseStamped& robot_vel) const;
+        /**
+         * @brief  frame of the odometry pose
+         * @return frame ID, empty if no message received
+         */
+        std::string getOdomFrame() const;
+
+    private:
+        /**
+         * @brief  odometry callback, the only writer of the cache
+         * @param  msg  odometry message
+         */
+        void _odomCallback(const nav_msgs::Odometry::ConstPtr& msg);
+
+        // slot index of each value in data_
+        enum Slot { X = 0, Y, THETA, VX, VY, WZ, STAMP, SLOT_NUM };
+
+        // sequence number, odd while the writer is updating data_
+        std::atomic<uint32_t> seq_;
+        // cached values
+        std::array<std::atomic<double>, SLOT_NUM> data_;
+        // odometry topic
+        std::string odom_topic_;
+        // odometry frame and robot frame of the odometry twist, written once before the first message is published
+        std::string frame_id_, child_frame_id_;
+        // odometry subscriber
+        ros::Subscriber odom_sub_;
+};
+}
+#endif  // ODOM_CACHE_H
@@ -0,0 +1,145 @@
+/***********************************************************
+ *
+ * @file: odom_cache.cpp
+ * @breif: Contains the lock-free latest-value odometry cache
+ * @author: Yang Haodong
+ * @update: 2023-2-6
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <limits>
+
+#include <tf2/utils.h>
+#include <tf2/LinearMath/Quaternion.h>
+
+#include "odom_cache.h"
+
+namespace local_planner {
+    /**
+     * @brief  Constructor
+     * @param  topic    odometry topic, nothing is subscribed if empty
+     */
+    OdomCache::OdomCache(const std::string& topic) : seq_(0) {
+        for (auto& d : this->data_)
+            d.store(0.0, std::memory_order_relaxed);
+        this->setOdomTopic(topic);
+    }
+
+    /**
+     * @brief  (re)subscribe to a odometry topic
+     * @param  topic    odometry topic
+     */
+    void OdomCache::setOdomTopic(const std::string& topic) {
+        if (topic == this->odom_topic_)
+            return;
+        this->odom_topic_ = topic;
+
+        if (!this->odom_topic_.empty()) {
+            ros::NodeHandle gn;
+            this->odom_sub_ = gn.subscribe(this->odom_topic_, 1, &OdomCache::_odomCallback, this);
+        } else
+            this->odom_sub_.shutdown();
+    }
+
+    /**
+     * @brief  read the latest odometry snapshot, never blocks the writer
+     * @param  state    latest robot state
+     * @return true if at least one odometry message has been received
+     */
+    bool OdomCache::getState(OdomState& state) const {
+        double values[SLOT_NUM];
+        uint32_t seq_begin, seq_end;
+        do {
+            seq_begin = this->seq_.load(std::memory_order_acquire);
+            for (int i = 0; i < SLOT_NUM; i++)
+                values[i] = this->data_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq_end = this->seq_.load(std::memory_order_relaxed);
+        } while ((seq_begin & 1) || seq_begin != seq_end);
+
+        state.x = values[X];
+        state.y = values[Y];
+        state.theta = values[THETA];
+        state.vx = values[VX];
+        state.vy = values[VY];
+        state.wz = values[WZ];
+        state.stamp = ros::Time(values[STAMP]);
+
+        return seq_begin != 0;
+    }
+
+    /**
+     * @brief  age of the latest odometry message
+     * @return seconds between now and the message stamp, infinity if no message received
+     */
+    double OdomCache::getAge() const {
+        OdomState state;
+        if (!this->getState(state))
+            return std::numeric_limits<double>::infinity();
+        return (ros::Time::now() - state.stamp).toSec();
+    }
+
+    /**
+     * @brief  robot velocity encoded as OdometryHelperRos::getRobotVel() does,
+     *         i.e. (vx, vy) as position and wz as yaw in robot frame
+     * @param  robot_vel    robot velocity
+     */
+    void OdomCache::getRobotVel(geometry_msgs::PoseStamped& robot_vel) const {
+        OdomState state;
+        bool received = this->getState(state);
+
+        tf2::Quaternion q;
+        q.setRPY(0, 0, state.wz);
+        robot_vel.header.frame_id = received ? this->child_frame_id_ : std::string();
+        robot_vel.header.stamp = ros::Time();
+        robot_vel.pose.position.x = state.vx;
+        robot_vel.pose.position.y = state.vy;
+        robot_vel.pose.position.z = 0.0;
+        robot_vel.pose.orientation.x = q[0];
+        robot_vel.pose.orientation.y = q[1];
+        robot_vel.pose.orientation.z = q[2];
+        robot_vel.pose.orientation.w = q[3];
+    }
+
+    /**
+     * @brief  frame of the odometry pose
+     * @return frame ID, empty if no message received
+     */
+    std::string OdomCache::getOdomFrame() const {
+        return this->seq_.load(std::memory_order_acquire) ? this->frame_id_ : std::string();
+    }
+
+    /**
+     * @brief  odometry callback, the only writer of the cache
+     * @param  msg  odometry message
+     */
+    void OdomCache::_odomCallback(const nav_msgs::Odometry::ConstPtr& msg) {
+        uint32_t seq = this->seq_.load(std::memory_order_relaxed);
+        // the frame never changes for a given topic, readers only touch it once seq_ != 0
+        if (seq == 0) {
+            this->frame_id_ = msg->header.frame_id;
+            this->child_frame_id_ = msg->child_frame_id;
+        }
+
+        ros::Time stamp = msg->header.stamp.isZero() ? ros::Time::now() : msg->header.stamp;
+
+        // odd sequence: update in progress
+        this->seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        this->data_[X].store(msg->pose.pose.position.x, std::memory_order_relaxed);
+        this->data_[Y].store(msg->pose.pose.position.y, std::memory_order_relaxed);
+        this->data_[THETA].store(tf2::getYaw(msg->pose.pose.orientation), std::memory_order_relaxed);
+        this->data_[VX].store(msg->twist.twist.linear.x, std::memory_order_relaxed);
+        this->data_[VY].store(msg->twist.twist.linear.y, std::memory_order_relaxed);
+        this->data_[WZ].store(msg->twist.twist.angular.z, std::memory_order_relaxed);
+        this->data_[STAMP].store(stamp.toSec(), std::memory_order_relaxed);
+
+        // even sequence: snapshot is consistent
+        this->seq_.store(seq + 2, std::memory_order_release);
+    }
+}
@@ -0,0 +1,192 @@
+/***********************************************************
+ *
+ * @file: mpc.h
+ * @breif: Contains the warm-started nonlinear MPC solver for unicycle model
+ * @author: Yang Haodong
+ * @update: 2023-2-8
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef MPC_H
+#define MPC_H
+
+#include <array>
+#include <vector>
+
+// prediction horizon (steps)
+#define MPC_HORIZON 20
+// maximum number of obstacle points considered by the solver
+#define MPC_MAX_OBSTACLES 64
+
+namespace mpc_planner {
+/**
+ * @brief Unicycle state
+ */
+struct MPCState {
+    double x, y, theta;
+};
+
+/**
+ * @brief MPC parameters
+ */
+struct MPCParams {
+    // discretization step
+    double dt = 0.1;
+    // control limits
+    double max_v = 0.26, min_v = 0.0, max_w = 1.82, min_w = -1.82;
+    // acceleration limits, only applied to the first control
+    double acc_lim_v = 2.5, acc_lim_w = 3.2;
+    // tracking weights
+    double w_pos = 1.0, w_theta = 0.2, w_terminal = 5.0;
+    // control smoothness weights
+    double w_dv = 0.5, w_dw = 0.05;
+    // obstacle distance constraint (penalty) weight and safety distance to obstacle points
+    double w_obs = 200.0, safe_dist = 0.25;
+    // solver iteration cap, convergence tolerance and wall-time budget (s)
+    int max_iter = 30;
+    double tolerance = 1e-4;
+    double time_budget = 0.01;
+};
+
+/**
+ * @brief Nonlinear MPC for a unicycle robot solved by single shooting with adjoint gradients and
+ *        projected gradient descent with Armijo backtracking. All storage is fixed-size, so solve()
+ *        never allocates, and the previous solution shifted by one step is used as the initial guess.
+ */
+class MPC {
+    public:
+        typedef std::array<MPCState, MPC_HORIZON + 1> Trajectory;
+        typedef std::array<double, MPC_HORIZON> Controls;
+
+        /**
+         * @brief  Constructor
+         * @param  params   MPC parameters
+         */
+        MPC(const MPCParams& params = MPCParams());
+        ~MPC() = default;
+
+        /**
+         * @brief  set or reset MPC parameters, drops the warm start
+         * @param  params   MPC parameters
+         */
+        void setParams(const MPCParams& params);
+        /**
+         * @brief  get MPC parameters
+         * @return MPC parameters
+         */
+        const MPCParams& getParams() const { return this->params_; }
+        /**
+         * @brief  drop the warm start, e.g. when a new global plan arrives
+         */
+        void reset();
+        /**
+         * @brief  set the reference trajectory, ref[k] is the desired state at time k * dt
+         * @param  ref  reference trajectory
+         */
+        void setReference(const Trajectory& ref);
+        /**
+         * @brief  set obstacle points, only the first MPC_MAX_OBSTACLES are kept
+         * @param  ox   obstacle x coordinates
+         * @param  oy   obstacle y coordinates
+         * @param  n    number of obstacle points
+         */
+        void setObstacles(const double* ox, const double* oy, int n);
+        /**
+         * @brief  solve the optimal control problem
+         * @param  x0   current robot state
+         * @param  v0   current linear velocity
+         * @param  w0   current angular velocity
+         * @param  v    optimal linear velocity to apply
+         * @param  w    optimal angular velocity to apply
+         * @return true if the solver converged within the iteration cap and time budget
+         */
+        bool solve(const MPCState& x0, double v0, double w0, double& v, double& w);
+
+        /**
+         * @brief  predicted trajectory of the last solution
+         * @return predicted trajectory
+         */
+        const Trajectory& getPrediction() const { return this->traj_; }
+        /**
+         * @brief  number of iterations used by the last solve
+         * @return iterations
+         */
+        int getIterations() const { return this->iter_; }
+        /**
+         * @brief  objective value of the last solution
+         * @return cost
+         */
+        double getCost() const { return this->cost_; }
+        /**
+         * @brief  minimum distance between the predicted trajectory and the obstacle points
+         * @return distance, a large value if there is no obstacle
+         */
+        double getMinObstacleDistance() const;
+
+    protected:
+        /**
+         * @brief  roll out the unicycle model and evaluate the objective
+         * @param  v    linear velocity controls
+         * @param  w    angular velocity controls
+         * @param  traj rolled out trajectory
+         * @return objective value
+         */
+        double _rollout(const Controls& v, const Controls& w, Trajectory& traj) const;
+        /**
+         * @brief  gradient of the objective w.r.t. the controls by backward adjoint pass
+         * @param  traj trajectory rolled out from v, w
+         */
+        void _gradient(const Trajectory& traj);
+        /**
+         * @brief  project controls onto the box constraints
+         * @param  v    linear velocity controls
+         * @param  w    angular velocity controls
+         */
+        void _project(Controls& v, Controls& w) const;
+
+    protected:
+        MPCParams params_;
+
+        // reference trajectory
+        Trajectory ref_;
+        // obstacle points
+        std::array<double, MPC_MAX_OBSTACLES> obs_x_, obs_y_;
+        int obs_num_;
+
+        // current solution, its trajectory and gradient
+        Controls v_, w_;
+        Trajectory traj_;
+        Controls grad_v_, grad_w_;
+        // candidate solution during line search
+        Controls v_try_, w_try_;
+        Trajectory traj_try_;
+
+        // current robot state
+        MPCState x0_;
+        // current velocity, used by the smoothness term and the first-step acceleration limits
+        double v0_, w0_;
+        // step size carried between cycles
+        double step_;
+        bool warm_;
+        int iter_;
+        double cost_;
+};
+
+/**
+ * @brief  build a reference trajectory by walking along a plan at constant speed, starting from
+ *         the plan pose closest to the robot
+ * @param  plan     plan poses
+ * @param  at_goal  whether the plan ends at the goal, whose orientation is then held at the end
+ * @param  x0       robot state
+ * @param  ds       distance between consecutive reference states, i.e. reference speed * dt
+ * @param  ref      reference trajectory
+ * @return index of the plan pose closest to the robot
+ */
+size_t buildReference(const std::vector<MPCState>& plan, bool at_goal, const MPCState& x0, double ds,
+                      MPC::Trajectory& ref);
+}
+#endif  // MPC_H
@@ -0,0 +1,131 @@
+/***********************************************************
+ *
+ * @file: mpc_planner.h
+ * @breif: Contains the MPC local planner ROS wrapper class
+ * @author: Yang Haodong
+ * @update: 2023-2-8
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef MPC_PLANNER_H
+#define MPC_PLANNER_H
+
+#include <utility>
+#include <vector>
+
+#include <ros/ros.h>
+#include <nav_core/base_local_planner.h>
+#include <costmap_2d/costmap_2d_ros.h>
+#include <tf2_ros/buffer.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/Twist.h>
+#include <nav_msgs/Path.h>
+
+#include "odom_cache.h"
+#include "mpc.h"
+
+namespace mpc_planner {
+class MPCPlanner : public nav_core::BaseLocalPlanner {
+    public:
+        /**
+         * @brief  Construct a new MPCPlanner object
+         */
+        MPCPlanner();
+        /**
+         * @brief  Construct a new MPCPlanner object
+         * @param  name         planner name
+         * @param  tf           transform buffer
+         * @param  costmap_ros  local costmap ROS wrapper
+         */
+        MPCPlanner(std::string name, tf2_ros::Buffer* tf, costmap_2d::Costmap2DROS* costmap_ros);
+        /**
+         * @brief  Destroy the MPCPlanner object
+         */
+        ~MPCPlanner() = default;
+
+        /**
+         * @brief  Planner initialization
+         * @param  name         planner name
+         * @param  tf           transform buffer
+         * @param  costmap_ros  local costmap ROS wrapper
+         */
+        void initialize(std::string name, tf2_ros::Buffer* tf, costmap_2d::Costmap2DROS* costmap_ros);
+        /**
+         * @brief  Set the plan that the controller is following
+         * @param  orig_global_plan the plan to pass to the controller
+         * @return true if the plan was updated successfully, else false
+         */
+        bool setPlan(const std::vector<geometry_msgs::PoseStamped>& orig_global_plan);
+        /**
+         * @brief  Given the current position, orientation, and velocity of the robot, compute the velocity commands
+         * @param  cmd_vel  will be filled with the velocity command to be passed to the robot base
+         * @return true if a valid velocity command was found, else false
+         */
+        bool computeVelocityCommands(geometry_msgs::Twist& cmd_vel);
+        /**
+         * @brief  Check if the goal pose has been achieved
+         * @return true if achieved, false otherwise
+         */
+        bool isGoalReached();
+
+    protected:
+        /**
+         * @brief  transform the remaining global plan into the costmap frame with one tf lookup
+         * @return true if the transform is available
+         */
+        bool _transformPlan();
+        /**
+         * @brief  build the reference trajectory by walking along the plan at ref_speed_ from the closest pose
+         * @param  x0   robot state in costmap frame
+         * @param  ref  reference trajectory
+         */
+        void _buildReference(const MPCState& x0, MPC::Trajectory& ref);
+        /**
+         * @brief  collect the lethal cells around the robot, keep the closest MPC_MAX_OBSTACLES
+         * @param  x0   robot state in costmap frame
+         */
+        void _collectObstacles(const MPCState& x0);
+        /**
+         * @brief  publish the predicted trajectory
+         * @param  frame_id costmap frame
+         */
+        void _publishPrediction(const std::string& frame_id);
+
+    protected:
+        bool initialized_, goal_reached_;
+        costmap_2d::Costmap2DROS* costmap_ros_;
+        tf2_ros::Buffer* tf_;
+        local_planner::OdomCache odom_cache_;
+
+        // solver
+        MPC mpc_;
+        // reference speed along the plan
+        double ref_speed_;
+        // half size of the obstacle search window
+        double obstacle_range_;
+        // goal tolerance
+        double xy_goal_tolerance_, yaw_goal_tolerance_;
+        // rotation gain when aligning with the goal orientation
+        double k_rotate_;
+
+        // global plan, and the part of it handled in this cycle in costmap frame
+        std::vector<geometry_msgs::PoseStamped> global_plan_;
+        std::vector<MPCState> local_plan_;
+        // index of the pose closest to the robot, and of the first pose in local_plan_
+        size_t closest_index_, local_begin_;
+        // goal pose in costmap frame
+        MPCState goal_;
+
+        // preallocated obstacle buffers, so the control loop does not allocate
+        std::vector<std::pair<double, int>> obs_candidates_;
+        std::vector<double> obs_x_, obs_y_;
+
+        ros::Publisher pred_pub_;
+        nav_msgs::Path pred_path_;
+};
+}
+#endif  // MPC_PLANNER_H
@@ -0,0 +1,381 @@
+/***********************************************************
+ *
+ * @file: mpc.cpp
+ * @breif: Contains the warm-started nonlinear MPC solver for unicycle model
+ * @author: Yang Haodong
+ * @update: 2023-2-8
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "mpc.h"
+#include "trace.h"
+
+namespace mpc_planner {
+/**
+ * @brief  normalize angle to [-pi, pi]
+ * @param  a    angle
+ * @return normalized angle
+ */
+static inline double normalizeAngle(double a) {
+    while (a > M_PI)
+        a -= 2.0 * M_PI;
+    while (a < -M_PI)
+        a += 2.0 * M_PI;
+    return a;
+}
+
+/**
+ * @brief  Constructor
+ * @param  params   MPC parameters
+ */
+MPC::MPC(const MPCParams& params) : obs_num_(0), v0_(0.0), w0_(0.0) {
+    this->x0_ = { 0.0, 0.0, 0.0 };
+    this->ref_.fill(this->x0_);
+    this->traj_.fill(this->x0_);
+    this->setParams(params);
+}
+
+/**
+ * @brief  set or reset MPC parameters, drops the warm start
+ * @param  params   MPC parameters
+ */
+void MPC::setParams(const MPCParams& params) {
+    this->params_ = params;
+    this->reset();
+}
+
+/**
+ * @brief  drop the warm start, e.g. when a new global plan arrives
+ */
+void MPC::reset() {
+    this->v_.fill(0.0);
+    this->w_.fill(0.0);
+    this->step_ = 1.0;
+    this->warm_ = false;
+    this->iter_ = 0;
+    this->cost_ = 0.0;
+}
+
+/**
+ * @brief  set the reference trajectory, ref[k] is the desired state at time k * dt
+ * @param  ref  reference trajectory
+ */
+void MPC::setReference(const Trajectory& ref) {
+    this->ref_ = ref;
+}
+
+/**
+ * @brief  set obstacle points, only the first MPC_MAX_OBSTACLES are kept
+ * @param  ox   obstacle x coordinates
+ * @param  oy   obstacle y coordinates
+ * @param  n    number of obstacle points
+ */
+void MPC::setObstacles(const double* ox, const double* oy, int n) {
+    this->obs_num_ = std::min(n, MPC_MAX_OBSTACLES);
+    for (int i = 0; i < this->obs_num_; i++) {
+        this->obs_x_[i] = ox[i];
+        this->obs_y_[i] = oy[i];
+    }
+}
+
+/**
+ * @brief  solve the optimal control problem
+ * @param  x0   current robot state
+ * @param  v0   current linear velocity
+ * @param  w0   current angular velocity
+ * @param  v    optimal linear velocity to apply
+ * @param  w    optimal angular velocity to apply
+ * @return true if the solver converged within the iteration cap and time budget
+ */
+bool MPC::solve(const MPCState& x0, double v0, double w0, double& v, double& w) {
+    TRACE_SCOPE("MPC::solve");
+    auto t_start = std::chrono::steady_clock::now();
+    const MPCParams& p = this->params_;
+
+    this->x0_ = x0;
+    this->v0_ = v0;
+    this->w0_ = w0;
+
+    // initial guess: previous solution shifted by one step, or the controls implied by the reference
+    if (this->warm_) {
+        for (int k = 0; k < MPC_HORIZON - 1; k++) {
+            this->v_[k] = this->v_[k + 1];
+            this->w_[k] = this->w_[k + 1];
+        }
+    } else {
+        for (int k = 0; k < MPC_HORIZON; k++) {
+            this->v_[k] = std::hypot(this->ref_[k + 1].x - this->ref_[k].x, this->ref_[k + 1].y - this->ref_[k].y) / p.dt;
+            this->w_[k] = normalizeAngle(this->ref_[k + 1].theta - this->ref_[k].theta) / p.dt;
+        }
+        this->step_ = 1.0;
+    }
+    this->_project(this->v_, this->w_);
+    this->cost_ = this->_rollout(this->v_, this->w_, this->traj_);
+
+    bool converged = false;
+    for (this->iter_ = 0; this->iter_ < p.max_iter; this->iter_++) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        if (elapsed > p.time_budget)
+            break;
+
+        this->_gradient(this->traj_);
+
+        // projected gradient step with Armijo backtracking, the step size is carried over between iterations
+        bool accepted = false, stationary = false;
+        double step = std::min(this->step_ * 2.0, 1e3), cost_try = 0.0, max_diff = 0.0;
+        for (int ls = 0; ls < 30; ls++) {
+            for (int k = 0; k < MPC_HORIZON; k++) {
+                this->v_try_[k] = this->v_[k] - step * this->grad_v_[k];
+                this->w_try_[k] = this->w_[k] - step * this->grad_w_[k];
+            }
+            this->_project(this->v_try_, this->w_try_);
+
+            double decrease = 0.0, sq_norm = 0.0;
+            max_diff = 0.0;
+            for (int k = 0; k < MPC_HORIZON; k++) {
+                double dv = this->v_try_[k] - this->v_[k], dw = this->w_try_[k] - this->w_[k];
+                decrease += this->grad_v_[k] * dv + this->grad_w_[k] * dw;
+                sq_norm += dv * dv + dw * dw;
+                max_diff = std::max(max_diff, std::max(std::fabs(dv), std::fabs(dw)));
+            }
+            if (max_diff < p.tolerance) {
+                stationary = true;
+                break;
+            }
+
+            cost_try = this->_rollout(this->v_try_, this->w_try_, this->traj_try_);
+            if (cost_try <= this->cost_ + decrease + sq_norm / (2.0 * step)) {
+                accepted = true;
+                break;
+            }
+            step *= 0.5;
+        }
+        this->step_ = step;
+
+        // the projected step vanished: projected stationary point
+        if (stationary) {
+            converged = true;
+            break;
+        }
+        // no sufficient decrease within the backtracking budget, the last accepted iterate is kept
+        if (!accepted)
+            break;
+
+        std::swap(this->v_, this->v_try_);
+        std::swap(this->w_, this->w_try_);
+        std::swap(this->traj_, this->traj_try_);
+        this->cost_ = cost_try;
+
+        if (max_diff < p.tolerance) {
+            converged = true;
+            this->iter_++;
+            break;
+        }
+    }
+
+    this->warm_ = true;
+    v = this->v_[0];
+    w = this->w_[0];
+
+    return converged;
+}
+
+/**
+ * @brief  minimum distance between the predicted trajectory and the obstacle points
+ * @return distance, a large value if there is no obstacle
+ */
+double MPC::getMinObstacleDistance() const {
+    double d_min = std::numeric_limits<double>::max();
+    for (int k = 0; k <= MPC_HORIZON; k++)
+        for (int i = 0; i < this->obs_num_; i++)
+            d_min = std::min(d_min, std::hypot(this->traj_[k].x - this->obs_x_[i], this->traj_[k].y - this->obs_y_[i]));
+    return d_min;
+}
+
+/**
+ * @brief  roll out the unicycle model and evaluate the objective
+ * @param  v    linear velocity controls
+ * @param  w    angular velocity controls
+ * @param  traj rolled out trajectory
+ * @return objective value
+ */
+double MPC::_rollout(const Controls& v, const Controls& w, Trajectory& traj) const {
+    const MPCParams& p = this->params_;
+    double cost = 0.0;
+
+    traj[0] = this->x0_;
+    for (int k = 0; k < MPC_HORIZON; k++) {
+        // unicycle model, explicit Euler
+        const MPCState& s = traj[k];
+        MPCState& s_next = traj[k + 1];
+        s_next.x = s.x + v[k] * std::cos(s.theta) * p.dt;
+        s_next.y = s.y + v[k] * std::sin(s.theta) * p.dt;
+        s_next.theta = s.theta + w[k] * p.dt;
+
+        // tracking
+        double weight = (k + 1 == MPC_HORIZON) ? p.w_terminal : 1.0;
+        double ex = s_next.x - this->ref_[k + 1].x;
+        double ey = s_next.y - this->ref_[k + 1].y;
+        double et = normalizeAngle(s_next.theta - this->ref_[k + 1].theta);
+        cost += weight * (p.w_pos * (ex * ex + ey * ey) + p.w_theta * et * et);
+
+        // obstacle distance constraint as exterior penalty
+        for (int i = 0; i < this->obs_num_; i++) {
+            double d = std::hypot(s_next.x - this->obs_x_[i], s_next.y - this->obs_y_[i]);
+            if (d < p.safe_dist)
+                cost += p.w_obs * (p.safe_dist - d) * (p.safe_dist - d);
+        }
+
+        // smoothness
+        double dv = v[k] - (k ? v[k - 1] : this->v0_);
+        double dw = w[k] - (k ? w[k - 1] : this->w0_);
+        cost += p.w_dv * dv * dv + p.w_dw * dw * dw;
+    }
+
+    return cost;
+}
+
+/**
+ * @brief  gradient of the objective w.r.t. the controls by backward adjoint pass
+ * @param  traj trajectory rolled out from v, w
+ */
+void MPC::_gradient(const Trajectory& traj) {
+    const MPCParams& p = this->params_;
+    double lx = 0.0, ly = 0.0, lt = 0.0;
+
+    for (int k = MPC_HORIZON; k >= 1; k--) {
+        const MPCState& s = traj[k];
+
+        // propagate costate through the model Jacobian of step k -> k + 1
+        if (k < MPC_HORIZON)
+            lt += p.dt * this->v_[k] * (-std::sin(s.theta) * lx + std::cos(s.theta) * ly);
+
+        // stage cost gradient at state k
+        double weight = (k == MPC_HORIZON) ? p.w_terminal : 1.0;
+        lx += 2.0 * weight * p.w_pos * (s.x - this->ref_[k].x);
+        ly += 2.0 * weight * p.w_pos * (s.y - this->ref_[k].y);
+        lt += 2.0 * weight * p.w_theta * normalizeAngle(s.theta - this->ref_[k].theta);
+        for (int i = 0; i < this->obs_num_; i++) {
+            double dx = s.x - this->obs_x_[i], dy = s.y - this->obs_y_[i];
+            double d = std::hypot(dx, dy);
+            if (d < p.safe_dist && d > 1e-9) {
+                double g = -2.0 * p.w_obs * (p.safe_dist - d) / d;
+                lx += g * dx;
+                ly += g * dy;
+            }
+        }
+
+        // control k - 1 drives state k - 1 -> k
+        const MPCState& s_prev = traj[k - 1];
+        this->grad_v_[k - 1] = p.dt * (std::cos(s_prev.theta) * lx + std::sin(s_prev.theta) * ly);
+        this->grad_w_[k - 1] = p.dt * lt;
+    }
+
+    // smoothness
+    for (int k = 0; k < MPC_HORIZON; k++) {
+        double dv = 2.0 * p.w_dv * (this->v_[k] - (k ? this->v_[k - 1] : this->v0_));
+        double dw = 2.0 * p.w_dw * (this->w_[k] - (k ? this->w_[k - 1] : this->w0_));
+        this->grad_v_[k] += dv;
+        this->grad_w_[k] += dw;
+        if (k) {
+            this->grad_v_[k - 1] -= dv;
+            this->grad_w_[k - 1] -= dw;
+        }
+    }
+}
+
+/**
+ * @brief  project controls onto the box constraints
+ * @param  v    linear velocity controls
+ * @param  w    angular velocity controls
+ */
+void MPC::_project(Controls& v, Controls& w) const {
+    const MPCParams& p = this->params_;
+    for (int k = 0; k < MPC_HORIZON; k++) {
+        double v_lo = p.min_v, v_hi = p.max_v, w_lo = p.min_w, w_hi = p.max_w;
+        // the first control must be reachable from the current velocity
+        if (k == 0) {
+            v_lo = std::min(std::max(v_lo, this->v0_ - p.acc_lim_v * p.dt), v_hi);
+            v_hi = std::max(std::min(v_hi, this->v0_ + p.acc_lim_v * p.dt), v_lo);
+            w_lo = std::min(std::max(w_lo, this->w0_ - p.acc_lim_w * p.dt), w_hi);
+            w_hi = std::max(std::min(w_hi, this->w0_ + p.acc_lim_w * p.dt), w_lo);
+        }
+        v[k] = std::min(std::max(v[k], v_lo), v_hi);
+        w[k] = std::min(std::max(w[k], w_lo), w_hi);
+    }
+}
+
+/**
+ * @brief  build a reference trajectory by walking along a plan at constant speed, starting from
+ *         the plan pose closest to the robot
+ * @param  plan     plan poses
+ * @param  at_goal  whether the plan ends at the goal, whose orientation is then held at the end
+ * @param  x0       robot state
+ * @param  ds       distance between consecutive reference states, i.e. reference speed * dt
+ * @param  ref      reference trajectory
+ * @return index of the plan pose closest to the robot
+ */
+size_t buildReference(const std::vector<MPCState>& plan, bool at_goal, const MPCState& x0, double ds,
+                      MPC::Trajectory& ref) {
+    ref[0] = x0;
+    if (plan.empty()) {
+        ref.fill(x0);
+        return 0;
+    }
+
+    size_t closest = 0;
+    double d_min = std::hypot(plan[0].x - x0.x, plan[0].y - x0.y);
+    for (size_t i = 1; i < plan.size(); i++) {
+        double d = std::hypot(plan[i].x - x0.x, plan[i].y - x0.y);
+        if (d < d_min) {
+            d_min = d;
+            closest = i;
+        }
+    }
+
+    size_t seg = closest;
+    double seg_offset = 0.0;
+    double heading = x0.theta;
+
+    for (int k = 1; k <= MPC_HORIZON; k++) {
+        // walk ds further along the plan
+        double remain = ds;
+        while (seg + 1 < plan.size()) {
+            const MPCState& a = plan[seg];
+            const MPCState& b = plan[seg + 1];
+            double seg_len = std::hypot(b.x - a.x, b.y - a.y);
+            if (seg_len > 1e-9)
+                heading = std::atan2(b.y - a.y, b.x - a.x);
+            if (seg_offset + remain <= seg_len) {
+                seg_offset += remain;
+                break;
+            }
+            remain -= seg_len - seg_offset;
+            seg_offset = 0.0;
+            seg++;
+        }
+
+        if (seg + 1 < plan.size()) {
+            const MPCState& a = plan[seg];
+            const MPCState& b = plan[seg + 1];
+            double seg_len = std::hypot(b.x - a.x, b.y - a.y);
+            double r = seg_len > 1e-9 ? seg_offset / seg_len : 0.0;
+            ref[k] = { a.x + r * (b.x - a.x), a.y + r * (b.y - a.y), heading };
+        } else {
+            // end of the plan, hold the last pose
+            ref[k] = { plan.back().x, plan.back().y, at_goal ? plan.back().theta : heading };
+        }
+    }
+
+    return closest;
+}
+}
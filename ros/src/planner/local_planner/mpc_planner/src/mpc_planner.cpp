@@ -0,0 +1,341 @@
+/***********************************************************
+ *
+ * @file: mpc_planner.cpp
+ * @breif: Contains the MPC local planner ROS wrapper class
+ * @author: Yang Haodong
+ * @update: 2023-2-8
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include <angles/angles.h>
+#include <tf2/utils.h>
+#include <pluginlib/class_list_macros.h>
+
+#include "mpc_planner.h"
+#include "trace.h"
+
+PLUGINLIB_EXPORT_CLASS(mpc_planner::MPCPlanner, nav_core::BaseLocalPlanner)
+
+namespace mpc_planner {
+/**
+ * @brief  Construct a new MPCPlanner object
+ */
+MPCPlanner::MPCPlanner() : initialized_(false), goal_reached_(false), costmap_ros_(nullptr), tf_(nullptr) {}
+
+/**
+ * @brief  Construct a new MPCPlanner object
+ * @param  name         planner name
+ * @param  tf           transform buffer
+ * @param  costmap_ros  local costmap ROS wrapper
+ */
+MPCPlanner::MPCPlanner(std::string name, tf2_ros::Buffer* tf, costmap_2d::Costmap2DROS* costmap_ros)
+    : MPCPlanner() {
+    this->initialize(name, tf, costmap_ros);
+}
+
+/**
+ * @brief  Planner initialization
+ * @param  name         planner name
+ * @param  tf           transform buffer
+ * @param  costmap_ros  local costmap ROS wrapper
+ */
+void MPCPlanner::initialize(std::string name, tf2_ros::Buffer* tf, costmap_2d::Costmap2DROS* costmap_ros) {
+    if (!this->initialized_) {
+        this->initialized_ = true;
+        this->tf_ = tf;
+        this->costmap_ros_ = costmap_ros;
+
+        ros::NodeHandle nh = ros::NodeHandle("~/" + name);
+
+        MPCParams params;
+        double controller_frequency;
+        nh.param("/move_base/controller_frequency", controller_frequency, 10.0);
+        nh.param("dt", params.dt, 1.0 / controller_frequency);
+        nh.param("max_v", params.max_v, params.max_v);
+        nh.param("min_v", params.min_v, params.min_v);
+        nh.param("max_w", params.max_w, params.max_w);
+        nh.param("min_w", params.min_w, params.min_w);
+        nh.param("acc_lim_v", params.acc_lim_v, params.acc_lim_v);
+        nh.param("acc_lim_w", params.acc_lim_w, params.acc_lim_w);
+        nh.param("w_pos", params.w_pos, params.w_pos);
+        nh.param("w_theta", params.w_theta, params.w_theta);
+        nh.param("w_terminal", params.w_terminal, params.w_terminal);
+        nh.param("w_dv", params.w_dv, params.w_dv);
+        nh.param("w_dw", params.w_dw, params.w_dw);
+        nh.param("w_obs", params.w_obs, params.w_obs);
+        nh.param("safe_dist", params.safe_dist, params.safe_dist);
+        nh.param("max_iter", params.max_iter, params.max_iter);
+        nh.param("tolerance", params.tolerance, params.tolerance);
+        nh.param("time_budget", params.time_budget, params.time_budget);
+        this->mpc_.setParams(params);
+
+        nh.param("ref_speed", this->ref_speed_, params.max_v);
+        nh.param("obstacle_range", this->obstacle_range_, params.max_v * params.dt * MPC_HORIZON + params.safe_dist);
+        nh.param("xy_goal_tolerance", this->xy_goal_tolerance_, 0.1);
+        nh.param("yaw_goal_tolerance", this->yaw_goal_tolerance_, 0.17);
+        nh.param("k_rotate", this->k_rotate_, 2.0);
+
+        std::string odom_topic;
+        nh.param("odom_topic", odom_topic, std::string("/odom"));
+        this->odom_cache_.setOdomTopic(odom_topic);
+
+        // every lethal cell of the search window fits, the control loop never grows these buffers
+        costmap_2d::Costmap2D* costmap = this->costmap_ros_->getCostmap();
+        int window = 2 * (int)std::ceil(this->obstacle_range_ / costmap->getResolution()) + 1;
+        this->obs_candidates_.reserve(window * window);
+        this->obs_x_.reserve(MPC_MAX_OBSTACLES);
+        this->obs_y_.reserve(MPC_MAX_OBSTACLES);
+        this->pred_path_.poses.resize(MPC_HORIZON + 1);
+
+        this->pred_pub_ = nh.advertise<nav_msgs::Path>("local_plan", 1);
+
+        ROS_INFO("MPC planner initialized!");
+    } else
+        ROS_WARN("MPC planner has already been initialized.");
+}
+
+/**
+ * @brief  Set the plan that the controller is following
+ * @param  orig_global_plan the plan to pass to the controller
+ * @return true if the plan was updated successfully, else false
+ */
+bool MPCPlanner::setPlan(const std::vector<geometry_msgs::PoseStamped>& orig_global_plan) {
+    if (!this->initialized_) {
+        ROS_ERROR("MPC planner has not been initialized");
+        return false;
+    }
+
+    // move_base replans at planner_frequency, only a new goal invalidates the warm start
+    if (this->global_plan_.empty() || orig_global_plan.empty() ||
+        std::hypot(orig_global_plan.back().pose.position.x - this->global_plan_.back().pose.position.x,
+                   orig_global_plan.back().pose.position.y - this->global_plan_.back().pose.position.y) > 1e-3) {
+        this->mpc_.reset();
+        this->goal_reached_ = false;
+    }
+
+    this->global_plan_ = orig_global_plan;
+    this->local_plan_.reserve(this->global_plan_.size());
+    this->closest_index_ = 0;
+    this->local_begin_ = 0;
+
+    return true;
+}
+
+/**
+ * @brief  Given the current position, orientation, and velocity of the robot, compute the velocity commands
+ * @param  cmd_vel  will be filled with the velocity command to be passed to the robot base
+ * @return true if a valid velocity command was found, else false
+ */
+bool MPCPlanner::computeVelocityCommands(geometry_msgs::Twist& cmd_vel) {
+    TRACE_SCOPE("MPCPlanner::computeVelocityCommands");
+    if (!this->initialized_) {
+        ROS_ERROR("MPC planner has not been initialized");
+        return false;
+    }
+
+    if (this->global_plan_.empty()) {
+        ROS_ERROR("MPC planner received an empty plan.");
+        return false;
+    }
+
+    // robot state in costmap frame
+    geometry_msgs::PoseStamped robot_pose;
+    if (!this->costmap_ros_->getRobotPose(robot_pose)) {
+        ROS_ERROR("MPC planner could not get the robot pose.");
+        return false;
+    }
+    MPCState x0 = { robot_pose.pose.position.x, robot_pose.pose.position.y, tf2::getYaw(robot_pose.pose.orientation) };
+
+    local_planner::OdomState odom;
+    if (!this->odom_cache_.getState(odom)) {
+        ROS_WARN_THROTTLE(1.0, "MPC planner has not received any odometry yet.");
+        return false;
+    }
+
+    if (!this->_transformPlan())
+        return false;
+
+    cmd_vel.linear.x = 0.0;
+    cmd_vel.linear.y = 0.0;
+    cmd_vel.angular.z = 0.0;
+
+    // goal position reached: rotate in place to the goal orientation
+    if (std::hypot(this->goal_.x - x0.x, this->goal_.y - x0.y) <= this->xy_goal_tolerance_) {
+        double e_theta = angles::normalize_angle(this->goal_.theta - x0.theta);
+        if (std::fabs(e_theta) <= this->yaw_goal_tolerance_) {
+            this->goal_reached_ = true;
+            return true;
+        }
+        const MPCParams& p = this->mpc_.getParams();
+        cmd_vel.angular.z = std::min(std::max(this->k_rotate_ * e_theta, p.min_w), p.max_w);
+        return true;
+    }
+
+    MPC::Trajectory ref;
+    this->_buildReference(x0, ref);
+    this->mpc_.setReference(ref);
+    this->_collectObstacles(x0);
+
+    double v, w;
+    ros::WallTime t_start = ros::WallTime::now();
+    bool converged = this->mpc_.solve(x0, odom.vx, odom.wz, v, w);
+    double t_solve = (ros::WallTime::now() - t_start).toSec();
+    if (!converged)
+        ROS_DEBUG("MPC planner stopped after %d iterations in %.2f ms without convergence.", this->mpc_.getIterations(),
+                  t_solve * 1000.0);
+    if (t_solve > 2 * this->mpc_.getParams().time_budget)
+        ROS_WARN_THROTTLE(1.0, "MPC planner solve took %.2f ms.", t_solve * 1000.0);
+
+    cmd_vel.linear.x = v;
+    cmd_vel.angular.z = w;
+
+    this->_publishPrediction(robot_pose.header.frame_id);
+
+    return true;
+}
+
+/**
+ * @brief  Check if the goal pose has been achieved
+ * @return true if achieved, false otherwise
+ */
+bool MPCPlanner::isGoalReached() {
+    if (!this->initialized_) {
+        ROS_ERROR("MPC planner has not been initialized");
+        return false;
+    }
+
+    if (this->goal_reached_) {
+        ROS_INFO("Goal has been reached!");
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief  transform the remaining global plan into the costmap frame with one tf lookup
+ * @return true if the transform is available
+ */
+bool MPCPlanner::_transformPlan() {
+    geometry_msgs::TransformStamped plan_to_costmap;
+    try {
+        plan_to_costmap = this->tf_->lookupTransform(this->costmap_ros_->getGlobalFrameID(),
+                                                     this->global_plan_.front().header.frame_id, ros::Time(0));
+    } catch (tf2::TransformException& ex) {
+        ROS_ERROR("MPC planner could not transform the plan: %s", ex.what());
+        return false;
+    }
+
+    double tx = plan_to_costmap.transform.translation.x;
+    double ty = plan_to_costmap.transform.translation.y;
+    double yaw = tf2::getYaw(plan_to_costmap.transform.rotation);
+    double c = std::cos(yaw), s = std::sin(yaw);
+    auto transform = [&](const geometry_msgs::PoseStamped& pose) {
+        MPCState state;
+        state.x = tx + c * pose.pose.position.x - s * pose.pose.position.y;
+        state.y = ty + s * pose.pose.position.x + c * pose.pose.position.y;
+        state.theta = angles::normalize_angle(tf2::getYaw(pose.pose.orientation) + yaw);
+        return state;
+    };
+
+    this->goal_ = transform(this->global_plan_.back());
+
+    // the reference never looks further than the horizon, plus a margin for moving the closest pose forward
+    const MPCParams& p = this->mpc_.getParams();
+    double lookahead = 2.0 * this->ref_speed_ * p.dt * MPC_HORIZON + this->obstacle_range_;
+    double length = 0.0;
+
+    this->local_plan_.clear();
+    this->local_begin_ = this->closest_index_;
+    for (size_t i = this->local_begin_; i < this->global_plan_.size(); i++) {
+        this->local_plan_.push_back(transform(this->global_plan_[i]));
+        if (this->local_plan_.size() > 1) {
+            const MPCState& a = this->local_plan_[this->local_plan_.size() - 2];
+            const MPCState& b = this->local_plan_.back();
+            length += std::hypot(b.x - a.x, b.y - a.y);
+        }
+        if (length > lookahead)
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief  build the reference trajectory by walking along the plan at ref_speed_ from the closest pose
+ * @param  x0   robot state in costmap frame
+ * @param  ref  reference trajectory
+ */
+void MPCPlanner::_buildReference(const MPCState& x0, MPC::Trajectory& ref) {
+    TRACE_SCOPE("MPCPlanner::buildReference");
+    // the plan is only ever followed forward
+    bool at_goal = this->local_begin_ + this->local_plan_.size() == this->global_plan_.size();
+    size_t closest = buildReference(this->local_plan_, at_goal, x0, this->ref_speed_ * this->mpc_.getParams().dt, ref);
+    this->closest_index_ = this->local_begin_ + closest;
+}
+
+/**
+ * @brief  collect the lethal cells around the robot, keep the closest MPC_MAX_OBSTACLES
+ * @param  x0   robot state in costmap frame
+ */
+void MPCPlanner::_collectObstacles(const MPCState& x0) {
+    TRACE_SCOPE("MPCPlanner::collectObstacles");
+    costmap_2d::Costmap2D* costmap = this->costmap_ros_->getCostmap();
+    double resolution = costmap->getResolution();
+    int nx = costmap->getSizeInCellsX(), ny = costmap->getSizeInCellsY();
+    int cx = (int)std::floor((x0.x - costmap->getOriginX()) / resolution);
+    int cy = (int)std::floor((x0.y - costmap->getOriginY()) / resolution);
+    int r = (int)std::ceil(this->obstacle_range_ / resolution);
+
+    this->obs_candidates_.clear();
+    for (int y = std::max(0, cy - r); y <= std::min(ny - 1, cy + r); y++) {
+        for (int x = std::max(0, cx - r); x <= std::min(nx - 1, cx + r); x++) {
+            if (costmap->getCost(x, y) == costmap_2d::LETHAL_OBSTACLE)
+                this->obs_candidates_.emplace_back((x - cx) * (x - cx) + (y - cy) * (y - cy), y * nx + x);
+        }
+    }
+
+    if (this->obs_candidates_.size() > MPC_MAX_OBSTACLES)
+        std::nth_element(this->obs_candidates_.begin(), this->obs_candidates_.begin() + MPC_MAX_OBSTACLES,
+                         this->obs_candidates_.end());
+
+    this->obs_x_.clear();
+    this->obs_y_.clear();
+    for (size_t i = 0; i < std::min(this->obs_candidates_.size(), (size_t)MPC_MAX_OBSTACLES); i++) {
+        double wx, wy;
+        int idx = this->obs_candidates_[i].second;
+        costmap->mapToWorld(idx % nx, idx / nx, wx, wy);
+        this->obs_x_.push_back(wx);
+        this->obs_y_.push_back(wy);
+    }
+    this->mpc_.setObstacles(this->obs_x_.data(), this->obs_y_.data(), (int)this->obs_x_.size());
+}
+
+/**
+ * @brief  publish the predicted trajectory
+ * @param  frame_id costmap frame
+ */
+void MPCPlanner::_publishPrediction(const std::string& frame_id) {
+    if (this->pred_pub_.getNumSubscribers() == 0)
+        return;
+
+    const MPC::Trajectory& traj = this->mpc_.getPrediction();
+    this->pred_path_.header.frame_id = frame_id;
+    this->pred_path_.header.stamp = ros::Time::now();
+    for (int k = 0; k <= MPC_HORIZON; k++) {
+        geometry_msgs::PoseStamped& pose = this->pred_path_.poses[k];
+        pose.header = this->pred_path_.header;
+        pose.pose.position.x = traj[k].x;
+        pose.pose.position.y = traj[k].y;
+        pose.pose.orientation.z = std::sin(traj[k].theta / 2.0);
+        pose.pose.orientation.w = std::cos(traj[k].theta / 2.0);
+    }
+    this->pred_pub_.publish(this->pred_path_);
+}
+}
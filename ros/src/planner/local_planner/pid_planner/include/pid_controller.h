@@ -0,0 +1,83 @@
+/***********************************************************
+ *
+ * @file: pid_controller.h
+ * @breif: Contains the ROS-free linear and angular PID velocity controllers
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#ifndef PID_CONTROLLER_H
+#define PID_CONTROLLER_H
+
+namespace pid_planner {
+/**
+ * @brief PID controller parameters
+ */
+struct PIDParams {
+    // control period
+    double d_t = 0.1;
+    // linear
+    double max_vel_lin = 0.3, min_vel_lin = 0.0, max_incr_lin = 0.3;
+    // angular
+    double max_vel_ang = 1.0, min_vel_ang = -1.0, max_incr_ang = 0.5;
+    // pid gains
+    double k_p_lin = 2.00, k_i_lin = 0.04, k_d_lin = 0.00;
+    double k_p_ang = 2.00, k_i_ang = 0.00, k_d_ang = 0.10;
+};
+
+/**
+ * @brief Linear and angular velocity PID controllers, independent of ROS so that they can be
+ *        used by PIDPlanner and by offline benchmarks alike
+ */
+class PIDController {
+    public:
+        /**
+         * @brief  Constructor
+         * @param  params   controller parameters
+         */
+        PIDController(const PIDParams& params = PIDParams());
+        ~PIDController() = default;
+
+        /**
+         * @brief  set or reset controller parameters
+         * @param  params   controller parameters
+         */
+        void setParams(const PIDParams& params) { this->params_ = params; }
+        /**
+         * @brief  get controller parameters
+         * @return controller parameters
+         */
+        const PIDParams& getParams() const { return this->params_; }
+        /**
+         * @brief  reset integral and derivative terms
+         */
+        void reset();
+        /**
+         * @brief  linear velocity controller
+         * @param  vel_curr current linear velocity
+         * @param  t_x      target x in robot frame
+         * @param  t_y      target y in robot frame
+         * @return linear velocity command
+         */
+        double linear(double vel_curr, double t_x, double t_y);
+        /**
+         * @brief  angular velocity controller
+         * @param  vel_ang      current angular velocity
+         * @param  target_th    target orientation
+         * @param  robot_th     robot orientation
+         * @return angular velocity command
+         */
+        double angular(double vel_ang, double target_th, double robot_th);
+
+    private:
+        PIDParams params_;
+        double error_lin_, error_ang_;
+        double integral_lin_, integral_ang_;
+};
+}
+#endif  // PID_CONTROLLER_H
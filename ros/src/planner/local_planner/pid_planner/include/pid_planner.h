@@ -2,9 +2,9 @@
 #define PID_PLANNER_H_
 
 #include <nav_core/base_local_planner.h>
-#include <base_local_planner/odometry_helper_ros.h>
 
 #include <ros/ros.h>
+#include <angles/angles.h>
 #include <tf2_ros/buffer.h>
 #include <tf2/LinearMath/Matrix3x3.h>
 #include <tf2/utils.h>
@@ -13,6 +13,9 @@
 #include <geometry_msgs/Twist.h>
 #include <nav_msgs/Odometry.h>
 
+#include "odom_cache.h"
+#include "pid_controller.h"
+
 // #include <Eigen/Eigen>
 // #include <Eigen/Dense>
 // #include <Eigen/Geometry>
@@ -42,9 +45,12 @@ namespace pid_planner
 
         std::vector<double> getEulerAngles(geometry_msgs::PoseStamped &Pose);
 
-        double LinearPIDController(nav_msgs::Odometry &base_odometry, double next_t_x, double next_t_y);
+        double LinearPIDController(const local_planner::OdomState &base_odometry, double next_t_x, double next_t_y);
+
+        double AngularPIDController(const local_planner::OdomState &base_odometry, double target_th_w, double robot_orien);
 
-        double AngularPIDController(nav_msgs::Odometry &base_odometry, double target_th_w, double robot_orien);
+        // forward simulate cmd_vel over collision_horizon_ and slow it down if the footprint would hit an obstacle
+        bool checkCollision(const local_planner::OdomState &odom, geometry_msgs::Twist &cmd_vel);
 
         // void controller(double x, double y, double theta, double x_d, double y_d, geometry_msgs::Twist &cmd_vel);
 
@@ -57,22 +63,21 @@ namespace pid_planner
             ROS_INFO("Robot will stop.");
         }
 
-        void getTransformedPosition(geometry_msgs::PoseStamped &pose, double *x, double *y, double *theta)
-        {
-            geometry_msgs::PoseStamped ps;
-            pose.header.stamp = ros::Time(0);
+        // sample the robot footprint into points in base frame, one per costmap cell
+        void initFootprintOffsets();
 
-            // tf_->transformPose(base_frame_, pose, ps);
-            tf_->transform(pose, ps, base_frame_);
+        // one tf lookup (plan frame -> base frame) per control cycle, cached for all plan poses
+        bool updateRobotState();
 
-            *x = ps.pose.position.x;
-            *y = ps.pose.position.y;
+        // transform a plan pose into base_frame_ using the transform cached by updateRobotState()
+        void getTransformedPosition(const geometry_msgs::PoseStamped &pose, double *x, double *y, double *theta)
+        {
+            double dx = pose.pose.position.x - robot_curr_pose[0];
+            double dy = pose.pose.position.y - robot_curr_pose[1];
 
-            // theta = tf::getYaw(ps.pose.orientation);
-            *theta = tf2::getYaw(ps.pose.orientation);
-            // tf2::Quaternion q(ps.pose.orientation.x, ps.pose.orientation.y,
-            //                   ps.pose.orientation.z, ps.pose.orientation.w);
-            // *theta = q.getAngle();
+            *x = robot_cos_ * dx + robot_sin_ * dy;
+            *y = -robot_sin_ * dx + robot_cos_ * dy;
+            *theta = angles::normalize_angle(tf2::getYaw(pose.pose.orientation) - robot_curr_orien);
         }
 
         costmap_2d::Costmap2DROS *costmap_ros_;
@@ -84,21 +89,22 @@ namespace pid_planner
         // tf::Vector3 robot_curr_pose;
         double robot_curr_pose[3];
         double robot_curr_orien;
+        double robot_cos_, robot_sin_;
         std::vector<double> final_orientation;
 
         double p_window_, o_window_;
         double p_precision_, o_precision_;
         double d_t_;
-        double error_lin_, error_ang_;
-        double integral_lin_, integral_ang_;
-        double max_vel_lin_, min_vel_lin_, max_incr_lin_;
-        double max_vel_ang_, min_vel_ang_, max_incr_ang_;
-        double k_p_lin_, k_i_lin_, k_d_lin_;
-        double k_p_ang_, k_i_ang_, k_d_ang_;
+        PIDController pid_;
         // double k_, l_;
         
         std::string base_frame_;
-        base_local_planner::OdometryHelperRos *odom_helper_;
+        local_planner::OdomCache odom_cache_;
+        double odom_timeout_;
+
+        bool collision_check_;
+        double collision_horizon_, collision_dt_;
+        std::vector<geometry_msgs::Point> footprint_offsets_;
         ros::Publisher target_pose_pub_, curr_pose_pub;
         ros::Subscriber emergency_stop_sub_;
     };
@@ -0,0 +1,109 @@
+/***********************************************************
+ *
+ * @file: pid_controller.cpp
+ * @breif: Contains the ROS-free linear and angular PID velocity controllers
+ * @author: Yang Haodong
+ * @update: 2023-2-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2023， Yang Haodong
+ * All rights reserved.
+ * --------------------------------------------------------
+ *
+ **********************************************************/
+#include <cmath>
+
+#include "pid_controller.h"
+
+namespace pid_planner {
+/**
+ * @brief  Constructor
+ * @param  params   controller parameters
+ */
+PIDController::PIDController(const PIDParams& params) : params_(params) {
+    this->reset();
+}
+
+/**
+ * @brief  reset integral and derivative terms
+ */
+void PIDController::reset() {
+    this->error_lin_ = 0.0;
+    this->error_ang_ = 0.0;
+    this->integral_lin_ = 0.0;
+    this->integral_ang_ = 0.0;
+}
+
+/**
+ * @brief  linear velocity controller
+ * @param  vel_curr current linear velocity
+ * @param  t_x      target x in robot frame
+ * @param  t_y      target y in robot frame
+ * @return linear velocity command
+ */
+double PIDController::linear(double vel_curr, double t_x, double t_y) {
+    const PIDParams& p = this->params_;
+
+    // linear velocity of depends on the p_windows (direct relation)
+    double vel_target = std::hypot(t_x, t_y) / p.d_t;
+
+    if (std::fabs(vel_target) > p.max_vel_lin)
+        vel_target = std::copysign(p.max_vel_lin, vel_target);
+
+    double err_vel = vel_target - vel_curr;
+
+    this->integral_lin_ += err_vel * p.d_t;
+    double derivative_lin = (err_vel - this->error_lin_) / p.d_t;
+    double incr_lin = p.k_p_lin * err_vel + p.k_i_lin * this->integral_lin_ + p.k_d_lin * derivative_lin;
+    this->error_lin_ = err_vel;
+
+    if (std::fabs(incr_lin) > p.max_incr_lin)
+        incr_lin = std::copysign(p.max_incr_lin, incr_lin);
+
+    double x_velocity = vel_curr + incr_lin;
+    if (std::fabs(x_velocity) > p.max_vel_lin)
+        x_velocity = std::copysign(p.max_vel_lin, x_velocity);
+    if (std::fabs(x_velocity) < p.min_vel_lin)
+        x_velocity = std::copysign(p.min_vel_lin, x_velocity);
+
+    return x_velocity;
+}
+
+/**
+ * @brief  angular velocity controller
+ * @param  vel_ang      current angular velocity
+ * @param  target_th    target orientation
+ * @param  robot_th     robot orientation
+ * @return angular velocity command
+ */
+double PIDController::angular(double vel_ang, double target_th, double robot_th) {
+    const PIDParams& p = this->params_;
+
+    double orien_err = target_th - robot_th;
+    if (orien_err > M_PI)
+        orien_err -= (2 * M_PI);
+    if (orien_err < -M_PI)
+        orien_err += (2 * M_PI);
+
+    double target_vel_ang = orien_err / p.d_t;
+    if (std::fabs(target_vel_ang) > p.max_vel_ang)
+        target_vel_ang = std::copysign(p.max_vel_ang, target_vel_ang);
+
+    double error_ang = target_vel_ang - vel_ang;
+    this->integral_ang_ += error_ang * p.d_t;
+    double derivative_ang = (error_ang - this->error_ang_) / p.d_t;
+    double incr_ang = p.k_p_ang * error_ang + p.k_i_ang * this->integral_ang_ + p.k_d_ang * derivative_ang;
+    this->error_ang_ = error_ang;
+
+    if (std::fabs(incr_ang) > p.max_incr_ang)
+        incr_ang = std::copysign(p.max_incr_ang, incr_ang);
+
+    double th_velocity = std::copysign(vel_ang + incr_ang, target_vel_ang);
+    if (std::fabs(th_velocity) > p.max_vel_ang)
+        th_velocity = std::copysign(p.max_vel_ang, th_velocity);
+    if (std::fabs(th_velocity) < p.min_vel_ang)
+        th_velocity = std::copysign(p.min_vel_ang, th_velocity);
+
+    return th_velocity;
+}
+}
@@ -1,4 +1,5 @@
 #include "pid_planner.h"
+#include "trace.h"
 #include <pluginlib/class_list_macros.h>
 
 PLUGINLIB_EXPORT_CLASS(pid_planner::PIDPlanner, nav_core::BaseLocalPlanner)
@@ -30,29 +31,36 @@ namespace pid_planner
             // goal tolerance
             p_precision_ = 0.5;
             o_precision_ = 0.2;
+            PIDParams pid_params;
             // linear
-            max_vel_lin_ = 0.3;
-            min_vel_lin_ = 0.0;
-            max_incr_lin_ = 0.3;
+            pid_params.max_vel_lin = 0.3;
+            pid_params.min_vel_lin = 0.0;
+            pid_params.max_incr_lin = 0.3;
             // angular
-            max_vel_ang_ = 1.0;
-            min_vel_ang_ = -1.0;
-            max_incr_ang_ = 0.5;
+            pid_params.max_vel_ang = 1.0;
+            pid_params.min_vel_ang = -1.0;
+            pid_params.max_incr_ang = 0.5;
             // pid controller params
-            k_p_lin_ = 2.00;
-            k_i_lin_ = 0.04;
-            k_d_lin_ = 0.00;
+            pid_params.k_p_lin = 2.00;
+            pid_params.k_i_lin = 0.04;
+            pid_params.k_d_lin = 0.00;
 
-            k_p_ang_ = 2.00;
-            k_i_ang_ = 0.00;
-            k_d_ang_ = 0.10;
+            pid_params.k_p_ang = 2.00;
+            pid_params.k_i_ang = 0.00;
+            pid_params.k_d_ang = 0.10;
 
             // k_ = 1.0;
             // l_ = 0.5;
             // **********************************************
 
             ros::NodeHandle nh = ros::NodeHandle("~/" + name);
-            odom_helper_ = new base_local_planner::OdometryHelperRos("/odom");
+            odom_cache_.setOdomTopic("/odom");
+            nh.param("odom_timeout", odom_timeout_, 0.5);
+            // predictive collision check against the local costmap
+            nh.param("collision_check", collision_check_, true);
+            nh.param("collision_horizon", collision_horizon_, 1.0);
+            nh.param("collision_dt", collision_dt_, 0.05);
+            initFootprintOffsets();
             target_pose_pub_ = nh.advertise<geometry_msgs::PoseStamped>("/target_pose", 10);
             curr_pose_pub = nh.advertise<geometry_msgs::PoseStamped>("/current_pose", 10);
 
@@ -63,10 +71,14 @@ namespace pid_planner
             robot_curr_pose[1] = 0.0;
             robot_curr_pose[2] = 0.0;
             robot_curr_orien = 0.0;
+            robot_cos_ = 1.0;
+            robot_sin_ = 0.0;
 
             double controller_freqency;
             nh.param("/move_base/controller_frequency", controller_freqency, 10.0);
             d_t_ = 1 / controller_freqency;
+            pid_params.d_t = d_t_;
+            pid_.setParams(pid_params);
             ROS_INFO("PID planner initialized!");
         }
         else
@@ -89,75 +101,24 @@ namespace pid_planner
         plan_index_ = 0;
         goal_reached_ = false;
 
+        // get final goal orientation - Quaternion to Euler
+        if (!global_plan_.empty())
+            final_orientation = getEulerAngles(global_plan_.back());
+
         // NOTE: should reset pid, but the global planner update too frequently, so descard these.
-        // integral_lin_ = 0.0;
-        // integral_ang_ = 0.0;
-        // error_lin_ = 0.0;
-        // error_ang_ = 0.0;
+        // pid_.reset();
 
         return true;
     }
 
-    double PIDPlanner::LinearPIDController(nav_msgs::Odometry &base_odometry, double next_t_x, double next_t_y)
+    double PIDPlanner::LinearPIDController(const local_planner::OdomState &base_odometry, double next_t_x, double next_t_y)
     {
-        double vel_curr = hypot(base_odometry.twist.twist.linear.y, base_odometry.twist.twist.linear.x);
-
-        // linear velocity of depends on the p_windows (direct relation)
-        double vel_target = hypot(next_t_x, next_t_y) / d_t_;
-
-        if (fabs(vel_target) > max_vel_lin_)
-            vel_target = copysign(max_vel_lin_, vel_target);
-
-        double err_vel = vel_target - vel_curr;
-
-        integral_lin_ += err_vel * d_t_;
-        double derivative_lin = (err_vel - error_lin_) / d_t_;
-        double incr_lin = k_p_lin_ * err_vel + k_i_lin_ * integral_lin_ + k_d_lin_ * derivative_lin;
-        error_lin_ = err_vel;
-
-        if (fabs(incr_lin) > max_incr_lin_)
-            incr_lin = copysign(max_incr_lin_, incr_lin);
-
-        double x_velocity = vel_curr + incr_lin;
-        if (fabs(x_velocity) > max_vel_lin_)
-            x_velocity = copysign(max_vel_lin_, x_velocity);
-        if (fabs(x_velocity) < min_vel_lin_)
-            x_velocity = copysign(min_vel_lin_, x_velocity);
-
-        return x_velocity;
+        return pid_.linear(hypot(base_odometry.vy, base_odometry.vx), next_t_x, next_t_y);
     }
 
-    double PIDPlanner::AngularPIDController(nav_msgs::Odometry &base_odometry, double target_th_w, double robot_orien)
+    double PIDPlanner::AngularPIDController(const local_planner::OdomState &base_odometry, double target_th_w, double robot_orien)
     {
-        double orien_err = target_th_w - robot_orien;
-        if (orien_err > M_PI)
-            orien_err -= (2 * M_PI);
-        if (orien_err < -M_PI)
-            orien_err += (2 * M_PI);
-
-        double target_vel_ang = orien_err / d_t_;
-        if (fabs(target_vel_ang) > max_vel_ang_)
-            target_vel_ang = copysign(max_vel_ang_, target_vel_ang);
-
-        double vel_ang = base_odometry.twist.twist.angular.z;
-        double error_ang = target_vel_ang - vel_ang;
-        integral_ang_ += error_ang * d_t_;
-        double derivative_ang = (error_ang - error_ang_) / d_t_;
-        double incr_ang = k_p_ang_ * error_ang + k_i_ang_ * integral_ang_ + k_d_ang_ * derivative_ang;
-        error_ang_ = error_ang;
-
-        if (fabs(incr_ang) > max_incr_ang_)
-            incr_ang = copysign(max_incr_ang_, incr_ang);
-
-        double th_velocity = copysign(vel_ang + incr_ang, target_vel_ang);
-        if (fabs(th_velocity) > max_vel_ang_)
-            th_velocity = copysign(max_vel_ang_, th_velocity);
-        if (fabs(th_velocity) < min_vel_ang_)
-            th_velocity = copysign(min_vel_ang_, th_velocity);
-
-        // ROS_INFO("orien_err: %lf, target_vel_ang: %lf, vel_ang: %lf, th_velocity: %lf", orien_err, target_vel_ang, vel_ang, th_velocity);
-
-        return th_velocity;
+        return pid_.angular(base_odometry.wz, target_th_w, robot_orien);
     }
 
     // void PIDPlanner::controller(double x, double y, double theta, double x_d, double y_d, geometry_msgs::Twist &cmd_vel)
@@ -173,8 +134,170 @@ namespace pid_planner
     //     cmd_vel.angular.z = v_w(1);
     // }
 
+    void PIDPlanner::initFootprintOffsets()
+    {
+        footprint_offsets_.clear();
+        std::vector<geometry_msgs::Point> footprint = costmap_ros_->getRobotFootprint();
+        if (footprint.empty())
+            return;
+
+        double resolution = costmap_ros_->getCostmap()->getResolution();
+
+        // polygon edges
+        for (size_t i = 0; i < footprint.size(); i++)
+        {
+            const geometry_msgs::Point &p1 = footprint[i];
+            const geometry_msgs::Point &p2 = footprint[(i + 1) % footprint.size()];
+            int n_step = std::max(1, (int)ceil(hypot(p2.x - p1.x, p2.y - p1.y) / resolution));
+            for (int j = 0; j < n_step; j++)
+            {
+                geometry_msgs::Point p;
+                p.x = p1.x + (p2.x - p1.x) * j / n_step;
+                p.y = p1.y + (p2.y - p1.y) * j / n_step;
+                footprint_offsets_.push_back(p);
+            }
+        }
+
+        // polygon interior, so that obstacles smaller than the footprint are caught as well
+        double min_x = footprint[0].x, max_x = footprint[0].x, min_y = footprint[0].y, max_y = footprint[0].y;
+        for (const auto &p : footprint)
+        {
+            min_x = std::min(min_x, p.x);
+            max_x = std::max(max_x, p.x);
+            min_y = std::min(min_y, p.y);
+            max_y = std::max(max_y, p.y);
+        }
+        for (double x = min_x + resolution; x < max_x; x += resolution)
+        {
+            for (double y = min_y + resolution; y < max_y; y += resolution)
+            {
+                bool inside = false;
+                for (size_t i = 0, j = footprint.size() - 1; i < footprint.size(); j = i++)
+                {
+                    if ((footprint[i].y > y) != (footprint[j].y > y) &&
+                        x < (footprint[j].x - footprint[i].x) * (y - footprint[i].y) / (footprint[j].y - footprint[i].y) + footprint[i].x)
+                        inside = !inside;
+                }
+                if (inside)
+                {
+                    geometry_msgs::Point p;
+                    p.x = x;
+                    p.y = y;
+                    footprint_offsets_.push_back(p);
+                }
+            }
+        }
+    }
+
+    bool PIDPlanner::checkCollision(const local_planner::OdomState &odom, geometry_msgs::Twist &cmd_vel)
+    {
+        if (!collision_check_ || footprint_offsets_.empty())
+            return true;
+
+        // the local costmap is expressed in the odometry frame, otherwise one extra lookup is needed
+        double x = odom.x, y = odom.y, theta = odom.theta;
+        std::string odom_frame = odom_cache_.getOdomFrame(), costmap_frame = costmap_ros_->getGlobalFrameID();
+        if (!odom_frame.empty() && odom_frame[0] == '/')
+            odom_frame.erase(0, 1);
+        if (!costmap_frame.empty() && costmap_frame[0] == '/')
+            costmap_frame.erase(0, 1);
+        if (odom_frame != costmap_frame)
+        {
+            geometry_msgs::PoseStamped global_pose;
+            if (!costmap_ros_->getRobotPose(global_pose))
+                return true;
+            x = global_pose.pose.position.x;
+            y = global_pose.pose.position.y;
+            theta = tf2::getYaw(global_pose.pose.orientation);
+        }
+
+        costmap_2d::Costmap2D *costmap = costmap_ros_->getCostmap();
+        double v = cmd_vel.linear.x, w = cmd_vel.angular.z;
+        int n_step = (int)ceil(collision_horizon_ / collision_dt_);
+        double t_free = collision_horizon_;
+
+        for (int i = 0; i <= n_step; i++)
+        {
+            double c = cos(theta), s = sin(theta);
+            bool collision = false;
+            for (const auto &p : footprint_offsets_)
+            {
+                unsigned int mx, my;
+                if (costmap->worldToMap(x + c * p.x - s * p.y, y + s * p.x + c * p.y, mx, my) &&
+                    costmap->getCost(mx, my) == costmap_2d::LETHAL_OBSTACLE)
+                {
+                    collision = true;
+                    break;
+                }
+            }
+            if (collision)
+            {
+                t_free = (i - 1) * collision_dt_;
+                break;
+            }
+
+            x += v * c * collision_dt_;
+            y += v * s * collision_dt_;
+            theta += w * collision_dt_;
+        }
+
+        // already in collision, stop and let move_base recover
+        if (t_free < 0)
+        {
+            ROS_WARN_THROTTLE(1.0, "PID planner: robot footprint is in collision, stopping.");
+            cmd_vel.linear.x = 0.0;
+            cmd_vel.angular.z = 0.0;
+            return false;
+        }
+
+        // scaling (v, w) together keeps the same arc, so the scaled command
+        // only reaches the first colliding pose at the end of the horizon
+        if (t_free < collision_horizon_)
+        {
+            double scale = t_free / collision_horizon_;
+            ROS_DEBUG("PID planner: collision predicted in %.2f s, scaling command by %.2f", t_free + collision_dt_, scale);
+            cmd_vel.linear.x *= scale;
+            cmd_vel.angular.z *= scale;
+            // the collision is within the first step, the robot is stopped rather than slowed down
+            if (scale <= 0.0)
+            {
+                ROS_WARN_THROTTLE(1.0, "PID planner: collision predicted within %.2f s, stopping.", collision_dt_);
+                cmd_vel.linear.x = 0.0;
+                cmd_vel.angular.z = 0.0;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PIDPlanner::updateRobotState()
+    {
+        TRACE_SCOPE("PIDPlanner::updateRobotState");
+        // robot pose expressed in the plan frame, so plan poses only need plain 2D math afterwards
+        geometry_msgs::TransformStamped plan_to_base;
+        try
+        {
+            plan_to_base = tf_->lookupTransform(global_plan_.front().header.frame_id, base_frame_, ros::Time(0));
+        }
+        catch (tf2::TransformException &ex)
+        {
+            ROS_ERROR("PID planner could not transform plan into %s: %s", base_frame_.c_str(), ex.what());
+            return false;
+        }
+
+        robot_curr_pose[0] = plan_to_base.transform.translation.x;
+        robot_curr_pose[1] = plan_to_base.transform.translation.y;
+        robot_curr_pose[2] = plan_to_base.transform.translation.z;
+        robot_curr_orien = tf2::getYaw(plan_to_base.transform.rotation);
+        robot_cos_ = cos(robot_curr_orien);
+        robot_sin_ = sin(robot_curr_orien);
+
+        return true;
+    }
+
     bool PIDPlanner::computeVelocityCommands(geometry_msgs::Twist &cmd_vel)
     {
+        TRACE_SCOPE("PIDPlanner::computeVelocityCommands");
         if (!initialized_)
         {
             ROS_ERROR("PID planner has not been initialized");
@@ -187,6 +310,27 @@ namespace pid_planner
             return true;
         }
 
+        if (global_plan_.empty())
+        {
+            ROS_ERROR("PID planner received an empty plan.");
+            return false;
+        }
+
+        // per-cycle state snapshot: a single transform lookup and a single odometry read
+        if (!updateRobotState())
+            return false;
+
+        // odometry observation - getting robot velocities in robot frame
+        local_planner::OdomState base_odom;
+        if (!odom_cache_.getState(base_odom))
+        {
+            ROS_WARN_THROTTLE(1.0, "PID planner has not received any odometry yet.");
+            return false;
+        }
+        double odom_age = (ros::Time::now() - base_odom.stamp).toSec();
+        if (odom_age > odom_timeout_)
+            ROS_WARN_THROTTLE(1.0, "PID planner odometry is %.3f s old.", odom_age);
+
         // next target
         geometry_msgs::PoseStamped target;
         geometry_msgs::PoseStamped curr_pose;
@@ -204,49 +348,28 @@ namespace pid_planner
                            (global_plan_[next_plan_index].pose.position.x -
                             global_plan_[plan_index_].pose.position.x)); // [-pi, pi]
 
-            // tf::Quaternion th_target_quat = tf::createQuaternionFromYaw(t_th_w);
-            tf2::Quaternion th_target_quat;
-            th_target_quat.setRPY(0, 0, t_th_w);
-            tf2::convert(th_target_quat, target.pose.orientation);
-            // target.pose.orientation.x = th_target_quat[0];
-            // target.pose.orientation.y = th_target_quat[1];
-            // target.pose.orientation.z = th_target_quat[2];
-            // target.pose.orientation.w = th_target_quat[3];
             // transform from map into base_frame
-            getTransformedPosition(target, &t_x, &t_y, &t_th);
+            double dx = target.pose.position.x - robot_curr_pose[0];
+            double dy = target.pose.position.y - robot_curr_pose[1];
+            t_x = robot_cos_ * dx + robot_sin_ * dy;
+            t_y = -robot_sin_ * dx + robot_cos_ * dy;
+            t_th = angles::normalize_angle(t_th_w - robot_curr_orien);
 
             if (hypot(t_x, t_y) > p_window_ || fabs(t_th) > o_window_)
                 break;
             plan_index_++;
         }
 
+        // tf::Quaternion th_target_quat = tf::createQuaternionFromYaw(t_th_w);
+        tf2::Quaternion th_target_quat;
+        th_target_quat.setRPY(0, 0, t_th_w);
+        tf2::convert(th_target_quat, target.pose.orientation);
+
         if (plan_index_ >= global_plan_.size() - 1)
         {
             getTransformedPosition(global_plan_.back(), &t_x, &t_y, &t_th);
         }
 
-        // invoking robot pose and orientaiton
-        geometry_msgs::PoseStamped global_pose;
-        costmap_ros_->getRobotPose(global_pose);
-
-        // robot_curr_pose = global_pose.getOrigin();
-        robot_curr_pose[0] = global_pose.pose.position.x;
-        robot_curr_pose[1] = global_pose.pose.position.y;
-        robot_curr_pose[2] = global_pose.pose.position.z;
-
-        // robot_curr_orien = tf::getYaw(global_pose.getRotation());
-        robot_curr_orien = tf2::getYaw(global_pose.pose.orientation);
-        // tf2::Quaternion q(global_pose.pose.orientation.x, global_pose.pose.orientation.y,
-        //                   global_pose.pose.orientation.z, global_pose.pose.orientation.w);
-        // robot_curr_orien = q.getAngle(); // [0, 2pi]
-
-        // odometry observation - getting robot velocities in robot frame
-        nav_msgs::Odometry base_odom;
-        odom_helper_->getOdom(base_odom);
-
-        // get final goal orientation - Quaternion to Euler
-        final_orientation = getEulerAngles(global_plan_.back());
-
         // controller(robot_curr_pose[0], robot_curr_pose[1], robot_curr_orien, target.pose.position.x, target.pose.position.y, cmd_vel);
 
         if (getGoalPositionDistance(global_plan_.back(), robot_curr_pose[0], robot_curr_pose[1]) <= p_precision_)
@@ -284,14 +407,18 @@ namespace pid_planner
             cmd_vel.angular.z = th_vel;
         }
 
+        // slow down in this cycle if the command is predicted to collide
+        bool collision_free = checkCollision(base_odom, cmd_vel);
+
         // publish next target pose
+        ros::Time now = ros::Time::now();
         target.header.frame_id = "/map";
-        target.header.stamp = ros::Time::now();
+        target.header.stamp = now;
         target_pose_pub_.publish(target);
 
         // publish robot pose
         curr_pose.header.frame_id = "/map";
-        curr_pose.header.stamp = ros::Time::now();
+        curr_pose.header.stamp = now;
 
         // tf::Quaternion curr_orien_quat = tf::createQuaternionFromYaw(robot_curr_orien);
         tf2::Quaternion curr_orien_quat;
@@ -305,7 +432,7 @@ namespace pid_planner
         curr_pose.pose.orientation.w = curr_orien_quat[3];
         curr_pose_pub.publish(curr_pose);
 
-        return true;
+        return collision_free;
     }
 
     bool PIDPlanner::isGoalReached()
@@ -14,6 +14,7 @@
 #ifndef RRT_H
 #define RRT_H
 
+#include <random>
 #include <tuple>
 #include <unordered_map>
 
@@ -45,6 +46,11 @@ class RRT : public global_planner::GlobalPlanner {
      */
     std::tuple<bool, std::vector<Node>> plan(const unsigned char* costs, const Node& start,
                                              const Node& goal, std::vector<Node> &expand);
+    /**
+     * @brief  seed the random sampling, the same seed and costmap give the same path
+     * @param  seed random seed
+     */
+    void setSeed(unsigned int seed);
 
 
   protected:
@@ -99,6 +105,8 @@ class RRT : public global_planner::GlobalPlanner {
     int sample_num_;
     // max distance threshold
     double max_dist_;
+    // random number generator of the samples
+    std::mt19937 eng_;
 };
 }
 #endif  // RRT_H
@@ -19,11 +19,16 @@
 #include <nav_msgs/GetPlan.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/Point.h>
+#include <std_srvs/Trigger.h>
 #include <std_msgs/ColorRGBA.h>
 #include <std_msgs/Header.h>
 #include <visualization_msgs/Marker.h>
 
+#include "costmap_snapshot.h"
 #include "global_planner.h"
+#include "plan_log.h"
+#include "planner_pool.h"
+#include "trace.h"
 
 namespace sample_planner {
 class SamplePlanner : public nav_core::BaseGlobalPlanner {
@@ -82,6 +87,12 @@ class SamplePlanner : public nav_core::BaseGlobalPlanner {
          * @param  resp response from server
          */
         bool makePlanService(nav_msgs::GetPlan::Request& req, nav_msgs::GetPlan::Response& resp);
+        /**
+         * @brief  dump the trace events recorded since the last dump as Chrome trace JSON
+         * @param  req  request from client
+         * @param  resp response from server, with the trace file in the message
+         */
+        bool dumpTraceService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& resp);
 
 
     protected:
@@ -93,16 +104,24 @@ class SamplePlanner : public nav_core::BaseGlobalPlanner {
         ros::Publisher plan_pub_;
         // initialization flag
         bool initialized_;
-        // global graph planner
-        global_planner::GlobalPlanner* g_planner_;
+        // workspaces of the global sample planner, one per concurrent makePlan call
+        global_planner::PlannerPool planner_pool_;
+        // copy-on-write mirror of the costmap, workspaces refresh only the tiles that changed
+        global_planner::TiledCostmap costmap_tiles_;
+        // log of the searches, for offline replay
+        global_planner::PlanLogWriter plan_log_;
+        // planner name
+        std::string planner_name_;
         // nodes explorer publisher
         ros::Publisher expand_pub_;
         // planning service
         ros::ServiceServer make_plan_srv_;
+        // trace dump service
+        ros::ServiceServer dump_trace_srv_;
+        // trace dump file
+        std::string trace_file_;
 
     private:
-        // thread mutex
-        boost::mutex mutex_;
         // offset of transform from world(x,y) to grid map(x,y)
         double convert_offset_;
         // tolerance
@@ -119,9 +138,35 @@ class SamplePlanner : public nav_core::BaseGlobalPlanner {
         double sample_max_d_;
         // optimization r
         double opt_r_;
+        // maximum number of concurrent makePlan calls
+        int max_concurrent_plans_;
 
 
     protected:
+        /**
+         * @brief  create a planner instance for a new workspace
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  resolution   costmap resolution
+         * @return planner, NULL if the planner name is unknown
+         */
+        global_planner::GlobalPlanner* _createPlanner(int nx, int ny, double resolution);
+        /**
+         * @brief  append a search to the request log
+         * @param  costs        costmap the planner searched
+         * @param  nx           pixel number in costmap x direction
+         * @param  ny           pixel number in costmap y direction
+         * @param  start        start node
+         * @param  goal         goal node
+         * @param  path_found   whether a path was found
+         * @param  path         path, goal first
+         * @param  expand_num   number of expanded nodes
+         * @param  plan_time    search time in seconds
+         * @param  seed         random seed the search was started with
+         */
+        void _recordRequest(const unsigned char* costs, int nx, int ny, const Node& start, const Node& goal,
+                            bool path_found, const std::vector<Node>& path,
+                            size_t expand_num, double plan_time, uint32_t seed);
         /**
          * @brief  Inflate the boundary of costmap into obstacles to prevent cross planning
          * @param  costarr  costmap pointer
@@ -131,9 +176,10 @@ class SamplePlanner : public nav_core::BaseGlobalPlanner {
         void _outlineMap(unsigned char* costarr, int nx, int ny);
         /**
          * @brief  publish expand zone
+         * @param  planner planner that expanded the nodes, for index conversion
          * @param  expand  set of expand nodes
          */
-        void _publishExpand(std::vector<Node> &expand);
+        void _publishExpand(global_planner::GlobalPlanner* planner, std::vector<Node> &expand);
         /**
          * @brief  calculate plan from planning path
          * @param  path path generated by global planner
@@ -159,12 +205,14 @@ class SamplePlanner : public nav_core::BaseGlobalPlanner {
         bool _worldToMap(double wx, double wy, double& mx, double& my);
         /**
          *  @brief Publishes a Marker msg with two points in Rviz
+         *  @param planner  planner that expanded the nodes, for index conversion
          *  @param line_msg Pointer to existing marker object.
          *  @param line_pub Pointer to existing marker Publisher.
          *  @param id first marker id
          *  @param pid second marker id
          */
-        void _pubLine(visualization_msgs::Marker* line_msg, ros::Publisher* line_pub, int id, int pid);
+        void _pubLine(global_planner::GlobalPlanner* planner, visualization_msgs::Marker* line_msg,
+                      ros::Publisher* line_pub, int id, int pid);
         void _pubGeometry(ros::Publisher* pub);
 };
 }
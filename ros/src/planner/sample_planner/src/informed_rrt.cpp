@@ -15,6 +15,7 @@
 #include <random>
 
 #include "informed_rrt.h"
+#include "trace.h"
 
 namespace rrt_planner {
     /**
@@ -37,6 +38,7 @@ namespace rrt_planner {
      */
     std::tuple<bool, std::vector<Node>> InformedRRT::plan(const unsigned char* costs, const Node& start,
                                                   const Node& goal, std::vector<Node> &expand) {
+        TRACE_SCOPE("InformedRRT::plan");
         // initialization
         this->c_best_ = std::numeric_limits<double>::max();
         this->c_min_ = this->_dist(start, goal);
@@ -51,7 +53,7 @@ namespace rrt_planner {
         
         // main loop
         int iteration = 0;
-        while (iteration < this->sample_num_) {
+        while (iteration < this->sample_num_ && !this->_isCanceled()) {
             iteration++;
 
             // generate a random node in the map
@@ -105,12 +107,10 @@ namespace rrt_planner {
             while (true) {
                 // unit ball sample
                 double x, y;
-                std::random_device rd;
-                std::mt19937 eng(rd());
                 std::uniform_real_distribution<float> p(-1, 1);
                 while (true) {
-                    x = p(eng);
-                    y = p(eng);
+                    x = p(this->eng_);
+                    y = p(this->eng_);
                     if (x * x + y * y < 1)
                         break;
                 }
@@ -15,6 +15,7 @@
 #include <random>
 
 #include "rrt.h"
+#include "trace.h"
 
 namespace rrt_planner {
     /**
@@ -25,7 +26,15 @@ namespace rrt_planner {
      * @param   max_dist    max distance between sample points
      */
     RRT::RRT(int nx, int ny, double resolution, int sample_num, double max_dist)
-      : GlobalPlanner(nx, ny, resolution), sample_num_(sample_num), max_dist_(max_dist) {}
+      : GlobalPlanner(nx, ny, resolution), sample_num_(sample_num), max_dist_(max_dist), eng_(std::random_device{}()) {}
+
+    /**
+     * @brief  seed the random sampling, the same seed and costmap give the same path
+     * @param  seed random seed
+     */
+    void RRT::setSeed(unsigned int seed) {
+      this->eng_.seed(seed);
+    }
 
     /**
      * @brief RRT implementation
@@ -37,6 +46,7 @@ namespace rrt_planner {
      */
     std::tuple<bool, std::vector<Node>> RRT::plan(const unsigned char* costs, const Node& start,
                                                   const Node& goal, std::vector<Node> &expand) {
+      TRACE_SCOPE("RRT::plan");
       this->sample_list_.clear();
       // copy
       this->start_ = start, this->goal_ = goal;
@@ -46,7 +56,7 @@ namespace rrt_planner {
       
       // main loop
       int iteration = 0;
-      while (iteration < this->sample_num_) {
+      while (iteration < this->sample_num_ && !this->_isCanceled()) {
         // generate a random node in the map
         Node sample_node = this->_generateRandomNode();
 
@@ -82,17 +92,13 @@ namespace rrt_planner {
      * @return Generated node
      */
     Node RRT::_generateRandomNode() {
-      // obtain a random number from hardware
-      std::random_device rd;
-      // seed the generator
-      std::mt19937 eng(rd());
       // define the range
       std::uniform_real_distribution<float> p(0, 1);
       // heuristic
-      if (p(eng) > 0.05) {
+      if (p(this->eng_) > 0.05) {
         // generate node
         std::uniform_int_distribution<int> distr(0, this->ns_ - 1);
-        const int id = distr(eng);
+        const int id = distr(this->eng_);
         int x, y;
         this->index2Grid(id, x, y);
         return Node(x, y, 0, 0, id, 0);
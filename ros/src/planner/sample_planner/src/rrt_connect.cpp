@@ -14,6 +14,7 @@
 #include <cmath>
 
 #include "rrt_connect.h"
+#include "trace.h"
 
 namespace rrt_planner {
     /**
@@ -36,6 +37,7 @@ namespace rrt_planner {
      */
     std::tuple<bool, std::vector<Node>> RRTConnect::plan(const unsigned char* costs, const Node& start,
                                                   const Node& goal, std::vector<Node> &expand) {
+      TRACE_SCOPE("RRTConnect::plan");
       this->sample_list_f_.clear();
       this->sample_list_b_.clear();
       // copy
@@ -48,7 +50,7 @@ namespace rrt_planner {
       
       // main loop
       int iteration = 0;
-      while (iteration < this->sample_num_) {
+      while (iteration < this->sample_num_ && !this->_isCanceled()) {
         // generate a random node in the map
         Node sample_node = this->_generateRandomNode();
 
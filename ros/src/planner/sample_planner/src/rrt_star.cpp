@@ -15,6 +15,7 @@
 #include <random>
 
 #include "rrt_star.h"
+#include "trace.h"
 
 namespace rrt_planner {
     /**
@@ -38,6 +39,7 @@ namespace rrt_planner {
      */
     std::tuple<bool, std::vector<Node>> RRTStar::plan(const unsigned char* costs, const Node& start,
                                                       const Node& goal, std::vector<Node> &expand) {
+      TRACE_SCOPE("RRTStar::plan");
       this->sample_list_.clear();
       // copy
       this->start_ = start, this->goal_ = goal;
@@ -47,7 +49,7 @@ namespace rrt_planner {
       
       // main loop
       int iteration = 0;
-      while (iteration < this->sample_num_) {
+      while (iteration < this->sample_num_ && !this->_isCanceled()) {
         // generate a random node in the map
         Node sample_node = this->_generateRandomNode();
 
@@ -12,7 +12,9 @@
  *
  **********************************************************/
 #include <pluginlib/class_list_macros.h>
+#include <chrono>
 #include <cmath>
+#include <random>
 
 #include "sample_planner.h"
 #include "rrt.h"
@@ -27,7 +29,7 @@ namespace sample_planner {
      * @brief  Constructor(default)
      */
     SamplePlanner::SamplePlanner() :
-            costmap_(NULL), initialized_(false), g_planner_(NULL){ }
+            costmap_(NULL), initialized_(false){ }
     /**
      * @brief  Constructor
      * @param  name     planner name
@@ -44,8 +46,7 @@ namespace sample_planner {
      * @details default
      */
     SamplePlanner::~SamplePlanner() {
-        if (g_planner_)
-            delete g_planner_;
+        // workspaces are released by the pool
     }
 
 
@@ -93,20 +94,25 @@ namespace sample_planner {
             private_nh.param("sample_max_d", this->sample_max_d_, 5.0);
             // optimization radius
             private_nh.param("optimization_r", this->opt_r_, 10.0);
+            // move_base planning and the make_plan service may plan at the same time
+            private_nh.param("max_concurrent_plans", this->max_concurrent_plans_, 2);
 
+            // trace points (built with PLANNER_TRACING), dumped by the dump_trace service
+            bool tracing;
+            private_nh.param("tracing", tracing, false);
+            private_nh.param("trace_file", this->trace_file_, (std::string)"/tmp/planner_trace.json");
+            global_planner::Tracer::setEnabled(tracing);
             // planner name
-            std::string planner_name; 
-            private_nh.param("planner_name", planner_name, (std::string)"rrt");
-            if (planner_name == "rrt")
-                this->g_planner_ = new rrt_planner::RRT(nx, ny, resolution, this->sample_points_, this->sample_max_d_);
-            else if (planner_name == "rrt_star")
-                this->g_planner_ = new rrt_planner::RRTStar(nx, ny, resolution, this->sample_points_, this->sample_max_d_, this->opt_r_);
-            else if (planner_name == "rrt_connect")
-                this->g_planner_ = new rrt_planner::RRTConnect(nx, ny, resolution, this->sample_points_, this->sample_max_d_);
-            else if (planner_name == "informed_rrt")
-                this->g_planner_ = new rrt_planner::InformedRRT(nx, ny, resolution, this->sample_points_, this->sample_max_d_, this->opt_r_);
+            private_nh.param("planner_name", this->planner_name_, (std::string)"rrt");
+            // append every search to a log that plan_replay feeds through the planners offline, empty to disable
+            std::string record_log;
+            private_nh.param("record_log", record_log, (std::string)"");
+            if (!record_log.empty() && !this->plan_log_.open(record_log))
+                ROS_WARN("Failed to open the planning request log %s", record_log.c_str());
+            this->planner_pool_.reset([this, nx, ny, resolution]() { return this->_createPlanner(nx, ny, resolution); },
+                                      this->max_concurrent_plans_);
 
-            ROS_INFO("Using global sample planner: %s", planner_name.c_str());
+            ROS_INFO("Using global sample planner: %s", this->planner_name_.c_str());
 
             /*====================== register topics and services =======================*/
             // register planning publisher
@@ -115,6 +121,8 @@ namespace sample_planner {
             this->expand_pub_ = private_nh.advertise<visualization_msgs::Marker>("tree", 1);
             // register planning service
             this->make_plan_srv_ = private_nh.advertiseService("make_plan", &SamplePlanner::makePlanService, this);
+            // register trace dump service
+            this->dump_trace_srv_ = private_nh.advertiseService("dump_trace", &SamplePlanner::dumpTraceService, this);
   
             // set initialization flag
             this->initialized_ = true;
@@ -135,12 +143,11 @@ namespace sample_planner {
     }
     bool SamplePlanner::makePlan(const geometry_msgs::PoseStamped& start, const geometry_msgs::PoseStamped& goal, double tolerance,
                 std::vector<geometry_msgs::PoseStamped>& plan) {
-                    // start thread mutex
-        boost::mutex::scoped_lock lock(this->mutex_);
         if (!this->initialized_) {
             ROS_ERROR("This planner has not been initialized yet, but it is being used, please call initialize() before use");
             return false;
         }
+        TRACE_SCOPE("SamplePlanner::makePlan");
         // clear existing plan
         plan.clear();
         // get costmap size
@@ -170,23 +177,49 @@ namespace sample_planner {
             ROS_WARN_THROTTLE(1.0, "The goal sent to the global planner is off the global costmap. Planning will always fail to this goal.");
             return false;
         }
+        // borrow a workspace, the search state is private to this call
+        global_planner::PlannerPool::Handle ws = this->planner_pool_.acquire();
+        if (!ws->planner) {
+            ROS_ERROR("Unknown global sample planner: %s", this->planner_name_.c_str());
+            return false;
+        }
+
         // tranform from costmap to grid map
         int g_start_x, g_start_y, g_goal_x, g_goal_y;
-        this->g_planner_->map2Grid(m_start_x, m_start_y, g_start_x, g_start_y);
-        this->g_planner_->map2Grid(m_goal_x, m_goal_y, g_goal_x, g_goal_y);
-        Node n_start(g_start_x, g_start_y, 0, 0, this->g_planner_->grid2Index(g_start_x, g_start_y), 0);
-        Node n_goal(g_goal_x, g_goal_y, 0, 0, this->g_planner_->grid2Index(g_goal_x, g_goal_y), 0);
-        
-        // clear the cost of robot location
-        this->costmap_->setCost(g_start_x, g_start_y, costmap_2d::FREE_SPACE);
+        ws->planner->map2Grid(m_start_x, m_start_y, g_start_x, g_start_y);
+        ws->planner->map2Grid(m_goal_x, m_goal_y, g_goal_x, g_goal_y);
+        Node n_start(g_start_x, g_start_y, 0, 0, ws->planner->grid2Index(g_start_x, g_start_y), 0);
+        Node n_goal(g_goal_x, g_goal_y, 0, 0, ws->planner->grid2Index(g_goal_x, g_goal_y), 0);
+
+        // snapshot the costmap, the only shared state. Its lock is held only for a flat copy, only tiles
+        // changed since the last snapshot are copied, and the search below runs while costmap updates continue.
+        global_planner::CostmapSnapshot snapshot;
+        {
+            TRACE_SCOPE("SamplePlanner::snapshot");
+            snapshot = this->costmap_tiles_.update(this->costmap_->getCharMap(), nx, ny,
+                                                   *(this->costmap_->getMutex()));
+        }
+        snapshot.copyTo(ws->costs, ws->tile_versions);
+
+        // clear the cost of robot location, in the workspace copy only
+        ws->costs[ws->planner->grid2Index(g_start_x, g_start_y)] = costmap_2d::FREE_SPACE;
+        snapshot.invalidate(ws->tile_versions, g_start_x, g_start_y);
 
         // outline the map
         if(this->is_outline_)
-            this->_outlineMap(this->costmap_->getCharMap(), nx, ny);
+            this->_outlineMap(ws->costs.data(), nx, ny);
 
-        // calculate path
+        // calculate path, with a seed the log can reproduce the samples from
+        bool is_record = this->plan_log_.isOpen();
+        uint32_t seed = is_record ? std::random_device{}() : 0;
+        if (is_record)
+            static_cast<rrt_planner::RRT*>(ws->planner.get())->setSeed(seed);
         std::vector<Node> expand;
-        const auto [path_found, path] = this->g_planner_->plan(this->costmap_->getCharMap(), n_start, n_goal, expand);
+        auto t0 = std::chrono::steady_clock::now();
+        const auto [path_found, path] = ws->planner->plan(ws->costs.data(), n_start, n_goal, expand);
+        if (is_record)
+            this->_recordRequest(ws->costs.data(), nx, ny, n_start, n_goal, path_found, path, expand.size(),
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count(), seed);
 
         if (path_found) {
             if (this->_getPlanFromPath(path, plan)) {
@@ -199,7 +232,7 @@ namespace sample_planner {
         else  ROS_ERROR("Failed to get a path.");
         // publish expand zone
         if(this->is_expand_)
-            this->_publishExpand(expand);
+            this->_publishExpand(ws->planner.get(), expand);
 
         // publish visulization plan
         this->publishPlan(plan);
@@ -210,6 +243,7 @@ namespace sample_planner {
      * @param  path planning path
      */
     void SamplePlanner::publishPlan(const std::vector<geometry_msgs::PoseStamped>& plan) {
+        TRACE_SCOPE("SamplePlanner::publishPlan");
         if (!this->initialized_) {
             ROS_ERROR("This planner has not been initialized yet, but it is being used, please call initialize() before use");
             return;
@@ -223,6 +257,21 @@ namespace sample_planner {
         // publish plan to rviz
         this->plan_pub_.publish(gui_plan);
     }
+    /**
+     * @brief  dump the trace events recorded since the last dump as Chrome trace JSON
+     * @param  req  request from client
+     * @param  resp response from server, with the trace file in the message
+     */
+    bool SamplePlanner::dumpTraceService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& resp) {
+        size_t events = 0;
+        resp.success = global_planner::Tracer::writeChromeTrace(this->trace_file_, events);
+        if (resp.success) {
+            global_planner::Tracer::clear();
+            resp.message = std::to_string(events) + " trace events written to " + this->trace_file_;
+        } else
+            resp.message = "Failed to write " + this->trace_file_;
+        return true;
+    }
     /**
      * @brief  regeister planning service
      * @param  req  request from client
@@ -236,6 +285,61 @@ namespace sample_planner {
     }
 
 
+    /**
+     * @brief  create a planner instance for a new workspace
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  resolution   costmap resolution
+     * @return planner, NULL if the planner name is unknown
+     */
+    global_planner::GlobalPlanner* SamplePlanner::_createPlanner(int nx, int ny, double resolution) {
+        if (this->planner_name_ == "rrt")
+            return new rrt_planner::RRT(nx, ny, resolution, this->sample_points_, this->sample_max_d_);
+        else if (this->planner_name_ == "rrt_star")
+            return new rrt_planner::RRTStar(nx, ny, resolution, this->sample_points_, this->sample_max_d_, this->opt_r_);
+        else if (this->planner_name_ == "rrt_connect")
+            return new rrt_planner::RRTConnect(nx, ny, resolution, this->sample_points_, this->sample_max_d_);
+        else if (this->planner_name_ == "informed_rrt")
+            return new rrt_planner::InformedRRT(nx, ny, resolution, this->sample_points_, this->sample_max_d_, this->opt_r_);
+        return NULL;
+    }
+    /**
+     * @brief  append a search to the request log
+     * @param  costs        costmap the planner searched
+     * @param  nx           pixel number in costmap x direction
+     * @param  ny           pixel number in costmap y direction
+     * @param  start        start node
+     * @param  goal         goal node
+     * @param  path_found   whether a path was found
+     * @param  path         path, goal first
+     * @param  expand_num   number of expanded nodes
+     * @param  plan_time    search time in seconds
+     * @param  seed         random seed the search was started with
+     */
+    void SamplePlanner::_recordRequest(const unsigned char* costs, int nx, int ny, const Node& start, const Node& goal, bool path_found,
+                                       const std::vector<Node>& path, size_t expand_num, double plan_time, uint32_t seed) {
+        global_planner::PlanRequest request;
+        request.planner = this->planner_name_;
+        request.params.emplace_back("sample_points", std::to_string(this->sample_points_));
+        request.params.emplace_back("sample_max_d", std::to_string(this->sample_max_d_));
+        request.params.emplace_back("optimization_r", std::to_string(this->opt_r_));
+        request.stamp = ros::Time::now().toSec();
+        request.nx = nx;
+        request.ny = ny;
+        request.resolution = this->costmap_->getResolution();
+        request.factor = this->factor_;
+        request.seed = seed;
+        request.start_x = start.x;
+        request.start_y = start.y;
+        request.goal_x = goal.x;
+        request.goal_y = goal.y;
+        request.found = path_found;
+        for (const Node& node : path)
+            request.path.emplace_back(node.x, node.y);
+        request.expand_num = expand_num;
+        request.plan_time = plan_time;
+        this->plan_log_.record(request, costs);
+    }
     /**
      * @brief  Inflate the boundary of costmap into obstacles to prevent cross planning
      * @param  costarr  costmap pointer
@@ -254,9 +358,11 @@ namespace sample_planner {
     }
     /**
      * @brief  publish expand zone
+     * @param  planner planner that expanded the nodes, for index conversion
      * @param  expand  set of expand nodes
      */
-    void SamplePlanner::_publishExpand(std::vector<Node> &expand){
+    void SamplePlanner::_publishExpand(global_planner::GlobalPlanner* planner, std::vector<Node> &expand){
+        TRACE_SCOPE("SamplePlanner::publishExpand");
         ROS_DEBUG("Expand Zone Size:%ld", expand.size());
 
         // Initializes a Marker msg for a LINE_LIST
@@ -272,7 +378,7 @@ namespace sample_planner {
         // Publish all edges
         for (auto node : expand)
             if (node.pid != 0)
-                this->_pubLine(&tree_msg, &this->expand_pub_, node.id, node.pid);
+                this->_pubLine(planner, &tree_msg, &this->expand_pub_, node.id, node.pid);
     }
     /**
      * @brief  tranform from costmap(x, y) to world map(x, y)
@@ -311,6 +417,7 @@ namespace sample_planner {
      * @return bool true if successful else false
      */
     bool SamplePlanner::_getPlanFromPath(std::vector<Node> path, std::vector<geometry_msgs::PoseStamped>& plan) {
+        TRACE_SCOPE("SamplePlanner::getPlanFromPath");
         if (!this->initialized_) {
             ROS_ERROR("This planner has not been initialized yet, but it is being used, please call initialize() before use");
             return false;
@@ -340,13 +447,14 @@ namespace sample_planner {
 
     /**
      *  @brief Publishes a Marker msg with two points in Rviz
+     *  @param planner  planner that expanded the nodes, for index conversion
      *  @param line_msg Pointer to existing marker object.
      *  @param line_pub Pointer to existing marker Publisher.
      *  @param id first marker id
      *  @param pid second marker id
      */
-    void SamplePlanner::_pubLine(visualization_msgs::Marker* line_msg, ros::Publisher* line_pub,
-                                 int id, int pid) {
+    void SamplePlanner::_pubLine(global_planner::GlobalPlanner* planner, visualization_msgs::Marker* line_msg,
+                                 ros::Publisher* line_pub, int id, int pid) {
         // Update line_msg header
         line_msg->header.stamp = ros::Time::now();
 
@@ -355,14 +463,14 @@ namespace sample_planner {
         std_msgs::ColorRGBA c1, c2;
         int p1x, p1y, p2x, p2y;
 
-        this->g_planner_->index2Grid(id, p1x, p1y);
-        this->g_planner_->grid2Map(p1x, p1y, p1.x, p1.y);
+        planner->index2Grid(id, p1x, p1y);
+        planner->grid2Map(p1x, p1y, p1.x, p1.y);
         p1.x = (p1.x + this->convert_offset_) + costmap_->getOriginX();
         p1.y = (p1.y + this->convert_offset_) + costmap_->getOriginY();
         p1.z = 1.0;
 
-        this->g_planner_->index2Grid(pid, p2x, p2y);
-        this->g_planner_->grid2Map(p2x, p2y, p2.x, p2.y);
+        planner->index2Grid(pid, p2x, p2y);
+        planner->grid2Map(p2x, p2y, p2.x, p2.y);
         p2.x = (p2.x + this->convert_offset_) + costmap_->getOriginX();
         p2.y = (p2.y + this->convert_offset_) + costmap_->getOriginY();
         p2.z = 1.0;